@@ -0,0 +1,339 @@
+/**
+ * TraceMind - End-to-End Analysis Benchmark
+ *
+ * Spawns the mock LLM server on a loopback port and drives tm_analyze()
+ * against it, reporting per-phase timings and throughput:
+ *
+ *   make bench
+ *   build/bin/bench_analyze --mock build/bin/tracemind-mock-llm -n 50 --latency 200
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include <getopt.h>
+#include <signal.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/wait.h>
+
+/* ============================================================================
+ * Sample Inputs
+ * ========================================================================== */
+
+static const char *SAMPLE_TRACES[] = {
+    "Traceback (most recent call last):\n"
+    "  File \"/app/main.py\", line 42, in process_request\n"
+    "    result = handler.execute(data)\n"
+    "  File \"/app/handlers.py\", line 156, in execute\n"
+    "    return self._run_query(query)\n"
+    "  File \"/app/handlers.py\", line 203, in _run_query\n"
+    "    cursor.execute(sql)\n"
+    "psycopg2.errors.SyntaxError: syntax error at or near \"FROM\"\n",
+
+    "panic: runtime error: index out of range [5] with length 3\n"
+    "\n"
+    "goroutine 1 [running]:\n"
+    "main.processItems(0xc0000a6000, 0x3, 0x8)\n"
+    "        /home/user/project/main.go:45 +0x1a3\n"
+    "main.handleRequest(0xc0000b2000)\n"
+    "        /home/user/project/handlers.go:89 +0x85\n"
+    "main.main()\n"
+    "        /home/user/project/main.go:23 +0x45\n",
+
+    "TypeError: Cannot read property 'id' of undefined\n"
+    "    at processUser (/app/src/users.js:25:18)\n"
+    "    at Array.map (<anonymous>)\n"
+    "    at handleRequest (/app/src/server.js:42:30)\n"
+    "    at Layer.handle (/app/node_modules/express/lib/router/layer.js:95:5)\n",
+};
+
+/* ============================================================================
+ * Phase Timing
+ * ========================================================================== */
+
+typedef enum {
+    PHASE_PARSE = 0,
+    PHASE_AST,
+    PHASE_GIT,
+    PHASE_LLM,
+    PHASE_TOTAL,
+    PHASE_COUNT
+} phase_t;
+
+static const char *PHASE_NAMES[PHASE_COUNT] = {
+    "parse", "ast", "git", "llm", "total"
+};
+
+typedef struct {
+    double last_ms;
+    double phase_ms[PHASE_COUNT];
+} phase_clock_t;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/*
+ * Attribute the time since the previous progress report to the phase the
+ * analyzer has just reached. Buckets follow the progress fractions the
+ * pipeline reports rather than stage labels.
+ */
+static void on_progress(const char *stage, float progress, void *ctx)
+{
+    (void)stage;
+    phase_clock_t *clock = ctx;
+    double now = now_ms();
+    double elapsed = now - clock->last_ms;
+    clock->last_ms = now;
+
+    phase_t phase;
+    if (progress <= 0.15f)      phase = PHASE_PARSE;
+    else if (progress <= 0.40f) phase = PHASE_AST;
+    else if (progress <= 0.60f) phase = PHASE_GIT;
+    else                        phase = PHASE_LLM;
+
+    clock->phase_ms[phase] += elapsed;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double pct)
+{
+    if (n == 0) return 0.0;
+    size_t idx = (size_t)(pct / 100.0 * (double)(n - 1) + 0.5);
+    return sorted[TM_MIN(idx, n - 1)];
+}
+
+/* ============================================================================
+ * Mock Server Process
+ * ========================================================================== */
+
+static pid_t spawn_mock(const char *mock_path, char **extra, size_t extra_count, int *port)
+{
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+
+        char **argv = tm_calloc(extra_count + 5, sizeof(char *));
+        size_t n = 0;
+        argv[n++] = (char *)mock_path;
+        argv[n++] = "--port";
+        argv[n++] = "0";
+        argv[n++] = "--quiet";
+        for (size_t i = 0; i < extra_count; i++) argv[n++] = extra[i];
+        argv[n] = NULL;
+
+        execv(mock_path, argv);
+        fprintf(stderr, "bench: cannot exec %s: %s\n", mock_path, strerror(errno));
+        _exit(127);
+    }
+
+    close(fds[1]);
+    FILE *out = fdopen(fds[0], "r");
+    char line[128];
+    *port = 0;
+    if (out && fgets(line, sizeof(line), out)) {
+        sscanf(line, "listening on 127.0.0.1:%d", port);
+    }
+    if (out) fclose(out);
+
+    if (*port == 0) {
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+    return pid;
+}
+
+/* ============================================================================
+ * Benchmark Run
+ * ========================================================================== */
+
+typedef struct {
+    int iterations;
+    const char *repo_path;
+    char **inputs;
+    size_t input_count;
+} bench_opts_t;
+
+static int run_provider(tm_llm_provider_t provider, const char *name, int port,
+                        const bench_opts_t *opts)
+{
+    tm_config_t *config = tm_config_new();
+    config->llm_provider = provider;
+    config->output_format = TM_OUTPUT_JSON;
+    config->color_output = false;
+    config->timeout_ms = 10000;
+
+    char endpoint[128];
+    snprintf(endpoint, sizeof(endpoint), "http://127.0.0.1:%d%s", port,
+             provider == TM_LLM_ANTHROPIC ? "/v1/messages" : "/v1/chat/completions");
+    config->api_endpoint = tm_strdup(endpoint);
+    TM_FREE(config->model_name);
+    config->model_name = tm_strdup("mock-model");
+    if (opts->repo_path) config->repo_path = tm_strdup(opts->repo_path);
+
+    tm_analyzer_t *analyzer = tm_analyzer_new(config);
+    if (!analyzer) {
+        fprintf(stderr, "bench: failed to create analyzer\n");
+        tm_config_free(config);
+        return 1;
+    }
+
+    size_t n = (size_t)opts->iterations;
+    double *samples[PHASE_COUNT];
+    for (int p = 0; p < PHASE_COUNT; p++) samples[p] = tm_calloc(n, sizeof(double));
+
+    size_t failed = 0;
+    double wall_start = now_ms();
+
+    for (size_t i = 0; i < n; i++) {
+        const char *input = opts->input_count > 0
+            ? opts->inputs[i % opts->input_count]
+            : SAMPLE_TRACES[i % TM_ARRAY_SIZE(SAMPLE_TRACES)];
+
+        phase_clock_t clock = { 0 };
+        tm_analyzer_set_progress_callback(analyzer, on_progress, &clock);
+
+        double start = now_ms();
+        clock.last_ms = start;
+        tm_analysis_result_t *result = tm_analyze(analyzer, input);
+        clock.phase_ms[PHASE_TOTAL] = now_ms() - start;
+
+        if (!result || result->hypothesis_count == 0) failed++;
+        tm_result_free(result);
+
+        for (int p = 0; p < PHASE_COUNT; p++) samples[p][i] = clock.phase_ms[p];
+    }
+
+    double wall_ms = now_ms() - wall_start;
+
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        qsort(samples[p], n, sizeof(double), compare_double);
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++) sum += samples[p][i];
+
+        printf("%-10s %-6s %10.2f %10.2f %10.2f %10.2f\n",
+               name, PHASE_NAMES[p], sum / (double)n,
+               percentile(samples[p], n, 50.0),
+               percentile(samples[p], n, 95.0),
+               samples[p][n - 1]);
+        free(samples[p]);
+    }
+
+    printf("%-10s %zu runs, %zu failed, %.2f analyses/s\n\n",
+           name, n, failed, (double)n * 1000.0 / wall_ms);
+
+    tm_analyzer_free(analyzer);
+    tm_config_free(config);
+    return failed == n ? 1 : 0;
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: bench_analyze [options] [-- mock-server-options]\n"
+        "\n"
+        "  --mock <path>         Mock server binary (default: build/bin/tracemind-mock-llm)\n"
+        "  -n, --iterations <n>  Analyses per provider (default: 20)\n"
+        "  -p, --provider <p>    openai, anthropic or both (default: both)\n"
+        "  -l, --latency <ms>    Mock LLM latency (default: 50)\n"
+        "  -i, --input <file>    Trace/log input; repeatable (default: built-in samples)\n"
+        "  -r, --repo <path>     Repository for AST/git phases\n"
+        "\n"
+        "Arguments after -- are passed to the mock server, e.g. -- --fail-429 10\n");
+}
+
+int main(int argc, char **argv)
+{
+    static struct option long_options[] = {
+        {"mock",       required_argument, 0, 'm'},
+        {"iterations", required_argument, 0, 'n'},
+        {"provider",   required_argument, 0, 'p'},
+        {"latency",    required_argument, 0, 'l'},
+        {"input",      required_argument, 0, 'i'},
+        {"repo",       required_argument, 0, 'r'},
+        {"help",       no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    const char *mock_path = "build/bin/tracemind-mock-llm";
+    const char *provider = "both";
+    char latency[16] = "50";
+    bench_opts_t opts = { .iterations = 20 };
+    size_t input_cap = 0;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "m:n:p:l:i:r:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'm': mock_path = optarg; break;
+            case 'n': opts.iterations = atoi(optarg); break;
+            case 'p': provider = optarg; break;
+            case 'l': snprintf(latency, sizeof(latency), "%s", optarg); break;
+            case 'i': TM_VEC_PUSH(opts.inputs, opts.input_count, input_cap, optarg); break;
+            case 'r': opts.repo_path = optarg; break;
+            case 'h': usage(); return 0;
+            default: usage(); return 1;
+        }
+    }
+
+    if (opts.iterations <= 0) {
+        fprintf(stderr, "bench: iterations must be positive\n");
+        return 1;
+    }
+
+    /* Mock options: latency first, then anything after -- */
+    size_t extra_count = (size_t)(argc - optind) + 2;
+    char **extra = tm_calloc(extra_count, sizeof(char *));
+    extra[0] = "--latency";
+    extra[1] = latency;
+    for (int i = optind; i < argc; i++) extra[2 + i - optind] = argv[i];
+
+    int port = 0;
+    pid_t mock = spawn_mock(mock_path, extra, extra_count, &port);
+    free(extra);
+    if (mock < 0) {
+        fprintf(stderr, "bench: failed to start mock server (%s)\n", mock_path);
+        free(opts.inputs);
+        return 1;
+    }
+
+    g_log_level = TM_LOG_ERROR;
+
+    printf("TraceMind end-to-end benchmark: mock LLM on port %d, %s ms latency, "
+           "%d iterations\n\n", port, latency, opts.iterations);
+    printf("%-10s %-6s %10s %10s %10s %10s\n",
+           "provider", "phase", "mean ms", "p50 ms", "p95 ms", "max ms");
+
+    int rc = 0;
+    if (strcasecmp(provider, "openai") == 0 || strcasecmp(provider, "both") == 0) {
+        rc |= run_provider(TM_LLM_OPENAI, "openai", port, &opts);
+    }
+    if (strcasecmp(provider, "anthropic") == 0 || strcasecmp(provider, "both") == 0) {
+        rc |= run_provider(TM_LLM_ANTHROPIC, "anthropic", port, &opts);
+    }
+
+    kill(mock, SIGTERM);
+    waitpid(mock, NULL, 0);
+    free(opts.inputs);
+
+    return rc;
+}
@@ -0,0 +1,301 @@
+/**
+ * TraceMind - Git History Benchmark
+ *
+ * Times file-filtered commit queries (tm_git_get_commits) and file history
+ * (tm_git_file_history) three ways: a plain revwalk, a revwalk pruned by
+ * git's commit-graph Bloom filters, and the persistent history index.
+ * Generates a synthetic repository with git fast-import if asked:
+ *
+ *   build/bin/bench_git_history --generate /tmp/tm-bench-repo -c 100000
+ *   build/bin/bench_git_history --repo /tmp/tm-bench-repo -f target.py
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/git.h"
+#include <getopt.h>
+#include <time.h>
+
+#define TARGET_PATH "src/core/target.py"
+
+typedef struct {
+    const char *repo_path;
+    const char *generate_dir;
+    const char *file;
+    int commits;
+    int files;
+    int target_every;
+    int iterations;
+    int max_commits;
+} bench_opts_t;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* ============================================================================
+ * Synthetic Repository
+ * ========================================================================== */
+
+static void emit_blob(FILE *out, const char *path, int commit)
+{
+    char content[64];
+    int len = snprintf(content, sizeof(content), "# revision %d\n", commit);
+    fprintf(out, "M 100644 inline %s\ndata %d\n%s\n", path, len, content);
+}
+
+/*
+ * Each commit edits two of opts->files files spread over 64 directories;
+ * every target_every-th commit also edits TARGET_PATH, so a query for it
+ * has to look at (nearly) the whole history to fill max_commits.
+ */
+static int generate_repo(const bench_opts_t *opts)
+{
+    char cmd[PATH_MAX + 128];
+
+    snprintf(cmd, sizeof(cmd), "git init -q '%s'", opts->generate_dir);
+    if (system(cmd) != 0) return 1;
+
+    snprintf(cmd, sizeof(cmd), "git -C '%s' fast-import --quiet", opts->generate_dir);
+    FILE *out = popen(cmd, "w");
+    if (!out) return 1;
+
+    int64_t base_time = 1600000000;
+    for (int i = 1; i <= opts->commits; i++) {
+        char message[64];
+        int len = snprintf(message, sizeof(message), "Change %d", i);
+
+        fprintf(out, "commit refs/heads/main\nmark :%d\n", i);
+        fprintf(out, "committer Bench <bench@example.com> %lld +0000\n",
+                (long long)(base_time + i * 60));
+        fprintf(out, "data %d\n%s\n", len, message);
+        if (i > 1) fprintf(out, "from :%d\n", i - 1);
+
+        for (int k = 0; k < 2; k++) {
+            int f = (int)(((int64_t)i * (k ? 104729 : 7919) + k * 13) % opts->files);
+            char path[64];
+            snprintf(path, sizeof(path), "src/mod%02d/file%05d.py", f % 64, f);
+            emit_blob(out, path, i);
+        }
+        if (i % opts->target_every == 0) emit_blob(out, TARGET_PATH, i);
+        fputc('\n', out);
+    }
+
+    if (pclose(out) != 0) return 1;
+
+    snprintf(cmd, sizeof(cmd),
+             "git -C '%s' symbolic-ref HEAD refs/heads/main && "
+             "git -C '%s' commit-graph write --reachable --changed-paths",
+             opts->generate_dir, opts->generate_dir);
+    return system(cmd) != 0;
+}
+
+/* ============================================================================
+ * Queries
+ * ========================================================================== */
+
+#ifdef HAVE_LIBGIT2
+
+typedef struct {
+    double commits_ms;
+    double history_ms;
+    size_t commit_count;
+    size_t history_count;
+} query_result_t;
+
+static void run_queries(const tm_git_repo_t *repo, const bench_opts_t *opts,
+                        query_result_t *result)
+{
+    const char *paths[] = { opts->file };
+    tm_commit_opts_t commit_opts = {
+        .max_commits = opts->max_commits,
+        .file_paths = paths,
+        .file_path_count = 1,
+    };
+
+    memset(result, 0, sizeof(*result));
+
+    for (int i = 0; i < opts->iterations; i++) {
+        tm_git_commit_t *commits = NULL;
+        size_t count = 0;
+        double start = now_ms();
+        tm_git_get_commits(repo, &commit_opts, &commits, &count);
+        result->commits_ms += now_ms() - start;
+        result->commit_count = count;
+        tm_git_commits_free(commits, count);
+
+        tm_file_change_t *changes = NULL;
+        start = now_ms();
+        tm_git_file_history(repo, opts->file, opts->max_commits, &changes, &count);
+        result->history_ms += now_ms() - start;
+        result->history_count = count;
+        tm_git_file_changes_free(changes, count);
+    }
+
+    result->commits_ms /= opts->iterations;
+    result->history_ms /= opts->iterations;
+}
+
+static void print_row(const char *mode, const query_result_t *r, double baseline)
+{
+    printf("%-14s %12.2f %12.2f %8zu %10.1fx\n", mode, r->commits_ms, r->history_ms,
+           r->commit_count, baseline / (r->commits_ms + r->history_ms));
+}
+
+static int run_bench(const bench_opts_t *opts)
+{
+    tm_git_repo_t *repo = NULL;
+    tm_error_t err = tm_git_repo_open(opts->repo_path, &repo);
+    if (err != TM_OK) {
+        fprintf(stderr, "bench: cannot open %s: %s\n", opts->repo_path, tm_strerror(err));
+        return 1;
+    }
+
+    printf("TraceMind git history benchmark: %s, file '%s', %d results, %d iterations\n\n",
+           opts->repo_path, opts->file, opts->max_commits, opts->iterations);
+    printf("%-14s %12s %12s %8s %11s\n", "mode", "commits ms", "history ms", "found", "speedup");
+
+    /* Plain revwalk: no Bloom filters, no index */
+    tm_commit_graph_t *graph = repo->graph;
+    repo->graph = NULL;
+
+    query_result_t walk;
+    run_queries(repo, opts, &walk);
+    double baseline = walk.commits_ms + walk.history_ms;
+    print_row("revwalk", &walk, baseline);
+
+    repo->graph = graph;
+    if (graph) {
+        query_result_t bloom;
+        run_queries(repo, opts, &bloom);
+        print_row("commit-graph", &bloom, baseline);
+    } else {
+        printf("%-14s (no commit-graph with changed-path Bloom filters)\n", "commit-graph");
+    }
+
+    /* History index in a scratch cache dir; first use builds it */
+    char cache_dir[] = "/tmp/tm-bench-cacheXXXXXX";
+    if (!mkdtemp(cache_dir)) {
+        tm_git_repo_free(repo);
+        return 1;
+    }
+
+    double start = now_ms();
+    err = tm_git_repo_use_history_index(repo, cache_dir);
+    double build_ms = now_ms() - start;
+
+    if (err == TM_OK) {
+        query_result_t indexed;
+        run_queries(repo, opts, &indexed);
+        print_row("history index", &indexed, baseline);
+        printf("\nhistory index build: %.2f ms (one-off, then incremental)\n", build_ms);
+    } else {
+        printf("%-14s failed: %s\n", "history index", tm_strerror(err));
+    }
+
+    char cmd[PATH_MAX];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", cache_dir);
+    if (system(cmd) != 0) fprintf(stderr, "bench: could not remove %s\n", cache_dir);
+
+    tm_git_repo_free(repo);
+    return 0;
+}
+
+#else
+
+static int run_bench(const bench_opts_t *opts)
+{
+    (void)opts;
+    fprintf(stderr, "bench: built without libgit2\n");
+    return 1;
+}
+
+#endif /* HAVE_LIBGIT2 */
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: bench_git_history [options]\n"
+        "\n"
+        "  -r, --repo <path>        Repository to query (default: the generated one)\n"
+        "  -g, --generate <dir>     Create a synthetic repository with a commit-graph\n"
+        "  -c, --commits <n>        Commits to generate (default: 100000)\n"
+        "      --files <n>          Distinct files to generate (default: 2000)\n"
+        "      --target-every <n>   Touch " TARGET_PATH " every n commits (default: 5000)\n"
+        "  -f, --file <path>        File to query (default: " TARGET_PATH ")\n"
+        "  -m, --max <n>            Commits to collect per query (default: 20)\n"
+        "  -n, --iterations <n>     Runs per mode (default: 3)\n");
+}
+
+int main(int argc, char **argv)
+{
+    static struct option long_options[] = {
+        {"repo",         required_argument, 0, 'r'},
+        {"generate",     required_argument, 0, 'g'},
+        {"commits",      required_argument, 0, 'c'},
+        {"files",        required_argument, 0, 'F'},
+        {"target-every", required_argument, 0, 'T'},
+        {"file",         required_argument, 0, 'f'},
+        {"max",          required_argument, 0, 'm'},
+        {"iterations",   required_argument, 0, 'n'},
+        {"help",         no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    bench_opts_t opts = {
+        .file = TARGET_PATH,
+        .commits = 100000,
+        .files = 2000,
+        .target_every = 5000,
+        .iterations = 3,
+        .max_commits = 20,
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:g:c:f:m:n:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'r': opts.repo_path = optarg; break;
+            case 'g': opts.generate_dir = optarg; break;
+            case 'c': opts.commits = atoi(optarg); break;
+            case 'F': opts.files = atoi(optarg); break;
+            case 'T': opts.target_every = atoi(optarg); break;
+            case 'f': opts.file = optarg; break;
+            case 'm': opts.max_commits = atoi(optarg); break;
+            case 'n': opts.iterations = atoi(optarg); break;
+            case 'h': usage(); return 0;
+            default: usage(); return 1;
+        }
+    }
+
+    if (opts.commits <= 0 || opts.files <= 0 || opts.target_every <= 0 ||
+        opts.iterations <= 0 || opts.max_commits <= 0) {
+        fprintf(stderr, "bench: counts must be positive\n");
+        return 1;
+    }
+
+    if (opts.generate_dir) {
+        printf("Generating %d commits in %s...\n", opts.commits, opts.generate_dir);
+        double start = now_ms();
+        if (generate_repo(&opts) != 0) {
+            fprintf(stderr, "bench: failed to generate repository\n");
+            return 1;
+        }
+        printf("Generated in %.1f s\n\n", (now_ms() - start) / 1000.0);
+        if (!opts.repo_path) opts.repo_path = opts.generate_dir;
+    }
+
+    if (!opts.repo_path) {
+        usage();
+        return 1;
+    }
+
+    g_log_level = TM_LOG_ERROR;
+    return run_bench(&opts);
+}
@@ -9,6 +9,9 @@
 #define TM_INTERNAL_AST_H
 
 #include "tracemind.h"
+#include "internal/common.h"
+#include "internal/interval.h"
+#include "internal/symbol_index.h"
 
 #ifdef HAVE_TREE_SITTER
 #include <tree_sitter/api.h>
@@ -37,7 +40,8 @@ const TSLanguage *tm_ts_language(tm_language_t lang);
 tm_error_t tm_ast_init(void);
 
 /**
- * Cleanup Tree-sitter resources.
+ * Cleanup Tree-sitter resources: compiled queries and the calling
+ * thread's parsers (other threads release theirs on exit).
  */
 void tm_ast_cleanup(void);
 
@@ -45,6 +49,11 @@ void tm_ast_cleanup(void);
  * Source File Parsing
  * ========================================================================== */
 
+/**
+ * Function lookup tables for one parsed file (see Function Index).
+ */
+typedef struct tm_function_index tm_function_index_t;
+
 /**
  * Parsed source file context.
  */
@@ -53,15 +62,44 @@ typedef struct {
     char *source;             /* Source content */
     size_t source_len;        /* Source length */
     TSTree *tree;             /* Parsed AST */
-    TSParser *parser;         /* Parser instance */
     tm_language_t language;   /* Detected language */
+    ino_t inode;              /* Identity when parsed, to detect edits */
+    struct timespec mtime;
+    tm_function_index_t *functions; /* Built once at parse time */
 } tm_source_file_t;
 
 /**
- * Parse a source file.
+ * Parse a source file. Parsers are shared per language and thread, so
+ * the file keeps only its tree.
  */
 tm_error_t tm_parse_source_file(const char *path, tm_source_file_t **file);
 
+/**
+ * Parse source already read from path (takes ownership of source).
+ */
+tm_error_t tm_parse_source(const char *path, char *source, size_t source_len,
+                           tm_source_file_t **file);
+
+/**
+ * Parse a source file through the AST summary cache in summary_dir (see
+ * ast_cache.h). When a summary of the same content exists, tree-sitter is
+ * skipped and the file has no tree; otherwise the file is parsed and its
+ * summary written.
+ */
+tm_error_t tm_parse_source_file_cached(const char *path,
+                                       const char *summary_dir,
+                                       tm_source_file_t **file);
+
+/**
+ * Bring a parsed file up to date with its content on disk. The text edit
+ * between old and new content is applied to the tree, which is then
+ * reparsed incrementally; only definitions overlapping the changed lines
+ * are extracted again (with their calls and complexity when summarized),
+ * and the summary is rewritten if summary_dir is set. TM_ERR_UNSUPPORTED
+ * for files loaded from a summary, which have no tree to edit.
+ */
+tm_error_t tm_source_file_update(tm_source_file_t *file, const char *summary_dir);
+
 /**
  * Free parsed source file.
  */
@@ -98,14 +136,14 @@ tm_error_t tm_extract_functions(const tm_source_file_t *file,
 void tm_functions_free(tm_function_def_t *funcs, size_t count);
 
 /**
- * Find function definition by name in a file.
+ * Find function definition by name in a file (caller frees the copy).
  */
 tm_error_t tm_find_function(const tm_source_file_t *file,
                             const char *name,
                             tm_function_def_t **func);
 
 /**
- * Find function definition by line number.
+ * Find function definition by line number (caller frees the copy).
  */
 tm_error_t tm_find_function_at_line(const tm_source_file_t *file,
                                     int line,
@@ -138,10 +176,86 @@ tm_error_t tm_extract_call_sites(const tm_source_file_t *file,
  */
 void tm_call_sites_free(tm_call_site_t *sites, size_t count);
 
+/* ============================================================================
+ * Import Extraction
+ * ========================================================================== */
+
+/**
+ * Import statement (or require call), with its text on one line.
+ */
+typedef struct {
+    char *text;
+    int line;
+} tm_import_t;
+
+/**
+ * Extract a parsed file's imports in document order.
+ */
+tm_error_t tm_extract_imports(const tm_source_file_t *file,
+                              tm_import_t **imports,
+                              size_t *count);
+
+/**
+ * Free imports array.
+ */
+void tm_imports_free(tm_import_t *imports, size_t count);
+
+/* ============================================================================
+ * Function Index
+ * ========================================================================== */
+
+/**
+ * Function index: definitions in document order, a name map to the first
+ * definition with each name, and an interval index over line ranges
+ * (tagged with the definition's position) for enclosing-function queries.
+ * Summarized indexes also hold every call site in the file and each
+ * definition's complexity, so they answer without a tree.
+ */
+struct tm_function_index {
+    tm_function_def_t *funcs;
+    size_t count;
+    tm_strmap_t by_name;
+    tm_interval_index_t by_line;
+    bool summarized;
+    tm_call_site_t *calls;            /* By line, then column */
+    size_t call_count;
+    uint32_t *complexity;             /* Per definition */
+};
+
+/**
+ * Index definitions (takes ownership of funcs).
+ */
+tm_function_index_t *tm_function_index_new(tm_function_def_t *funcs, size_t count);
+
+/**
+ * Index a file's functions with a single tree walk.
+ */
+tm_function_index_t *tm_function_index_build(const tm_source_file_t *file);
+
+/**
+ * Free a function index.
+ */
+void tm_function_index_free(tm_function_index_t *index);
+
+/**
+ * First definition named name, owned by the file, or NULL.
+ */
+const tm_function_def_t *tm_lookup_function(const tm_source_file_t *file,
+                                            const char *name);
+
+/**
+ * Innermost definition enclosing line, owned by the file, or NULL.
+ */
+const tm_function_def_t *tm_lookup_function_at_line(const tm_source_file_t *file,
+                                                    int line);
+
 /* ============================================================================
  * Call Graph Construction
  * ========================================================================== */
 
+#define TM_GRAPH_MAX_NODES_PER_DEPTH 64
+#define TM_GRAPH_TIME_BUDGET_MS 2000
+
 /**
  * Context for call graph building.
  */
@@ -150,7 +264,15 @@ typedef struct {
     tm_source_file_t **files;         /* Parsed files cache */
     size_t file_count;
     size_t file_capacity;
+    tm_strmap_t file_index;           /* Canonical path -> files index */
+    uint64_t *file_build;             /* Per file: build it was last checked in */
+    uint64_t build_id;                /* Build in progress, 0 between builds */
+    uint64_t build_count;
+    char *summary_dir;                /* AST summary cache (nullable) */
+    const tm_symbol_index_t *symbols; /* Repository symbols (nullable) */
     int max_depth;                    /* Maximum traversal depth */
+    size_t max_nodes_per_depth;       /* Nodes added per expansion depth */
+    int time_budget_ms;               /* Expansion time limit (0 = none) */
     bool include_stdlib;              /* Include stdlib functions */
     bool include_tests;               /* Include test files */
 } tm_graph_builder_t;
@@ -174,7 +296,8 @@ void tm_ast_builder_free(tm_ast_builder_t *builder);
 tm_error_t tm_ast_add_file(tm_ast_builder_t *builder, const char *path);
 
 /**
- * Build call graph from an entry function.
+ * Build call graph from the first definition of entry_function among the
+ * added files, expanding callees up to max_depth.
  */
 tm_call_graph_t *tm_ast_build_call_graph(tm_ast_builder_t *builder,
                                          const char *entry_function,
@@ -191,14 +314,33 @@ tm_graph_builder_t *tm_graph_builder_new(const char *repo_path, int max_depth);
 void tm_graph_builder_free(tm_graph_builder_t *builder);
 
 /**
- * Get or parse a source file (caches result).
+ * Load files through the AST summary cache in <cache_dir>/ast.
+ */
+tm_error_t tm_graph_builder_use_cache(tm_graph_builder_t *builder, const char *cache_dir);
+
+/**
+ * Resolve callees not defined in loaded files through a repository symbol
+ * index (borrowed; must outlive the builder).
+ */
+void tm_graph_builder_use_symbols(tm_graph_builder_t *builder,
+                                  const tm_symbol_index_t *symbols);
+
+/**
+ * Get or parse a source file. Files are cached by canonical path and
+ * reparsed when their inode or mtime changes, incrementally when the
+ * cached file has a tree. During a build, files already checked by it
+ * are returned as they are, since its nodes point into them.
  */
 tm_error_t tm_graph_builder_get_file(tm_graph_builder_t *builder,
                                      const char *path,
                                      tm_source_file_t **file);
 
 /**
- * Build call graph starting from stack trace frames.
+ * Build call graph starting from stack trace frames. Consecutive frames
+ * are linked, then callees are expanded breadth-first up to max_depth,
+ * resolved within the caller's file first, then across loaded files, then
+ * through the symbol index. Files cached by earlier builds are brought up
+ * to date first, so one builder can serve many traces.
  */
 tm_error_t tm_graph_builder_build(tm_graph_builder_t *builder,
                                   const tm_stack_trace_t *trace,
@@ -218,16 +360,19 @@ tm_call_node_t *tm_call_node_new(const char *name,
 
 /**
  * Free a call node (including callees/callers arrays, but not the nodes themselves).
+ * Not for nodes of a graph with a node block, which owns them.
  */
 void tm_call_node_free(tm_call_node_t *node);
 
 /**
- * Add caller to node.
+ * Add caller to node, once. For hand-built graphs: the graph builder
+ * dedups edges in a hash set and lays them out once, and graphs with
+ * shared adjacency keep their edge lists fixed.
  */
 tm_error_t tm_call_node_add_caller(tm_call_node_t *node, tm_call_node_t *caller);
 
 /**
- * Add callee to node.
+ * Add callee to node (see tm_call_node_add_caller).
  */
 tm_error_t tm_call_node_add_callee(tm_call_node_t *node, tm_call_node_t *callee);
 
@@ -245,6 +390,11 @@ const char *tm_query_function_defs(tm_language_t lang);
  */
 const char *tm_query_function_calls(tm_language_t lang);
 
+/**
+ * Get Tree-sitter query for decision points counted by complexity.
+ */
+const char *tm_query_complexity(tm_language_t lang);
+
 /**
  * Get Tree-sitter query for imports.
  */
@@ -0,0 +1,93 @@
+/**
+ * TraceMind - AST Summary Cache
+ *
+ * Persistent per-file summaries under <cache_dir>/ast: function
+ * definitions, call sites and complexity, enough to resolve frames and
+ * walk calls without tree-sitter. Summaries are keyed by a hash of the
+ * file content, so they stay valid across checkouts and branches, and
+ * checked against a second, independent hash when read. The file is
+ * memory-mapped when read.
+ *
+ * Layout (host byte order):
+ *   header | functions[function_count] | calls[call_count] | strings
+ * Strings are NUL-terminated; records refer to them by offset.
+ */
+
+#ifndef TM_INTERNAL_AST_CACHE_H
+#define TM_INTERNAL_AST_CACHE_H
+
+#include "tracemind.h"
+#include "internal/ast.h"
+
+/* ============================================================================
+ * On-Disk Records
+ * ========================================================================== */
+
+/**
+ * One function definition (32 bytes, no padding).
+ */
+typedef struct {
+    uint32_t name_offset;
+    uint32_t qualified_offset;
+    uint32_t signature_offset;
+    int32_t start_line;
+    int32_t end_line;
+    int32_t start_col;
+    int32_t end_col;
+    uint32_t complexity;
+} tm_ast_summary_func_t;
+
+/**
+ * One call site (12 bytes), in line then column order.
+ */
+typedef struct {
+    uint32_t callee_offset;
+    int32_t line;
+    int32_t column;
+} tm_ast_summary_call_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;              /* 0x01020304 as written */
+    uint64_t content_hash;            /* tm_hash_bytes of the source */
+    uint64_t content_len;
+    uint64_t content_check;           /* Independent second hash of the source */
+    uint32_t language;
+    uint32_t function_count;
+    uint32_t call_count;
+    uint32_t reserved;
+    uint64_t strings_size;
+} tm_ast_summary_header_t;
+
+/* ============================================================================
+ * Summary Files
+ * ========================================================================== */
+
+/**
+ * Summary file for source under dir (caller frees).
+ */
+char *tm_ast_cache_file(const char *dir, const char *source, size_t len);
+
+/**
+ * Load the summary in file as a summarized function index. TM_ERR_NOT_FOUND
+ * if missing, TM_ERR_PARSE if corrupt, from another version, or not a
+ * summary of this source and language.
+ */
+tm_error_t tm_ast_cache_read(const char *file,
+                             tm_language_t lang,
+                             const char *source,
+                             size_t len,
+                             tm_function_index_t **index);
+
+/**
+ * Write a summarized index for source to file. Atomic: readers see the
+ * old or the new file.
+ */
+tm_error_t tm_ast_cache_write(const char *file,
+                              tm_language_t lang,
+                              const char *source,
+                              size_t len,
+                              const tm_function_index_t *index);
+
+#endif /* TM_INTERNAL_AST_CACHE_H */
@@ -0,0 +1,124 @@
+/**
+ * TraceMind - Provider Batch API
+ *
+ * Offline bulk requests through the OpenAI Batch and Anthropic Message
+ * Batches APIs: stage many chat requests as one JSONL file, submit it,
+ * poll for completion, and map results back by custom ID. State lives in
+ * a directory so an interrupted run resumes instead of resubmitting.
+ */
+
+#ifndef TM_INTERNAL_BATCH_H
+#define TM_INTERNAL_BATCH_H
+
+#include "internal/common.h"
+#include "internal/llm.h"
+#include <stdio.h>
+
+/* ============================================================================
+ * Batch State
+ * ========================================================================== */
+
+/**
+ * Batch lifecycle.
+ */
+typedef enum {
+    TM_BATCH_STAGING = 0,             /* Requests staged locally, not submitted */
+    TM_BATCH_UPLOADED,                /* OpenAI: requests file uploaded, no batch yet */
+    TM_BATCH_SUBMITTED,               /* Accepted by the provider, in progress */
+    TM_BATCH_COMPLETED,               /* Finished; results can be fetched */
+    TM_BATCH_FAILED                   /* Failed or expired without output */
+} tm_batch_status_t;
+
+/**
+ * Result of one batched request.
+ */
+typedef struct {
+    char *custom_id;
+    tm_chat_response_t *response;     /* NULL if the request failed */
+    char *error;                      /* Failure reason (nullable) */
+} tm_batch_result_t;
+
+/**
+ * Batch job. Files in dir:
+ *   requests.jsonl  staged requests in the provider's batch format
+ *   state.json      provider batch/file IDs and status
+ *   results.jsonl   downloaded provider results
+ */
+typedef struct {
+    tm_llm_client_t *client;          /* Borrowed */
+    char *dir;
+    tm_batch_status_t status;
+    char *batch_id;
+    char *input_file_id;              /* OpenAI: uploaded requests file */
+    char *output_file_id;             /* OpenAI: successful results */
+    char *error_file_id;              /* OpenAI: failed requests */
+    char *results_url;                /* Anthropic: results download */
+    int64_t submitted_at;             /* Unix ms */
+    char **custom_ids;                /* In staging order */
+    size_t request_count;
+    size_t request_cap;
+    tm_strmap_t ids;                  /* custom_id -> request index */
+    tm_batch_result_t *results;       /* Indexed like custom_ids once fetched */
+    FILE *staging;                    /* Open requests.jsonl while staging */
+} tm_batch_t;
+
+/* ============================================================================
+ * Batch API
+ * ========================================================================== */
+
+/**
+ * Open (or resume) the batch stored in dir, creating it if needed.
+ * A batch found in dir that was uploaded or submitted is resumed; requests
+ * left staged by an interrupted run are discarded so they can be re-added.
+ */
+tm_batch_t *tm_batch_open(tm_llm_client_t *client, const char *dir);
+
+/**
+ * Stage one request. custom_id must be 1-64 characters of [A-Za-z0-9_-]
+ * and unique within the batch. Only valid before submission.
+ */
+tm_error_t tm_batch_add(tm_batch_t *batch,
+                        const char *custom_id,
+                        const tm_chat_request_t *request);
+
+/**
+ * Submit staged requests as one provider batch. State is saved after each
+ * provider request, so a resumed batch skips an upload that already
+ * succeeded. No-op for a batch that was already submitted.
+ */
+tm_error_t tm_batch_submit(tm_batch_t *batch);
+
+/**
+ * Refresh the batch status from the provider.
+ */
+tm_error_t tm_batch_poll(tm_batch_t *batch);
+
+/**
+ * Poll until the batch completes or fails.
+ * timeout_ms of 0 waits indefinitely. Returns TM_ERR_TIMEOUT if the
+ * batch is still running when the timeout expires.
+ */
+tm_error_t tm_batch_wait(tm_batch_t *batch, int poll_interval_ms, int timeout_ms);
+
+/**
+ * Download (once) and parse the results of a completed batch.
+ */
+tm_error_t tm_batch_fetch_results(tm_batch_t *batch);
+
+/**
+ * Look up the result for a custom ID, or NULL if unknown / not fetched.
+ */
+const tm_batch_result_t *tm_batch_get_result(const tm_batch_t *batch,
+                                             const char *custom_id);
+
+/**
+ * Get status name string.
+ */
+const char *tm_batch_status_name(tm_batch_status_t status);
+
+/**
+ * Free batch (state on disk is kept).
+ */
+void tm_batch_free(tm_batch_t *batch);
+
+#endif /* TM_INTERNAL_BATCH_H */
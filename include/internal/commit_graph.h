@@ -0,0 +1,80 @@
+/**
+ * TraceMind - Commit-Graph Reader
+ *
+ * Reads git's commit-graph file (objects/info/commit-graph or a split
+ * commit-graph chain) and its changed-path Bloom filters, so history walks
+ * can rule out commits that did not touch a path without loading trees.
+ * Pure file-format code; no libgit2 dependency.
+ */
+
+#ifndef TM_INTERNAL_COMMIT_GRAPH_H
+#define TM_INTERNAL_COMMIT_GRAPH_H
+
+#include "tracemind.h"
+
+#define TM_COMMIT_GRAPH_OID_SIZE 20
+
+/* Seeds of the two murmur3 hashes behind each Bloom key (git's bloom.c) */
+#define TM_BLOOM_SEED0 0x293ae76fu
+#define TM_BLOOM_SEED1 0x7e646e2cu
+
+/* ============================================================================
+ * Commit Graph
+ * ========================================================================== */
+
+/**
+ * One commit-graph file (a single file, or one layer of a chain).
+ */
+typedef struct {
+    void *map;
+    size_t map_size;
+    uint32_t commit_count;
+    const uint8_t *fanout;            /* OIDF: 256 big-endian counts */
+    const uint8_t *oids;              /* OIDL: sorted object IDs */
+    const uint8_t *bloom_index;       /* BIDX: big-endian end offsets (nullable) */
+    const uint8_t *bloom_data;        /* BDAT filters, after the header */
+    size_t bloom_data_size;
+    uint32_t bloom_version;           /* 1 or 2 (murmur3 variant) */
+    uint32_t bloom_hashes;
+} tm_commit_graph_layer_t;
+
+typedef struct {
+    tm_commit_graph_layer_t *layers;
+    size_t layer_count;
+} tm_commit_graph_t;
+
+/**
+ * Open the commit-graph under a git objects directory.
+ * TM_ERR_NOT_FOUND if the repository has none.
+ */
+tm_error_t tm_commit_graph_open(const char *objects_dir, tm_commit_graph_t **graph);
+
+/**
+ * True if any layer carries changed-path Bloom filters.
+ */
+bool tm_commit_graph_has_bloom(const tm_commit_graph_t *graph);
+
+/**
+ * Ask the Bloom filter whether a commit may have changed any of paths
+ * (repository-relative) against its first parent.
+ * Returns 0 if it definitely did not, 1 if it may have, and -1 if the
+ * commit has no filter (not in the graph, or filter missing).
+ */
+int tm_commit_graph_maybe_changed(const tm_commit_graph_t *graph,
+                                  const uint8_t oid[TM_COMMIT_GRAPH_OID_SIZE],
+                                  const char **paths,
+                                  size_t path_count);
+
+/**
+ * Seeded murmur3 as a changed-path filter of the given version hashes a
+ * key: version 1 sign-extends bytes >= 0x80 like the git that wrote it.
+ */
+uint32_t tm_commit_graph_murmur3(uint32_t seed, const char *data, size_t len,
+                                 uint32_t version);
+
+/**
+ * Unmap and free graph.
+ */
+void tm_commit_graph_free(tm_commit_graph_t *graph);
+
+#endif /* TM_INTERNAL_COMMIT_GRAPH_H */
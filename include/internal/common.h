@@ -266,6 +266,115 @@ static inline void tm_strbuf_free(tm_strbuf_t *sb)
     sb->cap = 0;
 }
 
+/* ============================================================================
+ * String Hash Map
+ * ========================================================================== */
+
+/**
+ * FNV-1a hash of a byte range.
+ */
+static inline uint64_t tm_hash_bytes(const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * Open-addressing map from owned string keys to size_t values
+ * (typically indices into a caller-owned array).
+ */
+typedef struct {
+    char **keys;
+    size_t *values;
+    size_t cap;                       /* Power of two, or 0 */
+    size_t count;
+} tm_strmap_t;
+
+/**
+ * Initialize an empty map.
+ */
+static inline void tm_strmap_init(tm_strmap_t *map)
+{
+    map->keys = NULL;
+    map->values = NULL;
+    map->cap = 0;
+    map->count = 0;
+}
+
+/* Slot holding key, or the empty slot where it would go */
+static inline size_t tm_strmap_slot(const tm_strmap_t *map, const char *key)
+{
+    size_t mask = map->cap - 1;
+    size_t i = (size_t)tm_hash_bytes(key, strlen(key)) & mask;
+    while (map->keys[i] && strcmp(map->keys[i], key) != 0) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/**
+ * Look up key. Returns true and stores the value if present.
+ */
+static inline bool tm_strmap_get(const tm_strmap_t *map, const char *key, size_t *value)
+{
+    if (!key || map->cap == 0) return false;
+    size_t i = tm_strmap_slot(map, key);
+    if (!map->keys[i]) return false;
+    if (value) *value = map->values[i];
+    return true;
+}
+
+/**
+ * Insert or overwrite key (the key is copied).
+ */
+static inline void tm_strmap_put(tm_strmap_t *map, const char *key, size_t value)
+{
+    if (!key) return;
+    
+    /* Keep load factor under 0.7 */
+    if ((map->count + 1) * 10 >= map->cap * 7) {
+        tm_strmap_t grown;
+        grown.cap = map->cap ? map->cap * 2 : 16;
+        grown.count = map->count;
+        grown.keys = tm_calloc(grown.cap, sizeof(char *));
+        grown.values = tm_calloc(grown.cap, sizeof(size_t));
+        for (size_t i = 0; i < map->cap; i++) {
+            if (!map->keys[i]) continue;
+            size_t j = tm_strmap_slot(&grown, map->keys[i]);
+            grown.keys[j] = map->keys[i];
+            grown.values[j] = map->values[i];
+        }
+        free(map->keys);
+        free(map->values);
+        *map = grown;
+    }
+    
+    size_t i = tm_strmap_slot(map, key);
+    if (!map->keys[i]) {
+        map->keys[i] = tm_strdup(key);
+        map->count++;
+    }
+    map->values[i] = value;
+}
+
+/**
+ * Free keys and storage.
+ */
+static inline void tm_strmap_free(tm_strmap_t *map)
+{
+    for (size_t i = 0; i < map->cap; i++) {
+        free(map->keys[i]);
+    }
+    free(map->keys);
+    free(map->values);
+    tm_strmap_init(map);
+}
+
 /* ============================================================================
  * Logging
  * ========================================================================== */
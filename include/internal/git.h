@@ -1,14 +1,17 @@
 /**
  * TraceMind - Git Context Collector
  * 
- * Uses libgit2 for repository analysis.
- * Compiles as stub when HAVE_LIBGIT2 is not defined.
+ * Uses libgit2 for repository analysis. Without it, commits and file
+ * history are read natively from the object database (git_odb.h).
  */
 
 #ifndef TM_INTERNAL_GIT_H
 #define TM_INTERNAL_GIT_H
 
 #include "tracemind.h"
+#include "internal/commit_graph.h"
+#include "internal/git_odb.h"
+#include "internal/history_index.h"
 
 #ifdef HAVE_LIBGIT2
 #include <git2.h>
@@ -48,23 +51,68 @@ typedef struct {
     char *root_path;
     char *branch;
     char head_sha[41];
+    tm_history_index_t *history;  /* Commit history index (owned, nullable) */
+    tm_commit_graph_t *graph;     /* git commit-graph with Bloom filters (owned, nullable) */
+    char *blame_cache_dir;        /* Blame cache directory (owned, nullable) */
+    git_repository **workers;     /* Per-thread handles, opened on first use (owned) */
+    size_t worker_count;          /* Threads for multi-file work (1 = serial) */
+    tm_odb_t *odb;                /* Native object reader without libgit2 (owned, nullable) */
 } tm_git_repo_t;
 
 /**
- * Open a repository.
+ * Open a repository. Loads git's commit-graph when it carries changed-path
+ * Bloom filters, which file-filtered revwalks use to skip commits.
  */
 tm_error_t tm_git_repo_open(const char *path, tm_git_repo_t **repo);
 
+/**
+ * Re-read HEAD and the current branch of an open repository, so a
+ * long-lived handle follows new commits and checkouts.
+ */
+tm_error_t tm_git_repo_refresh(tm_git_repo_t *repo);
+
 /**
  * Free repository wrapper.
  */
 void tm_git_repo_free(tm_git_repo_t *repo);
 
+/**
+ * Let multi-file operations (blame, commit walks and diff stats) use up
+ * to count threads. libgit2 handles are not thread-safe, so each extra
+ * thread opens its own handle on the same repository.
+ */
+void tm_git_repo_set_workers(tm_git_repo_t *repo, size_t count);
+
 /**
  * Find repository root from a path inside it.
  */
 tm_error_t tm_git_find_root(const char *path, char **root);
 
+/**
+ * Strip the repository root from an absolute path inside the worktree.
+ * Returns path unchanged if it is not under the root.
+ */
+const char *tm_git_relative_path(const tm_git_repo_t *repo, const char *path);
+
+/**
+ * Attach the commit history index stored under cache_dir, building it on
+ * first use and extending it with commits added since the last indexed
+ * HEAD. Each branch has its own index; a new tip starts from the index of
+ * a tip it descends from. If HEAD is behind every index, none is attached
+ * and queries walk history. File-filtered commit queries and file history
+ * then use the index instead of a revwalk.
+ *
+ * Each run indexes a bounded number of older commits, so a long history is
+ * indexed over several runs. Until then, queries the partial index cannot
+ * fully answer walk history.
+ */
+tm_error_t tm_git_repo_use_history_index(tm_git_repo_t *repo, const char *cache_dir);
+
+/**
+ * Cache blame results under cache_dir, keyed by file path, blob and HEAD.
+ */
+tm_error_t tm_git_repo_use_blame_cache(tm_git_repo_t *repo, const char *cache_dir);
+
 /* ============================================================================
  * Commit History
  * ========================================================================== */
@@ -77,6 +125,7 @@ typedef struct {
     const char **file_paths;      /* Filter to commits touching these files */
     size_t file_path_count;
     int64_t since_timestamp;      /* Only commits after this time (0 = no limit) */
+    int64_t until_timestamp;      /* Only commits up to this time (0 = no limit) */
     bool include_merges;          /* Include merge commits */
 } tm_commit_opts_t;
 
@@ -135,6 +184,24 @@ tm_error_t tm_git_blame_line(const tm_git_repo_t *repo,
                              int line,
                              tm_git_blame_t **blame);
 
+/**
+ * A line to blame with tm_git_blame_lines().
+ */
+typedef struct {
+    const char *file_path;        /* Repository-relative */
+    int line;
+    tm_git_blame_t *blame;        /* Result (caller frees), NULL if unavailable */
+} tm_blame_request_t;
+
+/**
+ * Blame several lines, running one blame per file over the span of its
+ * requested lines. With a blame cache attached, lines already blamed for
+ * the file's path and blob at the current HEAD are served from the cache.
+ */
+tm_error_t tm_git_blame_lines(const tm_git_repo_t *repo,
+                              tm_blame_request_t *requests,
+                              size_t count);
+
 /* ============================================================================
  * Diff Analysis
  * ========================================================================== */
@@ -219,10 +286,81 @@ tm_error_t tm_git_file_history(const tm_git_repo_t *repo,
  */
 void tm_git_file_changes_free(tm_file_change_t *changes, size_t count);
 
+/* ============================================================================
+ * Working Tree
+ * ========================================================================== */
+
+#define TM_GIT_MAX_DIRTY_HUNKS 20
+
+/**
+ * Uncommitted changes (staged or not) to the trace's files, as hunks
+ * against HEAD, those touching frame lines first. Only the trace files are
+ * checked, and files whose index stat data still matches are not read.
+ */
+tm_error_t tm_git_worktree_changes(const tm_git_repo_t *repo,
+                                   const tm_stack_trace_t *trace,
+                                   tm_git_dirty_hunk_t **hunks,
+                                   size_t *count);
+
+/**
+ * Free dirty hunks.
+ */
+void tm_git_dirty_hunks_free(tm_git_dirty_hunk_t *hunks, size_t count);
+
+/**
+ * Committed content of a repository-relative path at HEAD, NUL-terminated
+ * (caller frees). TM_ERR_NOT_FOUND if HEAD does not have it.
+ */
+tm_error_t tm_git_head_file(const tm_git_repo_t *repo,
+                            const char *path,
+                            char **content,
+                            size_t *content_len);
+
 /* ============================================================================
  * Context Collection (High-Level)
  * ========================================================================== */
 
+/**
+ * Options for context collection.
+ */
+typedef struct {
+    int max_commits;
+    const char *cache_dir;        /* History index / blame cache location (nullable) */
+    bool history_index;           /* Use the history index under cache_dir */
+    bool blame_cache;             /* Use the blame cache under cache_dir */
+    int workers;                  /* Git worker threads (0 = one per CPU, up to 8) */
+    int64_t incident_time;        /* Only commits up to this time (0 = up to HEAD) */
+    int window_hours;             /* ... and at most this long before it (0 = unbounded) */
+    const tm_call_graph_t *call_graph; /* Functions enclosing the frames (nullable) */
+    /* For a call graph still being built: blocks until it is ready, called
+     * just before commits are scored or a cached context is checked
+     * (nullable; replaces call_graph) */
+    const tm_call_graph_t *(*wait_call_graph)(void *ctx);
+    void *wait_call_graph_ctx;
+} tm_git_collect_opts_t;
+
+/**
+ * Collect git context for files, with options. With an incident time the
+ * revwalk skips later commits and stops at the start of the window, so the
+ * commits returned are the ones landed closest before the incident.
+ */
+tm_git_context_t *tm_git_collect_context_opts(const char *repo_path,
+                                              const char **files,
+                                              size_t file_count,
+                                              const tm_git_collect_opts_t *opts);
+
+/**
+ * Collect git context for a parsed trace: commits touching its files and
+ * blame for the lines of its top frames. Commits are ranked by how close
+ * their hunks come to the frame lines and to the functions enclosing them
+ * in opts->call_graph, weighted by recency, and keep the relevant hunks.
+ * Uncommitted changes to the trace files are read on every call, even
+ * when the rest comes from the registry's context cache.
+ */
+tm_git_context_t *tm_git_collect_context_trace(const char *repo_path,
+                                               const tm_stack_trace_t *trace,
+                                               const tm_git_collect_opts_t *opts);
+
 /* Note: tm_git_collect_context is declared in tracemind.h as:
  * tm_git_context_t *tm_git_collect_context(const char *repo_path,
  *                                          const char **files,
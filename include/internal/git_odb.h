@@ -0,0 +1,128 @@
+/**
+ * TraceMind - Native Git Object Reader
+ *
+ * Read-only access to a repository's object database without libgit2:
+ * loose objects, packfiles through their mmap'd .idx, zlib inflate and
+ * delta resolution, with a small cache of inflated objects so delta chains
+ * and trees shared between neighbouring commits are not rebuilt. Backs the
+ * git context collector in builds without libgit2; needs zlib (HAVE_ZLIB),
+ * otherwise opening fails with TM_ERR_UNSUPPORTED.
+ *
+ * An odb is not thread-safe; use one per thread.
+ */
+
+#ifndef TM_INTERNAL_GIT_ODB_H
+#define TM_INTERNAL_GIT_ODB_H
+
+#include "tracemind.h"
+
+#define TM_ODB_OID_SIZE 20
+
+/* ============================================================================
+ * Object Database
+ * ========================================================================== */
+
+typedef enum {
+    TM_ODB_COMMIT = 1,
+    TM_ODB_TREE = 2,
+    TM_ODB_BLOB = 3,
+    TM_ODB_TAG = 4
+} tm_odb_type_t;
+
+typedef struct tm_odb tm_odb_t;
+
+/**
+ * Open the object database under objects_dir (".git/objects").
+ */
+tm_error_t tm_odb_open(const char *objects_dir, tm_odb_t **odb);
+
+/**
+ * Unmap packs and free odb.
+ */
+void tm_odb_free(tm_odb_t *odb);
+
+/**
+ * Read an object. *data is NUL-terminated for convenience (caller frees).
+ * TM_ERR_NOT_FOUND if no pack or loose file has it.
+ */
+tm_error_t tm_odb_read(tm_odb_t *odb,
+                       const uint8_t oid[TM_ODB_OID_SIZE],
+                       tm_odb_type_t *type,
+                       uint8_t **data,
+                       size_t *size);
+
+/* ============================================================================
+ * Object IDs
+ * ========================================================================== */
+
+/**
+ * Parse 40 hex digits. False on anything else.
+ */
+bool tm_odb_oid_parse(const char *hex, uint8_t oid[TM_ODB_OID_SIZE]);
+
+/**
+ * Format an object ID as 40 hex digits plus NUL.
+ */
+void tm_odb_oid_format(const uint8_t oid[TM_ODB_OID_SIZE], char hex[41]);
+
+/* ============================================================================
+ * Commits and Trees
+ * ========================================================================== */
+
+/**
+ * Parsed commit.
+ */
+typedef struct {
+    uint8_t tree[TM_ODB_OID_SIZE];
+    uint8_t (*parents)[TM_ODB_OID_SIZE];  /* Owned */
+    size_t parent_count;
+    char *author;                 /* Owned */
+    char *email;                  /* Owned */
+    int64_t commit_time;          /* Committer time */
+    char *message;                /* Owned */
+} tm_odb_commit_t;
+
+/**
+ * Read and parse a commit.
+ */
+tm_error_t tm_odb_read_commit(tm_odb_t *odb,
+                              const uint8_t oid[TM_ODB_OID_SIZE],
+                              tm_odb_commit_t *commit);
+
+/**
+ * Free a parsed commit's fields.
+ */
+void tm_odb_commit_clear(tm_odb_commit_t *commit);
+
+/**
+ * One entry of a raw tree object.
+ */
+typedef struct {
+    uint32_t mode;
+    const char *name;             /* Not NUL-terminated */
+    size_t name_len;
+    const uint8_t *oid;
+} tm_odb_tree_entry_t;
+
+/**
+ * Step through a raw tree object, starting at *pos = 0.
+ * False at the end or on a malformed entry.
+ */
+bool tm_odb_tree_next(const uint8_t *tree, size_t size, size_t *pos,
+                      tm_odb_tree_entry_t *entry);
+
+/**
+ * True if mode is a subtree.
+ */
+static inline bool tm_odb_mode_is_tree(uint32_t mode)
+{
+    return (mode & 0170000) == 0040000;
+}
+
+/**
+ * Find name in a raw tree object.
+ */
+bool tm_odb_tree_find(const uint8_t *tree, size_t size, const char *name, size_t name_len,
+                      tm_odb_tree_entry_t *entry);
+
+#endif /* TM_INTERNAL_GIT_ODB_H */
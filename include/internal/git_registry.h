@@ -0,0 +1,84 @@
+/**
+ * TraceMind - Git Repository Registry
+ *
+ * Process-wide state shared by every analysis in a long-running process
+ * (batch runs, daemons): repository roots resolved per directory, open
+ * repository handles (with their object caches, history index and blame
+ * cache) per root, and collected git context keyed by HEAD, traced files
+ * and options so identical traces skip collection entirely. Thread-safe.
+ */
+
+#ifndef TM_INTERNAL_GIT_REGISTRY_H
+#define TM_INTERNAL_GIT_REGISTRY_H
+
+#include "internal/git.h"
+
+#define TM_GIT_REGISTRY_MAX_REPOS 16
+#define TM_GIT_REGISTRY_MAX_CONTEXTS 64
+
+/* ============================================================================
+ * Repository Roots
+ * ========================================================================== */
+
+/**
+ * Root of the repository containing dir (caller frees), or NULL. Every
+ * directory on the way up is remembered, so files that share a parent
+ * resolve without touching the filesystem again.
+ */
+char *tm_git_registry_find_root(const char *dir);
+
+/* ============================================================================
+ * Repository Handles
+ * ========================================================================== */
+
+/**
+ * Borrow the open handle for the repository at path, opening it on first
+ * use. HEAD is re-read on every acquire, so handles never go stale. A
+ * handle is lent to one caller at a time; concurrent callers get a
+ * private handle that release frees.
+ */
+tm_error_t tm_git_registry_acquire(const char *path, tm_git_repo_t **repo);
+
+/**
+ * Return a handle from tm_git_registry_acquire.
+ */
+void tm_git_registry_release(tm_git_repo_t *repo);
+
+/* ============================================================================
+ * Context Cache
+ * ========================================================================== */
+
+/**
+ * Cache key for collecting trace context at HEAD with opts (caller frees).
+ * Frame order is kept since frame position weights commit ranking. The
+ * call graph is not part of the key: it may still be building when the
+ * cache is consulted, so entries carry a scope for it instead.
+ */
+char *tm_git_context_key(const char *head_sha,
+                         const tm_stack_trace_t *trace,
+                         const tm_git_collect_opts_t *opts);
+
+/**
+ * Copy of the context cached under key, or NULL. *scope (if given) is the
+ * value it was stored with; callers compare it before reusing the entry.
+ */
+tm_git_context_t *tm_git_registry_context_get(const char *key, uint64_t *scope);
+
+/**
+ * Cache a copy of ctx under key with scope, a hash of the scoring inputs
+ * the key does not cover (0 if none), evicting the least recently used
+ * entry beyond TM_GIT_REGISTRY_MAX_CONTEXTS.
+ */
+void tm_git_registry_context_put(const char *key, uint64_t scope, const tm_git_context_t *ctx);
+
+/**
+ * Deep copy of a git context.
+ */
+tm_git_context_t *tm_git_context_clone(const tm_git_context_t *ctx);
+
+/**
+ * Close all handles and drop cached roots and contexts.
+ */
+void tm_git_registry_clear(void);
+
+#endif /* TM_INTERNAL_GIT_REGISTRY_H */
@@ -0,0 +1,159 @@
+/**
+ * TraceMind - Commit History Index
+ *
+ * Persistent path -> commit index under cache_dir. Each indexed path maps
+ * to the commits that changed it (newest first) with per-file line stats,
+ * so file history queries are a binary search instead of a revwalk. The
+ * file is memory-mapped; git.c builds it and extends it with commits newer
+ * than the last indexed HEAD.
+ *
+ * A build indexes a bounded number of commits per run, newest first. Until
+ * the walk reaches the root commits, the header's boundary is the commit
+ * time below which nothing is indexed yet; later runs continue from there.
+ *
+ * Layout (host byte order):
+ *   header | entries[entry_count] | paths[path_count] | strings
+ * Paths are sorted by name; each owns a contiguous run of entries.
+ */
+
+#ifndef TM_INTERNAL_HISTORY_INDEX_H
+#define TM_INTERNAL_HISTORY_INDEX_H
+
+#include "tracemind.h"
+#include "internal/common.h"
+
+#define TM_HISTORY_OID_SIZE 20
+
+/* Entry flags */
+#define TM_HISTORY_MERGE 0x1u         /* Commit has more than one parent */
+
+/* ============================================================================
+ * On-Disk Records
+ * ========================================================================== */
+
+/**
+ * One commit that changed one path (40 bytes, no padding).
+ */
+typedef struct {
+    int64_t timestamp;
+    uint32_t additions;
+    uint32_t deletions;
+    uint32_t flags;
+    uint8_t oid[TM_HISTORY_OID_SIZE];
+} tm_history_entry_t;
+
+/**
+ * Indexed path and its run of entries.
+ */
+typedef struct {
+    uint32_t name_offset;             /* NUL-terminated, in strings */
+    uint32_t name_len;
+    uint32_t first_entry;
+    uint32_t entry_count;
+} tm_history_path_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;              /* 0x01020304 as written */
+    uint8_t head[TM_HISTORY_OID_SIZE];/* Last indexed HEAD */
+    uint32_t path_count;
+    uint64_t entry_count;
+    uint64_t strings_size;
+    int64_t boundary;                 /* Older commits not indexed yet, 0 once complete */
+} tm_history_header_t;
+
+/* ============================================================================
+ * Index
+ * ========================================================================== */
+
+/**
+ * Memory-mapped history index.
+ */
+typedef struct {
+    void *map;
+    size_t map_size;
+    const tm_history_header_t *header;
+    const tm_history_entry_t *entries;
+    const tm_history_path_t *paths;
+    const char *strings;
+} tm_history_index_t;
+
+/**
+ * Map an index file. TM_ERR_NOT_FOUND if missing, TM_ERR_PARSE if the file
+ * is corrupt or from another version.
+ */
+tm_error_t tm_history_index_load(const char *file, tm_history_index_t **index);
+
+/**
+ * Entries for an exact repository-relative path (newest first), or NULL.
+ */
+const tm_history_entry_t *tm_history_index_lookup(const tm_history_index_t *index,
+                                                  const char *path,
+                                                  size_t *count);
+
+/**
+ * Commits that changed any path matching the patterns, newest first and
+ * unique by commit. A pattern that is an indexed path is a binary search;
+ * otherwise it matches every indexed path containing it as a substring.
+ * Entry stats are those of the first matching path.
+ */
+tm_error_t tm_history_index_query(const tm_history_index_t *index,
+                                  const char **patterns,
+                                  size_t pattern_count,
+                                  tm_history_entry_t **entries,
+                                  size_t *count);
+
+/**
+ * Unmap and free index.
+ */
+void tm_history_index_free(tm_history_index_t *index);
+
+/* ============================================================================
+ * Index Builder
+ * ========================================================================== */
+
+/**
+ * Accumulates (path, entry) records in walk order (newest first).
+ */
+typedef struct {
+    tm_strmap_t path_ids;             /* path -> index in paths */
+    char **paths;
+    size_t path_count;
+    size_t path_cap;
+    uint32_t *record_paths;           /* Path index per record */
+    tm_history_entry_t *records;
+    size_t record_count;
+    size_t record_cap;
+    int64_t boundary;                 /* Written to the header */
+    bool older;                       /* Records predate base's: continue its walk */
+} tm_history_builder_t;
+
+/**
+ * Initialize builder.
+ */
+void tm_history_builder_init(tm_history_builder_t *builder);
+
+/**
+ * Record that entry's commit changed path.
+ */
+void tm_history_builder_add(tm_history_builder_t *builder,
+                            const char *path,
+                            const tm_history_entry_t *entry);
+
+/**
+ * Write builder records and the entries of base if given as a new index for
+ * head, newest first per path: base's entries go first if builder->older.
+ * Atomic: readers see the old or the new file.
+ */
+tm_error_t tm_history_builder_write(const tm_history_builder_t *builder,
+                                    const tm_history_index_t *base,
+                                    const uint8_t head[TM_HISTORY_OID_SIZE],
+                                    const char *file);
+
+/**
+ * Free builder.
+ */
+void tm_history_builder_free(tm_history_builder_t *builder);
+
+#endif /* TM_INTERNAL_HISTORY_INDEX_H */
@@ -360,4 +360,27 @@ tm_error_t tm_unified_parse(const char *content,
                             tm_stack_trace_t **trace,
                             tm_generic_log_t **log);
 
+/* ============================================================================
+ * Timestamps
+ * ========================================================================== */
+
+/**
+ * Find the first timestamp in text and convert it to Unix seconds.
+ * Recognizes ISO 8601 / RFC 3339 ("2024-01-15T10:30:45.123Z", with a space
+ * instead of T, or an offset), Common Log Format ("15/Jan/2024:10:30:45
+ * +0000"), syslog ("Jan 15 10:30:45", current year) and bare epoch seconds
+ * or milliseconds. Times without an offset are in this host's local time
+ * zone (TZ), as the process that wrote the log would have used.
+ */
+bool tm_parse_timestamp(const char *text, int64_t *out);
+
+/**
+ * Incident time for input: the timestamp of the first error entry of log
+ * if given, else of the first error-looking line of content, else the first
+ * timestamp found at all. Returns 0 if the input carries no timestamps.
+ */
+int64_t tm_find_incident_time(const char *content,
+                              size_t len,
+                              const tm_generic_log_t *log);
+
 #endif /* TM_INTERNAL_INPUT_FORMAT_H */
@@ -0,0 +1,66 @@
+/**
+ * TraceMind - Interval Index
+ *
+ * Static interval tree over line ranges: intervals are sorted by start and
+ * each implicit subtree records its largest end, so overlap queries cost
+ * O(log n + k) and nearest-interval queries O(log n). Used to match diff
+ * hunks against failing lines and enclosing functions.
+ */
+
+#ifndef TM_INTERNAL_INTERVAL_H
+#define TM_INTERNAL_INTERVAL_H
+
+#include "tracemind.h"
+
+/* ============================================================================
+ * Interval Index
+ * ========================================================================== */
+
+/**
+ * Closed line range [start, end] with a caller-defined tag.
+ */
+typedef struct {
+    int start;
+    int end;
+    uint32_t tag;
+} tm_interval_t;
+
+typedef struct {
+    tm_interval_t *items;         /* Sorted by start (owned) */
+    int *subtree_max;             /* Largest end in each implicit subtree */
+    int *prefix_max;              /* Largest end among items[0..i] */
+    size_t count;
+} tm_interval_index_t;
+
+/**
+ * Build an index over a copy of intervals.
+ */
+void tm_interval_index_init(tm_interval_index_t *index,
+                            const tm_interval_t *intervals,
+                            size_t count);
+
+/**
+ * Free the index's arrays.
+ */
+void tm_interval_index_free(tm_interval_index_t *index);
+
+/**
+ * Visitor for overlap queries.
+ */
+typedef void (*tm_interval_fn)(const tm_interval_t *interval, void *ctx);
+
+/**
+ * Call fn for each interval overlapping [start, end], in start order.
+ * Returns the number of overlapping intervals.
+ */
+size_t tm_interval_index_overlaps(const tm_interval_index_t *index,
+                                  int start, int end,
+                                  tm_interval_fn fn, void *ctx);
+
+/**
+ * Lines between [start, end] and the nearest interval: 0 if one overlaps,
+ * -1 if the index is empty.
+ */
+int tm_interval_index_distance(const tm_interval_index_t *index, int start, int end);
+
+#endif /* TM_INTERNAL_INTERVAL_H */
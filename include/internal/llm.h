@@ -8,6 +8,7 @@
 #define TM_INTERNAL_LLM_H
 
 #include "tracemind.h"
+#include "internal/common.h"
 #include "internal/input_format.h"
 #include <curl/curl.h>
 
@@ -30,16 +31,25 @@ void tm_http_cleanup(void);
  * LLM Client
  * ========================================================================== */
 
+typedef struct tm_rate_limiter tm_rate_limiter_t;
+
 /**
  * LLM client instance.
+ * A client (and its CURL handle) must only be used by one thread at a
+ * time; use tm_llm_client_clone() for concurrent requests.
  */
 typedef struct {
     tm_llm_provider_t provider;
     char *api_key;
     char *endpoint;
     char *model;
+    char *map_model;                  /* Model for map-reduce summaries */
     int timeout_ms;
     float temperature;
+    int context_tokens;               /* Prompt token budget per request */
+    int max_parallel;                 /* Concurrent requests for fan-out */
+    tm_rate_limiter_t *limiter;       /* Shared with clones (nullable) */
+    bool owns_limiter;
     CURL *curl;
 } tm_llm_client_t;
 
@@ -48,6 +58,12 @@ typedef struct {
  */
 tm_llm_client_t *tm_llm_client_new(const tm_config_t *cfg);
 
+/**
+ * Create a client with the same settings and its own CURL handle, sharing
+ * the rate limiter. If model is non-NULL it replaces the model name.
+ */
+tm_llm_client_t *tm_llm_client_clone(const tm_llm_client_t *client, const char *model);
+
 /**
  * Free LLM client.
  */
@@ -81,16 +97,36 @@ typedef struct {
 
 /**
  * Build the analysis prompt from stack trace context.
+ * Contains only per-trace (volatile) content; the repository summary is
+ * built separately by tm_build_repo_summary() so it can sit in the cached
+ * prefix ahead of this prompt.
  * Returns allocated string (caller must free).
  */
 char *tm_build_analysis_prompt(const tm_analysis_context_t *ctx);
 
 /**
  * Build analysis prompt from generic log context.
+ * Like tm_build_analysis_prompt(), excludes the repository summary.
  * Returns allocated string (caller must free).
  */
 char *tm_build_generic_log_prompt(const tm_generic_analysis_ctx_t *ctx);
 
+/**
+ * Build the repository summary (branch, HEAD).
+ * Output is byte-identical for the same repository state so it can be
+ * served from the provider prompt cache across analyses.
+ * Returns allocated string (caller must free), or NULL if git_ctx is NULL.
+ */
+char *tm_build_repo_summary(const tm_git_context_t *git_ctx);
+
+/**
+ * Build the commit history section: the incident time and the commits
+ * touching the analyzed files, ranked with their relevant hunks. Depends
+ * on the trace, so it belongs in the volatile prompt.
+ * Returns allocated string (caller must free), or NULL if there is none.
+ */
+char *tm_build_commit_history(const tm_git_context_t *git_ctx);
+
 /**
  * Build a system prompt for root cause analysis.
  * Returns allocated string (caller must free).
@@ -123,6 +159,7 @@ typedef enum {
 typedef struct {
     tm_message_role_t role;
     char *content;
+    bool cache_breakpoint;            /* Ends a stable, cacheable prefix */
 } tm_chat_message_t;
 
 /**
@@ -142,6 +179,8 @@ typedef struct {
     char *content;                    /* Response content (owned) */
     int prompt_tokens;                /* Tokens in prompt */
     int completion_tokens;            /* Tokens in completion */
+    int cached_tokens;                /* Prompt tokens read from provider cache */
+    int cache_write_tokens;           /* Prompt tokens written to cache (Anthropic) */
     char *model;                      /* Model used (owned) */
     char *finish_reason;              /* stop, length, etc. (owned) */
 } tm_chat_response_t;
@@ -158,12 +197,124 @@ tm_error_t tm_llm_chat(tm_llm_client_t *client,
  */
 void tm_chat_response_free(tm_chat_response_t *response);
 
+/**
+ * Append provider authentication and version headers to a header list.
+ * Returns the (possibly reallocated) list.
+ */
+struct curl_slist *tm_llm_auth_headers(const tm_llm_client_t *client,
+                                       struct curl_slist *headers);
+
+/* ============================================================================
+ * Hypothesis Requests
+ * ========================================================================== */
+
+/**
+ * Hypothesis request laid out stable-first for provider prompt caches:
+ * system prompt, response schema, repository summary, volatile prompt.
+ * Owns its prompt strings. request.messages points into the struct, so
+ * it must not be copied once initialized.
+ */
+typedef struct {
+    tm_chat_request_t request;
+    tm_chat_message_t messages[4];
+    char *system_prompt;
+    char *schema;
+    char *repo_summary;               /* Nullable */
+    char *user_prompt;
+} tm_hypothesis_request_t;
+
+/**
+ * Lay out a hypothesis request, taking ownership of the prompts.
+ */
+void tm_hypothesis_request_init(tm_hypothesis_request_t *hr,
+                                const tm_llm_client_t *client,
+                                char *system_prompt,
+                                char *repo_summary,
+                                char *user_prompt);
+
+/**
+ * Build the stack trace hypothesis request without sending it.
+ */
+tm_error_t tm_llm_build_hypothesis_request(const tm_llm_client_t *client,
+                                           const tm_stack_trace_t *trace,
+                                           const tm_call_graph_t *call_graph,
+                                           const tm_git_context_t *git_ctx,
+                                           tm_hypothesis_request_t *hr);
+
+/**
+ * Build the generic log hypothesis request without sending it.
+ * Returns TM_ERR_UNSUPPORTED if the relevant entries exceed
+ * client->context_tokens (see tm_llm_map_reduce_hypotheses()).
+ */
+tm_error_t tm_llm_build_generic_hypothesis_request(const tm_llm_client_t *client,
+                                                   const tm_generic_log_t *log,
+                                                   const tm_git_context_t *git_ctx,
+                                                   tm_hypothesis_request_t *hr);
+
+/**
+ * Free the prompts owned by a hypothesis request.
+ */
+void tm_hypothesis_request_free(tm_hypothesis_request_t *hr);
+
 /* ============================================================================
  * Response Parsing
  * ========================================================================== */
 
+/**
+ * Incremental hypothesis parser. Text may arrive in any number of chunks
+ * (e.g. while a response is streaming) and may be wrapped in prose or
+ * markdown fences; each hypothesis is parsed as soon as it is complete.
+ */
+typedef struct {
+    tm_strbuf_t text;                 /* All text fed so far */
+    size_t scan_pos;                  /* Next byte to scan */
+    int depth;                        /* Bracket depth (0 = outside JSON) */
+    bool in_string;
+    bool escape;
+    size_t string_start;
+    size_t key_start;                 /* Last string closed */
+    size_t key_end;
+    int key_depth;                    /* ... and the depth it closed at */
+    bool key_closed;                  /* Last token was that string */
+    bool after_key;                   /* ... followed by ':' (an object key) */
+    size_t element_start;             /* Current array element */
+    int array_depth;                  /* Depth of the "hypotheses" array's object */
+    bool in_array;                    /* Inside the "hypotheses" array */
+    bool found_array;
+    bool complete;                    /* Array closed */
+    tm_hypothesis_t **hypotheses;     /* Completed hypotheses (owned) */
+    size_t count;
+    size_t cap;
+} tm_hypothesis_parser_t;
+
+/**
+ * Initialize parser.
+ */
+void tm_hypothesis_parser_init(tm_hypothesis_parser_t *parser);
+
+/**
+ * Feed the next chunk of response text.
+ */
+tm_error_t tm_hypothesis_parser_feed(tm_hypothesis_parser_t *parser,
+                                     const char *chunk,
+                                     size_t len);
+
+/**
+ * Take the hypotheses parsed so far. A truncated array yields its complete
+ * elements; TM_ERR_PARSE only if no array or no complete element was seen.
+ */
+tm_error_t tm_hypothesis_parser_finish(tm_hypothesis_parser_t *parser,
+                                       tm_hypothesis_t ***hypotheses,
+                                       size_t *count);
+
+/**
+ * Free parser state (and any hypotheses not taken by finish).
+ */
+void tm_hypothesis_parser_free(tm_hypothesis_parser_t *parser);
+
 /**
  * Parse LLM response into structured hypotheses.
+ * Tolerates surrounding prose, markdown fences and truncated output.
  */
 tm_error_t tm_parse_hypotheses(const char *response_text,
                                tm_hypothesis_t ***hypotheses,
@@ -190,6 +341,20 @@ tm_error_t tm_llm_generate_generic_hypotheses(tm_llm_client_t *client,
                                               tm_hypothesis_t ***hypotheses,
                                               size_t *count);
 
+/**
+ * Generate hypotheses for logs too large for one request.
+ * Relevant entries are grouped into message templates, partitioned by
+ * service or time window to fit client->context_tokens, summarized in
+ * parallel with client->map_model, and the merged findings are sent to a
+ * final request that produces ranked hypotheses.
+ * Called by tm_llm_generate_generic_hypotheses() when needed.
+ */
+tm_error_t tm_llm_map_reduce_hypotheses(tm_llm_client_t *client,
+                                        const tm_generic_log_t *log,
+                                        const tm_git_context_t *git_ctx,
+                                        tm_hypothesis_t ***hypotheses,
+                                        size_t *count);
+
 /**
  * Generate hypotheses for a freeform error string (no trace needed).
  * Used by the "explain" command.
@@ -280,6 +445,22 @@ typedef struct {
  */
 tm_retry_config_t tm_default_retry_config(void);
 
+/**
+ * Create a client-side rate limiter (token buckets refilled per minute).
+ * A limit of 0 disables that dimension. Returns NULL if both are 0.
+ */
+tm_rate_limiter_t *tm_rate_limiter_new(int requests_per_minute, int tokens_per_minute);
+
+/**
+ * Block until one request of the given token cost fits under the limits.
+ */
+void tm_rate_limiter_acquire(tm_rate_limiter_t *limiter, int tokens);
+
+/**
+ * Free rate limiter.
+ */
+void tm_rate_limiter_free(tm_rate_limiter_t *limiter);
+
 /**
  * Execute request with retry logic.
  */
@@ -0,0 +1,36 @@
+/**
+ * TraceMind - Parallel Execution Helpers
+ * 
+ * Minimal pthread-based fan-out used by the LLM, git and AST stages.
+ */
+
+#ifndef TM_INTERNAL_PARALLEL_H
+#define TM_INTERNAL_PARALLEL_H
+
+#include "tracemind.h"
+
+/* ============================================================================
+ * Parallel For
+ * ========================================================================== */
+
+/**
+ * Task callback. `worker` is a stable index in [0, worker_count) so callers
+ * can keep per-worker state (HTTP handles, repository handles) in an array.
+ */
+typedef void (*tm_parallel_fn)(void *ctx, size_t task, size_t worker);
+
+/**
+ * Run fn for every task index in [0, task_count) on up to max_workers
+ * threads. Tasks are claimed in index order; results should be written to
+ * per-task slots so merging stays deterministic. Runs inline when only one
+ * worker is needed. Returns the number of workers used (0 if no tasks).
+ */
+size_t tm_parallel_for(size_t task_count, size_t max_workers,
+                       tm_parallel_fn fn, void *ctx);
+
+/**
+ * Number of online CPUs (at least 1).
+ */
+size_t tm_cpu_count(void);
+
+#endif /* TM_INTERNAL_PARALLEL_H */
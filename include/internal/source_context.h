@@ -0,0 +1,43 @@
+/**
+ * TraceMind - Source Context
+ *
+ * Fills tm_stack_frame_t.context with the code around each in-repository
+ * frame: the enclosing function when the call graph knows it, otherwise
+ * a window of lines either side, trimmed around the frame line to a token
+ * budget. Files are memory-mapped and line-indexed once per fill; files
+ * with uncommitted changes are read from HEAD instead, so line numbers
+ * match the committed code the trace most likely came from.
+ */
+
+#ifndef TM_INTERNAL_SOURCE_CONTEXT_H
+#define TM_INTERNAL_SOURCE_CONTEXT_H
+
+#include "tracemind.h"
+#include "internal/git.h"
+
+#define TM_SOURCE_CONTEXT_FRAME_TOKENS 300
+#define TM_SOURCE_CONTEXT_TOKENS 3000
+
+/**
+ * Options for context extraction.
+ */
+typedef struct {
+    int lines;                        /* Lines either side of the frame line */
+    int frame_tokens;                 /* Budget per frame (0 = default) */
+    int max_tokens;                   /* Budget for the whole trace (0 = default) */
+    const tm_call_graph_t *call_graph; /* Enclosing functions (nullable) */
+    const tm_git_repo_t *repo;        /* Reads HEAD for dirty files (nullable) */
+    const tm_git_context_t *git_ctx;  /* Dirty hunks name the dirty files (nullable) */
+} tm_source_context_opts_t;
+
+/**
+ * Set the context of every frame of trace under repo_root that has none,
+ * in frame order until the trace budget is spent. Library frames and
+ * frames outside the repository are skipped. Returns the number of frames
+ * filled.
+ */
+size_t tm_source_context_fill(tm_stack_trace_t *trace,
+                              const char *repo_root,
+                              const tm_source_context_opts_t *opts);
+
+#endif /* TM_INTERNAL_SOURCE_CONTEXT_H */
@@ -0,0 +1,136 @@
+/**
+ * TraceMind - Repository Symbol Index
+ *
+ * Persistent index of the definitions, exports and imports in every
+ * Python, Go and JavaScript file of a repository, with each file's module
+ * path, so call sites resolve to definitions outside the traced files.
+ * Stored under <cache_dir>/symbols and memory-mapped. Each file entry
+ * records the size, mtime and content hash it was indexed at; a refresh
+ * parses only files whose content changed and copies every other entry.
+ *
+ * Layout (host byte order):
+ *   header | files[file_count] | symbols[symbol_count] |
+ *   by_name[symbol_count] | strings
+ * Files are sorted by repository-relative path and each owns a contiguous
+ * run of symbols; by_name holds symbol ids sorted by name.
+ */
+
+#ifndef TM_INTERNAL_SYMBOL_INDEX_H
+#define TM_INTERNAL_SYMBOL_INDEX_H
+
+#include "tracemind.h"
+#include "internal/common.h"
+
+/* Symbol kinds */
+#define TM_SYMBOL_DEFINITION 0x1u     /* Function or method definition */
+#define TM_SYMBOL_EXPORTED   0x2u     /* Definition visible to other modules */
+#define TM_SYMBOL_IMPORT     0x4u     /* Import statement (name is its text) */
+
+/* ============================================================================
+ * On-Disk Records
+ * ========================================================================== */
+
+/**
+ * One indexed source file (56 bytes, no padding).
+ */
+typedef struct {
+    uint32_t path_offset;             /* Repository-relative path */
+    uint32_t module_offset;           /* Module path (a.b.c, pkg/dir, lib/util) */
+    uint32_t language;
+    uint32_t first_symbol;
+    uint32_t symbol_count;
+    uint32_t reserved;
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t content_hash;            /* tm_hash_bytes of the content */
+} tm_symbol_file_t;
+
+/**
+ * One symbol (20 bytes).
+ */
+typedef struct {
+    uint32_t name_offset;
+    uint32_t file;                    /* Index in files */
+    uint32_t kind;                    /* TM_SYMBOL_* flags */
+    int32_t start_line;
+    int32_t end_line;
+} tm_symbol_t;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;              /* 0x01020304 as written */
+    uint32_t file_count;
+    uint32_t symbol_count;
+    uint64_t strings_size;
+} tm_symbol_header_t;
+
+/* ============================================================================
+ * Index
+ * ========================================================================== */
+
+/**
+ * Memory-mapped symbol index.
+ */
+typedef struct {
+    void *map;
+    size_t map_size;
+    const tm_symbol_header_t *header;
+    const tm_symbol_file_t *files;
+    const tm_symbol_t *symbols;
+    const uint32_t *by_name;
+    const char *strings;
+} tm_symbol_index_t;
+
+/**
+ * Map an index file. TM_ERR_NOT_FOUND if missing, TM_ERR_PARSE if the file
+ * is corrupt or from another version.
+ */
+tm_error_t tm_symbol_index_load(const char *file, tm_symbol_index_t **index);
+
+/**
+ * Ids of the symbols named name (a run of by_name), or NULL.
+ */
+const uint32_t *tm_symbol_index_lookup(const tm_symbol_index_t *index,
+                                       const char *name,
+                                       size_t *count);
+
+/**
+ * String at offset in the index's string table.
+ */
+static inline const char *tm_symbol_index_string(const tm_symbol_index_t *index,
+                                                 uint32_t offset)
+{
+    return index->strings + offset;
+}
+
+/**
+ * Unmap and free index.
+ */
+void tm_symbol_index_free(tm_symbol_index_t *index);
+
+/* ============================================================================
+ * Indexing
+ * ========================================================================== */
+
+/**
+ * Index file for repo_root under <cache_dir>/symbols, creating the
+ * directory (caller frees), or NULL.
+ */
+char *tm_symbol_index_file(const char *cache_dir, const char *repo_root);
+
+/**
+ * Bring the index in file up to date with the working tree at repo_root
+ * and load it. Source files are found by a directory walk (skipping
+ * hidden, vendored and dependency directories) with each top-level
+ * directory walked and each changed file parsed on up to workers threads
+ * (0 = one per CPU). The file is rewritten atomically only when something
+ * changed.
+ */
+tm_error_t tm_symbol_index_update(const char *repo_root,
+                                  const char *file,
+                                  size_t workers,
+                                  tm_symbol_index_t **index);
+
+#endif /* TM_INTERNAL_SYMBOL_INDEX_H */
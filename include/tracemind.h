@@ -134,6 +134,9 @@ typedef struct {
     size_t node_capacity;
     size_t edge_count;            /* Number of edges (caller->callee relationships) */
     tm_call_node_t *entry_point;  /* The failing function */
+    tm_call_node_t **adjacency;   /* Backs every node's callees, then callers (nullable) */
+    tm_call_node_t *node_block;   /* Backs every node when built as one block (nullable) */
+    char *strings;                /* Backs node names, files and signatures (nullable) */
 } tm_call_graph_t;
 
 /* ============================================================================
@@ -155,6 +158,8 @@ typedef struct {
     int deletions;            /* Total lines deleted */
     bool touches_config;      /* True if touches config files */
     bool touches_schema;      /* True if touches DB schema */
+    int relevance;            /* Hunk overlap with failing lines, 0-100 (if ranked) */
+    char *relevant_hunks;     /* Diff hunks near failing lines (owned, nullable) */
 } tm_git_commit_t;
 
 /**
@@ -167,6 +172,17 @@ typedef struct {
     char *line_content;
 } tm_git_blame_t;
 
+/**
+ * Uncommitted change to a trace file (staged or in the working tree).
+ */
+typedef struct {
+    char *file;               /* Repository-relative path (owned) */
+    int start_line;           /* Changed lines in the working-tree file */
+    int end_line;
+    int frame;                /* Lowest frame index whose line it touches, or -1 */
+    char *diff;               /* Hunk against HEAD (owned, nullable) */
+} tm_git_dirty_hunk_t;
+
 /**
  * Complete git context for analysis.
  */
@@ -178,6 +194,11 @@ typedef struct {
     size_t commit_count;
     tm_git_blame_t **blames;      /* Blame info for error lines */
     size_t blame_count;
+    int64_t incident_time;        /* Incident the commits lead up to (0 = unknown) */
+    int64_t window_start;         /* Oldest commit time considered (0 = unbounded) */
+    bool commits_ranked;          /* Commits ordered by relevance, not time */
+    tm_git_dirty_hunk_t *dirty_hunks; /* Uncommitted changes to trace files, frame hits first */
+    size_t dirty_hunk_count;
 } tm_git_context_t;
 
 /* ============================================================================
@@ -270,12 +291,26 @@ typedef struct {
     char *model_name;         /* Model identifier (owned) */
     int timeout_ms;           /* Request timeout in milliseconds */
     float temperature;        /* LLM temperature (0.0-1.0) */
+    char *map_model;          /* Cheaper model for map-reduce summaries (owned, nullable) */
+    int context_tokens;       /* Prompt token budget per request (default: 32000) */
+    int max_parallel_requests; /* Concurrent LLM requests (default: 4) */
+    int requests_per_minute;  /* Client-side request rate limit (0 = none) */
+    int tokens_per_minute;    /* Client-side token rate limit (0 = none) */
+    int batch_poll_ms;        /* Batch API status poll interval (default: 30000) */
     
     /* Analysis Settings */
     int max_commits;          /* Max commits to analyze (default: 20) */
     int max_call_depth;       /* Max call graph depth (default: 5) */
     bool include_stdlib;      /* Include stdlib in analysis */
     bool include_tests;       /* Include test files in analysis */
+    bool history_index;       /* Keep a commit history index in cache_dir (default: true) */
+    bool blame_cache;         /* Cache blame results in cache_dir (default: true) */
+    bool ast_cache;           /* Cache AST summaries in cache_dir (default: true) */
+    bool symbol_index;        /* Keep a repository symbol index in cache_dir (default: true) */
+    int source_context_lines; /* Source lines either side of each frame (default: 5, 0 = none) */
+    int git_workers;          /* Threads for git context (default: 0 = one per CPU, up to 8) */
+    int64_t incident_time;    /* Incident time, Unix seconds (default: 0 = from the log) */
+    int incident_window_hours; /* Commit window before the incident (default: 168, 0 = all) */
     tm_analysis_mode_t analysis_mode;  /* Analysis mode hint (auto by default) */
     
     /* Input Settings */
@@ -312,6 +347,19 @@ tm_error_t tm_config_load_env(tm_config_t *cfg);
  */
 void tm_config_free(tm_config_t *cfg);
 
+/**
+ * Whether the configured LLM endpoint needs an API key.
+ * Local providers and loopback endpoints (e.g. the mock server) do not.
+ */
+bool tm_config_needs_api_key(const tm_config_t *cfg);
+
+/**
+ * Resolve the cache directory: cfg->cache_dir, else $XDG_CACHE_HOME/tracemind,
+ * else ~/.cache/tracemind. Returns allocated path (caller must free), or
+ * NULL if none can be determined.
+ */
+char *tm_config_cache_dir(const tm_config_t *cfg);
+
 /* ============================================================================
  * Main Analysis API
  * ========================================================================== */
@@ -335,6 +383,24 @@ tm_analyzer_t *tm_analyzer_new(tm_config_t *cfg);
  */
 tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input);
 
+/**
+ * Analyze many inputs through the provider batch API (offline triage).
+ * Requests are staged under <cache_dir>/batches/<name>; calling again with
+ * the same name and inputs (in the same order) resumes the submitted batch
+ * instead of resubmitting it.
+ *
+ * @param wait      Poll until done; if false, returns TM_ERR_TIMEOUT while
+ *                  the batch is still running
+ * @param results   One result per input, in input order (caller frees each
+ *                  with tm_result_free(), then the array)
+ */
+tm_error_t tm_analyze_batch(tm_analyzer_t *analyzer,
+                            const char *name,
+                            const char **inputs,
+                            size_t count,
+                            bool wait,
+                            tm_analysis_result_t ***results);
+
 /**
  * Convenience function for one-shot analysis with default config.
  */
@@ -455,6 +521,18 @@ void tm_hypothesis_free(tm_hypothesis_t *h);
  */
 char *tm_read_file(const char *path, size_t *size);
 
+/**
+ * Write a file atomically (temp file + rename), so readers never see a
+ * partially written file. Concurrent writers of one path each use their
+ * own temp file; the last rename wins.
+ */
+tm_error_t tm_write_file_atomic(const char *path, const char *data, size_t len);
+
+/**
+ * Create a directory and any missing parents (like mkdir -p).
+ */
+tm_error_t tm_mkdir_p(const char *path);
+
 /**
  * Generate a UUID v4 string.
  * Caller must free returned string.
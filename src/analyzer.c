@@ -4,7 +4,7 @@
  * Coordinates the full analysis pipeline:
  * 1. Parse stack trace input
  * 2. Build call graph via AST analysis
- * 3. Collect git context
+ * 3. Collect git context (alongside step 2)
  * 4. Generate hypotheses via LLM
  * 5. Format and present results
  */
@@ -13,11 +13,17 @@
 #include "internal/parser.h"
 #include "internal/input_format.h"
 #include "internal/ast.h"
+#include "internal/symbol_index.h"
+#include "internal/source_context.h"
 #include "internal/git.h"
+#include "internal/git_registry.h"
 #include "internal/llm.h"
+#include "internal/batch.h"
+#include "internal/parallel.h"
 #include "internal/output.h"
 #include "tracemind.h"
 #include <sys/time.h>
+#include <pthread.h>
 
 /* ============================================================================
  * Analyzer Context
@@ -35,6 +41,17 @@ struct tm_analyzer {
     /* Progress callback */
     tm_progress_cb progress_cb;
     void *progress_ctx;
+    
+    /* Call graph builder kept across traces, so unchanged files are not
+     * parsed again; one trace builds at a time */
+    pthread_mutex_t graph_lock;
+    tm_graph_builder_t *graph_builder;
+    
+    /* First symbol index build, run in the background */
+    pthread_mutex_t symbols_lock;
+    pthread_t symbols_thread;
+    bool symbols_started;             /* Thread not yet joined */
+    bool symbols_done;                /* Thread finished */
 };
 
 /* ============================================================================
@@ -61,11 +78,15 @@ tm_analyzer_t *tm_analyzer_new(tm_config_t *config)
     
     tm_analyzer_t *a = tm_calloc(1, sizeof(tm_analyzer_t));
     a->config = config;
+    pthread_mutex_init(&a->graph_lock, NULL);
+    pthread_mutex_init(&a->symbols_lock, NULL);
     
     /* Create LLM client */
     a->llm = tm_llm_client_new(config);
     if (!a->llm) {
         TM_ERROR("Failed to create LLM client");
+        pthread_mutex_destroy(&a->graph_lock);
+        pthread_mutex_destroy(&a->symbols_lock);
         free(a);
         return NULL;
     }
@@ -75,6 +96,8 @@ tm_analyzer_t *tm_analyzer_new(tm_config_t *config)
     if (!a->formatter) {
         TM_ERROR("Failed to create formatter");
         tm_llm_client_free(a->llm);
+        pthread_mutex_destroy(&a->graph_lock);
+        pthread_mutex_destroy(&a->symbols_lock);
         free(a);
         return NULL;
     }
@@ -86,6 +109,13 @@ void tm_analyzer_free(tm_analyzer_t *analyzer)
 {
     if (!analyzer) return;
     
+    /* A first symbol index build still running is finished, not lost */
+    if (analyzer->symbols_started) pthread_join(analyzer->symbols_thread, NULL);
+    pthread_mutex_destroy(&analyzer->symbols_lock);
+    
+    tm_graph_builder_free(analyzer->graph_builder);
+    pthread_mutex_destroy(&analyzer->graph_lock);
+    
     tm_llm_client_free(analyzer->llm);
     tm_formatter_free(analyzer->formatter);
     free(analyzer);
@@ -221,42 +251,27 @@ static char *read_input(const char *input, size_t *size)
  */
 static char *find_repo_from_trace(tm_stack_trace_t *trace)
 {
+    /* Roots are memoized per directory, so frames sharing one cost nothing */
     for (size_t i = 0; i < trace->frame_count; i++) {
         const char *file = trace->frames[i].file;
         if (!file || file[0] != '/') continue;
         
-        /* Walk up the directory tree looking for .git */
-        char *path = tm_strdup(file);
-        char *slash = strrchr(path, '/');
+        const char *slash = strrchr(file, '/');
+        if (slash == file) continue;
         
-        while (slash && slash != path) {
-            *slash = '\0';
-            
-            char git_dir[PATH_MAX];
-            snprintf(git_dir, sizeof(git_dir), "%s/.git", path);
-            
-            struct stat st;
-            if (stat(git_dir, &st) == 0 && S_ISDIR(st.st_mode)) {
-                TM_DEBUG("Found repo root: %s", path);
-                return path;
-            }
-            
-            slash = strrchr(path, '/');
-        }
-        
-        free(path);
+        char *dir = tm_strndup(file, (size_t)(slash - file));
+        char *root = tm_git_registry_find_root(dir);
+        free(dir);
+        if (root) return root;
     }
     
     /* Try current directory */
     char cwd[PATH_MAX];
     if (getcwd(cwd, sizeof(cwd))) {
-        char git_dir[PATH_MAX];
-        snprintf(git_dir, sizeof(git_dir), "%s/.git", cwd);
-        
-        struct stat st;
-        if (stat(git_dir, &st) == 0) {
-            TM_DEBUG("Using current directory as repo: %s", cwd);
-            return tm_strdup(cwd);
+        char *root = tm_git_registry_find_root(cwd);
+        if (root) {
+            TM_DEBUG("Using current directory's repo: %s", root);
+            return root;
         }
     }
     
@@ -264,73 +279,369 @@ static char *find_repo_from_trace(tm_stack_trace_t *trace)
 }
 
 /* ============================================================================
- * File Collection for AST Analysis
+ * Trace File Resolution
  * ========================================================================== */
 
 /**
- * Collect unique files from stack trace for AST analysis
+ * Join a trace file path onto repo_root (unless absolute) and check that it
+ * exists.
  */
-static char **collect_trace_files(tm_stack_trace_t *trace, 
-                                  const char *repo_root,
-                                  size_t *count)
+static bool resolve_trace_file(const char *file,
+                               const char *repo_root,
+                               char *full_path,
+                               size_t size)
 {
-    if (!trace || trace->frame_count == 0) {
-        *count = 0;
-        return NULL;
+    if (file[0] == '/') {
+        snprintf(full_path, size, "%s", file);
+    } else if (repo_root) {
+        snprintf(full_path, size, "%s/%s", repo_root, file);
+    } else {
+        return false;
     }
     
-    /* Allocate array for unique files */
-    char **files = tm_malloc(trace->frame_count * sizeof(char *));
-    size_t n = 0;
+    struct stat st;
+    return stat(full_path, &st) == 0;
+}
+
+/**
+ * Trace files resolved against the repository, once for both the AST and
+ * git stages.
+ */
+typedef struct {
+    const char **frame_paths;         /* Full path per frame, NULL if missing */
+    char **files;                     /* Distinct existing files, in trace order */
+    size_t file_count;
+} trace_files_t;
+
+static void resolve_trace_files(const tm_stack_trace_t *trace,
+                                const char *repo_root,
+                                trace_files_t *out)
+{
+    *out = (trace_files_t){0};
+    if (!trace || trace->frame_count == 0) return;
+    
+    out->frame_paths = tm_calloc(trace->frame_count, sizeof(char *));
+    out->files = tm_calloc(trace->frame_count, sizeof(char *));
+    
+    /* Frames repeat files: each name is stat'ed once, each path kept once */
+    tm_strmap_t by_name, by_path;
+    tm_strmap_init(&by_name);
+    tm_strmap_init(&by_path);
     
     for (size_t i = 0; i < trace->frame_count; i++) {
         const char *file = trace->frames[i].file;
         if (!file) continue;
         
-        /* Build full path */
-        char full_path[PATH_MAX];
-        if (file[0] == '/') {
-            snprintf(full_path, sizeof(full_path), "%s", file);
-        } else if (repo_root) {
-            snprintf(full_path, sizeof(full_path), "%s/%s", repo_root, file);
-        } else {
-            continue;
+        size_t slot;
+        if (!tm_strmap_get(&by_name, file, &slot)) {
+            char full_path[PATH_MAX];
+            slot = SIZE_MAX;
+            if (resolve_trace_file(file, repo_root, full_path, sizeof(full_path)) &&
+                !tm_strmap_get(&by_path, full_path, &slot)) {
+                slot = out->file_count++;
+                out->files[slot] = tm_strdup(full_path);
+                tm_strmap_put(&by_path, full_path, slot);
+            }
+            tm_strmap_put(&by_name, file, slot);
         }
         
-        /* Check if file exists */
-        struct stat st;
-        if (stat(full_path, &st) != 0) continue;
+        if (slot != SIZE_MAX) out->frame_paths[i] = out->files[slot];
+    }
+    
+    tm_strmap_free(&by_name);
+    tm_strmap_free(&by_path);
+}
+
+static void trace_files_free(trace_files_t *files)
+{
+    for (size_t i = 0; i < files->file_count; i++) {
+        free(files->files[i]);
+    }
+    free(files->files);
+    free(files->frame_paths);
+}
+
+/**
+ * Shallow copy of trace keeping only frames whose files exist under the
+ * repository, in trace order, so blame still sees the top frames. Frame
+ * files are the full paths in files; other frame fields are borrowed.
+ */
+static tm_stack_trace_t collect_repo_frames(const tm_stack_trace_t *trace,
+                                            const trace_files_t *files)
+{
+    tm_stack_trace_t repo_trace = { .language = trace->language };
+    repo_trace.frames = tm_calloc(trace->frame_count ? trace->frame_count : 1,
+                                  sizeof(tm_stack_frame_t));
+    
+    for (size_t i = 0; i < trace->frame_count; i++) {
+        if (!files->frame_paths[i]) continue;
         
-        /* Check for duplicates */
-        bool dup = false;
-        for (size_t j = 0; j < n; j++) {
-            if (strcmp(files[j], full_path) == 0) {
-                dup = true;
-                break;
-            }
+        tm_stack_frame_t *copy = &repo_trace.frames[repo_trace.frame_count++];
+        *copy = trace->frames[i];
+        copy->file = (char *)files->frame_paths[i];
+    }
+    
+    return repo_trace;
+}
+
+/* ============================================================================
+ * Context Stages
+ * ========================================================================== */
+
+/*
+ * Code and git context for one trace. Once the trace files are resolved
+ * the AST and git stages run side by side; git needs the call graph only
+ * to score commits, and waits for it there, so the pair takes about as
+ * long as the slower stage rather than both.
+ */
+typedef struct {
+    tm_analyzer_t *analyzer;
+    const char *repo_path;
+    const tm_stack_trace_t *trace;
+    const trace_files_t *files;
+    const tm_git_collect_opts_t *git_opts;
+    
+    tm_call_graph_t *call_graph;
+    tm_git_context_t *git_ctx;
+    
+    /* Set once the AST stage is done, graph or not */
+    pthread_mutex_t lock;
+    pthread_cond_t graph_built;
+    bool graph_done;
+} context_job_t;
+
+/* Stages in claim order: git may wait on the AST stage, never the reverse */
+enum { STAGE_AST, STAGE_GIT, STAGE_COUNT };
+
+typedef struct {
+    tm_analyzer_t *analyzer;
+    char *repo_path;
+    char *file;
+} symbol_build_t;
+
+static void *symbol_build_main(void *arg)
+{
+    symbol_build_t *build = arg;
+    
+    tm_symbol_index_t *symbols = NULL;
+    if (tm_symbol_index_update(build->repo_path, build->file, 0, &symbols) == TM_OK) {
+        TM_DEBUG("Built symbol index %s", build->file);
+        tm_symbol_index_free(symbols);
+    }
+    
+    pthread_mutex_lock(&build->analyzer->symbols_lock);
+    build->analyzer->symbols_done = true;
+    pthread_mutex_unlock(&build->analyzer->symbols_lock);
+    
+    free(build->repo_path);
+    free(build->file);
+    free(build);
+    return NULL;
+}
+
+/**
+ * Build a missing symbol index on a thread of its own, one build at a
+ * time. A first build parses the whole repository; traces analyzed
+ * meanwhile resolve callees within their own files. False if no thread
+ * could be started.
+ */
+static bool start_symbol_build(tm_analyzer_t *analyzer, const char *repo_path,
+                               const char *file)
+{
+    pthread_mutex_lock(&analyzer->symbols_lock);
+    
+    bool running = analyzer->symbols_started && !analyzer->symbols_done;
+    if (!running) {
+        /* Done threads no longer take the lock, so joining here is safe */
+        if (analyzer->symbols_started) pthread_join(analyzer->symbols_thread, NULL);
+        
+        symbol_build_t *build = tm_calloc(1, sizeof(symbol_build_t));
+        build->analyzer = analyzer;
+        build->repo_path = tm_strdup(repo_path);
+        build->file = tm_strdup(file);
+        
+        analyzer->symbols_done = false;
+        analyzer->symbols_started = pthread_create(&analyzer->symbols_thread, NULL,
+                                                   symbol_build_main, build) == 0;
+        running = analyzer->symbols_started;
+        if (!running) {
+            free(build->repo_path);
+            free(build->file);
+            free(build);
         }
+    }
+    
+    pthread_mutex_unlock(&analyzer->symbols_lock);
+    return running;
+}
+
+/**
+ * The analyzer's graph builder for repo_path, replacing one kept for
+ * another repository. Call with graph_lock held.
+ */
+static tm_graph_builder_t *graph_builder_for(tm_analyzer_t *analyzer, const char *repo_path)
+{
+    tm_graph_builder_t *ast = analyzer->graph_builder;
+    if (ast) {
+        char *root = tm_normalize_path(repo_path);
+        bool same = strcmp(root, ast->repo_path) == 0;
+        free(root);
+        if (same) return ast;
         
-        if (!dup) {
-            files[n++] = tm_strdup(full_path);
+        tm_graph_builder_free(ast);
+        analyzer->graph_builder = NULL;
+    }
+    
+    ast = tm_graph_builder_new(repo_path, analyzer->config->max_call_depth);
+    if (!ast) return NULL;
+    
+    ast->include_stdlib = analyzer->config->include_stdlib;
+    ast->include_tests = analyzer->config->include_tests;
+    
+    if (analyzer->config->ast_cache) {
+        char *ast_cache_dir = tm_config_cache_dir(analyzer->config);
+        if (ast_cache_dir) tm_graph_builder_use_cache(ast, ast_cache_dir);
+        TM_FREE(ast_cache_dir);
+    }
+    
+    analyzer->graph_builder = ast;
+    return ast;
+}
+
+static tm_call_graph_t *build_call_graph(tm_analyzer_t *analyzer,
+                                         const char *repo_path,
+                                         const tm_stack_trace_t *trace,
+                                         const trace_files_t *files)
+{
+    /* Resolve callees across the repository, once it has an index */
+    tm_symbol_index_t *symbols = NULL;
+    if (analyzer->config->symbol_index) {
+        char *cache_dir = tm_config_cache_dir(analyzer->config);
+        char *symbol_file = tm_symbol_index_file(cache_dir, repo_path);
+        if (symbol_file && access(symbol_file, F_OK) != 0 &&
+            start_symbol_build(analyzer, repo_path, symbol_file)) {
+            TM_DEBUG("Building symbol index in the background: %s", symbol_file);
+        } else if (symbol_file) {
+            tm_symbol_index_update(repo_path, symbol_file, 0, &symbols);
         }
+        TM_FREE(symbol_file);
+        TM_FREE(cache_dir);
+    }
+    
+    pthread_mutex_lock(&analyzer->graph_lock);
+    
+    tm_call_graph_t *graph = NULL;
+    tm_graph_builder_t *ast = graph_builder_for(analyzer, repo_path);
+    if (ast) {
+        tm_graph_builder_use_symbols(ast, symbols);
+        
+        TM_DEBUG("Analyzing %zu files", files->file_count);
+        for (size_t i = 0; i < files->file_count; i++) {
+            tm_ast_add_file(ast, files->files[i]);
+        }
+        
+        /* Expand from every frame, starting at the crash location */
+        tm_graph_builder_build(ast, trace, &graph);
+        tm_graph_builder_use_symbols(ast, NULL);
     }
     
-    *count = n;
-    return files;
+    pthread_mutex_unlock(&analyzer->graph_lock);
+    
+    tm_symbol_index_free(symbols);
+    return graph;
+}
+
+static const tm_call_graph_t *wait_call_graph(void *ctx)
+{
+    context_job_t *job = ctx;
+    
+    pthread_mutex_lock(&job->lock);
+    while (!job->graph_done) {
+        pthread_cond_wait(&job->graph_built, &job->lock);
+    }
+    pthread_mutex_unlock(&job->lock);
+    
+    return job->call_graph;
+}
+
+static void context_stage(void *ctx, size_t task, size_t worker)
+{
+    context_job_t *job = ctx;
+    (void)worker;
+    
+    if (task == STAGE_AST) {
+        tm_call_graph_t *graph = build_call_graph(job->analyzer, job->repo_path,
+                                                  job->trace, job->files);
+        
+        pthread_mutex_lock(&job->lock);
+        job->call_graph = graph;
+        job->graph_done = true;
+        pthread_cond_broadcast(&job->graph_built);
+        pthread_mutex_unlock(&job->lock);
+        return;
+    }
+    
+    /* Commits and blame for frames in the repo */
+    tm_stack_trace_t repo_trace = collect_repo_frames(job->trace, job->files);
+    if (repo_trace.frame_count > 0) {
+        tm_git_collect_opts_t git_opts = *job->git_opts;
+        git_opts.wait_call_graph = wait_call_graph;
+        git_opts.wait_call_graph_ctx = job;
+        job->git_ctx = tm_git_collect_context_trace(job->repo_path, &repo_trace, &git_opts);
+    }
+    TM_FREE(repo_trace.frames);
+}
+
+/**
+ * Run the AST and git stages for a stack trace under repo_path, storing
+ * the call graph and git context in result.
+ */
+static void collect_trace_context(tm_analyzer_t *analyzer,
+                                  const char *repo_path,
+                                  const tm_git_collect_opts_t *git_opts,
+                                  tm_analysis_result_t *result)
+{
+    trace_files_t files;
+    resolve_trace_files(result->trace, repo_path, &files);
+    if (files.file_count == 0) {
+        trace_files_free(&files);
+        return;
+    }
+    
+    context_job_t job = {
+        .analyzer = analyzer,
+        .repo_path = repo_path,
+        .trace = result->trace,
+        .files = &files,
+        .git_opts = git_opts
+    };
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.graph_built, NULL);
+    
+    tm_parallel_for(STAGE_COUNT, STAGE_COUNT, context_stage, &job);
+    
+    pthread_cond_destroy(&job.graph_built);
+    pthread_mutex_destroy(&job.lock);
+    trace_files_free(&files);
+    
+    result->call_graph = job.call_graph;
+    result->git_ctx = job.git_ctx;
 }
 
 /* ============================================================================
  * Main Analysis Pipeline
  * ========================================================================== */
 
-tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
+/*
+ * Phases 1-4: parse the input and collect code and git context into result.
+ * On failure sets result->error_message and returns false. Generic logs are
+ * returned through *generic_log (caller frees).
+ */
+static bool collect_context(tm_analyzer_t *analyzer, const char *input,
+                            tm_analysis_result_t *result,
+                            tm_generic_log_t **generic_log_out)
 {
-    if (!analyzer) return NULL;
-    
-    tm_analysis_result_t *result = result_new();
-    gettimeofday(&analyzer->start_time, NULL);
-    
-    TM_INFO("Starting analysis");
+    *generic_log_out = NULL;
     
     /* ========== Phase 1: Parse Input (Format-Agnostic) ========== */
     report_progress(analyzer, "Parsing input", 0.0f);
@@ -341,7 +652,7 @@ tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
         result->error_message = tm_strdup("Failed to read input");
         result->analysis_time_ms = 0;
         TM_ERROR("Failed to read input");
-        return result;
+        return false;
     }
     
     /* Use unified parsing to auto-detect mode */
@@ -350,12 +661,19 @@ tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
     tm_generic_log_t *generic_log = NULL;
     
     tm_error_t parse_err = tm_unified_parse(raw_input, input_size, &mode, &trace, &generic_log);
+    
+    /* The incident bounds the commits worth looking at */
+    int64_t incident_time = analyzer->config->incident_time;
+    if (parse_err == TM_OK && incident_time <= 0) {
+        incident_time = tm_find_incident_time(raw_input, input_size, generic_log);
+        if (incident_time > 0) TM_DEBUG("Incident time from input: %lld", (long long)incident_time);
+    }
     TM_FREE(raw_input);
     
     if (parse_err != TM_OK) {
         result->error_message = tm_strdup("Failed to parse input - not a recognized log format");
         TM_ERROR("Failed to parse input");
-        return result;
+        return false;
     }
     
     /* Store results based on mode */
@@ -380,7 +698,7 @@ tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
         tm_generic_log_free(generic_log);
         result->error_message = tm_strdup("Failed to parse input as stack trace or log");
         TM_ERROR("Failed to parse input");
-        return result;
+        return false;
     }
     
     /* ========== Phase 2: Find Repository ========== */
@@ -400,34 +718,25 @@ tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
         TM_DEBUG("Using repository: %s", repo_path);
     }
     
-    /* ========== Phase 3: Build Call Graph (Stack Trace Mode Only) ========== */
+    /* ========== Phases 3-4: Call Graph and Git Context ========== */
+    char *cache_dir = analyzer->config->history_index || analyzer->config->blame_cache
+        ? tm_config_cache_dir(analyzer->config) : NULL;
+    tm_git_collect_opts_t git_opts = {
+        .max_commits = analyzer->config->max_commits,
+        .cache_dir = cache_dir,
+        .history_index = analyzer->config->history_index,
+        .blame_cache = analyzer->config->blame_cache,
+        .workers = analyzer->config->git_workers,
+        .incident_time = incident_time,
+        .window_hours = analyzer->config->incident_window_hours
+    };
+    
     if (!is_generic_mode && result->trace && result->trace->frame_count > 0) {
-        report_progress(analyzer, "Analyzing code structure", 0.20f);
+        /* Stack trace mode: code structure and history together */
+        report_progress(analyzer, "Analyzing code structure and git history", 0.20f);
         
         if (repo_path) {
-            tm_ast_builder_t *ast = tm_ast_builder_new();
-            if (ast) {
-                /* Collect files from trace */
-                size_t file_count = 0;
-                char **files = collect_trace_files(result->trace, repo_path, &file_count);
-                
-                if (files && file_count > 0) {
-                    TM_DEBUG("Analyzing %zu files", file_count);
-                    
-                    for (size_t i = 0; i < file_count; i++) {
-                        tm_ast_add_file(ast, files[i]);
-                        TM_FREE(files[i]);
-                    }
-                    TM_FREE(files);
-                    
-                    /* Build call graph focused on crash location */
-                    const char *entry = result->trace->frames[0].function;
-                    result->call_graph = tm_ast_build_call_graph(
-                        ast, entry, analyzer->config->max_call_depth);
-                }
-                
-                tm_ast_builder_free(ast);
-            }
+            collect_trace_context(analyzer, repo_path, &git_opts, result);
         }
         
         if (result->call_graph) {
@@ -435,43 +744,20 @@ tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
                     result->call_graph->node_count,
                     result->call_graph->edge_count);
         }
-        
-        report_progress(analyzer, "Code structure analyzed", 0.40f);
     } else {
         report_progress(analyzer, "Skipping code analysis (generic mode)", 0.40f);
-    }
-    
-    /* ========== Phase 4: Collect Git Context ========== */
-    report_progress(analyzer, "Collecting git history", 0.45f);
-    
-    if (repo_path && !is_generic_mode && result->trace) {
-        /* Stack trace mode: collect files involved in trace */
-        size_t file_count = 0;
-        char **files = collect_trace_files(result->trace, repo_path, &file_count);
+        report_progress(analyzer, "Collecting git history", 0.45f);
         
-        if (files && file_count > 0) {
-            /* Convert to const char** */
-            const char **const_files = (const char **)files;
-            
-            result->git_ctx = tm_git_collect_context(
+        /* Generic mode: collect recent commits (no specific files) */
+        if (repo_path) {
+            result->git_ctx = tm_git_collect_context_opts(
                 repo_path,
-                const_files,
-                file_count,
-                analyzer->config->max_commits);
-            
-            for (size_t i = 0; i < file_count; i++) {
-                TM_FREE(files[i]);
-            }
-            TM_FREE(files);
+                NULL,
+                0,
+                &git_opts);
         }
-    } else if (repo_path && is_generic_mode) {
-        /* Generic mode: collect recent commits (no specific files) */
-        result->git_ctx = tm_git_collect_context(
-            repo_path,
-            NULL,
-            0,
-            analyzer->config->max_commits);
     }
+    TM_FREE(cache_dir);
     
     if (result->git_ctx) {
         TM_INFO("Collected %zu commits, %zu blame entries",
@@ -479,13 +765,58 @@ tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
                 result->git_ctx->blame_count);
     }
     
+    /* Code at each in-repo frame, from HEAD where the working copy is dirty */
+    if (repo_path && !is_generic_mode && result->trace &&
+        analyzer->config->source_context_lines > 0) {
+        tm_git_repo_t *repo = NULL;
+        if (result->git_ctx && result->git_ctx->dirty_hunk_count > 0 &&
+            tm_git_registry_acquire(repo_path, &repo) != TM_OK) {
+            repo = NULL;
+        }
+        
+        tm_source_context_opts_t context_opts = {
+            .lines = analyzer->config->source_context_lines,
+            .call_graph = result->call_graph,
+            .repo = repo,
+            .git_ctx = result->git_ctx
+        };
+        size_t filled = tm_source_context_fill(result->trace, repo_path, &context_opts);
+        if (repo) tm_git_registry_release(repo);
+        TM_DEBUG("Source context for %zu frames", filled);
+    }
+    
     report_progress(analyzer, "Git history collected", 0.60f);
     
+    TM_FREE(repo_path);
+    if (!is_generic_mode) {
+        tm_generic_log_free(generic_log);
+        generic_log = NULL;
+    }
+    *generic_log_out = generic_log;
+    return true;
+}
+
+tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
+{
+    if (!analyzer) return NULL;
+    
+    tm_analysis_result_t *result = result_new();
+    gettimeofday(&analyzer->start_time, NULL);
+    
+    TM_INFO("Starting analysis");
+    
+    tm_generic_log_t *generic_log = NULL;
+    if (!collect_context(analyzer, input, result, &generic_log)) {
+        return result;
+    }
+    bool is_generic_mode = generic_log != NULL;
+    
     /* ========== Phase 5: Generate Hypotheses ========== */
     report_progress(analyzer, "Generating hypotheses (LLM)", 0.65f);
     
-    /* Check API key */
-    if (!analyzer->config->api_key || strlen(analyzer->config->api_key) == 0) {
+    /* Check API key (local and loopback endpoints run without one) */
+    if (tm_config_needs_api_key(analyzer->config) &&
+        (!analyzer->config->api_key || strlen(analyzer->config->api_key) == 0)) {
         TM_WARN("No API key configured - skipping LLM analysis");
         result->error_message = tm_strdup("No LLM API key configured");
     } else {
@@ -533,12 +864,144 @@ tm_analysis_result_t *tm_analyze(tm_analyzer_t *analyzer, const char *input)
     TM_INFO("Analysis completed in %d ms", result->analysis_time_ms);
     
     /* Cleanup */
-    TM_FREE(repo_path);
     tm_generic_log_free(generic_log);
     
     return result;
 }
 
+/* ============================================================================
+ * Batch Analysis
+ * ========================================================================== */
+
+/* Stage the hypothesis request for one prepared input */
+static tm_error_t stage_request(tm_analyzer_t *analyzer, tm_batch_t *batch,
+                                const char *custom_id, tm_analysis_result_t *result,
+                                const tm_generic_log_t *generic_log)
+{
+    tm_hypothesis_request_t hr;
+    tm_error_t err = generic_log
+        ? tm_llm_build_generic_hypothesis_request(analyzer->llm, generic_log,
+                                                  result->git_ctx, &hr)
+        : tm_llm_build_hypothesis_request(analyzer->llm, result->trace,
+                                          result->call_graph, result->git_ctx, &hr);
+    
+    if (err == TM_ERR_UNSUPPORTED) {
+        result->error_message = tm_strdup("Log too large for batch mode - analyze it individually");
+        return err;
+    }
+    if (err != TM_OK) return err;
+    
+    err = tm_batch_add(batch, custom_id, &hr.request);
+    tm_hypothesis_request_free(&hr);
+    return err;
+}
+
+tm_error_t tm_analyze_batch(tm_analyzer_t *analyzer,
+                            const char *name,
+                            const char **inputs,
+                            size_t count,
+                            bool wait,
+                            tm_analysis_result_t ***results)
+{
+    TM_CHECK_NULL(analyzer, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(name, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(inputs, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(results, TM_ERR_INVALID_ARG);
+    
+    *results = NULL;
+    if (count == 0 || strchr(name, '/')) return TM_ERR_INVALID_ARG;
+    
+    char *cache_dir = tm_config_cache_dir(analyzer->config);
+    if (!cache_dir) return TM_ERR_IO;
+    
+    tm_strbuf_t dir;
+    tm_strbuf_init(&dir);
+    tm_strbuf_appendf(&dir, "%s/batches/%s", cache_dir, name);
+    TM_FREE(cache_dir);
+    
+    tm_batch_t *batch = tm_batch_open(analyzer->llm, dir.data);
+    tm_strbuf_free(&dir);
+    if (!batch) return TM_ERR_IO;
+    
+    bool staging = batch->status == TM_BATCH_STAGING;
+    tm_analysis_result_t **out = tm_calloc(count, sizeof(tm_analysis_result_t *));
+    char custom_id[32];
+    
+    /* Phases 1-4 per input; a resumed batch only needs the context back */
+    for (size_t i = 0; i < count; i++) {
+        out[i] = result_new();
+        gettimeofday(&analyzer->start_time, NULL);
+        
+        tm_generic_log_t *generic_log = NULL;
+        if (collect_context(analyzer, inputs[i], out[i], &generic_log) && staging) {
+            snprintf(custom_id, sizeof(custom_id), "input-%05zu", i);
+            if (stage_request(analyzer, batch, custom_id, out[i], generic_log) != TM_OK &&
+                !out[i]->error_message) {
+                out[i]->error_message = tm_strdup("Failed to stage batch request");
+            }
+        }
+        tm_generic_log_free(generic_log);
+        
+        gettimeofday(&analyzer->end_time, NULL);
+        out[i]->analysis_time_ms =
+            (analyzer->end_time.tv_sec - analyzer->start_time.tv_sec) * 1000 +
+            (analyzer->end_time.tv_usec - analyzer->start_time.tv_usec) / 1000;
+    }
+    
+    /* ========== Phase 5: Submit, wait, and map results back ========== */
+    tm_error_t err = TM_OK;
+    
+    if (batch->request_count > 0) {
+        report_progress(analyzer, "Submitting batch", 0.65f);
+        err = tm_batch_submit(batch);
+        
+        if (err == TM_OK) {
+            report_progress(analyzer, "Waiting for batch", 0.70f);
+            err = wait
+                ? tm_batch_wait(batch, analyzer->config->batch_poll_ms, 0)
+                : tm_batch_poll(batch);
+            if (err == TM_OK && batch->status == TM_BATCH_SUBMITTED) err = TM_ERR_TIMEOUT;
+            if (err == TM_OK && batch->status == TM_BATCH_FAILED) err = TM_ERR_LLM;
+        }
+        
+        if (err == TM_OK) err = tm_batch_fetch_results(batch);
+    }
+    
+    if (err != TM_OK) {
+        if (err == TM_ERR_TIMEOUT) {
+            TM_INFO("Batch %s still running", batch->batch_id ? batch->batch_id : name);
+        } else {
+            TM_ERROR("Batch analysis failed: %s", tm_strerror(err));
+        }
+        for (size_t i = 0; i < count; i++) tm_result_free(out[i]);
+        free(out);
+        tm_batch_free(batch);
+        return err;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (out[i]->error_message) continue;
+        
+        snprintf(custom_id, sizeof(custom_id), "input-%05zu", i);
+        const tm_batch_result_t *r = tm_batch_get_result(batch, custom_id);
+        
+        if (!r) {
+            out[i]->error_message = tm_strdup("Input is not part of the resumed batch");
+        } else if (!r->response || !r->response->content) {
+            out[i]->error_message = tm_strdup(r->error ? r->error : "LLM analysis failed");
+        } else if (tm_parse_hypotheses(r->response->content, &out[i]->hypotheses,
+                                       &out[i]->hypothesis_count) != TM_OK) {
+            out[i]->error_message = tm_strdup("LLM analysis failed");
+        }
+    }
+    
+    report_progress(analyzer, "Batch complete", 1.0f);
+    
+    tm_batch_free(batch);
+    *results = out;
+    return TM_OK;
+}
+
 /* ============================================================================
  * Result Output
  * ========================================================================== */
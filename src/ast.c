@@ -7,9 +7,13 @@
 
 #include "internal/common.h"
 #include "internal/ast.h"
+#include "internal/ast_cache.h"
 #include "internal/parser.h"
 
 #ifdef HAVE_TREE_SITTER
+#include <ctype.h>
+#include <pthread.h>
+#include <time.h>
 #include <tree_sitter/api.h>
 
 /* External Tree-sitter language declarations */
@@ -34,8 +38,17 @@ tm_error_t tm_ast_init(void)
     return TM_OK;
 }
 
+#ifdef HAVE_TREE_SITTER
+static void release_thread_parsers(void);
+static void release_queries(void);
+#endif
+
 void tm_ast_cleanup(void)
 {
+#ifdef HAVE_TREE_SITTER
+    release_thread_parsers();
+    release_queries();
+#endif
     g_ast_initialized = false;
     TM_DEBUG("AST module cleaned up");
 }
@@ -60,72 +73,252 @@ const TSLanguage *tm_ts_language(tm_language_t lang)
 }
 
 /* ============================================================================
- * Source File Parsing
+ * Per-Thread Parsers
  * ========================================================================== */
 
-tm_error_t tm_parse_source_file(const char *path, tm_source_file_t **result)
+#define AST_LANG_SLOTS (TM_LANG_CPP + 1)
+
+static pthread_key_t g_parser_key;
+static pthread_once_t g_parser_once = PTHREAD_ONCE_INIT;
+
+static void free_parsers(void *ptr)
 {
-    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
+    TSParser **parsers = ptr;
+    for (size_t i = 0; i < AST_LANG_SLOTS; i++) {
+        if (parsers[i]) ts_parser_delete(parsers[i]);
+    }
+    free(parsers);
+}
+
+static void create_parser_key(void)
+{
+    pthread_key_create(&g_parser_key, free_parsers);
+}
+
+/**
+ * The calling thread's parser for lang, created on first use. A parser
+ * holds no per-file state between parses, so one per language suffices.
+ */
+static TSParser *thread_parser(tm_language_t lang, const TSLanguage *ts_lang)
+{
+    pthread_once(&g_parser_once, create_parser_key);
     
-    *result = NULL;
+    TSParser **parsers = pthread_getspecific(g_parser_key);
+    if (!parsers) {
+        parsers = tm_calloc(AST_LANG_SLOTS, sizeof(TSParser *));
+        pthread_setspecific(g_parser_key, parsers);
+    }
+    
+    if (!parsers[lang]) {
+        TSParser *parser = ts_parser_new();
+        if (!ts_parser_set_language(parser, ts_lang)) {
+            ts_parser_delete(parser);
+            return NULL;
+        }
+        parsers[lang] = parser;
+    }
+    return parsers[lang];
+}
+
+static void release_thread_parsers(void)
+{
+    pthread_once(&g_parser_once, create_parser_key);
     
+    TSParser **parsers = pthread_getspecific(g_parser_key);
+    if (parsers) {
+        pthread_setspecific(g_parser_key, NULL);
+        free_parsers(parsers);
+    }
+}
+
+/* ============================================================================
+ * Source File Parsing
+ * ========================================================================== */
+
+/**
+ * Read a source file and detect its language.
+ */
+static tm_error_t read_source(const char *path, char **source, size_t *source_len,
+                              tm_language_t *lang)
+{
     /* Read file content */
-    size_t source_len = 0;
-    char *source = tm_read_file(path, &source_len);
-    if (!source) {
+    *source = tm_read_file(path, source_len);
+    if (!*source) {
         TM_ERROR("Failed to read source file: %s", path);
         return TM_ERR_IO;
     }
     
     /* Detect language */
-    tm_language_t lang = tm_detect_language(path);
-    if (lang == TM_LANG_UNKNOWN) {
+    *lang = tm_detect_language(path);
+    if (*lang == TM_LANG_UNKNOWN) {
         /* Try detecting from content */
-        lang = tm_detect_language(source);
+        *lang = tm_detect_language(*source);
     }
     
-    if (lang == TM_LANG_UNKNOWN) {
+    if (*lang == TM_LANG_UNKNOWN) {
         TM_WARN("Could not detect language for: %s", path);
-        TM_FREE(source);
+        TM_FREE(*source);
         return TM_ERR_UNSUPPORTED;
     }
     
+    return TM_OK;
+}
+
+/**
+ * Parse source with the calling thread's parser for lang.
+ */
+static tm_error_t parse_tree(const char *path, const char *source, size_t source_len,
+                             tm_language_t lang, TSTree **tree)
+{
     /* Get Tree-sitter language */
     const TSLanguage *ts_lang = tm_ts_language(lang);
     if (!ts_lang) {
         TM_ERROR("No Tree-sitter grammar for: %s", tm_language_name(lang));
-        TM_FREE(source);
         return TM_ERR_UNSUPPORTED;
     }
     
-    /* Create parser */
-    TSParser *parser = ts_parser_new();
-    if (!ts_parser_set_language(parser, ts_lang)) {
+    TSParser *parser = thread_parser(lang, ts_lang);
+    if (!parser) {
         TM_ERROR("Failed to set Tree-sitter language");
-        ts_parser_delete(parser);
-        TM_FREE(source);
         return TM_ERR_INTERNAL;
     }
     
     /* Parse source */
-    TSTree *tree = ts_parser_parse_string(parser, NULL, source, (uint32_t)source_len);
-    if (!tree) {
+    *tree = ts_parser_parse_string(parser, NULL, source, (uint32_t)source_len);
+    if (!*tree) {
         TM_ERROR("Tree-sitter parsing failed for: %s", path);
-        ts_parser_delete(parser);
-        TM_FREE(source);
+        ts_parser_reset(parser);
         return TM_ERR_PARSE;
     }
     
-    /* Build result */
+    return TM_OK;
+}
+
+/**
+ * Source file record taking ownership of source and tree (nullable).
+ */
+static tm_source_file_t *new_source_file(const char *path, char *source, size_t source_len,
+                                         tm_language_t lang, TSTree *tree)
+{
     tm_source_file_t *file = tm_calloc(1, sizeof(tm_source_file_t));
     file->path = tm_strdup(path);
     file->source = source;
     file->source_len = source_len;
     file->tree = tree;
-    file->parser = parser;
     file->language = lang;
     
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        file->inode = st.st_ino;
+        file->mtime = st.st_mtim;
+    }
+    
+    return file;
+}
+
+tm_error_t tm_parse_source(const char *path, char *source, size_t source_len,
+                           tm_source_file_t **result)
+{
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(source, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
+    
+    *result = NULL;
+    
+    tm_language_t lang = tm_detect_language(path);
+    if (lang == TM_LANG_UNKNOWN) {
+        lang = tm_detect_language(source);
+    }
+    if (lang == TM_LANG_UNKNOWN) {
+        TM_WARN("Could not detect language for: %s", path);
+        free(source);
+        return TM_ERR_UNSUPPORTED;
+    }
+    
+    TSTree *tree = NULL;
+    tm_error_t err = parse_tree(path, source, source_len, lang, &tree);
+    if (err != TM_OK) {
+        free(source);
+        return err;
+    }
+    
+    /* Build result */
+    tm_source_file_t *file = new_source_file(path, source, source_len, lang, tree);
+    file->functions = tm_function_index_build(file);
+    
+    *result = file;
+    TM_DEBUG("Parsed source file: %s (%zu bytes, %s)", 
+             path, source_len, tm_language_name(lang));
+    
+    return TM_OK;
+}
+
+tm_error_t tm_parse_source_file(const char *path, tm_source_file_t **result)
+{
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
+    
+    *result = NULL;
+    
+    size_t source_len = 0;
+    char *source = tm_read_file(path, &source_len);
+    if (!source) {
+        TM_ERROR("Failed to read source file: %s", path);
+        return TM_ERR_IO;
+    }
+    
+    return tm_parse_source(path, source, source_len, result);
+}
+
+static void summarize_functions(tm_source_file_t *file);
+
+tm_error_t tm_parse_source_file_cached(const char *path,
+                                       const char *summary_dir,
+                                       tm_source_file_t **result)
+{
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
+    
+    if (!summary_dir) return tm_parse_source_file(path, result);
+    
+    *result = NULL;
+    
+    char *source = NULL;
+    size_t source_len = 0;
+    tm_language_t lang = TM_LANG_UNKNOWN;
+    tm_error_t err = read_source(path, &source, &source_len, &lang);
+    if (err != TM_OK) return err;
+    
+    /* Unchanged content: the summary stands in for the tree */
+    char *summary = tm_ast_cache_file(summary_dir, source, source_len);
+    tm_function_index_t *index = NULL;
+    if (tm_ast_cache_read(summary, lang, source, source_len, &index) == TM_OK) {
+        tm_source_file_t *file = new_source_file(path, source, source_len, lang, NULL);
+        file->functions = index;
+        free(summary);
+        
+        *result = file;
+        TM_DEBUG("Loaded source file summary: %s (%zu functions)", path, index->count);
+        return TM_OK;
+    }
+    
+    TSTree *tree = NULL;
+    err = parse_tree(path, source, source_len, lang, &tree);
+    if (err != TM_OK) {
+        TM_FREE(source);
+        free(summary);
+        return err;
+    }
+    
+    tm_source_file_t *file = new_source_file(path, source, source_len, lang, tree);
+    file->functions = tm_function_index_build(file);
+    summarize_functions(file);
+    
+    if (tm_ast_cache_write(summary, lang, source, source_len, file->functions) != TM_OK) {
+        TM_DEBUG("Could not write AST summary for %s", path);
+    }
+    free(summary);
+    
     *result = file;
     TM_DEBUG("Parsed source file: %s (%zu bytes, %s)", 
              path, source_len, tm_language_name(lang));
@@ -137,8 +330,8 @@ void tm_source_file_free(tm_source_file_t *file)
 {
     if (!file) return;
     
+    tm_function_index_free(file->functions);
     if (file->tree) ts_tree_delete(file->tree);
-    if (file->parser) ts_parser_delete(file->parser);
     TM_FREE(file->path);
     TM_FREE(file->source);
     free(file);
@@ -157,10 +350,16 @@ const char *tm_query_function_defs(tm_language_t lang)
                "  parameters: (parameters) @params"
                ") @func";
     case TM_LANG_GO:
-        return "(function_declaration"
-               "  name: (identifier) @name"
-               "  parameters: (parameter_list) @params"
-               ") @func";
+        return "["
+               "  (function_declaration"
+               "    name: (identifier) @name"
+               "    parameters: (parameter_list) @params"
+               "  ) @func"
+               "  (method_declaration"
+               "    name: (field_identifier) @name"
+               "    parameters: (parameter_list) @params"
+               "  ) @func"
+               "]";
     case TM_LANG_NODEJS:
         return "["
                "  (function_declaration"
@@ -203,6 +402,28 @@ const char *tm_query_function_calls(tm_language_t lang)
     }
 }
 
+const char *tm_query_complexity(tm_language_t lang)
+{
+    switch (lang) {
+    case TM_LANG_PYTHON:
+        return "["
+               "  (if_statement) (elif_clause) (for_statement) (while_statement)"
+               "  (try_statement) (except_clause) (conditional_expression)"
+               "] @branch";
+    case TM_LANG_GO:
+        return "["
+               "  (if_statement) (for_statement) \"&&\" \"||\""
+               "] @branch";
+    case TM_LANG_NODEJS:
+        return "["
+               "  (if_statement) (for_statement) (for_in_statement) (while_statement)"
+               "  (try_statement) (switch_statement) (ternary_expression) \"&&\" \"||\""
+               "] @branch";
+    default:
+        return NULL;
+    }
+}
+
 const char *tm_query_imports(tm_language_t lang)
 {
     switch (lang) {
@@ -225,6 +446,135 @@ const char *tm_query_imports(tm_language_t lang)
     }
 }
 
+/* ============================================================================
+ * Compiled Queries
+ * ========================================================================== */
+
+typedef enum {
+    AST_QUERY_FUNCTIONS,
+    AST_QUERY_CALLS,
+    AST_QUERY_COMPLEXITY,
+    AST_QUERY_IMPORTS,
+    AST_QUERY_KINDS
+} ast_query_kind_t;
+
+/**
+ * A query compiled for one language, with its capture ids resolved.
+ * Queries are immutable once built and shared by all threads; each
+ * search runs its own cursor.
+ */
+typedef struct {
+    TSQuery *query;
+    uint32_t node_id;                 /* @func, @call, @branch or @import */
+    uint32_t name_id;                 /* @name (UINT32_MAX if absent) */
+    uint32_t params_id;               /* @params (UINT32_MAX if absent) */
+    bool failed;                      /* Compilation failed; don't retry */
+} ast_query_t;
+
+static ast_query_t g_queries[AST_LANG_SLOTS][AST_QUERY_KINDS];
+static pthread_mutex_t g_query_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t capture_id(const TSQuery *query, const char *name)
+{
+    uint32_t count = ts_query_capture_count(query);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t len = 0;
+        const char *capture = ts_query_capture_name_for_id(query, i, &len);
+        if (len == strlen(name) && strncmp(capture, name, len) == 0) return i;
+    }
+    return UINT32_MAX;
+}
+
+/**
+ * The compiled query of kind for lang, compiling it on first use, or
+ * NULL if the language has no such query.
+ */
+static const ast_query_t *language_query(tm_language_t lang, ast_query_kind_t kind)
+{
+    if ((size_t)lang >= AST_LANG_SLOTS) return NULL;
+    
+    pthread_mutex_lock(&g_query_lock);
+    ast_query_t *q = &g_queries[lang][kind];
+    
+    if (!q->query && !q->failed) {
+        const char *source = kind == AST_QUERY_FUNCTIONS ? tm_query_function_defs(lang)
+                           : kind == AST_QUERY_CALLS ? tm_query_function_calls(lang)
+                           : kind == AST_QUERY_COMPLEXITY ? tm_query_complexity(lang)
+                           : tm_query_imports(lang);
+        const char *node_name = kind == AST_QUERY_FUNCTIONS ? "func"
+                              : kind == AST_QUERY_CALLS ? "call"
+                              : kind == AST_QUERY_COMPLEXITY ? "branch"
+                              : "import";
+        const TSLanguage *ts_lang = tm_ts_language(lang);
+        
+        uint32_t error_offset = 0;
+        TSQueryError error = TSQueryErrorNone;
+        if (source && ts_lang) {
+            q->query = ts_query_new(ts_lang, source, (uint32_t)strlen(source),
+                                    &error_offset, &error);
+        }
+        
+        if (q->query) {
+            q->node_id = capture_id(q->query, node_name);
+            q->name_id = capture_id(q->query, "name");
+            q->params_id = capture_id(q->query, "params");
+        } else {
+            if (source && ts_lang) {
+                TM_WARN("Invalid %s query for %s (error %d at offset %u)",
+                        node_name, tm_language_name(lang), (int)error, error_offset);
+            }
+            q->failed = true;
+        }
+    }
+    
+    pthread_mutex_unlock(&g_query_lock);
+    return q->query ? q : NULL;
+}
+
+static void release_queries(void)
+{
+    pthread_mutex_lock(&g_query_lock);
+    for (size_t lang = 0; lang < AST_LANG_SLOTS; lang++) {
+        for (size_t kind = 0; kind < AST_QUERY_KINDS; kind++) {
+            ast_query_t *q = &g_queries[lang][kind];
+            if (q->query) ts_query_delete(q->query);
+            memset(q, 0, sizeof(*q));
+        }
+    }
+    pthread_mutex_unlock(&g_query_lock);
+}
+
+/**
+ * Cursor over matches of q under node, limited to lines [start_line,
+ * end_line] when start_line > 0 (caller deletes).
+ */
+static TSQueryCursor *query_exec(const ast_query_t *q, TSNode node,
+                                 int start_line, int end_line)
+{
+    TSQueryCursor *cursor = ts_query_cursor_new();
+    if (start_line > 0) {
+        TSPoint start = { (uint32_t)start_line - 1, 0 };
+        TSPoint end = { (uint32_t)end_line, 0 };
+        ts_query_cursor_set_point_range(cursor, start, end);
+    }
+    ts_query_cursor_exec(cursor, q->query, node);
+    return cursor;
+}
+
+/**
+ * Capture id's node in match, if captured.
+ */
+static bool match_capture(const TSQueryMatch *match, uint32_t id, TSNode *node)
+{
+    for (uint16_t i = 0; i < match->capture_count; i++) {
+        if (match->captures[i].index == id) {
+            *node = match->captures[i].node;
+            return true;
+        }
+    }
+    return false;
+}
+
 /* ============================================================================
  * Function Extraction
  * ========================================================================== */
@@ -242,86 +592,80 @@ static char *node_text(const tm_source_file_t *file, TSNode node)
     return tm_strndup(file->source + start, end - start);
 }
 
+static int compare_function_defs(const void *a, const void *b)
+{
+    const tm_function_def_t *x = a, *y = b;
+    if (x->start_line != y->start_line) return x->start_line < y->start_line ? -1 : 1;
+    if (x->start_col != y->start_col) return x->start_col < y->start_col ? -1 : 1;
+    return 0;
+}
+
 /**
- * Recursive function finder using manual traversal.
+ * Collect named function definitions under node overlapping lines
+ * [start_line, end_line] (all when start_line is 0) with the language's
+ * definition query, in document order.
  */
-static void find_functions_recursive(const tm_source_file_t *file,
-                                     TSNode node,
-                                     tm_function_def_t **funcs,
-                                     size_t *count,
-                                     size_t *capacity)
+static void find_functions(const tm_source_file_t *file,
+                           TSNode node,
+                           int start_line,
+                           int end_line,
+                           tm_function_def_t **funcs,
+                           size_t *count,
+                           size_t *capacity)
 {
-    const char *type = ts_node_type(node);
+    const ast_query_t *q = language_query(file->language, AST_QUERY_FUNCTIONS);
+    if (!q) return;
     
-    /* Check if this node is a function definition */
-    bool is_func = false;
-    const char *name_field = "name";
+    TSQueryCursor *cursor = query_exec(q, node, start_line, end_line);
+    TSQueryMatch match;
     
-    switch (file->language) {
-    case TM_LANG_PYTHON:
-        is_func = strcmp(type, "function_definition") == 0;
-        break;
-    case TM_LANG_GO:
-        is_func = strcmp(type, "function_declaration") == 0 ||
-                  strcmp(type, "method_declaration") == 0;
-        break;
-    case TM_LANG_NODEJS:
-        is_func = strcmp(type, "function_declaration") == 0 ||
-                  strcmp(type, "method_definition") == 0;
-        if (strcmp(type, "method_definition") == 0) {
-            name_field = "name";
+    while (ts_query_cursor_next_match(cursor, &match)) {
+        TSNode func_node, name_node, params_node;
+        
+        /* Anonymous functions (arrow functions) have no name to index */
+        if (!match_capture(&match, q->node_id, &func_node) ||
+            !match_capture(&match, q->name_id, &name_node)) {
+            continue;
         }
-        break;
-    default:
-        break;
-    }
-    
-    if (is_func) {
-        TSNode name_node = ts_node_child_by_field_name(node, name_field, strlen(name_field));
         
-        if (!ts_node_is_null(name_node)) {
-            /* Ensure capacity */
-            if (*count >= *capacity) {
-                *capacity = *capacity == 0 ? 16 : *capacity * 2;
-                *funcs = tm_realloc(*funcs, *capacity * sizeof(tm_function_def_t));
-            }
-            
-            tm_function_def_t *func = &(*funcs)[*count];
-            memset(func, 0, sizeof(tm_function_def_t));
-            
-            func->name = node_text(file, name_node);
-            func->qualified_name = tm_strdup(func->name);  /* TODO: Add module prefix */
-            
-            TSPoint start = ts_node_start_point(node);
-            TSPoint end = ts_node_end_point(node);
-            
-            func->start_line = (int)start.row + 1;
-            func->end_line = (int)end.row + 1;
-            func->start_col = (int)start.column;
-            func->end_col = (int)end.column;
-            func->node = node;
-            
-            /* Extract signature */
-            TSNode params_node = ts_node_child_by_field_name(node, "parameters", 10);
-            if (!ts_node_is_null(params_node)) {
-                char *params = node_text(file, params_node);
-                size_t sig_len = strlen(func->name) + (params ? strlen(params) : 2) + 1;
-                func->signature = tm_malloc(sig_len);
-                snprintf(func->signature, sig_len, "%s%s", func->name, params ? params : "()");
-                TM_FREE(params);
-            } else {
-                func->signature = tm_strdup(func->name);
-            }
-            
-            (*count)++;
+        TSPoint start = ts_node_start_point(func_node);
+        TSPoint end = ts_node_end_point(func_node);
+        
+        /* The range admits matches that merely share a capture with it */
+        if (start_line > 0 &&
+            ((int)end.row + 1 < start_line || (int)start.row + 1 > end_line)) {
+            continue;
         }
+        
+        tm_function_def_t func;
+        memset(&func, 0, sizeof(func));
+        
+        func.name = node_text(file, name_node);
+        func.qualified_name = tm_strdup(func.name);  /* TODO: Add module prefix */
+        
+        func.start_line = (int)start.row + 1;
+        func.end_line = (int)end.row + 1;
+        func.start_col = (int)start.column;
+        func.end_col = (int)end.column;
+        func.node = func_node;
+        
+        /* Extract signature */
+        char *params = match_capture(&match, q->params_id, &params_node)
+            ? node_text(file, params_node) : NULL;
+        if (func.name) {
+            size_t sig_len = strlen(func.name) + (params ? strlen(params) : 2) + 1;
+            func.signature = tm_malloc(sig_len);
+            snprintf(func.signature, sig_len, "%s%s", func.name, params ? params : "()");
+        }
+        TM_FREE(params);
+        
+        TM_VEC_PUSH(*funcs, *count, *capacity, func);
     }
     
-    /* Recurse into children */
-    uint32_t child_count = ts_node_child_count(node);
-    for (uint32_t i = 0; i < child_count; i++) {
-        TSNode child = ts_node_child(node, i);
-        find_functions_recursive(file, child, funcs, count, capacity);
+    ts_query_cursor_delete(cursor);
+    
+    if (*count > 1) {
+        qsort(*funcs, *count, sizeof(tm_function_def_t), compare_function_defs);
     }
 }
 
@@ -337,8 +681,25 @@ tm_error_t tm_extract_functions(const tm_source_file_t *file,
     *count = 0;
     size_t capacity = 0;
     
+    /* Files loaded from a summary have only their index */
+    if (!file->tree) {
+        if (!file->functions) return TM_ERR_INVALID_ARG;
+        
+        *funcs = tm_calloc(file->functions->count ? file->functions->count : 1,
+                           sizeof(tm_function_def_t));
+        for (size_t i = 0; i < file->functions->count; i++) {
+            const tm_function_def_t *func = &file->functions->funcs[i];
+            (*funcs)[i] = *func;
+            (*funcs)[i].name = tm_strdup(func->name);
+            (*funcs)[i].qualified_name = tm_strdup(func->qualified_name);
+            (*funcs)[i].signature = tm_strdup(func->signature);
+        }
+        *count = file->functions->count;
+        return TM_OK;
+    }
+    
     TSNode root = ts_tree_root_node(file->tree);
-    find_functions_recursive(file, root, funcs, count, &capacity);
+    find_functions(file, root, 0, 0, funcs, count, &capacity);
     
     TM_DEBUG("Extracted %zu functions from %s", *count, file->path);
     return TM_OK;
@@ -356,6 +717,19 @@ void tm_functions_free(tm_function_def_t *funcs, size_t count)
     free(funcs);
 }
 
+/**
+ * Heap copy of a definition for the tm_find_function* API.
+ */
+static tm_function_def_t *function_def_copy(const tm_function_def_t *func)
+{
+    tm_function_def_t *copy = tm_malloc(sizeof(tm_function_def_t));
+    *copy = *func;
+    copy->name = tm_strdup(func->name);
+    copy->qualified_name = tm_strdup(func->qualified_name);
+    copy->signature = tm_strdup(func->signature);
+    return copy;
+}
+
 tm_error_t tm_find_function(const tm_source_file_t *file,
                             const char *name,
                             tm_function_def_t **result)
@@ -364,38 +738,9 @@ tm_error_t tm_find_function(const tm_source_file_t *file,
     TM_CHECK_NULL(name, TM_ERR_INVALID_ARG);
     TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
     
-    *result = NULL;
-    
-    tm_function_def_t *funcs = NULL;
-    size_t count = 0;
-    
-    tm_error_t err = tm_extract_functions(file, &funcs, &count);
-    if (err != TM_OK) return err;
-    
-    for (size_t i = 0; i < count; i++) {
-        if (strcmp(funcs[i].name, name) == 0) {
-            /* Copy the found function */
-            *result = tm_malloc(sizeof(tm_function_def_t));
-            **result = funcs[i];
-            (*result)->name = tm_strdup(funcs[i].name);
-            (*result)->qualified_name = tm_strdup(funcs[i].qualified_name);
-            (*result)->signature = tm_strdup(funcs[i].signature);
-            
-            /* Free the rest */
-            for (size_t j = 0; j < count; j++) {
-                if (j != i) {
-                    TM_FREE(funcs[j].name);
-                    TM_FREE(funcs[j].qualified_name);
-                    TM_FREE(funcs[j].signature);
-                }
-            }
-            free(funcs);
-            return TM_OK;
-        }
-    }
-    
-    tm_functions_free(funcs, count);
-    return TM_ERR_NOT_FOUND;
+    const tm_function_def_t *func = tm_lookup_function(file, name);
+    *result = func ? function_def_copy(func) : NULL;
+    return func ? TM_OK : TM_ERR_NOT_FOUND;
 }
 
 tm_error_t tm_find_function_at_line(const tm_source_file_t *file,
@@ -405,44 +750,19 @@ tm_error_t tm_find_function_at_line(const tm_source_file_t *file,
     TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
     TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
     
-    *result = NULL;
-    
-    tm_function_def_t *funcs = NULL;
-    size_t count = 0;
-    
-    tm_error_t err = tm_extract_functions(file, &funcs, &count);
-    if (err != TM_OK) return err;
-    
-    /* Find the innermost function containing the line */
-    tm_function_def_t *best = NULL;
-    int best_span = INT_MAX;
-    
-    for (size_t i = 0; i < count; i++) {
-        if (line >= funcs[i].start_line && line <= funcs[i].end_line) {
-            int span = funcs[i].end_line - funcs[i].start_line;
-            if (span < best_span) {
-                best = &funcs[i];
-                best_span = span;
-            }
-        }
-    }
-    
-    if (best) {
-        *result = tm_malloc(sizeof(tm_function_def_t));
-        **result = *best;
-        (*result)->name = tm_strdup(best->name);
-        (*result)->qualified_name = tm_strdup(best->qualified_name);
-        (*result)->signature = tm_strdup(best->signature);
-    }
-    
-    tm_functions_free(funcs, count);
-    return best ? TM_OK : TM_ERR_NOT_FOUND;
+    const tm_function_def_t *func = tm_lookup_function_at_line(file, line);
+    *result = func ? function_def_copy(func) : NULL;
+    return func ? TM_OK : TM_ERR_NOT_FOUND;
 }
 
 /* ============================================================================
  * Call Site Extraction
  * ========================================================================== */
 
+/**
+ * Collect calls starting on lines [start_line, end_line] with the
+ * language's call query.
+ */
 static void find_calls_in_range(const tm_source_file_t *file,
                                 TSNode node,
                                 int start_line,
@@ -451,76 +771,37 @@ static void find_calls_in_range(const tm_source_file_t *file,
                                 size_t *count,
                                 size_t *capacity)
 {
-    TSPoint point = ts_node_start_point(node);
-    int line = (int)point.row + 1;
-    
-    /* Skip nodes outside our range */
-    if (line < start_line) {
-        TSPoint end_point = ts_node_end_point(node);
-        if ((int)end_point.row + 1 < start_line) return;
-    }
-    if (line > end_line) return;
-    
-    const char *type = ts_node_type(node);
+    const ast_query_t *q = language_query(file->language, AST_QUERY_CALLS);
+    if (!q) return;
     
-    /* Check for call expression */
-    bool is_call = false;
-    switch (file->language) {
-    case TM_LANG_PYTHON:
-        is_call = strcmp(type, "call") == 0;
-        break;
-    case TM_LANG_GO:
-    case TM_LANG_NODEJS:
-        is_call = strcmp(type, "call_expression") == 0;
-        break;
-    default:
-        break;
-    }
+    TSQueryCursor *cursor = query_exec(q, node, start_line, end_line);
+    TSQueryMatch match;
     
-    if (is_call && line >= start_line && line <= end_line) {
-        TSNode func_node = ts_node_child_by_field_name(node, "function", 8);
-        if (!ts_node_is_null(func_node)) {
-            /* Get the actual function name */
-            const char *func_type = ts_node_type(func_node);
-            char *callee_name = NULL;
-            
-            if (strcmp(func_type, "identifier") == 0) {
-                callee_name = node_text(file, func_node);
-            } else if (strcmp(func_type, "attribute") == 0 ||
-                       strcmp(func_type, "member_expression") == 0 ||
-                       strcmp(func_type, "selector_expression") == 0) {
-                /* Get the last part (method name) */
-                uint32_t child_count = ts_node_child_count(func_node);
-                if (child_count > 0) {
-                    TSNode last = ts_node_child(func_node, child_count - 1);
-                    callee_name = node_text(file, last);
-                }
-            }
-            
-            if (callee_name) {
-                /* Ensure capacity */
-                if (*count >= *capacity) {
-                    *capacity = *capacity == 0 ? 16 : *capacity * 2;
-                    *sites = tm_realloc(*sites, *capacity * sizeof(tm_call_site_t));
-                }
-                
-                tm_call_site_t *site = &(*sites)[*count];
-                site->callee_name = callee_name;
-                site->line = line;
-                site->column = (int)point.column;
-                site->node = node;
-                
-                (*count)++;
-            }
+    while (ts_query_cursor_next_match(cursor, &match)) {
+        TSNode call_node, name_node;
+        if (!match_capture(&match, q->node_id, &call_node) ||
+            !match_capture(&match, q->name_id, &name_node)) {
+            continue;
         }
+        
+        /* The range admits calls that merely overlap it */
+        TSPoint point = ts_node_start_point(call_node);
+        int line = (int)point.row + 1;
+        if (line < start_line || line > end_line) continue;
+        
+        char *callee_name = node_text(file, name_node);
+        if (!callee_name) continue;
+        
+        tm_call_site_t site = {
+            .callee_name = callee_name,
+            .line = line,
+            .column = (int)point.column,
+            .node = call_node
+        };
+        TM_VEC_PUSH(*sites, *count, *capacity, site);
     }
     
-    /* Recurse */
-    uint32_t child_count = ts_node_child_count(node);
-    for (uint32_t i = 0; i < child_count; i++) {
-        TSNode child = ts_node_child(node, i);
-        find_calls_in_range(file, child, start_line, end_line, sites, count, capacity);
-    }
+    ts_query_cursor_delete(cursor);
 }
 
 tm_error_t tm_extract_call_sites(const tm_source_file_t *file,
@@ -537,6 +818,26 @@ tm_error_t tm_extract_call_sites(const tm_source_file_t *file,
     *count = 0;
     size_t capacity = 0;
     
+    const tm_function_index_t *index = file->functions;
+    if (index && index->summarized) {
+        /* Calls are in line order: find the function's first line */
+        size_t lo = 0, hi = index->call_count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (index->calls[mid].line < func->start_line) lo = mid + 1;
+            else hi = mid;
+        }
+        
+        for (size_t i = lo; i < index->call_count && index->calls[i].line <= func->end_line; i++) {
+            tm_call_site_t site = index->calls[i];
+            site.callee_name = tm_strdup(site.callee_name);
+            TM_VEC_PUSH(*sites, *count, capacity, site);
+        }
+        return TM_OK;
+    }
+    
+    if (!file->tree) return TM_ERR_INVALID_ARG;
+    
     TSNode root = ts_tree_root_node(file->tree);
     find_calls_in_range(file, root, func->start_line, func->end_line,
                         sites, count, &capacity);
@@ -555,6 +856,87 @@ void tm_call_sites_free(tm_call_site_t *sites, size_t count)
     free(sites);
 }
 
+/* ============================================================================
+ * Import Extraction
+ * ========================================================================== */
+
+#define IMPORT_TEXT_MAX 256
+
+/* Collapse whitespace runs (multi-line import lists) to single spaces */
+static char *collapse_whitespace(char *text)
+{
+    size_t out = 0;
+    bool space = false;
+    for (const char *p = text; *p && out < IMPORT_TEXT_MAX; p++) {
+        if (isspace((unsigned char)*p)) {
+            space = out > 0;
+            continue;
+        }
+        if (space) text[out++] = ' ';
+        space = false;
+        text[out++] = *p;
+    }
+    text[out] = '\0';
+    return text;
+}
+
+tm_error_t tm_extract_imports(const tm_source_file_t *file,
+                              tm_import_t **imports,
+                              size_t *count)
+{
+    TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(imports, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    
+    *imports = NULL;
+    *count = 0;
+    if (!file->tree) return TM_ERR_INVALID_ARG;
+    
+    const ast_query_t *q = language_query(file->language, AST_QUERY_IMPORTS);
+    if (!q) return TM_OK;
+    
+    /* Cursors don't evaluate text predicates: check require() by hand */
+    uint32_t func_id = capture_id(q->query, "func");
+    
+    size_t capacity = 0;
+    TSQueryCursor *cursor = query_exec(q, ts_tree_root_node(file->tree), 0, 0);
+    TSQueryMatch match;
+    
+    while (ts_query_cursor_next_match(cursor, &match)) {
+        TSNode import_node, func_node;
+        if (!match_capture(&match, q->node_id, &import_node)) continue;
+        
+        if (match_capture(&match, func_id, &func_node)) {
+            char *func = node_text(file, func_node);
+            bool is_require = func && strcmp(func, "require") == 0;
+            free(func);
+            if (!is_require) continue;
+        }
+        
+        char *text = node_text(file, import_node);
+        if (!text) continue;
+        
+        tm_import_t import = {
+            .text = collapse_whitespace(text),
+            .line = (int)ts_node_start_point(import_node).row + 1
+        };
+        TM_VEC_PUSH(*imports, *count, capacity, import);
+    }
+    
+    ts_query_cursor_delete(cursor);
+    return TM_OK;
+}
+
+void tm_imports_free(tm_import_t *imports, size_t count)
+{
+    if (!imports) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        TM_FREE(imports[i].text);
+    }
+    free(imports);
+}
+
 /* ============================================================================
  * Call Graph Builder
  * ========================================================================== */
@@ -563,11 +945,15 @@ tm_graph_builder_t *tm_graph_builder_new(const char *repo_path, int max_depth)
 {
     tm_graph_builder_t *builder = tm_calloc(1, sizeof(tm_graph_builder_t));
     
-    builder->repo_path = tm_strdup(repo_path);
+    /* Canonical, like cached file paths, so nodes get repo-relative paths */
+    builder->repo_path = tm_normalize_path(repo_path);
     builder->files = NULL;
     builder->file_count = 0;
     builder->file_capacity = 0;
+    tm_strmap_init(&builder->file_index);
     builder->max_depth = max_depth > 0 ? max_depth : 5;
+    builder->max_nodes_per_depth = TM_GRAPH_MAX_NODES_PER_DEPTH;
+    builder->time_budget_ms = TM_GRAPH_TIME_BUDGET_MS;
     builder->include_stdlib = false;
     builder->include_tests = false;
     
@@ -582,10 +968,39 @@ void tm_graph_builder_free(tm_graph_builder_t *builder)
         tm_source_file_free(builder->files[i]);
     }
     TM_FREE(builder->files);
+    TM_FREE(builder->file_build);
+    tm_strmap_free(&builder->file_index);
+    TM_FREE(builder->summary_dir);
     TM_FREE(builder->repo_path);
     free(builder);
 }
 
+tm_error_t tm_graph_builder_use_cache(tm_graph_builder_t *builder, const char *cache_dir)
+{
+    TM_CHECK_NULL(builder, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(cache_dir, TM_ERR_INVALID_ARG);
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/ast", cache_dir);
+    
+    tm_error_t err = tm_mkdir_p(sb.data);
+    if (err != TM_OK) {
+        tm_strbuf_free(&sb);
+        return err;
+    }
+    
+    TM_FREE(builder->summary_dir);
+    builder->summary_dir = tm_strbuf_finish(&sb);
+    return TM_OK;
+}
+
+void tm_graph_builder_use_symbols(tm_graph_builder_t *builder,
+                                  const tm_symbol_index_t *symbols)
+{
+    if (builder) builder->symbols = symbols;
+}
+
 tm_error_t tm_graph_builder_get_file(tm_graph_builder_t *builder,
                                      const char *path,
                                      tm_source_file_t **file)
@@ -594,26 +1009,71 @@ tm_error_t tm_graph_builder_get_file(tm_graph_builder_t *builder,
     TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
     TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
     
-    /* Check cache */
-    for (size_t i = 0; i < builder->file_count; i++) {
-        if (strcmp(builder->files[i]->path, path) == 0) {
-            *file = builder->files[i];
+    *file = NULL;
+    
+    char *key = tm_normalize_path(path);
+    size_t slot;
+    bool cached = tm_strmap_get(&builder->file_index, key, &slot);
+    
+    /* Checked by this build: expansion points into its definitions */
+    if (cached && builder->build_id && builder->file_build[slot] == builder->build_id) {
+        free(key);
+        *file = builder->files[slot];
+        return TM_OK;
+    }
+    
+    struct stat st;
+    bool exists = stat(key, &st) == 0;
+    
+    /* Check cache; entries whose file changed on disk are reparsed */
+    if (cached && exists) {
+        tm_source_file_t *hit = builder->files[slot];
+        if (hit->inode == st.st_ino &&
+            hit->mtime.tv_sec == st.st_mtim.tv_sec &&
+            hit->mtime.tv_nsec == st.st_mtim.tv_nsec) {
+            free(key);
+            builder->file_build[slot] = builder->build_id;
+            *file = hit;
             return TM_OK;
         }
     }
     
+    /* Edited files with a tree are reparsed incrementally, in place */
+    if (cached && exists && tm_source_file_update(builder->files[slot],
+                                                  builder->summary_dir) == TM_OK) {
+        free(key);
+        builder->file_build[slot] = builder->build_id;
+        *file = builder->files[slot];
+        return TM_OK;
+    }
+    
     /* Parse new file */
     tm_source_file_t *new_file = NULL;
-    tm_error_t err = tm_parse_source_file(path, &new_file);
-    if (err != TM_OK) return err;
+    tm_error_t err = tm_parse_source_file_cached(key, builder->summary_dir, &new_file);
+    if (err != TM_OK) {
+        free(key);
+        return err;
+    }
     
-    /* Add to cache */
-    if (builder->file_count >= builder->file_capacity) {
-        builder->file_capacity = builder->file_capacity == 0 ? 8 : builder->file_capacity * 2;
-        builder->files = tm_realloc(builder->files, 
-                                    builder->file_capacity * sizeof(tm_source_file_t *));
+    if (cached) {
+        TM_DEBUG("Reparsed modified file: %s", key);
+        tm_source_file_free(builder->files[slot]);
+        builder->files[slot] = new_file;
+    } else {
+        /* Add to cache */
+        if (builder->file_count >= builder->file_capacity) {
+            builder->file_capacity = builder->file_capacity == 0 ? 8 : builder->file_capacity * 2;
+            builder->files = tm_realloc(builder->files, 
+                                        builder->file_capacity * sizeof(tm_source_file_t *));
+            builder->file_build = tm_realloc(builder->file_build,
+                                             builder->file_capacity * sizeof(uint64_t));
+        }
+        slot = builder->file_count++;
+        tm_strmap_put(&builder->file_index, key, slot);
+        builder->files[slot] = new_file;
     }
-    builder->files[builder->file_count++] = new_file;
+    builder->file_build[slot] = builder->build_id;
+    free(key);
     
     *file = new_file;
     return TM_OK;
@@ -656,6 +1116,16 @@ void tm_call_node_free(tm_call_node_t *node)
     free(node);
 }
 
+/* Append to an edge list grown in powers of two, so the count alone
+ * tells when it is full */
+static void edge_list_push(tm_call_node_t ***list, size_t *count, tm_call_node_t *node)
+{
+    if ((*count & (*count - 1)) == 0) {
+        *list = tm_realloc(*list, (*count ? *count * 2 : 1) * sizeof(tm_call_node_t *));
+    }
+    (*list)[(*count)++] = node;
+}
+
 tm_error_t tm_call_node_add_caller(tm_call_node_t *node, tm_call_node_t *caller)
 {
     TM_CHECK_NULL(node, TM_ERR_INVALID_ARG);
@@ -666,10 +1136,7 @@ tm_error_t tm_call_node_add_caller(tm_call_node_t *node, tm_call_node_t *caller)
         if (node->callers[i] == caller) return TM_OK;
     }
     
-    size_t new_count = node->caller_count + 1;
-    node->callers = tm_realloc(node->callers, new_count * sizeof(tm_call_node_t *));
-    node->callers[node->caller_count++] = caller;
-    
+    edge_list_push(&node->callers, &node->caller_count, caller);
     return TM_OK;
 }
 
@@ -683,10 +1150,7 @@ tm_error_t tm_call_node_add_callee(tm_call_node_t *node, tm_call_node_t *callee)
         if (node->callees[i] == callee) return TM_OK;
     }
     
-    size_t new_count = node->callee_count + 1;
-    node->callees = tm_realloc(node->callees, new_count * sizeof(tm_call_node_t *));
-    node->callees[node->callee_count++] = callee;
-    
+    edge_list_push(&node->callees, &node->callee_count, callee);
     return TM_OK;
 }
 
@@ -698,13 +1162,432 @@ void tm_call_graph_free(tm_call_graph_t *graph)
 {
     if (!graph) return;
     
-    for (size_t i = 0; i < graph->node_count; i++) {
+    /* Built graphs keep nodes and strings in one block each */
+    for (size_t i = 0; !graph->node_block && i < graph->node_count; i++) {
+        /* Edge lists point into the shared adjacency array */
+        if (graph->adjacency) {
+            graph->nodes[i]->callers = NULL;
+            graph->nodes[i]->callees = NULL;
+        }
         tm_call_node_free(graph->nodes[i]);
     }
+    TM_FREE(graph->node_block);
+    TM_FREE(graph->strings);
     TM_FREE(graph->nodes);
+    TM_FREE(graph->adjacency);
     free(graph);
 }
 
+/* Offset of an absent string */
+#define NO_STRING SIZE_MAX
+
+/**
+ * Expansion state for one node, and the node itself until the graph is
+ * laid out. Strings are offsets into the expansion's string table.
+ */
+typedef struct {
+    const tm_source_file_t *file;
+    const tm_function_def_t *func;
+    int depth;
+    size_t name;
+    size_t path;
+    size_t signature;
+    int start_line;
+    int end_line;
+    uint32_t complexity;
+} expand_item_t;
+
+/**
+ * A definition in a loaded file, for resolving callees across files.
+ */
+typedef struct {
+    const tm_source_file_t *file;
+    const tm_function_def_t *func;
+} expand_symbol_t;
+
+typedef struct {
+    size_t caller;
+    size_t callee;
+} expand_edge_t;
+
+typedef struct {
+    tm_graph_builder_t *builder;
+    expand_item_t *items;             /* By node index; doubles as the queue */
+    size_t node_count;
+    size_t item_capacity;
+    size_t entry;                     /* Entry point node, or SIZE_MAX */
+    tm_strmap_t node_ids;             /* "path:line:col" -> node index */
+    tm_strbuf_t strings;              /* Interned node strings */
+    tm_strmap_t string_ids;           /* String -> offset in strings */
+    expand_symbol_t *symbols;
+    size_t symbol_count;
+    size_t symbol_capacity;
+    tm_strmap_t symbol_ids;           /* Function name -> symbols index */
+    expand_edge_t *edges;             /* By node index, in discovery order */
+    size_t edge_count;
+    size_t edge_capacity;
+    uint64_t *edge_set;               /* Open addressing; caller:callee + 1, 0 = empty */
+    size_t edge_set_capacity;
+    size_t *depth_nodes;              /* Nodes added at each depth */
+    int max_depth;
+} expand_t;
+
+static void expand_init(expand_t *ex, tm_graph_builder_t *builder, int max_depth)
+{
+    memset(ex, 0, sizeof(*ex));
+    ex->builder = builder;
+    ex->entry = SIZE_MAX;
+    ex->max_depth = max_depth > 0 ? max_depth : builder->max_depth;
+    ex->depth_nodes = tm_calloc((size_t)ex->max_depth + 1, sizeof(size_t));
+    tm_strmap_init(&ex->node_ids);
+    tm_strbuf_init(&ex->strings);
+    tm_strmap_init(&ex->string_ids);
+    tm_strmap_init(&ex->symbol_ids);
+    
+    /* First definition of each name across loaded files, in load order */
+    for (size_t i = 0; i < builder->file_count; i++) {
+        const tm_source_file_t *file = builder->files[i];
+        if (!file->functions) continue;
+        
+        for (size_t j = 0; j < file->functions->count; j++) {
+            const tm_function_def_t *func = &file->functions->funcs[j];
+            if (!func->name || tm_strmap_get(&ex->symbol_ids, func->name, NULL)) continue;
+            
+            expand_symbol_t symbol = { file, func };
+            tm_strmap_put(&ex->symbol_ids, func->name, ex->symbol_count);
+            TM_VEC_PUSH(ex->symbols, ex->symbol_count, ex->symbol_capacity, symbol);
+        }
+    }
+}
+
+static void expand_free(expand_t *ex)
+{
+    TM_FREE(ex->items);
+    TM_FREE(ex->symbols);
+    TM_FREE(ex->edges);
+    TM_FREE(ex->edge_set);
+    TM_FREE(ex->depth_nodes);
+    tm_strmap_free(&ex->node_ids);
+    tm_strbuf_free(&ex->strings);
+    tm_strmap_free(&ex->string_ids);
+    tm_strmap_free(&ex->symbol_ids);
+}
+
+/* Offset of s in the string table, adding it on first use; file paths
+ * and signatures repeat across nodes */
+static size_t expand_string(expand_t *ex, const char *s)
+{
+    if (!s) return NO_STRING;
+    
+    size_t offset;
+    if (tm_strmap_get(&ex->string_ids, s, &offset)) return offset;
+    
+    offset = ex->strings.len;
+    tm_strbuf_append_len(&ex->strings, s, strlen(s) + 1);
+    tm_strmap_put(&ex->string_ids, s, offset);
+    return offset;
+}
+
+/**
+ * Node for func, adding it at depth unless that depth's node budget is
+ * spent. Returns the node index, or SIZE_MAX.
+ */
+static size_t expand_node(expand_t *ex,
+                          const tm_source_file_t *file,
+                          const tm_function_def_t *func,
+                          int depth,
+                          const char *display_path)
+{
+    char key[PATH_MAX + 32];
+    snprintf(key, sizeof(key), "%s:%d:%d", file->path, func->start_line, func->start_col);
+    
+    size_t id;
+    if (tm_strmap_get(&ex->node_ids, key, &id)) return id;
+    
+    if (depth > 0 && ex->depth_nodes[depth] >= ex->builder->max_nodes_per_depth) {
+        return SIZE_MAX;
+    }
+    
+    char *relative = display_path ? NULL : tm_relative_path(ex->builder->repo_path, file->path);
+    expand_item_t item = {
+        .file = file,
+        .func = func,
+        .depth = depth,
+        .name = expand_string(ex, func->name),
+        .path = expand_string(ex, display_path ? display_path : relative),
+        .signature = expand_string(ex, func->signature),
+        .start_line = func->start_line,
+        .end_line = func->end_line,
+        .complexity = tm_compute_complexity(file, func)
+    };
+    TM_FREE(relative);
+    
+    id = ex->node_count;
+    TM_VEC_PUSH(ex->items, ex->node_count, ex->item_capacity, item);
+    
+    tm_strmap_put(&ex->node_ids, key, id);
+    ex->depth_nodes[depth]++;
+    return id;
+}
+
+/* Add key to the edge set unless present; false if it was */
+static bool edge_set_insert(uint64_t *set, size_t capacity, uint64_t key)
+{
+    size_t mask = capacity - 1;
+    size_t i = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (set[i]) {
+        if (set[i] == key) return false;
+        i = (i + 1) & mask;
+    }
+    set[i] = key;
+    return true;
+}
+
+static void expand_edge(expand_t *ex, size_t caller, size_t callee)
+{
+    /* Keep load factor at most 0.5 */
+    if ((ex->edge_count + 1) * 2 > ex->edge_set_capacity) {
+        size_t capacity = ex->edge_set_capacity ? ex->edge_set_capacity * 2 : 64;
+        uint64_t *set = tm_calloc(capacity, sizeof(uint64_t));
+        for (size_t i = 0; i < ex->edge_set_capacity; i++) {
+            if (ex->edge_set[i]) edge_set_insert(set, capacity, ex->edge_set[i]);
+        }
+        free(ex->edge_set);
+        ex->edge_set = set;
+        ex->edge_set_capacity = capacity;
+    }
+    
+    uint64_t key = ((uint64_t)caller << 32 | (uint64_t)callee) + 1;
+    if (!edge_set_insert(ex->edge_set, ex->edge_set_capacity, key)) return;
+    
+    expand_edge_t edge = { caller, callee };
+    TM_VEC_PUSH(ex->edges, ex->edge_count, ex->edge_capacity, edge);
+}
+
+/**
+ * Definition called as name from file: the file's own definition, else
+ * the first one in any loaded file.
+ */
+/**
+ * Definition of name in a file outside the loaded set, found through the
+ * symbol index and loaded on demand. Exported definitions win over
+ * module-private ones.
+ */
+static bool resolve_indexed(expand_t *ex, const char *name, expand_symbol_t *def)
+{
+    const tm_symbol_index_t *symbols = ex->builder->symbols;
+    if (!symbols || !ex->builder->repo_path) return false;
+    
+    size_t count = 0;
+    const uint32_t *ids = tm_symbol_index_lookup(symbols, name, &count);
+    const tm_symbol_t *best = NULL;
+    
+    for (size_t i = 0; i < count; i++) {
+        const tm_symbol_t *sym = &symbols->symbols[ids[i]];
+        if (!(sym->kind & TM_SYMBOL_DEFINITION)) continue;
+        if (!best || ((sym->kind & TM_SYMBOL_EXPORTED) && !(best->kind & TM_SYMBOL_EXPORTED))) {
+            best = sym;
+        }
+    }
+    if (!best) return false;
+    
+    const tm_symbol_file_t *entry = &symbols->files[best->file];
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", ex->builder->repo_path,
+             tm_symbol_index_string(symbols, entry->path_offset));
+    
+    tm_source_file_t *file = NULL;
+    if (tm_graph_builder_get_file(ex->builder, path, &file) != TM_OK) return false;
+    
+    /* The index may be older than the file: fall back to the name */
+    const tm_function_def_t *func = tm_lookup_function_at_line(file, best->start_line);
+    if (!func || !func->name || strcmp(func->name, name) != 0) {
+        func = tm_lookup_function(file, name);
+    }
+    if (!func) return false;
+    
+    expand_symbol_t symbol = { file, func };
+    tm_strmap_put(&ex->symbol_ids, name, ex->symbol_count);
+    TM_VEC_PUSH(ex->symbols, ex->symbol_count, ex->symbol_capacity, symbol);
+    
+    *def = symbol;
+    return true;
+}
+
+static bool resolve_callee(expand_t *ex,
+                           const tm_source_file_t *file,
+                           const char *name,
+                           expand_symbol_t *def)
+{
+    const tm_function_def_t *local = tm_lookup_function(file, name);
+    if (local) {
+        def->file = file;
+        def->func = local;
+        return true;
+    }
+    
+    size_t i;
+    if (tm_strmap_get(&ex->symbol_ids, name, &i)) {
+        *def = ex->symbols[i];
+        return true;
+    }
+    return resolve_indexed(ex, name, def);
+}
+
+static int64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Breadth-first expansion of callees from the seeded nodes, up to the
+ * maximum depth and within the builder's node and time budgets. Nodes
+ * are appended to the items, so they double as the queue.
+ */
+static void expand_run(expand_t *ex)
+{
+    int64_t deadline = monotonic_ms() + ex->builder->time_budget_ms;
+    
+    for (size_t head = 0; head < ex->node_count; head++) {
+        expand_item_t item = ex->items[head];
+        if (item.depth >= ex->max_depth) continue;
+        
+        if (ex->builder->time_budget_ms > 0 && monotonic_ms() > deadline) {
+            TM_DEBUG("Call graph expansion stopped at time budget (%zu nodes)",
+                     ex->node_count);
+            break;
+        }
+        
+        tm_call_site_t *sites = NULL;
+        size_t site_count = 0;
+        if (tm_extract_call_sites(item.file, item.func, &sites, &site_count) != TM_OK) {
+            continue;
+        }
+        
+        for (size_t i = 0; i < site_count; i++) {
+            expand_symbol_t def;
+            if (!resolve_callee(ex, item.file, sites[i].callee_name, &def)) continue;
+            
+            size_t callee = expand_node(ex, def.file, def.func, item.depth + 1, NULL);
+            if (callee != SIZE_MAX) expand_edge(ex, head, callee);
+        }
+        tm_call_sites_free(sites, site_count);
+    }
+}
+
+/* String at offset in a graph's string table */
+static char *graph_string(char *strings, size_t offset)
+{
+    return offset == NO_STRING ? NULL : strings + offset;
+}
+
+/**
+ * Lay the graph out in a few blocks: every node in one array, their
+ * strings in one table, and the edges in CSR form, one array holding
+ * every node's callees, grouped by caller, followed by every node's
+ * callers, grouped by callee.
+ */
+static tm_call_graph_t *expand_finish(expand_t *ex)
+{
+    tm_call_graph_t *graph = tm_calloc(1, sizeof(tm_call_graph_t));
+    size_t n = ex->node_count;
+    size_t e = ex->edge_count;
+    
+    graph->strings = ex->strings.data;
+    tm_strbuf_init(&ex->strings);
+    
+    graph->node_block = tm_calloc(n ? n : 1, sizeof(tm_call_node_t));
+    graph->nodes = tm_malloc((n ? n : 1) * sizeof(tm_call_node_t *));
+    graph->node_count = n;
+    graph->node_capacity = n;
+    
+    for (size_t i = 0; i < n; i++) {
+        const expand_item_t *item = &ex->items[i];
+        tm_call_node_t *node = &graph->node_block[i];
+        node->name = graph_string(graph->strings, item->name);
+        node->file = graph_string(graph->strings, item->path);
+        node->signature = graph_string(graph->strings, item->signature);
+        node->start_line = item->start_line;
+        node->end_line = item->end_line;
+        node->complexity = item->complexity;
+        graph->nodes[i] = node;
+    }
+    if (ex->entry != SIZE_MAX) graph->entry_point = graph->nodes[ex->entry];
+    
+    graph->edge_count = e;
+    if (e > 0) {
+        size_t *out_start = tm_calloc(n + 1, sizeof(size_t));
+        size_t *in_start = tm_calloc(n + 1, sizeof(size_t));
+        for (size_t k = 0; k < e; k++) {
+            out_start[ex->edges[k].caller + 1]++;
+            in_start[ex->edges[k].callee + 1]++;
+        }
+        for (size_t i = 0; i < n; i++) {
+            out_start[i + 1] += out_start[i];
+            in_start[i + 1] += in_start[i];
+        }
+        
+        graph->adjacency = tm_malloc(2 * e * sizeof(tm_call_node_t *));
+        tm_call_node_t **callees = graph->adjacency;
+        tm_call_node_t **callers = graph->adjacency + e;
+        
+        size_t *out_fill = tm_malloc(n * sizeof(size_t));
+        size_t *in_fill = tm_malloc(n * sizeof(size_t));
+        memcpy(out_fill, out_start, n * sizeof(size_t));
+        memcpy(in_fill, in_start, n * sizeof(size_t));
+        
+        /* Stable: callees keep call-site order */
+        for (size_t k = 0; k < e; k++) {
+            size_t from = ex->edges[k].caller, to = ex->edges[k].callee;
+            callees[out_fill[from]++] = graph->nodes[to];
+            callers[in_fill[to]++] = graph->nodes[from];
+        }
+        
+        for (size_t i = 0; i < n; i++) {
+            tm_call_node_t *node = graph->nodes[i];
+            node->callee_count = out_start[i + 1] - out_start[i];
+            node->callees = node->callee_count ? callees + out_start[i] : NULL;
+            node->caller_count = in_start[i + 1] - in_start[i];
+            node->callers = node->caller_count ? callers + in_start[i] : NULL;
+        }
+        
+        free(out_start);
+        free(in_start);
+        free(out_fill);
+        free(in_fill);
+    }
+    
+    expand_free(ex);
+    return graph;
+}
+
+/**
+ * Start a build. Expansion keeps pointers into the definitions of every
+ * loaded file, so all of them are checked against the disk now and not
+ * again until build_end.
+ */
+static void build_begin(tm_graph_builder_t *builder)
+{
+    builder->build_id = ++builder->build_count;
+    
+    for (size_t i = 0; i < builder->file_count; i++) {
+        /* The cached file, and its path, may be replaced */
+        char *path = tm_strdup(builder->files[i]->path);
+        tm_source_file_t *file = NULL;
+        if (tm_graph_builder_get_file(builder, path, &file) != TM_OK) {
+            TM_DEBUG("Keeping unreadable cached file: %s", path);
+        }
+        free(path);
+    }
+}
+
+static void build_end(tm_graph_builder_t *builder)
+{
+    builder->build_id = 0;
+}
+
 tm_error_t tm_graph_builder_build(tm_graph_builder_t *builder,
                                   const tm_stack_trace_t *trace,
                                   tm_call_graph_t **result)
@@ -714,14 +1597,10 @@ tm_error_t tm_graph_builder_build(tm_graph_builder_t *builder,
     TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
     
     *result = NULL;
+    build_begin(builder);
     
-    tm_call_graph_t *graph = tm_calloc(1, sizeof(tm_call_graph_t));
-    graph->nodes = NULL;
-    graph->node_count = 0;
-    graph->node_capacity = 0;
-    graph->entry_point = NULL;
-    
-    /* Process each frame in the stack trace */
+    /* Load every frame's file first, so callees resolve across all of them */
+    tm_source_file_t **frame_files = tm_calloc(trace->frame_count + 1, sizeof(tm_source_file_t *));
     for (size_t i = 0; i < trace->frame_count; i++) {
         const tm_stack_frame_t *frame = &trace->frames[i];
         
@@ -740,17 +1619,28 @@ tm_error_t tm_graph_builder_build(tm_graph_builder_t *builder,
         full_path[PATH_MAX - 1] = '\0';
         
         /* Try to get/parse the source file */
-        tm_source_file_t *src_file = NULL;
-        if (tm_graph_builder_get_file(builder, full_path, &src_file) != TM_OK) {
+        if (tm_graph_builder_get_file(builder, full_path, &frame_files[i]) != TM_OK) {
             TM_DEBUG("Skipping unavailable file: %s", full_path);
-            continue;
         }
+    }
+    
+    expand_t ex;
+    expand_init(&ex, builder, builder->max_depth);
+    
+    /* Seed with each frame's function; consecutive frames are linked */
+    size_t prev = SIZE_MAX;
+    for (size_t i = 0; i < trace->frame_count; i++) {
+        const tm_stack_frame_t *frame = &trace->frames[i];
+        const tm_source_file_t *src_file = frame_files[i];
+        if (!src_file) continue;
         
-        /* Find the function at this frame's line */
-        tm_function_def_t *func = NULL;
-        if (frame->function && tm_find_function(src_file, frame->function, &func) != TM_OK) {
-            /* Try by line number */
-            tm_find_function_at_line(src_file, frame->line, &func);
+        /* Find the function by name, falling back to the frame's line */
+        const tm_function_def_t *func = NULL;
+        if (frame->function) {
+            func = tm_lookup_function(src_file, frame->function);
+        }
+        if (!func) {
+            func = tm_lookup_function_at_line(src_file, frame->line);
         }
         
         if (!func) {
@@ -759,43 +1649,71 @@ tm_error_t tm_graph_builder_build(tm_graph_builder_t *builder,
             continue;
         }
         
-        /* Create call node */
-        tm_call_node_t *node = tm_call_node_new(func->name, frame->file,
-                                                func->start_line, func->end_line);
-        node->signature = tm_strdup(func->signature);
-        
-        /* Add to graph */
-        if (graph->node_count >= graph->node_capacity) {
-            graph->node_capacity = graph->node_capacity == 0 ? 16 : graph->node_capacity * 2;
-            graph->nodes = tm_realloc(graph->nodes, 
-                                      graph->node_capacity * sizeof(tm_call_node_t *));
-        }
-        graph->nodes[graph->node_count++] = node;
+        size_t id = expand_node(&ex, src_file, func, 0, frame->file);
         
         /* First node is the entry point (error location) */
-        if (i == 0 || graph->entry_point == NULL) {
-            graph->entry_point = node;
+        if (ex.entry == SIZE_MAX) {
+            ex.entry = id;
         }
         
         /* Link to previous node (caller -> callee relationship) */
-        if (graph->node_count >= 2) {
-            tm_call_node_t *prev = graph->nodes[graph->node_count - 2];
-            tm_call_node_add_callee(prev, node);
-            tm_call_node_add_caller(node, prev);
+        if (prev != SIZE_MAX && prev != id) {
+            expand_edge(&ex, prev, id);
         }
-        
-        /* Free function def */
-        TM_FREE(func->name);
-        TM_FREE(func->qualified_name);
-        TM_FREE(func->signature);
-        free(func);
+        prev = id;
     }
+    free(frame_files);
+    
+    expand_run(&ex);
+    *result = expand_finish(&ex);
+    build_end(builder);
     
-    TM_DEBUG("Built call graph with %zu nodes", graph->node_count);
-    *result = graph;
+    TM_DEBUG("Built call graph with %zu nodes, %zu edges",
+             (*result)->node_count, (*result)->edge_count);
     return TM_OK;
 }
 
+/* ============================================================================
+ * AST Builder
+ * ========================================================================== */
+
+tm_ast_builder_t *tm_ast_builder_new(void)
+{
+    return tm_graph_builder_new(".", 0);
+}
+
+void tm_ast_builder_free(tm_ast_builder_t *builder)
+{
+    tm_graph_builder_free(builder);
+}
+
+tm_error_t tm_ast_add_file(tm_ast_builder_t *builder, const char *path)
+{
+    tm_source_file_t *file = NULL;
+    return tm_graph_builder_get_file(builder, path, &file);
+}
+
+tm_call_graph_t *tm_ast_build_call_graph(tm_ast_builder_t *builder,
+                                         const char *entry_function,
+                                         int max_depth)
+{
+    if (!builder) return NULL;
+    
+    build_begin(builder);
+    expand_t ex;
+    expand_init(&ex, builder, max_depth);
+    
+    size_t i;
+    if (entry_function && tm_strmap_get(&ex.symbol_ids, entry_function, &i)) {
+        ex.entry = expand_node(&ex, ex.symbols[i].file, ex.symbols[i].func, 0, NULL);
+        expand_run(&ex);
+    }
+    
+    tm_call_graph_t *graph = expand_finish(&ex);
+    build_end(builder);
+    return graph;
+}
+
 tm_error_t tm_build_call_graph(const tm_stack_trace_t *trace,
                                const char *repo_path,
                                int max_depth,
@@ -817,45 +1735,30 @@ tm_error_t tm_build_call_graph(const tm_stack_trace_t *trace,
  * Complexity Analysis
  * ========================================================================== */
 
+/**
+ * Count decision points starting on lines [start_line, end_line].
+ */
 static uint32_t count_complexity_nodes(const tm_source_file_t *file,
                                        TSNode node,
                                        int start_line,
                                        int end_line)
 {
-    TSPoint point = ts_node_start_point(node);
-    int line = (int)point.row + 1;
-    
-    if (line < start_line || line > end_line) return 0;
+    const ast_query_t *q = language_query(file->language, AST_QUERY_COMPLEXITY);
+    if (!q) return 0;
     
     uint32_t complexity = 0;
-    const char *type = ts_node_type(node);
-    
-    /* Count decision points */
-    if (strcmp(type, "if_statement") == 0 ||
-        strcmp(type, "elif_clause") == 0 ||
-        strcmp(type, "for_statement") == 0 ||
-        strcmp(type, "while_statement") == 0 ||
-        strcmp(type, "for_in_statement") == 0 ||
-        strcmp(type, "try_statement") == 0 ||
-        strcmp(type, "except_clause") == 0 ||
-        strcmp(type, "case_clause") == 0 ||
-        strcmp(type, "switch_statement") == 0 ||
-        strcmp(type, "conditional_expression") == 0 ||
-        strcmp(type, "ternary_expression") == 0 ||
-        strcmp(type, "and_expression") == 0 ||
-        strcmp(type, "or_expression") == 0 ||
-        strcmp(type, "&&") == 0 ||
-        strcmp(type, "||") == 0) {
-        complexity++;
-    }
-    
-    /* Recurse */
-    uint32_t child_count = ts_node_child_count(node);
-    for (uint32_t i = 0; i < child_count; i++) {
-        complexity += count_complexity_nodes(file, ts_node_child(node, i),
-                                             start_line, end_line);
+    TSQueryCursor *cursor = query_exec(q, node, start_line, end_line);
+    TSQueryMatch match;
+    
+    while (ts_query_cursor_next_match(cursor, &match)) {
+        TSNode branch;
+        if (!match_capture(&match, q->node_id, &branch)) continue;
+        
+        int line = (int)ts_node_start_point(branch).row + 1;
+        if (line >= start_line && line <= end_line) complexity++;
     }
     
+    ts_query_cursor_delete(cursor);
     return complexity;
 }
 
@@ -864,12 +1767,305 @@ uint32_t tm_compute_complexity(const tm_source_file_t *file,
 {
     if (!file || !func) return 0;
     
+    const tm_function_index_t *index = file->functions;
+    if (index && index->summarized) {
+        for (size_t i = 0; i < index->count; i++) {
+            const tm_function_def_t *def = &index->funcs[i];
+            if (def->start_line == func->start_line && def->end_line == func->end_line &&
+                def->start_col == func->start_col) {
+                return index->complexity[i];
+            }
+        }
+    }
+    if (!file->tree) return 0;
+    
     TSNode root = ts_tree_root_node(file->tree);
     
     /* Base complexity is 1 */
     return 1 + count_complexity_nodes(file, root, func->start_line, func->end_line);
 }
 
+/* ============================================================================
+ * Summaries
+ * ========================================================================== */
+
+static int compare_call_sites(const void *a, const void *b)
+{
+    const tm_call_site_t *x = a, *y = b;
+    if (x->line != y->line) return x->line < y->line ? -1 : 1;
+    if (x->column != y->column) return x->column < y->column ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Record every call site and each function's complexity in the file's
+ * index, as stored in AST summaries.
+ */
+static void summarize_functions(tm_source_file_t *file)
+{
+    tm_function_index_t *index = file->functions;
+    if (!index || index->summarized) return;
+    
+    size_t capacity = 0;
+    find_calls_in_range(file, ts_tree_root_node(file->tree), 1, INT_MAX,
+                        &index->calls, &index->call_count, &capacity);
+    if (index->call_count > 0) {
+        qsort(index->calls, index->call_count, sizeof(tm_call_site_t), compare_call_sites);
+    }
+    
+    index->complexity = tm_calloc(index->count ? index->count : 1, sizeof(uint32_t));
+    for (size_t i = 0; i < index->count; i++) {
+        index->complexity[i] = tm_compute_complexity(file, &index->funcs[i]);
+    }
+    index->summarized = true;
+}
+
+/* ============================================================================
+ * Incremental Reparsing
+ * ========================================================================== */
+
+/* Row and byte column of offset in source */
+static TSPoint point_at(const char *source, size_t offset)
+{
+    TSPoint point = { 0, 0 };
+    size_t line_start = 0;
+    for (size_t i = 0; i < offset; i++) {
+        if (source[i] == '\n') {
+            point.row++;
+            line_start = i + 1;
+        }
+    }
+    point.column = (uint32_t)(offset - line_start);
+    return point;
+}
+
+/**
+ * The single edit turning old_source into new_source: everything between
+ * their common prefix and common suffix.
+ */
+static TSInputEdit diff_sources(const char *old_source, size_t old_len,
+                                const char *new_source, size_t new_len)
+{
+    size_t prefix = 0;
+    size_t limit = TM_MIN(old_len, new_len);
+    while (prefix < limit && old_source[prefix] == new_source[prefix]) prefix++;
+    
+    size_t suffix = 0;
+    while (suffix < limit - prefix &&
+           old_source[old_len - 1 - suffix] == new_source[new_len - 1 - suffix]) {
+        suffix++;
+    }
+    
+    TSInputEdit edit = {
+        .start_byte = (uint32_t)prefix,
+        .old_end_byte = (uint32_t)(old_len - suffix),
+        .new_end_byte = (uint32_t)(new_len - suffix),
+        .start_point = point_at(new_source, prefix),
+        .old_end_point = point_at(old_source, old_len - suffix),
+        .new_end_point = point_at(new_source, new_len - suffix)
+    };
+    return edit;
+}
+
+/* A definition with its complexity, kept together while merging */
+typedef struct {
+    tm_function_def_t def;
+    uint32_t complexity;
+    bool fresh;                       /* Re-extracted; complexity unknown */
+} reparse_func_t;
+
+static int compare_reparse_funcs(const void *a, const void *b)
+{
+    const reparse_func_t *x = a, *y = b;
+    return compare_function_defs(&x->def, &y->def);
+}
+
+/**
+ * Rebuild file's function index after applying edit changed lines
+ * [first, last] of the new tree. Definitions wholly before the change are
+ * kept, those wholly after it are shifted by the lines the edit added,
+ * and only those overlapping it are extracted again, with their calls and
+ * complexity.
+ */
+static void reparse_functions(tm_source_file_t *file, const TSInputEdit *edit,
+                              int first, int last)
+{
+    tm_function_index_t *old = file->functions;
+    TSNode root = ts_tree_root_node(file->tree);
+    
+    /* Old lines after edit_end move by delta */
+    int edit_end = (int)edit->old_end_point.row + 1;
+    int delta = (int)edit->new_end_point.row - (int)edit->old_end_point.row;
+    
+    reparse_func_t *merged = NULL;
+    size_t count = 0, capacity = 0;
+    
+    for (size_t i = 0; i < old->count; i++) {
+        tm_function_def_t def = old->funcs[i];
+        bool before = def.end_line < first;
+        bool after = def.start_line > edit_end && def.start_line + delta > last;
+        if (!before && !after) {
+            TM_FREE(old->funcs[i].name);
+            TM_FREE(old->funcs[i].qualified_name);
+            TM_FREE(old->funcs[i].signature);
+            continue;
+        }
+        
+        if (after) {
+            def.start_line += delta;
+            def.end_line += delta;
+        }
+        
+        /* Nodes of the previous tree die with it */
+        TSPoint start = { (uint32_t)def.start_line - 1, (uint32_t)def.start_col };
+        TSPoint end = { (uint32_t)def.end_line - 1, (uint32_t)def.end_col };
+        def.node = ts_node_descendant_for_point_range(root, start, end);
+        
+        reparse_func_t entry = { def, old->complexity ? old->complexity[i] : 0, false };
+        TM_VEC_PUSH(merged, count, capacity, entry);
+    }
+    
+    tm_function_def_t *found = NULL;
+    size_t found_count = 0, found_capacity = 0;
+    find_functions(file, root, first, last, &found, &found_count, &found_capacity);
+    for (size_t i = 0; i < found_count; i++) {
+        reparse_func_t entry = { found[i], 0, true };
+        TM_VEC_PUSH(merged, count, capacity, entry);
+    }
+    free(found);
+    
+    if (count > 1) qsort(merged, count, sizeof(reparse_func_t), compare_reparse_funcs);
+    
+    tm_function_def_t *funcs = tm_calloc(count ? count : 1, sizeof(tm_function_def_t));
+    for (size_t i = 0; i < count; i++) funcs[i] = merged[i].def;
+    tm_function_index_t *index = tm_function_index_new(funcs, count);
+    
+    if (old->summarized) {
+        index->summarized = true;
+        index->complexity = tm_calloc(count ? count : 1, sizeof(uint32_t));
+        for (size_t i = 0; i < count; i++) {
+            index->complexity[i] = merged[i].fresh
+                ? 1 + count_complexity_nodes(file, root, funcs[i].start_line, funcs[i].end_line)
+                : merged[i].complexity;
+        }
+        
+        /* Calls follow the same split; summary calls carry no nodes */
+        size_t call_capacity = 0;
+        for (size_t i = 0; i < old->call_count; i++) {
+            tm_call_site_t site = old->calls[i];
+            bool after = site.line > edit_end && site.line + delta > last;
+            if (site.line >= first && !after) {
+                TM_FREE(old->calls[i].callee_name);
+                continue;
+            }
+            if (after) site.line += delta;
+            memset(&site.node, 0, sizeof(site.node));
+            TM_VEC_PUSH(index->calls, index->call_count, call_capacity, site);
+        }
+        find_calls_in_range(file, root, first, last,
+                            &index->calls, &index->call_count, &call_capacity);
+        for (size_t i = 0; i < index->call_count; i++) {
+            memset(&index->calls[i].node, 0, sizeof(index->calls[i].node));
+        }
+        if (index->call_count > 1) {
+            qsort(index->calls, index->call_count, sizeof(tm_call_site_t), compare_call_sites);
+        }
+    }
+    
+    free(merged);
+    
+    /* Kept strings moved to the new index */
+    TM_FREE(old->funcs);
+    TM_FREE(old->calls);
+    old->count = 0;
+    old->call_count = 0;
+    tm_function_index_free(old);
+    file->functions = index;
+}
+
+tm_error_t tm_source_file_update(tm_source_file_t *file, const char *summary_dir)
+{
+    TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
+    if (!file->tree || !file->functions) return TM_ERR_UNSUPPORTED;
+    
+    size_t source_len = 0;
+    char *source = tm_read_file(file->path, &source_len);
+    if (!source) {
+        TM_ERROR("Failed to read source file: %s", file->path);
+        return TM_ERR_IO;
+    }
+    
+    struct stat st;
+    bool identity = stat(file->path, &st) == 0;
+    
+    /* Touched but not edited: nothing to reparse */
+    if (source_len == file->source_len && memcmp(source, file->source, source_len) == 0) {
+        free(source);
+        if (identity) {
+            file->inode = st.st_ino;
+            file->mtime = st.st_mtim;
+        }
+        return TM_OK;
+    }
+    
+    TSParser *parser = thread_parser(file->language, tm_ts_language(file->language));
+    if (!parser) {
+        free(source);
+        return TM_ERR_INTERNAL;
+    }
+    
+    /* Edit a copy, so a failed parse leaves the file as it was */
+    TSInputEdit edit = diff_sources(file->source, file->source_len, source, source_len);
+    TSTree *edited = ts_tree_copy(file->tree);
+    ts_tree_edit(edited, &edit);
+    
+    TSTree *tree = ts_parser_parse_string(parser, edited, source, (uint32_t)source_len);
+    if (!tree) {
+        TM_ERROR("Tree-sitter parsing failed for: %s", file->path);
+        ts_parser_reset(parser);
+        ts_tree_delete(edited);
+        free(source);
+        return TM_ERR_PARSE;
+    }
+    
+    /* Lines to re-extract: the edit, plus anything whose structure it changed */
+    int first = (int)edit.start_point.row + 1;
+    int last = (int)edit.new_end_point.row + 1;
+    uint32_t range_count = 0;
+    TSRange *ranges = ts_tree_get_changed_ranges(edited, tree, &range_count);
+    for (uint32_t i = 0; i < range_count; i++) {
+        first = TM_MIN(first, (int)ranges[i].start_point.row + 1);
+        last = TM_MAX(last, (int)ranges[i].end_point.row + 1);
+    }
+    free(ranges);
+    ts_tree_delete(edited);
+    
+    ts_tree_delete(file->tree);
+    free(file->source);
+    file->tree = tree;
+    file->source = source;
+    file->source_len = source_len;
+    
+    if (identity) {
+        file->inode = st.st_ino;
+        file->mtime = st.st_mtim;
+    }
+    
+    reparse_functions(file, &edit, first, last);
+    
+    if (summary_dir && file->functions->summarized) {
+        char *summary = tm_ast_cache_file(summary_dir, source, source_len);
+        if (tm_ast_cache_write(summary, file->language, source, source_len,
+                               file->functions) != TM_OK) {
+            TM_DEBUG("Could not write AST summary for %s", file->path);
+        }
+        free(summary);
+    }
+    
+    TM_DEBUG("Reparsed %s incrementally (lines %d-%d)", file->path, first, last);
+    return TM_OK;
+}
+
 #else /* !HAVE_TREE_SITTER - Stub implementations */
 
 /* ============================================================================
@@ -882,6 +2078,17 @@ const TSLanguage *tm_ts_language(tm_language_t lang)
     return NULL;
 }
 
+tm_error_t tm_parse_source(const char *path, char *source, size_t source_len,
+                           tm_source_file_t **result)
+{
+    (void)path;
+    (void)source_len;
+    free(source);
+    *result = NULL;
+    TM_DEBUG("AST analysis unavailable (no tree-sitter)");
+    return TM_ERR_UNSUPPORTED;
+}
+
 tm_error_t tm_parse_source_file(const char *path, tm_source_file_t **result)
 {
     (void)path;
@@ -890,9 +2097,25 @@ tm_error_t tm_parse_source_file(const char *path, tm_source_file_t **result)
     return TM_ERR_UNSUPPORTED;
 }
 
+tm_error_t tm_source_file_update(tm_source_file_t *file, const char *summary_dir)
+{
+    (void)file;
+    (void)summary_dir;
+    return TM_ERR_UNSUPPORTED;
+}
+
+tm_error_t tm_parse_source_file_cached(const char *path,
+                                       const char *summary_dir,
+                                       tm_source_file_t **result)
+{
+    (void)summary_dir;
+    return tm_parse_source_file(path, result);
+}
+
 void tm_source_file_free(tm_source_file_t *file)
 {
     if (file) {
+        tm_function_index_free(file->functions);
         TM_FREE(file->path);
         TM_FREE(file->source);
         free(file);
@@ -909,6 +2132,18 @@ tm_error_t tm_extract_functions(const tm_source_file_t *file,
     return TM_ERR_UNSUPPORTED;
 }
 
+void tm_functions_free(tm_function_def_t *funcs, size_t count)
+{
+    if (!funcs) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        TM_FREE(funcs[i].name);
+        TM_FREE(funcs[i].qualified_name);
+        TM_FREE(funcs[i].signature);
+    }
+    free(funcs);
+}
+
 tm_error_t tm_find_function(const tm_source_file_t *file,
                             const char *name,
                             tm_function_def_t **func)
@@ -949,6 +2184,36 @@ void tm_call_site_free(tm_call_site_t *site)
     }
 }
 
+void tm_call_sites_free(tm_call_site_t *sites, size_t count)
+{
+    if (!sites) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        TM_FREE(sites[i].callee_name);
+    }
+    free(sites);
+}
+
+tm_error_t tm_extract_imports(const tm_source_file_t *file,
+                              tm_import_t **imports,
+                              size_t *count)
+{
+    (void)file;
+    *imports = NULL;
+    *count = 0;
+    return TM_ERR_UNSUPPORTED;
+}
+
+void tm_imports_free(tm_import_t *imports, size_t count)
+{
+    if (!imports) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        TM_FREE(imports[i].text);
+    }
+    free(imports);
+}
+
 tm_ast_builder_t *tm_ast_builder_new(void)
 {
     TM_DEBUG("AST builder unavailable (no tree-sitter)");
@@ -982,17 +2247,22 @@ void tm_call_graph_free(tm_call_graph_t *graph)
 {
     if (!graph) return;
     
-    for (size_t i = 0; i < graph->node_count; i++) {
+    for (size_t i = 0; !graph->node_block && i < graph->node_count; i++) {
         if (graph->nodes[i]) {
             TM_FREE(graph->nodes[i]->name);
             TM_FREE(graph->nodes[i]->file);
             TM_FREE(graph->nodes[i]->signature);
-            TM_FREE(graph->nodes[i]->callers);
-            TM_FREE(graph->nodes[i]->callees);
+            if (!graph->adjacency) {
+                TM_FREE(graph->nodes[i]->callers);
+                TM_FREE(graph->nodes[i]->callees);
+            }
             free(graph->nodes[i]);
         }
     }
+    TM_FREE(graph->node_block);
+    TM_FREE(graph->strings);
     TM_FREE(graph->nodes);
+    TM_FREE(graph->adjacency);
     free(graph);
 }
 
@@ -1008,6 +2278,30 @@ void tm_graph_builder_free(tm_graph_builder_t *builder)
     (void)builder;
 }
 
+tm_error_t tm_graph_builder_use_cache(tm_graph_builder_t *builder, const char *cache_dir)
+{
+    (void)builder;
+    (void)cache_dir;
+    return TM_ERR_UNSUPPORTED;
+}
+
+void tm_graph_builder_use_symbols(tm_graph_builder_t *builder,
+                                  const tm_symbol_index_t *symbols)
+{
+    (void)builder;
+    (void)symbols;
+}
+
+tm_error_t tm_graph_builder_get_file(tm_graph_builder_t *builder,
+                                     const char *path,
+                                     tm_source_file_t **file)
+{
+    (void)builder;
+    (void)path;
+    *file = NULL;
+    return TM_ERR_UNSUPPORTED;
+}
+
 tm_error_t tm_graph_builder_build(tm_graph_builder_t *builder,
                                   const tm_stack_trace_t *trace,
                                   tm_call_graph_t **result)
@@ -1039,3 +2333,96 @@ uint32_t tm_compute_complexity(const tm_source_file_t *file,
 }
 
 #endif /* HAVE_TREE_SITTER */
+
+/* ============================================================================
+ * Function Index
+ * ========================================================================== */
+
+tm_function_index_t *tm_function_index_new(tm_function_def_t *funcs, size_t count)
+{
+    tm_function_index_t *index = tm_calloc(1, sizeof(tm_function_index_t));
+    index->funcs = funcs;
+    index->count = count;
+    tm_strmap_init(&index->by_name);
+    
+    tm_interval_t *lines = tm_calloc(count ? count : 1, sizeof(tm_interval_t));
+    for (size_t i = 0; i < count; i++) {
+        const tm_function_def_t *func = &funcs[i];
+        
+        /* Earlier definitions win, as with a linear scan */
+        if (func->name && !tm_strmap_get(&index->by_name, func->name, NULL)) {
+            tm_strmap_put(&index->by_name, func->name, i);
+        }
+        lines[i].start = func->start_line;
+        lines[i].end = func->end_line;
+        lines[i].tag = (uint32_t)i;
+    }
+    tm_interval_index_init(&index->by_line, lines, count);
+    free(lines);
+    
+    return index;
+}
+
+tm_function_index_t *tm_function_index_build(const tm_source_file_t *file)
+{
+    if (!file) return NULL;
+    
+    tm_function_def_t *funcs = NULL;
+    size_t count = 0;
+    if (tm_extract_functions(file, &funcs, &count) != TM_OK) {
+        return tm_function_index_new(NULL, 0);
+    }
+    return tm_function_index_new(funcs, count);
+}
+
+void tm_function_index_free(tm_function_index_t *index)
+{
+    if (!index) return;
+    
+    tm_functions_free(index->funcs, index->count);
+    tm_strmap_free(&index->by_name);
+    tm_interval_index_free(&index->by_line);
+    tm_call_sites_free(index->calls, index->call_count);
+    TM_FREE(index->complexity);
+    free(index);
+}
+
+const tm_function_def_t *tm_lookup_function(const tm_source_file_t *file,
+                                            const char *name)
+{
+    if (!file || !file->functions || !name) return NULL;
+    
+    size_t i;
+    if (!tm_strmap_get(&file->functions->by_name, name, &i)) return NULL;
+    return &file->functions->funcs[i];
+}
+
+typedef struct {
+    uint32_t best;
+    int best_span;
+} innermost_ctx_t;
+
+static void visit_enclosing(const tm_interval_t *interval, void *ctx)
+{
+    innermost_ctx_t *c = ctx;
+    int span = interval->end - interval->start;
+    
+    /* Narrowest span is innermost; ties go to the earlier definition */
+    if (span < c->best_span || (span == c->best_span && interval->tag < c->best)) {
+        c->best = interval->tag;
+        c->best_span = span;
+    }
+}
+
+const tm_function_def_t *tm_lookup_function_at_line(const tm_source_file_t *file,
+                                                    int line)
+{
+    if (!file || !file->functions) return NULL;
+    
+    innermost_ctx_t ctx = { 0, INT_MAX };
+    if (tm_interval_index_overlaps(&file->functions->by_line, line, line,
+                                   visit_enclosing, &ctx) == 0) {
+        return NULL;
+    }
+    return &file->functions->funcs[ctx.best];
+}
@@ -0,0 +1,293 @@
+/**
+ * TraceMind - AST Summary Cache
+ */
+
+#include "internal/common.h"
+#include "internal/ast_cache.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#define SUMMARY_MAGIC "TMAST\0\0\0"
+#define SUMMARY_VERSION 2
+#define SUMMARY_BYTE_ORDER 0x01020304u
+
+/*
+ * MurmurHash64A of the source. Files are named and matched by FNV-1a and
+ * length; this unrelated second hash keeps an FNV collision between two
+ * sources of the same length from serving one's summary for the other.
+ */
+static uint64_t content_check(const char *source, size_t len)
+{
+    const uint64_t m = 0xc6a4a7935bd1e995ull;
+    const unsigned char *data = (const unsigned char *)source;
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ ((uint64_t)len * m);
+
+    size_t blocks = len / 8;
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t k;
+        memcpy(&k, data + 8 * i, sizeof(k));
+        k *= m;
+        k ^= k >> 47;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    const unsigned char *tail = data + 8 * blocks;
+    switch (len & 7) {
+        case 7: h ^= (uint64_t)tail[6] << 48; /* fall through */
+        case 6: h ^= (uint64_t)tail[5] << 40; /* fall through */
+        case 5: h ^= (uint64_t)tail[4] << 32; /* fall through */
+        case 4: h ^= (uint64_t)tail[3] << 24; /* fall through */
+        case 3: h ^= (uint64_t)tail[2] << 16; /* fall through */
+        case 2: h ^= (uint64_t)tail[1] << 8;  /* fall through */
+        case 1:
+            h ^= (uint64_t)tail[0];
+            h *= m;
+            break;
+        default:
+            break;
+    }
+
+    h ^= h >> 47;
+    h *= m;
+    h ^= h >> 47;
+    return h;
+}
+
+char *tm_ast_cache_file(const char *dir, const char *source, size_t len)
+{
+    if (!dir || !source) return NULL;
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/%016llx-%zx.ast", dir,
+                      (unsigned long long)tm_hash_bytes(source, len), len);
+    return tm_strbuf_finish(&sb);
+}
+
+/* ============================================================================
+ * Loading
+ * ========================================================================== */
+
+/* String at offset, or NULL if it lies outside the string table */
+static char *summary_string(const char *strings, uint64_t size, uint32_t offset)
+{
+    if (offset >= size) return NULL;
+    return tm_strdup(strings + offset);
+}
+
+tm_error_t tm_ast_cache_read(const char *file,
+                             tm_language_t lang,
+                             const char *source,
+                             size_t len,
+                             tm_function_index_t **index)
+{
+    TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(source, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(index, TM_ERR_INVALID_ARG);
+
+    *index = NULL;
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? TM_ERR_NOT_FOUND : TM_ERR_IO;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(tm_ast_summary_header_t)) {
+        close(fd);
+        return TM_ERR_PARSE;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return TM_ERR_IO;
+
+    const tm_ast_summary_header_t *header = map;
+
+    /* Validate header, source identity and section bounds */
+    bool valid = memcmp(header->magic, SUMMARY_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == SUMMARY_VERSION &&
+                 header->byte_order == SUMMARY_BYTE_ORDER &&
+                 header->language == (uint32_t)lang &&
+                 header->content_len == len &&
+                 header->content_hash == tm_hash_bytes(source, len) &&
+                 header->content_check == content_check(source, len);
+
+    /* Sections are bounded by the file size first so the sum cannot wrap */
+    size_t funcs_size = 0, calls_size = 0;
+    if (valid) {
+        funcs_size = (size_t)header->function_count * sizeof(tm_ast_summary_func_t);
+        calls_size = (size_t)header->call_count * sizeof(tm_ast_summary_call_t);
+        valid = funcs_size <= size && calls_size <= size && header->strings_size <= size &&
+                sizeof(*header) + funcs_size + calls_size + header->strings_size == size;
+    }
+
+    const tm_ast_summary_func_t *func_recs =
+        (const tm_ast_summary_func_t *)((const char *)map + sizeof(*header));
+    const tm_ast_summary_call_t *call_recs =
+        (const tm_ast_summary_call_t *)((const char *)func_recs + funcs_size);
+    const char *strings = (const char *)call_recs + calls_size;
+    uint64_t strings_size = header->strings_size;
+
+    /* Every string must be terminated inside the table */
+    if (valid && strings_size > 0) {
+        valid = strings[strings_size - 1] == '\0';
+    }
+
+    if (!valid) {
+        munmap(map, size);
+        return TM_ERR_PARSE;
+    }
+
+    size_t func_count = header->function_count;
+    size_t call_count = header->call_count;
+    tm_function_def_t *funcs = tm_calloc(func_count ? func_count : 1, sizeof(tm_function_def_t));
+    tm_call_site_t *calls = tm_calloc(call_count ? call_count : 1, sizeof(tm_call_site_t));
+    uint32_t *complexity = tm_calloc(func_count ? func_count : 1, sizeof(uint32_t));
+
+    for (size_t i = 0; i < func_count && valid; i++) {
+        const tm_ast_summary_func_t *rec = &func_recs[i];
+        tm_function_def_t *func = &funcs[i];
+
+        func->name = summary_string(strings, strings_size, rec->name_offset);
+        func->qualified_name = summary_string(strings, strings_size, rec->qualified_offset);
+        func->signature = summary_string(strings, strings_size, rec->signature_offset);
+        func->start_line = rec->start_line;
+        func->end_line = rec->end_line;
+        func->start_col = rec->start_col;
+        func->end_col = rec->end_col;
+        complexity[i] = rec->complexity;
+
+        valid = func->name && func->qualified_name && func->signature;
+    }
+
+    for (size_t i = 0; i < call_count && valid; i++) {
+        const tm_ast_summary_call_t *rec = &call_recs[i];
+
+        calls[i].callee_name = summary_string(strings, strings_size, rec->callee_offset);
+        calls[i].line = rec->line;
+        calls[i].column = rec->column;
+
+        valid = calls[i].callee_name != NULL;
+    }
+
+    munmap(map, size);
+
+    if (!valid) {
+        tm_functions_free(funcs, func_count);
+        tm_call_sites_free(calls, call_count);
+        free(complexity);
+        return TM_ERR_PARSE;
+    }
+
+    tm_function_index_t *idx = tm_function_index_new(funcs, func_count);
+    idx->summarized = true;
+    idx->calls = calls;
+    idx->call_count = call_count;
+    idx->complexity = complexity;
+
+    TM_DEBUG("Loaded AST summary %s: %zu functions, %zu calls", file, func_count, call_count);
+
+    *index = idx;
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Writing
+ * ========================================================================== */
+
+/* Offset of s in the string table, adding it on first use */
+static uint32_t intern_string(tm_strbuf_t *strings, tm_strmap_t *offsets, const char *s)
+{
+    if (!s) s = "";
+
+    size_t offset;
+    if (tm_strmap_get(offsets, s, &offset)) return (uint32_t)offset;
+
+    offset = strings->len;
+    tm_strbuf_append_len(strings, s, strlen(s) + 1);
+    tm_strmap_put(offsets, s, offset);
+    return (uint32_t)offset;
+}
+
+tm_error_t tm_ast_cache_write(const char *file,
+                              tm_language_t lang,
+                              const char *source,
+                              size_t len,
+                              const tm_function_index_t *index)
+{
+    TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(source, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(index, TM_ERR_INVALID_ARG);
+    if (!index->summarized) return TM_ERR_INVALID_ARG;
+
+    tm_strbuf_t funcs, calls, strings;
+    tm_strbuf_init(&funcs);
+    tm_strbuf_init(&calls);
+    tm_strbuf_init(&strings);
+
+    /* Callee names repeat heavily, so strings are shared */
+    tm_strmap_t offsets;
+    tm_strmap_init(&offsets);
+
+    for (size_t i = 0; i < index->count; i++) {
+        const tm_function_def_t *func = &index->funcs[i];
+        tm_ast_summary_func_t rec = {
+            .name_offset = intern_string(&strings, &offsets, func->name),
+            .qualified_offset = intern_string(&strings, &offsets, func->qualified_name),
+            .signature_offset = intern_string(&strings, &offsets, func->signature),
+            .start_line = func->start_line,
+            .end_line = func->end_line,
+            .start_col = func->start_col,
+            .end_col = func->end_col,
+            .complexity = index->complexity[i]
+        };
+        tm_strbuf_append_len(&funcs, (const char *)&rec, sizeof(rec));
+    }
+
+    for (size_t i = 0; i < index->call_count; i++) {
+        const tm_call_site_t *site = &index->calls[i];
+        tm_ast_summary_call_t rec = {
+            .callee_offset = intern_string(&strings, &offsets, site->callee_name),
+            .line = site->line,
+            .column = site->column
+        };
+        tm_strbuf_append_len(&calls, (const char *)&rec, sizeof(rec));
+    }
+
+    tm_strmap_free(&offsets);
+
+    tm_ast_summary_header_t header = {
+        .version = SUMMARY_VERSION,
+        .byte_order = SUMMARY_BYTE_ORDER,
+        .content_hash = tm_hash_bytes(source, len),
+        .content_len = len,
+        .content_check = content_check(source, len),
+        .language = (uint32_t)lang,
+        .function_count = (uint32_t)index->count,
+        .call_count = (uint32_t)index->call_count,
+        .strings_size = strings.len
+    };
+    memcpy(header.magic, SUMMARY_MAGIC, sizeof(header.magic));
+
+    tm_strbuf_t out;
+    tm_strbuf_init(&out);
+    tm_strbuf_append_len(&out, (const char *)&header, sizeof(header));
+    tm_strbuf_append_len(&out, funcs.data, funcs.len);
+    tm_strbuf_append_len(&out, calls.data, calls.len);
+    tm_strbuf_append_len(&out, strings.data, strings.len);
+
+    tm_strbuf_free(&funcs);
+    tm_strbuf_free(&calls);
+    tm_strbuf_free(&strings);
+
+    tm_error_t err = tm_write_file_atomic(file, out.data, out.len);
+    tm_strbuf_free(&out);
+
+    if (err == TM_OK) {
+        TM_DEBUG("Wrote AST summary %s: %zu functions, %zu calls", file,
+                 index->count, index->call_count);
+    }
+    return err;
+}
@@ -0,0 +1,905 @@
+/**
+ * TraceMind - Provider Batch API
+ *
+ * OpenAI:    upload requests.jsonl to /files, create /batches, poll
+ *            /batches/{id}, download /files/{output_file_id}/content.
+ * Anthropic: POST /messages/batches with all requests, poll
+ *            /messages/batches/{id}, download its results_url.
+ */
+
+#include "internal/batch.h"
+#include <ctype.h>
+#include <jansson.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/* ============================================================================
+ * Constants
+ * ========================================================================== */
+
+#define REQUESTS_FILE "requests.jsonl"
+#define STATE_FILE "state.json"
+#define RESULTS_FILE "results.jsonl"
+
+#define MAX_CUSTOM_ID_LEN 64
+#define MAX_POLL_FAILURES 5               /* Consecutive poll errors tolerated */
+#define OPENAI_COMPLETION_WINDOW "24h"
+
+/* ============================================================================
+ * Helpers
+ * ========================================================================== */
+
+static const char *STATUS_NAMES[] = {
+    "staging", "uploaded", "submitted", "completed", "failed"
+};
+
+const char *tm_batch_status_name(tm_batch_status_t status)
+{
+    if ((size_t)status < TM_ARRAY_SIZE(STATUS_NAMES)) {
+        return STATUS_NAMES[status];
+    }
+    return "unknown";
+}
+
+static tm_batch_status_t status_from_name(const char *name)
+{
+    for (size_t i = 0; name && i < TM_ARRAY_SIZE(STATUS_NAMES); i++) {
+        if (strcmp(name, STATUS_NAMES[i]) == 0) return (tm_batch_status_t)i;
+    }
+    return TM_BATCH_STAGING;
+}
+
+static const char *provider_name(tm_llm_provider_t provider)
+{
+    switch (provider) {
+    case TM_LLM_OPENAI:    return "openai";
+    case TM_LLM_ANTHROPIC: return "anthropic";
+    case TM_LLM_LOCAL:     return "local";
+    }
+    return "unknown";
+}
+
+static char *batch_path(const tm_batch_t *batch, const char *file)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/%s", batch->dir, file);
+    return tm_strbuf_finish(&sb);
+}
+
+static void set_string(char **dst, json_t *val)
+{
+    if (!json_is_string(val)) return;
+    TM_FREE(*dst);
+    *dst = tm_strdup(json_string_value(val));
+}
+
+static bool valid_custom_id(const char *id)
+{
+    size_t len = strlen(id);
+    if (len == 0 || len > MAX_CUSTOM_ID_LEN) return false;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)id[i];
+        if (!isalnum(c) && c != '_' && c != '-') return false;
+    }
+    return true;
+}
+
+static void sleep_ms(int ms)
+{
+    if (ms <= 0) return;
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+/* ============================================================================
+ * Provider URLs
+ * ========================================================================== */
+
+/*
+ * OpenAI batch endpoints live next to chat completions:
+ * https://api.openai.com/v1/chat/completions -> https://api.openai.com/v1
+ */
+static char *openai_base_url(const tm_llm_client_t *client)
+{
+    const char *suffix = "/chat/completions";
+    if (!client->endpoint || !tm_str_ends_with(client->endpoint, suffix)) return NULL;
+    return tm_strndup(client->endpoint, strlen(client->endpoint) - strlen(suffix));
+}
+
+/* Path part of the endpoint, used as the per-line batch "url" */
+static const char *endpoint_path(const tm_llm_client_t *client)
+{
+    const char *host = strstr(client->endpoint, "://");
+    host = host ? host + 3 : client->endpoint;
+    const char *path = strchr(host, '/');
+    return path ? path : "/v1/chat/completions";
+}
+
+static char *batches_url(const tm_batch_t *batch, const char *id)
+{
+    const tm_llm_client_t *client = batch->client;
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+
+    if (client->provider == TM_LLM_ANTHROPIC) {
+        /* https://api.anthropic.com/v1/messages -> .../messages/batches */
+        tm_strbuf_appendf(&sb, "%s/batches", client->endpoint);
+    } else {
+        char *base = openai_base_url(client);
+        tm_strbuf_appendf(&sb, "%s/batches", base ? base : "");
+        TM_FREE(base);
+    }
+
+    if (id) tm_strbuf_appendf(&sb, "/%s", id);
+    return tm_strbuf_finish(&sb);
+}
+
+/* ============================================================================
+ * HTTP
+ * ========================================================================== */
+
+typedef struct {
+    char *data;
+    size_t size;
+} http_buffer_t;
+
+static size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    size_t realsize = size * nmemb;
+    http_buffer_t *buf = (http_buffer_t *)userp;
+
+    buf->data = tm_realloc(buf->data, buf->size + realsize + 1);
+    memcpy(buf->data + buf->size, contents, realsize);
+    buf->size += realsize;
+    buf->data[buf->size] = '\0';
+
+    return realsize;
+}
+
+/**
+ * Perform a batch API call: GET when neither json_body nor mime is set,
+ * otherwise POST. Stores the response body in *out on 2xx.
+ */
+static tm_error_t batch_http(tm_batch_t *batch, const char *url,
+                             const char *json_body, curl_mime *mime, char **out)
+{
+    *out = NULL;
+
+    CURL *curl = batch->client->curl;
+    curl_easy_reset(curl);
+
+    struct curl_slist *headers = NULL;
+    if (json_body) headers = curl_slist_append(headers, "Content-Type: application/json");
+    headers = tm_llm_auth_headers(batch->client, headers);
+
+    http_buffer_t buf = { .data = NULL, .size = 0 };
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buf);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long)batch->client->timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    if (json_body) curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_body);
+    if (mime) curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+
+    TM_DEBUG("Batch API: %s %s", (json_body || mime) ? "POST" : "GET", url);
+
+    CURLcode res = curl_easy_perform(curl);
+    curl_slist_free_all(headers);
+
+    if (res != CURLE_OK) {
+        TM_ERROR("CURL error: %s", curl_easy_strerror(res));
+        TM_FREE(buf.data);
+        return res == CURLE_OPERATION_TIMEDOUT ? TM_ERR_TIMEOUT : TM_ERR_LLM;
+    }
+
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+
+    if (http_code < 200 || http_code >= 300) {
+        TM_ERROR("Batch API error: HTTP %ld: %.200s", http_code, buf.data ? buf.data : "");
+        TM_FREE(buf.data);
+        return TM_ERR_LLM;
+    }
+
+    *out = buf.data ? buf.data : tm_strdup("");
+    return TM_OK;
+}
+
+/* Perform a call and parse the JSON object response */
+static tm_error_t batch_http_json(tm_batch_t *batch, const char *url,
+                                  const char *json_body, curl_mime *mime, json_t **out)
+{
+    char *body = NULL;
+    tm_error_t err = batch_http(batch, url, json_body, mime, &body);
+    if (err != TM_OK) return err;
+
+    json_error_t jerr;
+    *out = json_loads(body, 0, &jerr);
+    TM_FREE(body);
+
+    if (!json_is_object(*out)) {
+        TM_ERROR("Batch API returned invalid JSON: %s", jerr.text);
+        json_decref(*out);
+        *out = NULL;
+        return TM_ERR_PARSE;
+    }
+    return TM_OK;
+}
+
+/* ============================================================================
+ * State Persistence
+ * ========================================================================== */
+
+static tm_error_t save_state(tm_batch_t *batch)
+{
+    json_t *state = json_object();
+    json_object_set_new(state, "provider", json_string(provider_name(batch->client->provider)));
+    json_object_set_new(state, "status", json_string(tm_batch_status_name(batch->status)));
+    json_object_set_new(state, "request_count", json_integer((json_int_t)batch->request_count));
+    json_object_set_new(state, "submitted_at", json_integer(batch->submitted_at));
+
+    if (batch->batch_id) json_object_set_new(state, "batch_id", json_string(batch->batch_id));
+    if (batch->input_file_id) json_object_set_new(state, "input_file_id", json_string(batch->input_file_id));
+    if (batch->output_file_id) json_object_set_new(state, "output_file_id", json_string(batch->output_file_id));
+    if (batch->error_file_id) json_object_set_new(state, "error_file_id", json_string(batch->error_file_id));
+    if (batch->results_url) json_object_set_new(state, "results_url", json_string(batch->results_url));
+
+    char *text = json_dumps(state, JSON_INDENT(2));
+    json_decref(state);
+    if (!text) return TM_ERR_NOMEM;
+
+    char *path = batch_path(batch, STATE_FILE);
+    tm_error_t err = tm_write_file_atomic(path, text, strlen(text));
+    if (err != TM_OK) TM_ERROR("Failed to save batch state: %s", path);
+
+    TM_FREE(path);
+    free(text);
+    return err;
+}
+
+static tm_error_t load_state(tm_batch_t *batch)
+{
+    char *path = batch_path(batch, STATE_FILE);
+    json_error_t jerr;
+    json_t *state = json_load_file(path, 0, &jerr);
+    TM_FREE(path);
+
+    if (!json_is_object(state)) {
+        json_decref(state);
+        return TM_ERR_NOT_FOUND;
+    }
+
+    json_t *provider = json_object_get(state, "provider");
+    if (json_is_string(provider) &&
+        strcmp(json_string_value(provider), provider_name(batch->client->provider)) != 0) {
+        TM_ERROR("Batch in %s was submitted to %s, not %s", batch->dir,
+                 json_string_value(provider), provider_name(batch->client->provider));
+        json_decref(state);
+        return TM_ERR_INVALID_ARG;
+    }
+
+    batch->status = status_from_name(json_string_value(json_object_get(state, "status")));
+    batch->submitted_at = json_integer_value(json_object_get(state, "submitted_at"));
+    set_string(&batch->batch_id, json_object_get(state, "batch_id"));
+    set_string(&batch->input_file_id, json_object_get(state, "input_file_id"));
+    set_string(&batch->output_file_id, json_object_get(state, "output_file_id"));
+    set_string(&batch->error_file_id, json_object_get(state, "error_file_id"));
+    set_string(&batch->results_url, json_object_get(state, "results_url"));
+
+    json_decref(state);
+    return TM_OK;
+}
+
+static void register_id(tm_batch_t *batch, const char *custom_id)
+{
+    char *id = tm_strdup(custom_id);
+    tm_strmap_put(&batch->ids, id, batch->request_count);
+    TM_VEC_PUSH(batch->custom_ids, batch->request_count, batch->request_cap, id);
+}
+
+/* Rebuild the custom ID list of a submitted batch from requests.jsonl */
+static tm_error_t load_request_ids(tm_batch_t *batch)
+{
+    char *path = batch_path(batch, REQUESTS_FILE);
+    char *content = tm_read_file(path, NULL);
+    TM_FREE(path);
+    if (!content) return TM_ERR_IO;
+
+    char *save = NULL;
+    for (char *line = strtok_r(content, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        json_error_t jerr;
+        json_t *obj = json_loads(line, 0, &jerr);
+        json_t *id = json_object_get(obj, "custom_id");
+        if (json_is_string(id)) register_id(batch, json_string_value(id));
+        json_decref(obj);
+    }
+
+    TM_FREE(content);
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Lifecycle
+ * ========================================================================== */
+
+tm_batch_t *tm_batch_open(tm_llm_client_t *client, const char *dir)
+{
+    if (!client || !dir) return NULL;
+
+    if (tm_mkdir_p(dir) != TM_OK) {
+        TM_ERROR("Cannot create batch directory: %s", dir);
+        return NULL;
+    }
+
+    tm_batch_t *batch = tm_calloc(1, sizeof(tm_batch_t));
+    batch->client = client;
+    batch->dir = tm_strdup(dir);
+    tm_strmap_init(&batch->ids);
+
+    tm_error_t err = load_state(batch);
+    if (err == TM_ERR_INVALID_ARG) {
+        tm_batch_free(batch);
+        return NULL;
+    }
+
+    if (err == TM_OK && batch->status != TM_BATCH_STAGING) {
+        if (load_request_ids(batch) != TM_OK) {
+            TM_ERROR("Batch state in %s has no requests file", dir);
+            tm_batch_free(batch);
+            return NULL;
+        }
+        TM_INFO("Resuming batch %s (%s, %zu requests)",
+                batch->batch_id ? batch->batch_id : "?",
+                tm_batch_status_name(batch->status), batch->request_count);
+        return batch;
+    }
+
+    /* Discard anything staged by an interrupted run */
+    batch->status = TM_BATCH_STAGING;
+    char *requests = batch_path(batch, REQUESTS_FILE);
+    char *results = batch_path(batch, RESULTS_FILE);
+    remove(requests);
+    remove(results);
+    TM_FREE(requests);
+    TM_FREE(results);
+
+    return batch;
+}
+
+void tm_batch_free(tm_batch_t *batch)
+{
+    if (!batch) return;
+
+    if (batch->staging) fclose(batch->staging);
+
+    for (size_t i = 0; i < batch->request_count; i++) {
+        if (batch->results) {
+            TM_FREE(batch->results[i].custom_id);
+            tm_chat_response_free(batch->results[i].response);
+            TM_FREE(batch->results[i].error);
+        }
+        TM_FREE(batch->custom_ids[i]);
+    }
+    TM_FREE(batch->results);
+    TM_FREE(batch->custom_ids);
+    tm_strmap_free(&batch->ids);
+
+    TM_FREE(batch->dir);
+    TM_FREE(batch->batch_id);
+    TM_FREE(batch->input_file_id);
+    TM_FREE(batch->output_file_id);
+    TM_FREE(batch->error_file_id);
+    TM_FREE(batch->results_url);
+    free(batch);
+}
+
+/* ============================================================================
+ * Staging
+ * ========================================================================== */
+
+tm_error_t tm_batch_add(tm_batch_t *batch,
+                        const char *custom_id,
+                        const tm_chat_request_t *request)
+{
+    TM_CHECK_NULL(batch, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(custom_id, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(request, TM_ERR_INVALID_ARG);
+
+    if (batch->status != TM_BATCH_STAGING) {
+        TM_ERROR("Batch already submitted; cannot add %s", custom_id);
+        return TM_ERR_INVALID_ARG;
+    }
+    if (!valid_custom_id(custom_id) || tm_strmap_get(&batch->ids, custom_id, NULL)) {
+        TM_ERROR("Invalid or duplicate batch custom_id: %s", custom_id);
+        return TM_ERR_INVALID_ARG;
+    }
+
+    const tm_llm_client_t *client = batch->client;
+    char *body = client->provider == TM_LLM_ANTHROPIC
+        ? tm_anthropic_build_request(request, client->model)
+        : tm_openai_build_request(request, client->model);
+    if (!body) return TM_ERR_INTERNAL;
+
+    json_error_t jerr;
+    json_t *params = json_loads(body, 0, &jerr);
+    TM_FREE(body);
+    if (!params) return TM_ERR_INTERNAL;
+
+    /* One line per request in the provider's batch input format */
+    json_t *line = json_object();
+    json_object_set_new(line, "custom_id", json_string(custom_id));
+    if (client->provider == TM_LLM_ANTHROPIC) {
+        json_object_set_new(line, "params", params);
+    } else {
+        json_object_set_new(line, "method", json_string("POST"));
+        json_object_set_new(line, "url", json_string(endpoint_path(client)));
+        json_object_set_new(line, "body", params);
+    }
+
+    char *text = json_dumps(line, JSON_COMPACT);
+    json_decref(line);
+    if (!text) return TM_ERR_NOMEM;
+
+    if (!batch->staging) {
+        char *path = batch_path(batch, REQUESTS_FILE);
+        batch->staging = fopen(path, "a");
+        TM_FREE(path);
+        if (!batch->staging) {
+            free(text);
+            return TM_ERR_IO;
+        }
+    }
+
+    bool ok = fputs(text, batch->staging) >= 0 && fputc('\n', batch->staging) != EOF;
+    free(text);
+    if (!ok) return TM_ERR_IO;
+
+    register_id(batch, custom_id);
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Submission
+ * ========================================================================== */
+
+/* Map an OpenAI batch object onto our state */
+static void apply_openai_batch(tm_batch_t *batch, json_t *obj)
+{
+    set_string(&batch->batch_id, json_object_get(obj, "id"));
+    set_string(&batch->output_file_id, json_object_get(obj, "output_file_id"));
+    set_string(&batch->error_file_id, json_object_get(obj, "error_file_id"));
+
+    const char *status = json_string_value(json_object_get(obj, "status"));
+    if (!status) return;
+
+    if (strcmp(status, "completed") == 0) {
+        batch->status = TM_BATCH_COMPLETED;
+    } else if (strcmp(status, "failed") == 0 || strcmp(status, "expired") == 0 ||
+               strcmp(status, "cancelled") == 0) {
+        /* Expired/cancelled batches may still carry partial output */
+        batch->status = (batch->output_file_id || batch->error_file_id)
+            ? TM_BATCH_COMPLETED : TM_BATCH_FAILED;
+    } else {
+        batch->status = TM_BATCH_SUBMITTED;   /* validating, in_progress, finalizing, ... */
+    }
+
+    json_t *counts = json_object_get(obj, "request_counts");
+    TM_DEBUG("OpenAI batch %s: %s (%lld/%lld done, %lld failed)",
+             batch->batch_id ? batch->batch_id : "?", status,
+             (long long)json_integer_value(json_object_get(counts, "completed")),
+             (long long)json_integer_value(json_object_get(counts, "total")),
+             (long long)json_integer_value(json_object_get(counts, "failed")));
+}
+
+/* Map an Anthropic message batch object onto our state */
+static void apply_anthropic_batch(tm_batch_t *batch, json_t *obj)
+{
+    set_string(&batch->batch_id, json_object_get(obj, "id"));
+    set_string(&batch->results_url, json_object_get(obj, "results_url"));
+
+    const char *status = json_string_value(json_object_get(obj, "processing_status"));
+    if (!status) return;
+
+    batch->status = strcmp(status, "ended") == 0 ? TM_BATCH_COMPLETED : TM_BATCH_SUBMITTED;
+
+    json_t *counts = json_object_get(obj, "request_counts");
+    TM_DEBUG("Anthropic batch %s: %s (%lld processing, %lld succeeded, %lld errored)",
+             batch->batch_id ? batch->batch_id : "?", status,
+             (long long)json_integer_value(json_object_get(counts, "processing")),
+             (long long)json_integer_value(json_object_get(counts, "succeeded")),
+             (long long)json_integer_value(json_object_get(counts, "errored")));
+}
+
+/* Upload requests.jsonl and record the file ID before the batch is created */
+static tm_error_t upload_openai_requests(tm_batch_t *batch, const char *base)
+{
+    char *path = batch_path(batch, REQUESTS_FILE);
+    curl_mime *mime = curl_mime_init(batch->client->curl);
+
+    curl_mimepart *part = curl_mime_addpart(mime);
+    curl_mime_name(part, "purpose");
+    curl_mime_data(part, "batch", CURL_ZERO_TERMINATED);
+
+    part = curl_mime_addpart(mime);
+    curl_mime_name(part, "file");
+    curl_mime_filedata(part, path);
+    curl_mime_filename(part, REQUESTS_FILE);
+    curl_mime_type(part, "application/jsonl");
+
+    tm_strbuf_t url;
+    tm_strbuf_init(&url);
+    tm_strbuf_appendf(&url, "%s/files", base);
+
+    json_t *file = NULL;
+    tm_error_t err = batch_http_json(batch, url.data, NULL, mime, &file);
+    curl_mime_free(mime);
+    tm_strbuf_free(&url);
+    TM_FREE(path);
+    if (err != TM_OK) return err;
+
+    set_string(&batch->input_file_id, json_object_get(file, "id"));
+    json_decref(file);
+    if (!batch->input_file_id) return TM_ERR_PARSE;
+
+    /* Saved before the next request, so a rerun never uploads twice */
+    batch->status = TM_BATCH_UPLOADED;
+    return save_state(batch);
+}
+
+static tm_error_t submit_openai(tm_batch_t *batch)
+{
+    char *base = openai_base_url(batch->client);
+    if (!base) {
+        TM_ERROR("Batch mode needs an endpoint ending in /chat/completions");
+        return TM_ERR_UNSUPPORTED;
+    }
+
+    /* 1. Upload the requests file, unless an interrupted run already did */
+    tm_error_t err = TM_OK;
+    if (batch->status == TM_BATCH_UPLOADED && batch->input_file_id) {
+        TM_INFO("Reusing uploaded requests file %s", batch->input_file_id);
+    } else {
+        err = upload_openai_requests(batch, base);
+    }
+    if (err != TM_OK) {
+        TM_FREE(base);
+        return err;
+    }
+
+    /* 2. Create the batch */
+    json_t *req = json_object();
+    json_object_set_new(req, "input_file_id", json_string(batch->input_file_id));
+    json_object_set_new(req, "endpoint", json_string(endpoint_path(batch->client)));
+    json_object_set_new(req, "completion_window", json_string(OPENAI_COMPLETION_WINDOW));
+    char *body = json_dumps(req, JSON_COMPACT);
+    json_decref(req);
+
+    char *create_url = batches_url(batch, NULL);
+    json_t *obj = NULL;
+    err = batch_http_json(batch, create_url, body, NULL, &obj);
+    TM_FREE(create_url);
+    free(body);
+    TM_FREE(base);
+
+    if (err != TM_OK) return err;
+
+    apply_openai_batch(batch, obj);
+    json_decref(obj);
+    return batch->batch_id ? TM_OK : TM_ERR_PARSE;
+}
+
+static tm_error_t submit_anthropic(tm_batch_t *batch)
+{
+    char *path = batch_path(batch, REQUESTS_FILE);
+    char *content = tm_read_file(path, NULL);
+    TM_FREE(path);
+    if (!content) return TM_ERR_IO;
+
+    /* Lines are already {custom_id, params}; wrap them in {"requests": [...]} */
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_append(&sb, "{\"requests\":[");
+
+    bool first = true;
+    char *save = NULL;
+    for (char *line = strtok_r(content, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        if (!first) tm_strbuf_append(&sb, ",");
+        tm_strbuf_append(&sb, line);
+        first = false;
+    }
+    tm_strbuf_append(&sb, "]}");
+    TM_FREE(content);
+
+    char *url = batches_url(batch, NULL);
+    json_t *obj = NULL;
+    tm_error_t err = batch_http_json(batch, url, sb.data, NULL, &obj);
+    TM_FREE(url);
+    tm_strbuf_free(&sb);
+
+    if (err != TM_OK) return err;
+
+    apply_anthropic_batch(batch, obj);
+    json_decref(obj);
+    return batch->batch_id ? TM_OK : TM_ERR_PARSE;
+}
+
+tm_error_t tm_batch_submit(tm_batch_t *batch)
+{
+    TM_CHECK_NULL(batch, TM_ERR_INVALID_ARG);
+
+    if (batch->status != TM_BATCH_STAGING && batch->status != TM_BATCH_UPLOADED) return TM_OK;
+    if (batch->request_count == 0) return TM_ERR_INVALID_ARG;
+
+    if (batch->staging) {
+        fclose(batch->staging);
+        batch->staging = NULL;
+    }
+
+    tm_error_t err;
+    switch (batch->client->provider) {
+    case TM_LLM_OPENAI:
+        err = submit_openai(batch);
+        break;
+    case TM_LLM_ANTHROPIC:
+        err = submit_anthropic(batch);
+        break;
+    default:
+        TM_ERROR("Batch mode is not supported for provider %s",
+                 provider_name(batch->client->provider));
+        return TM_ERR_UNSUPPORTED;
+    }
+
+    if (err != TM_OK) {
+        TM_ERROR("Batch submission failed: %s", tm_strerror(err));
+        return err;
+    }
+
+    /* Saved before anything else can fail: a rerun polls this batch */
+    if (batch->status == TM_BATCH_STAGING || batch->status == TM_BATCH_UPLOADED) {
+        batch->status = TM_BATCH_SUBMITTED;
+    }
+    batch->submitted_at = tm_timestamp_ms();
+    err = save_state(batch);
+
+    TM_INFO("Submitted batch %s with %zu requests", batch->batch_id, batch->request_count);
+    return err;
+}
+
+/* ============================================================================
+ * Polling
+ * ========================================================================== */
+
+tm_error_t tm_batch_poll(tm_batch_t *batch)
+{
+    TM_CHECK_NULL(batch, TM_ERR_INVALID_ARG);
+
+    if (batch->status != TM_BATCH_SUBMITTED) return TM_OK;
+    if (!batch->batch_id) return TM_ERR_INVALID_ARG;
+
+    char *url = batches_url(batch, batch->batch_id);
+    json_t *obj = NULL;
+    tm_error_t err = batch_http_json(batch, url, NULL, NULL, &obj);
+    TM_FREE(url);
+    if (err != TM_OK) return err;
+
+    if (batch->client->provider == TM_LLM_ANTHROPIC) {
+        apply_anthropic_batch(batch, obj);
+    } else {
+        apply_openai_batch(batch, obj);
+    }
+    json_decref(obj);
+
+    return save_state(batch);
+}
+
+tm_error_t tm_batch_wait(tm_batch_t *batch, int poll_interval_ms, int timeout_ms)
+{
+    TM_CHECK_NULL(batch, TM_ERR_INVALID_ARG);
+
+    int64_t start = tm_timestamp_ms();
+    int failures = 0;
+
+    for (;;) {
+        tm_error_t err = tm_batch_poll(batch);
+        if (err != TM_OK) {
+            /* Ride out transient API errors; the batch keeps running */
+            if (++failures >= MAX_POLL_FAILURES) return err;
+            TM_WARN("Batch poll failed (%d/%d): %s", failures, MAX_POLL_FAILURES,
+                    tm_strerror(err));
+        } else {
+            failures = 0;
+        }
+
+        if (batch->status == TM_BATCH_COMPLETED) return TM_OK;
+        if (batch->status == TM_BATCH_FAILED) return TM_ERR_LLM;
+        if (batch->status == TM_BATCH_STAGING) return TM_ERR_INVALID_ARG;
+
+        int64_t elapsed = tm_timestamp_ms() - start;
+        if (timeout_ms > 0 && elapsed >= timeout_ms) return TM_ERR_TIMEOUT;
+
+        TM_INFO("Batch %s still running (%lld s elapsed)", batch->batch_id,
+                (long long)(elapsed / 1000));
+        sleep_ms(poll_interval_ms);
+    }
+}
+
+/* ============================================================================
+ * Results
+ * ========================================================================== */
+
+static char *download(tm_batch_t *batch, const char *url)
+{
+    char *body = NULL;
+    return batch_http(batch, url, NULL, NULL, &body) == TM_OK ? body : NULL;
+}
+
+static char *openai_file_content(tm_batch_t *batch, const char *file_id)
+{
+    char *base = openai_base_url(batch->client);
+    tm_strbuf_t url;
+    tm_strbuf_init(&url);
+    tm_strbuf_appendf(&url, "%s/files/%s/content", base ? base : "", file_id);
+    char *content = download(batch, url.data);
+    tm_strbuf_free(&url);
+    TM_FREE(base);
+    return content;
+}
+
+/* Download results once; later calls (and resumed runs) reuse the file */
+static char *load_results(tm_batch_t *batch)
+{
+    char *path = batch_path(batch, RESULTS_FILE);
+    char *content = tm_read_file(path, NULL);
+    if (content) {
+        TM_FREE(path);
+        return content;
+    }
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    bool ok = true;
+
+    if (batch->client->provider == TM_LLM_ANTHROPIC) {
+        char *part = batch->results_url ? download(batch, batch->results_url) : NULL;
+        ok = part != NULL;
+        if (part) tm_strbuf_append(&sb, part);
+        TM_FREE(part);
+    } else {
+        const char *files[] = { batch->output_file_id, batch->error_file_id };
+        for (size_t i = 0; i < TM_ARRAY_SIZE(files) && ok; i++) {
+            if (!files[i]) continue;
+            char *part = openai_file_content(batch, files[i]);
+            ok = part != NULL;
+            if (part) {
+                tm_strbuf_append(&sb, part);
+                if (sb.len > 0 && sb.data[sb.len - 1] != '\n') tm_strbuf_append(&sb, "\n");
+            }
+            TM_FREE(part);
+        }
+    }
+
+    content = tm_strbuf_finish(&sb);
+    if (!ok) {
+        TM_FREE(content);
+    } else if (tm_write_file_atomic(path, content, strlen(content)) != TM_OK) {
+        TM_WARN("Could not cache batch results in %s", path);
+    }
+
+    TM_FREE(path);
+    return content;
+}
+
+static char *error_message(json_t *err, const char *fallback)
+{
+    json_t *msg = json_object_get(err, "message");
+    return tm_strdup(json_is_string(msg) ? json_string_value(msg) : fallback);
+}
+
+static void parse_openai_result(json_t *line, tm_batch_result_t *r)
+{
+    json_t *response = json_object_get(line, "response");
+    json_t *body = json_object_get(response, "body");
+    json_int_t status = json_integer_value(json_object_get(response, "status_code"));
+
+    if (status == 200 && json_is_object(body)) {
+        char *text = json_dumps(body, JSON_COMPACT);
+        if (text && tm_openai_parse_response(text, &r->response) != TM_OK) {
+            r->error = tm_strdup("unparseable response");
+        }
+        free(text);
+        return;
+    }
+
+    json_t *err = json_object_get(line, "error");
+    if (!json_is_object(err)) err = json_object_get(body, "error");
+
+    char fallback[32];
+    snprintf(fallback, sizeof(fallback), "HTTP %lld", (long long)status);
+    r->error = error_message(err, fallback);
+}
+
+static void parse_anthropic_result(json_t *line, tm_batch_result_t *r)
+{
+    json_t *result = json_object_get(line, "result");
+    const char *type = json_string_value(json_object_get(result, "type"));
+
+    if (type && strcmp(type, "succeeded") == 0) {
+        char *text = json_dumps(json_object_get(result, "message"), JSON_COMPACT);
+        if (text && tm_anthropic_parse_response(text, &r->response) != TM_OK) {
+            r->error = tm_strdup("unparseable response");
+        }
+        free(text);
+    } else if (type && strcmp(type, "errored") == 0) {
+        /* {"type":"errored","error":{"type":"error","error":{"message":...}}} */
+        json_t *err = json_object_get(result, "error");
+        json_t *inner = json_object_get(err, "error");
+        r->error = error_message(inner ? inner : err, "errored");
+    } else {
+        r->error = tm_strdup(type ? type : "missing result");   /* canceled, expired */
+    }
+}
+
+tm_error_t tm_batch_fetch_results(tm_batch_t *batch)
+{
+    TM_CHECK_NULL(batch, TM_ERR_INVALID_ARG);
+
+    if (batch->results) return TM_OK;
+    if (batch->status != TM_BATCH_COMPLETED) return TM_ERR_INVALID_ARG;
+
+    char *content = load_results(batch);
+    if (!content) return TM_ERR_LLM;
+
+    batch->results = tm_calloc(batch->request_count ? batch->request_count : 1,
+                               sizeof(tm_batch_result_t));
+    size_t matched = 0;
+
+    char *save = NULL;
+    for (char *line = strtok_r(content, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        json_error_t jerr;
+        json_t *obj = json_loads(line, 0, &jerr);
+        size_t idx;
+
+        const char *id = json_string_value(json_object_get(obj, "custom_id"));
+        if (!id || !tm_strmap_get(&batch->ids, id, &idx) || batch->results[idx].custom_id) {
+            TM_DEBUG("Skipping batch result line: %.80s", line);
+            json_decref(obj);
+            continue;
+        }
+
+        tm_batch_result_t *r = &batch->results[idx];
+        r->custom_id = tm_strdup(id);
+        if (batch->client->provider == TM_LLM_ANTHROPIC) {
+            parse_anthropic_result(obj, r);
+        } else {
+            parse_openai_result(obj, r);
+        }
+        matched++;
+        json_decref(obj);
+    }
+    TM_FREE(content);
+
+    /* Requests the provider never answered (e.g. batch expired) */
+    for (size_t i = 0; i < batch->request_count; i++) {
+        if (batch->results[i].custom_id) continue;
+        batch->results[i].custom_id = tm_strdup(batch->custom_ids[i]);
+        batch->results[i].error = tm_strdup("no result returned");
+    }
+
+    TM_INFO("Batch %s: %zu/%zu results", batch->batch_id ? batch->batch_id : "?",
+            matched, batch->request_count);
+    return TM_OK;
+}
+
+const tm_batch_result_t *tm_batch_get_result(const tm_batch_t *batch,
+                                             const char *custom_id)
+{
+    size_t idx;
+    if (!batch || !batch->results || !tm_strmap_get(&batch->ids, custom_id, &idx)) {
+        return NULL;
+    }
+    return &batch->results[idx];
+}
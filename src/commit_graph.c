@@ -0,0 +1,351 @@
+/**
+ * TraceMind - Commit-Graph Reader
+ *
+ * Format: Documentation/gitformat-commit-graph.txt in git.git. Bloom keys
+ * follow bloom.c there: seeded murmur3, double hashing, one key per path.
+ */
+
+#include "internal/common.h"
+#include "internal/commit_graph.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#define GRAPH_SIGNATURE 0x43475048u   /* "CGPH" */
+#define CHUNK_OIDF 0x4f494446u
+#define CHUNK_OIDL 0x4f49444cu
+#define CHUNK_BIDX 0x42494458u
+#define CHUNK_BDAT 0x42444154u
+#define GRAPH_HEADER_SIZE 8
+#define CHUNK_ENTRY_SIZE 12
+#define BDAT_HEADER_SIZE 12
+
+#define BLOOM_MAX_HASHES 32
+
+/* ============================================================================
+ * Helpers
+ * ========================================================================== */
+
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint64_t be64(const uint8_t *p)
+{
+    return ((uint64_t)be32(p) << 32) | be32(p + 4);
+}
+
+static uint32_t rotl32(uint32_t x, int r)
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+/*
+ * Seeded murmur3 (x86, 32-bit). Version 1 filters were written by a git
+ * that sign-extended bytes >= 0x80; version 2 reads them unsigned.
+ */
+uint32_t tm_commit_graph_murmur3(uint32_t seed, const char *data, size_t len,
+                                 uint32_t version)
+{
+    const uint32_t c1 = 0xcc9e2d51, c2 = 0x1b873593;
+    bool sign_extend = version == 1;
+    size_t blocks = len / 4;
+
+#define BYTE(x) (sign_extend ? (uint32_t)(int32_t)(signed char)(x) : (uint32_t)(unsigned char)(x))
+
+    for (size_t i = 0; i < blocks; i++) {
+        const char *b = data + 4 * i;
+        uint32_t k = BYTE(b[0]) | (BYTE(b[1]) << 8) | (BYTE(b[2]) << 16) | (BYTE(b[3]) << 24);
+        k *= c1;
+        k = rotl32(k, 15);
+        k *= c2;
+        seed ^= k;
+        seed = rotl32(seed, 13) * 5 + 0xe6546b64;
+    }
+
+    const char *tail = data + 4 * blocks;
+    uint32_t k1 = 0;
+    switch (len & 3) {
+        case 3: k1 ^= BYTE(tail[2]) << 16; /* fall through */
+        case 2: k1 ^= BYTE(tail[1]) << 8;  /* fall through */
+        case 1:
+            k1 ^= BYTE(tail[0]);
+            k1 *= c1;
+            k1 = rotl32(k1, 15);
+            k1 *= c2;
+            seed ^= k1;
+            break;
+        default:
+            break;
+    }
+
+#undef BYTE
+
+    seed ^= (uint32_t)len;
+    seed ^= seed >> 16;
+    seed *= 0x85ebca6b;
+    seed ^= seed >> 13;
+    seed *= 0xc2b2ae35;
+    seed ^= seed >> 16;
+    return seed;
+}
+
+/* ============================================================================
+ * Loading
+ * ========================================================================== */
+
+static tm_error_t layer_open(const char *file, tm_commit_graph_layer_t *layer)
+{
+    memset(layer, 0, sizeof(*layer));
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? TM_ERR_NOT_FOUND : TM_ERR_IO;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < GRAPH_HEADER_SIZE) {
+        close(fd);
+        return TM_ERR_PARSE;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return TM_ERR_IO;
+
+    const uint8_t *base = map;
+    layer->map = map;
+    layer->map_size = size;
+
+    /* Version 1, SHA-1 only */
+    if (be32(base) != GRAPH_SIGNATURE || base[4] != 1 || base[5] != 1) {
+        goto invalid;
+    }
+
+    size_t chunk_count = base[6];
+    if (GRAPH_HEADER_SIZE + (chunk_count + 1) * CHUNK_ENTRY_SIZE > size) goto invalid;
+
+    const uint8_t *bdat = NULL;
+    size_t bdat_size = 0, bidx_size = 0, oidl_size = 0;
+
+    for (size_t i = 0; i < chunk_count; i++) {
+        const uint8_t *entry = base + GRAPH_HEADER_SIZE + i * CHUNK_ENTRY_SIZE;
+        uint32_t id = be32(entry);
+        uint64_t start = be64(entry + 4);
+        uint64_t end = be64(entry + 4 + CHUNK_ENTRY_SIZE);
+        if (start > end || end > size) goto invalid;
+
+        const uint8_t *chunk = base + start;
+        size_t chunk_size = (size_t)(end - start);
+
+        switch (id) {
+            case CHUNK_OIDF:
+                if (chunk_size != 256 * 4) goto invalid;
+                layer->fanout = chunk;
+                break;
+            case CHUNK_OIDL:
+                layer->oids = chunk;
+                oidl_size = chunk_size;
+                break;
+            case CHUNK_BIDX:
+                layer->bloom_index = chunk;
+                bidx_size = chunk_size;
+                break;
+            case CHUNK_BDAT:
+                bdat = chunk;
+                bdat_size = chunk_size;
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (!layer->fanout || !layer->oids) goto invalid;
+
+    layer->commit_count = be32(layer->fanout + 255 * 4);
+    if ((size_t)layer->commit_count * TM_COMMIT_GRAPH_OID_SIZE != oidl_size) goto invalid;
+
+    /* Bloom filters are optional; ignore them if malformed */
+    if (layer->bloom_index && bdat && bdat_size >= BDAT_HEADER_SIZE &&
+        bidx_size == (size_t)layer->commit_count * 4) {
+        layer->bloom_version = be32(bdat);
+        layer->bloom_hashes = be32(bdat + 4);
+        layer->bloom_data = bdat + BDAT_HEADER_SIZE;
+        layer->bloom_data_size = bdat_size - BDAT_HEADER_SIZE;
+
+        if ((layer->bloom_version != 1 && layer->bloom_version != 2) ||
+            layer->bloom_hashes == 0 || layer->bloom_hashes > BLOOM_MAX_HASHES) {
+            layer->bloom_index = NULL;
+            layer->bloom_data = NULL;
+        }
+    } else {
+        layer->bloom_index = NULL;
+    }
+
+    return TM_OK;
+
+invalid:
+    munmap(map, size);
+    memset(layer, 0, sizeof(*layer));
+    return TM_ERR_PARSE;
+}
+
+tm_error_t tm_commit_graph_open(const char *objects_dir, tm_commit_graph_t **graph)
+{
+    TM_CHECK_NULL(objects_dir, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(graph, TM_ERR_INVALID_ARG);
+
+    *graph = NULL;
+
+    tm_commit_graph_t *g = tm_calloc(1, sizeof(tm_commit_graph_t));
+    size_t cap = 0;
+    char path[PATH_MAX];
+
+    /* Single file first, then a split chain */
+    snprintf(path, sizeof(path), "%s/info/commit-graph", objects_dir);
+    tm_commit_graph_layer_t layer;
+    tm_error_t err = layer_open(path, &layer);
+
+    if (err == TM_OK) {
+        TM_VEC_PUSH(g->layers, g->layer_count, cap, layer);
+    } else if (err == TM_ERR_NOT_FOUND) {
+        snprintf(path, sizeof(path), "%s/info/commit-graphs/commit-graph-chain", objects_dir);
+        FILE *chain = fopen(path, "r");
+
+        if (chain) {
+            char line[128];
+            while (fgets(line, sizeof(line), chain)) {
+                line[strcspn(line, "\r\n")] = '\0';
+                if (!line[0]) continue;
+
+                snprintf(path, sizeof(path), "%s/info/commit-graphs/graph-%s.graph",
+                         objects_dir, line);
+                err = layer_open(path, &layer);
+                if (err != TM_OK) break;
+                TM_VEC_PUSH(g->layers, g->layer_count, cap, layer);
+            }
+            fclose(chain);
+        }
+    }
+
+    if (err != TM_OK || g->layer_count == 0) {
+        tm_commit_graph_free(g);
+        return err != TM_OK ? err : TM_ERR_NOT_FOUND;
+    }
+
+    TM_DEBUG("Loaded commit-graph (%zu layer%s, bloom filters: %s)",
+             g->layer_count, g->layer_count == 1 ? "" : "s",
+             tm_commit_graph_has_bloom(g) ? "yes" : "no");
+
+    *graph = g;
+    return TM_OK;
+}
+
+void tm_commit_graph_free(tm_commit_graph_t *graph)
+{
+    if (!graph) return;
+
+    for (size_t i = 0; i < graph->layer_count; i++) {
+        munmap(graph->layers[i].map, graph->layers[i].map_size);
+    }
+    free(graph->layers);
+    free(graph);
+}
+
+/* ============================================================================
+ * Queries
+ * ========================================================================== */
+
+bool tm_commit_graph_has_bloom(const tm_commit_graph_t *graph)
+{
+    if (!graph) return false;
+
+    for (size_t i = 0; i < graph->layer_count; i++) {
+        if (graph->layers[i].bloom_index) return true;
+    }
+    return false;
+}
+
+/* Position of oid in layer, or -1 */
+static int64_t layer_find(const tm_commit_graph_layer_t *layer, const uint8_t *oid)
+{
+    uint32_t lo = oid[0] == 0 ? 0 : be32(layer->fanout + (oid[0] - 1) * 4);
+    uint32_t hi = be32(layer->fanout + oid[0] * 4);
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(layer->oids + (size_t)mid * TM_COMMIT_GRAPH_OID_SIZE, oid,
+                         TM_COMMIT_GRAPH_OID_SIZE);
+        if (cmp == 0) return mid;
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return -1;
+}
+
+static bool filter_contains_key(const uint8_t *filter, size_t len,
+                                const tm_commit_graph_layer_t *layer,
+                                const char *key, size_t key_len)
+{
+    uint32_t hash0 = tm_commit_graph_murmur3(TM_BLOOM_SEED0, key, key_len, layer->bloom_version);
+    uint32_t hash1 = tm_commit_graph_murmur3(TM_BLOOM_SEED1, key, key_len, layer->bloom_version);
+    uint64_t bits = (uint64_t)len * 8;
+
+    for (uint32_t i = 0; i < layer->bloom_hashes; i++) {
+        uint64_t bit = (uint32_t)(hash0 + i * hash1) % bits;
+        if (!(filter[bit / 8] & (1u << (bit & 7)))) return false;
+    }
+    return true;
+}
+
+/*
+ * git adds every leading directory of a changed path to the filter, so
+ * requiring "a/b/c.py", "a/b" and "a" all to be present (as git log does)
+ * cuts the false-positive rate well below a single-key probe.
+ */
+static bool filter_contains(const uint8_t *filter, size_t len,
+                            const tm_commit_graph_layer_t *layer,
+                            const char *path)
+{
+    size_t path_len = strlen(path);
+    if (!filter_contains_key(filter, len, layer, path, path_len)) return false;
+
+    for (size_t i = path_len; i > 0; i--) {
+        if (path[i - 1] == '/' && i > 1 &&
+            !filter_contains_key(filter, len, layer, path, i - 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int tm_commit_graph_maybe_changed(const tm_commit_graph_t *graph,
+                                  const uint8_t oid[TM_COMMIT_GRAPH_OID_SIZE],
+                                  const char **paths,
+                                  size_t path_count)
+{
+    if (!graph || !oid) return -1;
+
+    for (size_t i = 0; i < graph->layer_count; i++) {
+        const tm_commit_graph_layer_t *layer = &graph->layers[i];
+
+        int64_t pos = layer_find(layer, oid);
+        if (pos < 0) continue;
+        if (!layer->bloom_index) return -1;
+
+        uint32_t start = pos == 0 ? 0 : be32(layer->bloom_index + (pos - 1) * 4);
+        uint32_t end = be32(layer->bloom_index + pos * 4);
+
+        /* Empty filters mean "not computed" */
+        if (end <= start || end > layer->bloom_data_size) return -1;
+
+        for (size_t p = 0; p < path_count; p++) {
+            if (filter_contains(layer->bloom_data + start, end - start, layer, paths[p])) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    return -1;
+}
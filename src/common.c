@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <limits.h>
 #include <strings.h>  /* For strcasecmp on POSIX */
+#include <sys/stat.h>
 
 /* Global log level */
 tm_log_level_t g_log_level = TM_LOG_WARN;
@@ -239,6 +240,76 @@ char *tm_read_file(const char *path, size_t *size)
     return content;
 }
 
+tm_error_t tm_write_file_atomic(const char *path, const char *data, size_t len)
+{
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(data, TM_ERR_INVALID_ARG);
+    
+    /*
+     * Write a sibling temp file, then rename over the target. mkstemp gives
+     * each writer its own file, so threads writing the same target never
+     * share one.
+     */
+    char tmp_path[PATH_MAX];
+    int n = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.XXXXXX", path);
+    if (n < 0 || (size_t)n >= sizeof(tmp_path)) return TM_ERR_INVALID_ARG;
+    
+    int fd = mkstemp(tmp_path);
+    if (fd < 0) {
+        TM_DEBUG("Failed to create %s: %s", tmp_path, strerror(errno));
+        return TM_ERR_IO;
+    }
+    
+    /* mkstemp creates 0600; cache files are readable like any other */
+    fchmod(fd, 0644);
+    
+    FILE *f = fdopen(fd, "wb");
+    if (!f) {
+        TM_DEBUG("Failed to open %s: %s", tmp_path, strerror(errno));
+        close(fd);
+        remove(tmp_path);
+        return TM_ERR_IO;
+    }
+    
+    bool ok = fwrite(data, 1, len, f) == len;
+    ok = (fclose(f) == 0) && ok;
+    
+    if (!ok || rename(tmp_path, path) != 0) {
+        TM_DEBUG("Failed to write %s: %s", path, strerror(errno));
+        remove(tmp_path);
+        return TM_ERR_IO;
+    }
+    
+    return TM_OK;
+}
+
+tm_error_t tm_mkdir_p(const char *path)
+{
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    
+    char buf[PATH_MAX];
+    size_t len = strlen(path);
+    if (len == 0 || len >= sizeof(buf)) return TM_ERR_INVALID_ARG;
+    memcpy(buf, path, len + 1);
+    
+    /* Create each missing component in turn */
+    for (char *p = buf + 1; ; p++) {
+        if (*p != '/' && *p != '\0') continue;
+        
+        char saved = *p;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST) {
+            TM_DEBUG("Failed to create directory %s: %s", buf, strerror(errno));
+            return TM_ERR_IO;
+        }
+        *p = saved;
+        
+        if (saved == '\0') break;
+    }
+    
+    return TM_OK;
+}
+
 /* ============================================================================
  * UUID Generation
  * ========================================================================== */
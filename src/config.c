@@ -18,7 +18,12 @@
 #define DEFAULT_TIMEOUT_MS 60000
 #define DEFAULT_TEMPERATURE 0.3f
 #define DEFAULT_MAX_COMMITS 20
+#define DEFAULT_INCIDENT_WINDOW_HOURS 168
 #define DEFAULT_MAX_CALL_DEPTH 5
+#define DEFAULT_SOURCE_CONTEXT_LINES 5
+#define DEFAULT_CONTEXT_TOKENS 32000
+#define DEFAULT_MAX_PARALLEL_REQUESTS 4
+#define DEFAULT_BATCH_POLL_MS 30000
 
 /* ============================================================================
  * Configuration Creation
@@ -35,12 +40,26 @@ tm_config_t *tm_config_new(void)
     cfg->model_name = tm_strdup(DEFAULT_MODEL);
     cfg->timeout_ms = DEFAULT_TIMEOUT_MS;
     cfg->temperature = DEFAULT_TEMPERATURE;
+    cfg->map_model = NULL;
+    cfg->context_tokens = DEFAULT_CONTEXT_TOKENS;
+    cfg->max_parallel_requests = DEFAULT_MAX_PARALLEL_REQUESTS;
+    cfg->requests_per_minute = 0;
+    cfg->tokens_per_minute = 0;
+    cfg->batch_poll_ms = DEFAULT_BATCH_POLL_MS;
     
     /* Analysis defaults */
     cfg->max_commits = DEFAULT_MAX_COMMITS;
     cfg->max_call_depth = DEFAULT_MAX_CALL_DEPTH;
     cfg->include_stdlib = false;
     cfg->include_tests = false;
+    cfg->history_index = true;
+    cfg->blame_cache = true;
+    cfg->ast_cache = true;
+    cfg->symbol_index = true;
+    cfg->source_context_lines = DEFAULT_SOURCE_CONTEXT_LINES;
+    cfg->git_workers = 0;
+    cfg->incident_time = 0;
+    cfg->incident_window_hours = DEFAULT_INCIDENT_WINDOW_HOURS;
     
     /* Output defaults */
     cfg->output_format = TM_OUTPUT_CLI;
@@ -61,11 +80,60 @@ void tm_config_free(tm_config_t *cfg)
     TM_FREE(cfg->api_key);
     TM_FREE(cfg->api_endpoint);
     TM_FREE(cfg->model_name);
+    TM_FREE(cfg->map_model);
     TM_FREE(cfg->repo_path);
     TM_FREE(cfg->cache_dir);
     free(cfg);
 }
 
+bool tm_config_needs_api_key(const tm_config_t *cfg)
+{
+    if (!cfg) return true;
+    if (cfg->llm_provider == TM_LLM_LOCAL) return false;
+    if (!cfg->api_endpoint) return true;
+    
+    /* Skip the scheme, then match the host against loopback names */
+    const char *host = strstr(cfg->api_endpoint, "://");
+    host = host ? host + 3 : cfg->api_endpoint;
+    
+    static const char *loopback[] = { "localhost", "127.0.0.1", "[::1]" };
+    for (size_t i = 0; i < TM_ARRAY_SIZE(loopback); i++) {
+        size_t len = strlen(loopback[i]);
+        if (strncmp(host, loopback[i], len) == 0 &&
+            (host[len] == '\0' || host[len] == ':' || host[len] == '/')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+char *tm_config_cache_dir(const tm_config_t *cfg)
+{
+    if (cfg && cfg->cache_dir) return tm_strdup(cfg->cache_dir);
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0]) {
+        tm_strbuf_appendf(&sb, "%s/tracemind", xdg);
+        return tm_strbuf_finish(&sb);
+    }
+    
+    const char *home = getenv("HOME");
+    if (!home) {
+        struct passwd *pw = getpwuid(getuid());
+        if (pw) home = pw->pw_dir;
+    }
+    if (!home) {
+        tm_strbuf_free(&sb);
+        return NULL;
+    }
+    
+    tm_strbuf_appendf(&sb, "%s/.cache/tracemind", home);
+    return tm_strbuf_finish(&sb);
+}
+
 /* ============================================================================
  * Environment Variable Loading
  * ========================================================================== */
@@ -98,6 +166,12 @@ tm_error_t tm_config_load_env(tm_config_t *cfg)
         TM_DEBUG("Using model from environment: %s", model);
     }
     
+    const char *map_model = getenv("TRACEMIND_MAP_MODEL");
+    if (map_model && strlen(map_model) > 0) {
+        TM_FREE(cfg->map_model);
+        cfg->map_model = tm_strdup(map_model);
+    }
+    
     /* Endpoint override */
     const char *endpoint = getenv("TRACEMIND_ENDPOINT");
     if (endpoint && strlen(endpoint) > 0) {
@@ -249,6 +323,37 @@ tm_error_t tm_config_load(tm_config_t *cfg, const char *path)
         cfg->temperature = (float)json_real_value(val);
     }
     
+    val = json_object_get(root, "map_model");
+    if (val && json_is_string(val)) {
+        TM_FREE(cfg->map_model);
+        cfg->map_model = tm_strdup(json_string_value(val));
+    }
+    
+    val = json_object_get(root, "context_tokens");
+    if (val && json_is_integer(val)) {
+        cfg->context_tokens = (int)json_integer_value(val);
+    }
+    
+    val = json_object_get(root, "max_parallel_requests");
+    if (val && json_is_integer(val)) {
+        cfg->max_parallel_requests = (int)json_integer_value(val);
+    }
+    
+    val = json_object_get(root, "requests_per_minute");
+    if (val && json_is_integer(val)) {
+        cfg->requests_per_minute = (int)json_integer_value(val);
+    }
+    
+    val = json_object_get(root, "tokens_per_minute");
+    if (val && json_is_integer(val)) {
+        cfg->tokens_per_minute = (int)json_integer_value(val);
+    }
+    
+    val = json_object_get(root, "batch_poll_ms");
+    if (val && json_is_integer(val)) {
+        cfg->batch_poll_ms = (int)json_integer_value(val);
+    }
+    
     /* Analysis settings */
     val = json_object_get(root, "max_commits");
     if (val && json_is_integer(val)) {
@@ -270,6 +375,41 @@ tm_error_t tm_config_load(tm_config_t *cfg, const char *path)
         cfg->include_tests = json_boolean_value(val);
     }
     
+    val = json_object_get(root, "history_index");
+    if (val && json_is_boolean(val)) {
+        cfg->history_index = json_boolean_value(val);
+    }
+    
+    val = json_object_get(root, "blame_cache");
+    if (val && json_is_boolean(val)) {
+        cfg->blame_cache = json_boolean_value(val);
+    }
+    
+    val = json_object_get(root, "ast_cache");
+    if (val && json_is_boolean(val)) {
+        cfg->ast_cache = json_boolean_value(val);
+    }
+    
+    val = json_object_get(root, "symbol_index");
+    if (val && json_is_boolean(val)) {
+        cfg->symbol_index = json_boolean_value(val);
+    }
+    
+    val = json_object_get(root, "source_context_lines");
+    if (val && json_is_integer(val)) {
+        cfg->source_context_lines = (int)json_integer_value(val);
+    }
+    
+    val = json_object_get(root, "git_workers");
+    if (val && json_is_integer(val)) {
+        cfg->git_workers = (int)json_integer_value(val);
+    }
+    
+    val = json_object_get(root, "incident_window_hours");
+    if (val && json_is_integer(val)) {
+        cfg->incident_window_hours = (int)json_integer_value(val);
+    }
+    
     /* Output settings */
     val = json_object_get(root, "output_format");
     if (val && json_is_string(val)) {
@@ -2,11 +2,17 @@
  * TraceMind - Git Context Collector
  * 
  * Uses libgit2 for repository analysis.
- * Compiles as stub when HAVE_LIBGIT2 is not defined.
+ * Without HAVE_LIBGIT2 the core API comes from git_native.c and the rest
+ * compiles as stubs.
  */
 
 #include "internal/common.h"
 #include "internal/git.h"
+#include "internal/git_registry.h"
+#include "internal/interval.h"
+#include "internal/parallel.h"
+#include <dirent.h>
+#include <jansson.h>
 #include <time.h>
 
 #ifdef HAVE_LIBGIT2
@@ -40,6 +46,8 @@ tm_error_t tm_git_init(void)
 
 void tm_git_cleanup(void)
 {
+    tm_git_registry_clear();
+    
     if (g_git_initialized) {
         git_libgit2_shutdown();
         g_git_initialized = false;
@@ -70,6 +78,34 @@ static tm_error_t git_error_to_tm(int git_err)
  * Repository Management
  * ========================================================================== */
 
+/* Current branch and HEAD SHA */
+static void read_head(tm_git_repo_t *repo)
+{
+    TM_FREE(repo->branch);
+    repo->head_sha[0] = '\0';
+    
+    git_reference *head = NULL;
+    int err = git_repository_head(&head, repo->repo);
+    if (err == 0 && head) {
+        const char *branch_name = NULL;
+        if (git_branch_name(&branch_name, head) == 0 && branch_name) {
+            repo->branch = tm_strdup(branch_name);
+        } else {
+            repo->branch = tm_strdup("HEAD");
+        }
+        
+        /* Get HEAD SHA */
+        const git_oid *oid = git_reference_target(head);
+        if (oid) {
+            git_oid_tostr(repo->head_sha, sizeof(repo->head_sha), oid);
+        }
+        
+        git_reference_free(head);
+    } else {
+        repo->branch = tm_strdup("(detached)");
+    }
+}
+
 tm_error_t tm_git_repo_open(const char *path, tm_git_repo_t **result)
 {
     TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
@@ -82,6 +118,7 @@ tm_error_t tm_git_repo_open(const char *path, tm_git_repo_t **result)
     if (init_err != TM_OK) return init_err;
     
     tm_git_repo_t *repo = tm_calloc(1, sizeof(tm_git_repo_t));
+    repo->worker_count = 1;
     
     /* Open repository */
     int err = git_repository_open(&repo->repo, path);
@@ -101,26 +138,15 @@ tm_error_t tm_git_repo_open(const char *path, tm_git_repo_t **result)
         repo->root_path[len - 1] = '\0';
     }
     
-    /* Get current branch */
-    git_reference *head = NULL;
-    err = git_repository_head(&head, repo->repo);
-    if (err == 0 && head) {
-        const char *branch_name = NULL;
-        if (git_branch_name(&branch_name, head) == 0 && branch_name) {
-            repo->branch = tm_strdup(branch_name);
-        } else {
-            repo->branch = tm_strdup("HEAD");
-        }
-        
-        /* Get HEAD SHA */
-        const git_oid *oid = git_reference_target(head);
-        if (oid) {
-            git_oid_tostr(repo->head_sha, sizeof(repo->head_sha), oid);
-        }
-        
-        git_reference_free(head);
-    } else {
-        repo->branch = tm_strdup("(detached)");
+    read_head(repo);
+    
+    /* Changed-path Bloom filters from `git commit-graph write --changed-paths` */
+    char objects_dir[PATH_MAX];
+    snprintf(objects_dir, sizeof(objects_dir), "%sobjects", git_repository_commondir(repo->repo));
+    if (tm_commit_graph_open(objects_dir, &repo->graph) == TM_OK &&
+        !tm_commit_graph_has_bloom(repo->graph)) {
+        tm_commit_graph_free(repo->graph);
+        repo->graph = NULL;
     }
     
     TM_DEBUG("Opened repository: %s (branch: %s)", repo->root_path, repo->branch);
@@ -128,16 +154,66 @@ tm_error_t tm_git_repo_open(const char *path, tm_git_repo_t **result)
     return TM_OK;
 }
 
+tm_error_t tm_git_repo_refresh(tm_git_repo_t *repo)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    
+    struct stat st;
+    if (stat(git_repository_path(repo->repo), &st) != 0) return TM_ERR_NOT_FOUND;
+    
+    read_head(repo);
+    return TM_OK;
+}
+
 void tm_git_repo_free(tm_git_repo_t *repo)
 {
     if (!repo) return;
     
+    tm_git_repo_set_workers(repo, 1);
     if (repo->repo) git_repository_free(repo->repo);
+    tm_history_index_free(repo->history);
+    tm_commit_graph_free(repo->graph);
+    TM_FREE(repo->blame_cache_dir);
     TM_FREE(repo->root_path);
     TM_FREE(repo->branch);
     free(repo);
 }
 
+void tm_git_repo_set_workers(tm_git_repo_t *repo, size_t count)
+{
+    if (!repo) return;
+    
+    /* Keep the worker handles (and their caches) of a reused repository */
+    if (TM_MAX(count, 1) == repo->worker_count) return;
+    
+    for (size_t i = 1; i < repo->worker_count && repo->workers; i++) {
+        if (repo->workers[i]) git_repository_free(repo->workers[i]);
+    }
+    TM_FREE(repo->workers);
+    
+    repo->worker_count = TM_MAX(count, 1);
+    if (repo->worker_count > 1) {
+        repo->workers = tm_calloc(repo->worker_count, sizeof(git_repository *));
+    }
+}
+
+/**
+ * Repository handle for a tm_parallel_for worker. Worker 0 runs on the
+ * calling thread and uses the main handle; the others open their own on
+ * first use and keep it until the pool is resized.
+ */
+static git_repository *worker_repo(const tm_git_repo_t *repo, size_t worker)
+{
+    if (worker == 0 || !repo->workers) return repo->repo;
+    
+    if (!repo->workers[worker] &&
+        git_repository_open(&repo->workers[worker], git_repository_path(repo->repo)) != 0) {
+        TM_WARN("Worker %zu could not open repository: %s", worker, repo->root_path);
+        repo->workers[worker] = NULL;
+    }
+    return repo->workers[worker];
+}
+
 tm_error_t tm_git_find_root(const char *path, char **root)
 {
     TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
@@ -168,6 +244,17 @@ tm_error_t tm_git_find_root(const char *path, char **root)
     return TM_OK;
 }
 
+const char *tm_git_relative_path(const tm_git_repo_t *repo, const char *path)
+{
+    if (!repo || !repo->root_path || !path) return path;
+    
+    size_t len = strlen(repo->root_path);
+    if (strncmp(path, repo->root_path, len) == 0 && path[len] == '/') {
+        return path + len + 1;
+    }
+    return path;
+}
+
 /* ============================================================================
  * Commit History
  * ========================================================================== */
@@ -179,6 +266,7 @@ static void free_commit_contents(tm_git_commit_t *commit)
     TM_FREE(commit->author);
     TM_FREE(commit->email);
     TM_FREE(commit->message);
+    TM_FREE(commit->relevant_hunks);
     
     for (size_t i = 0; i < commit->file_count; i++) {
         TM_FREE(commit->files_changed[i]);
@@ -196,23 +284,217 @@ void tm_git_commits_free(tm_git_commit_t *commits, size_t count)
     free(commits);
 }
 
+/* ============================================================================
+ * Path Filtering
+ * ========================================================================== */
+
+/*
+ * Trace files match repository paths by substring, so each filter is
+ * resolved once against the HEAD tree into a trie of concrete paths. A
+ * commit touches the filter iff an entry along one of those paths differs
+ * from its first parent; equal subtree OIDs prune the comparison without
+ * loading anything below them, so no full tree diff is needed.
+ */
+typedef struct path_node {
+    char *name;
+    struct path_node *children;
+    size_t child_count;
+    size_t child_cap;
+    bool is_leaf;
+} path_node_t;
+
+typedef struct {
+    path_node_t root;
+    char **paths;                     /* Resolved paths, for Bloom probes */
+    size_t path_count;
+    size_t path_cap;
+    const char **unresolved;          /* Filters with no match at HEAD */
+    size_t unresolved_count;
+} path_filter_t;
+
+typedef struct {
+    path_filter_t *filter;
+    const char **files;
+    size_t file_count;
+    bool *matched;
+} path_resolve_ctx_t;
+
+static void path_node_free(path_node_t *node)
+{
+    for (size_t i = 0; i < node->child_count; i++) {
+        path_node_free(&node->children[i]);
+    }
+    TM_FREE(node->children);
+    TM_FREE(node->name);
+}
+
+static void path_filter_insert(path_filter_t *filter, const char *path)
+{
+    path_node_t *node = &filter->root;
+    const char *full_path = path;
+    
+    while (*path) {
+        size_t len = strcspn(path, "/");
+        path_node_t *child = NULL;
+        
+        for (size_t i = 0; i < node->child_count; i++) {
+            if (strlen(node->children[i].name) == len &&
+                strncmp(node->children[i].name, path, len) == 0) {
+                child = &node->children[i];
+                break;
+            }
+        }
+        
+        if (!child) {
+            path_node_t fresh = { .name = tm_strndup(path, len) };
+            TM_VEC_PUSH(node->children, node->child_count, node->child_cap, fresh);
+            child = &node->children[node->child_count - 1];
+        }
+        
+        node = child;
+        path += len;
+        if (*path == '/') path++;
+    }
+    
+    if (!node->is_leaf) {
+        node->is_leaf = true;
+        char *copy = tm_strdup(full_path);
+        TM_VEC_PUSH(filter->paths, filter->path_count, filter->path_cap, copy);
+    }
+}
+
+static int path_resolve_cb(const char *root, const git_tree_entry *entry, void *payload)
+{
+    path_resolve_ctx_t *ctx = payload;
+    if (git_tree_entry_type(entry) != GIT_OBJECT_BLOB) return 0;
+    
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s", root, git_tree_entry_name(entry));
+    
+    for (size_t i = 0; i < ctx->file_count; i++) {
+        if (strstr(path, ctx->files[i])) {
+            path_filter_insert(ctx->filter, path);
+            ctx->matched[i] = true;
+        }
+    }
+    return 0;
+}
+
 /**
- * Check if commit touches any of the specified files.
+ * Tree of the commit HEAD points at, or NULL (unborn branch, error).
  */
-static bool commit_touches_files(git_repository *repo,
-                                 git_commit *commit,
-                                 const char **files,
-                                 size_t file_count)
+static git_tree *head_tree(git_repository *repo)
+{
+    git_reference *head = NULL;
+    git_commit *commit = NULL;
+    git_tree *tree = NULL;
+    
+    if (git_repository_head(&head, repo) == 0 &&
+        git_commit_lookup(&commit, repo, git_reference_target(head)) == 0) {
+        git_commit_tree(&tree, commit);
+    }
+    
+    if (commit) git_commit_free(commit);
+    if (head) git_reference_free(head);
+    return tree;
+}
+
+static void path_filter_init(path_filter_t *filter,
+                             git_repository *repo,
+                             const char **files,
+                             size_t file_count)
+{
+    memset(filter, 0, sizeof(*filter));
+    if (!files || file_count == 0) return;
+    
+    path_resolve_ctx_t ctx = {
+        .filter = filter,
+        .files = files,
+        .file_count = file_count,
+        .matched = tm_calloc(file_count, sizeof(bool))
+    };
+    
+    git_tree *tree = head_tree(repo);
+    if (tree) {
+        git_tree_walk(tree, GIT_TREEWALK_PRE, path_resolve_cb, &ctx);
+        git_tree_free(tree);
+    }
+    
+    /* Files gone from HEAD fall back to diff matching */
+    filter->unresolved = tm_calloc(file_count, sizeof(char *));
+    for (size_t i = 0; i < file_count; i++) {
+        if (!ctx.matched[i]) filter->unresolved[filter->unresolved_count++] = files[i];
+    }
+    free(ctx.matched);
+    
+    TM_DEBUG("Path filter: %zu paths resolved, %zu unresolved",
+             filter->path_count, filter->unresolved_count);
+}
+
+static void path_filter_free(path_filter_t *filter)
+{
+    path_node_free(&filter->root);
+    for (size_t i = 0; i < filter->path_count; i++) {
+        free(filter->paths[i]);
+    }
+    TM_FREE(filter->paths);
+    TM_FREE(filter->unresolved);
+}
+
+static bool path_filter_active(const path_filter_t *filter)
+{
+    return filter->path_count > 0 || filter->unresolved_count > 0;
+}
+
+/**
+ * Compare tree entries along the filter paths.
+ */
+static bool tree_paths_differ(git_repository *repo,
+                              const git_tree *old_tree,
+                              const git_tree *new_tree,
+                              const path_node_t *node)
 {
-    if (!files || file_count == 0) return true;  /* No filter = all commits */
+    for (size_t i = 0; i < node->child_count; i++) {
+        const path_node_t *child = &node->children[i];
+        const git_tree_entry *old_entry = old_tree ? git_tree_entry_byname(old_tree, child->name) : NULL;
+        const git_tree_entry *new_entry = new_tree ? git_tree_entry_byname(new_tree, child->name) : NULL;
+        
+        if (!old_entry && !new_entry) continue;
+        if (!old_entry || !new_entry) return true;
+        if (git_oid_equal(git_tree_entry_id(old_entry), git_tree_entry_id(new_entry))) continue;
+        if (child->is_leaf) return true;
+        
+        /* Both sides changed below this component: descend */
+        if (git_tree_entry_type(old_entry) != GIT_OBJECT_TREE ||
+            git_tree_entry_type(new_entry) != GIT_OBJECT_TREE) {
+            return true;
+        }
+        
+        git_tree *old_sub = NULL, *new_sub = NULL;
+        bool differ = true;
+        if (git_tree_lookup(&old_sub, repo, git_tree_entry_id(old_entry)) == 0 &&
+            git_tree_lookup(&new_sub, repo, git_tree_entry_id(new_entry)) == 0) {
+            differ = tree_paths_differ(repo, old_sub, new_sub, child);
+        }
+        if (old_sub) git_tree_free(old_sub);
+        if (new_sub) git_tree_free(new_sub);
+        
+        if (differ) return true;
+    }
     
+    return false;
+}
+
+/**
+ * Diff a commit against its first parent (or the empty tree).
+ */
+static git_diff *commit_diff(git_repository *repo, git_commit *commit)
+{
     git_tree *tree = NULL, *parent_tree = NULL;
     git_diff *diff = NULL;
-    bool touches = false;
     
-    if (git_commit_tree(&tree, commit) != 0) return false;
+    if (git_commit_tree(&tree, commit) != 0) return NULL;
     
-    /* Get parent tree (or empty for first commit) */
     if (git_commit_parentcount(commit) > 0) {
         git_commit *parent = NULL;
         if (git_commit_parent(&parent, commit, 0) == 0) {
@@ -221,42 +503,91 @@ static bool commit_touches_files(git_repository *repo,
         }
     }
     
-    /* Get diff */
     git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
     if (git_diff_tree_to_tree(&diff, repo, parent_tree, tree, &opts) != 0) {
-        goto cleanup;
+        diff = NULL;
+    }
+    
+    if (tree) git_tree_free(tree);
+    if (parent_tree) git_tree_free(parent_tree);
+    return diff;
+}
+
+/**
+ * Check if commit touches any filtered file. A commit-graph Bloom filter,
+ * if available, rules out resolved paths before any tree is loaded. If a
+ * full diff was needed to decide, it is handed back in *diff_out (if given)
+ * for reuse.
+ */
+static bool commit_touches_files(git_repository *repo,
+                                 const tm_commit_graph_t *graph,
+                                 git_commit *commit,
+                                 const path_filter_t *filter,
+                                 git_diff **diff_out)
+{
+    if (diff_out) *diff_out = NULL;
+    if (!path_filter_active(filter)) return true;  /* No filter = all commits */
+    
+    /* Bloom filters are computed against the first parent, as we compare */
+    if (filter->path_count > 0 &&
+        tm_commit_graph_maybe_changed(graph, git_commit_id(commit)->id,
+                                      (const char **)filter->paths,
+                                      filter->path_count) != 0) {
+        git_commit *parent = NULL;
+        if (git_commit_parentcount(commit) > 0 && git_commit_parent(&parent, commit, 0) != 0) {
+            parent = NULL;
+        }
+        
+        bool touches;
+        if (parent && git_oid_equal(git_commit_tree_id(commit), git_commit_tree_id(parent))) {
+            touches = false;
+        } else {
+            git_tree *tree = NULL, *parent_tree = NULL;
+            git_commit_tree(&tree, commit);
+            if (parent) git_commit_tree(&parent_tree, parent);
+            
+            touches = tree_paths_differ(repo, parent_tree, tree, &filter->root);
+            
+            if (tree) git_tree_free(tree);
+            if (parent_tree) git_tree_free(parent_tree);
+        }
+        if (parent) git_commit_free(parent);
+        
+        if (touches) return true;
     }
     
+    if (filter->unresolved_count == 0) return false;
+    
+    git_diff *diff = commit_diff(repo, commit);
+    if (!diff) return false;
+    
     /* Check each delta */
     size_t delta_count = git_diff_num_deltas(diff);
-    for (size_t i = 0; i < delta_count && !touches; i++) {
+    for (size_t i = 0; i < delta_count; i++) {
         const git_diff_delta *delta = git_diff_get_delta(diff, i);
         
-        for (size_t j = 0; j < file_count; j++) {
-            if (delta->old_file.path && strstr(delta->old_file.path, files[j])) {
-                touches = true;
-                break;
-            }
-            if (delta->new_file.path && strstr(delta->new_file.path, files[j])) {
-                touches = true;
-                break;
+        for (size_t j = 0; j < filter->unresolved_count; j++) {
+            const char *file = filter->unresolved[j];
+            if ((delta->old_file.path && strstr(delta->old_file.path, file)) ||
+                (delta->new_file.path && strstr(delta->new_file.path, file))) {
+                if (diff_out) *diff_out = diff;
+                else git_diff_free(diff);
+                return true;
             }
         }
     }
     
-cleanup:
-    if (diff) git_diff_free(diff);
-    if (tree) git_tree_free(tree);
-    if (parent_tree) git_tree_free(parent_tree);
-    
-    return touches;
+    git_diff_free(diff);
+    return false;
 }
 
 /**
- * Get files changed in a commit.
+ * Get files changed in a commit. Uses diff if given (not freed), else
+ * computes one.
  */
 static void get_commit_files(git_repository *repo,
                              git_commit *commit,
+                             git_diff *diff,
                              char ***files,
                              size_t *count,
                              int *additions,
@@ -271,22 +602,10 @@ static void get_commit_files(git_repository *repo,
     *touches_config = false;
     *touches_schema = false;
     
-    git_tree *tree = NULL, *parent_tree = NULL;
-    git_diff *diff = NULL;
-    
-    if (git_commit_tree(&tree, commit) != 0) return;
-    
-    if (git_commit_parentcount(commit) > 0) {
-        git_commit *parent = NULL;
-        if (git_commit_parent(&parent, commit, 0) == 0) {
-            git_commit_tree(&parent_tree, parent);
-            git_commit_free(parent);
-        }
-    }
-    
-    git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
-    if (git_diff_tree_to_tree(&diff, repo, parent_tree, tree, &opts) != 0) {
-        goto cleanup;
+    git_diff *owned = NULL;
+    if (!diff) {
+        diff = owned = commit_diff(repo, commit);
+        if (!diff) return;
     }
     
     /* Get stats */
@@ -316,30 +635,88 @@ static void get_commit_files(git_repository *repo,
         }
     }
     
-cleanup:
-    if (diff) git_diff_free(diff);
-    if (tree) git_tree_free(tree);
-    if (parent_tree) git_tree_free(parent_tree);
+    if (owned) git_diff_free(owned);
 }
 
-tm_error_t tm_git_get_commits(const tm_git_repo_t *repo,
-                              const tm_commit_opts_t *opts,
-                              tm_git_commit_t **commits,
-                              size_t *count)
+/**
+ * Fill commit metadata and changed files. If changes is given, its files
+ * and stats are moved into c instead of diffing the commit again.
+ */
+static void fill_commit(git_repository *repo,
+                        git_commit *commit,
+                        tm_git_commit_t *changes,
+                        tm_git_commit_t *c)
 {
-    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(commits, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    git_oid_tostr(c->sha, sizeof(c->sha), git_commit_id(commit));
     
-    *commits = NULL;
-    *count = 0;
+    const git_signature *author = git_commit_author(commit);
+    if (author) {
+        c->author = tm_strdup(author->name);
+        c->email = tm_strdup(author->email);
+    }
     
-    int max = opts ? opts->max_commits : 20;
-    if (max <= 0) max = 20;
+    c->timestamp = (int64_t)git_commit_time(commit);
+    c->message = tm_strdup(git_commit_message(commit));
+    
+    if (changes) {
+        c->files_changed = changes->files_changed;
+        c->file_count = changes->file_count;
+        c->additions = changes->additions;
+        c->deletions = changes->deletions;
+        c->touches_config = changes->touches_config;
+        c->touches_schema = changes->touches_schema;
+        changes->files_changed = NULL;
+        changes->file_count = 0;
+        return;
+    }
+    
+    get_commit_files(repo, commit, NULL,
+                     &c->files_changed, &c->file_count,
+                     &c->additions, &c->deletions,
+                     &c->touches_config, &c->touches_schema);
+}
+
+/**
+ * A commit selected by a walk or the history index. A walk that had to
+ * diff the commit to match it keeps the files and stats from that diff,
+ * read on the walking thread's handle, so filling the record does not
+ * diff it again.
+ */
+typedef struct {
+    git_oid oid;
+    int64_t timestamp;
+    tm_git_commit_t *changes;     /* Files and stats only (owned, nullable) */
+} commit_hit_t;
+
+static void free_hits(commit_hit_t *hits, size_t count)
+{
+    if (!hits) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        tm_git_commits_free(hits[i].changes, 1);
+    }
+    free(hits);
+}
+
+/**
+ * Walk from HEAD, newest first, collecting up to max commits that pass the
+ * time and merge filters of opts and touch one of files (all if none).
+ * Commits after until_timestamp are skipped without diffing; the walk stops
+ * at the first commit before since_timestamp.
+ */
+static tm_error_t walk_commits(git_repository *repo,
+                               const tm_commit_graph_t *graph,
+                               const tm_commit_opts_t *opts,
+                               const char **files,
+                               size_t file_count,
+                               size_t max,
+                               commit_hit_t *hits,
+                               size_t *count)
+{
+    *count = 0;
     
-    /* Set up revwalk */
     git_revwalk *walk = NULL;
-    int err = git_revwalk_new(&walk, repo->repo);
+    int err = git_revwalk_new(&walk, repo);
     if (err != 0) return git_error_to_tm(err);
     
     git_revwalk_sorting(walk, GIT_SORT_TIME);
@@ -350,29 +727,13 @@ tm_error_t tm_git_get_commits(const tm_git_repo_t *repo,
         return git_error_to_tm(err);
     }
     
-    /* Allocate result array */
-    tm_git_commit_t *result = tm_calloc((size_t)max, sizeof(tm_git_commit_t));
-    size_t collected = 0;
+    path_filter_t filter;
+    path_filter_init(&filter, repo, files, file_count);
     
     git_oid oid;
-    while (collected < (size_t)max && git_revwalk_next(&oid, walk) == 0) {
+    while (*count < max && git_revwalk_next(&oid, walk) == 0) {
         git_commit *commit = NULL;
-        if (git_commit_lookup(&commit, repo->repo, &oid) != 0) continue;
-        
-        /* Check file filter */
-        if (opts && opts->file_paths && opts->file_path_count > 0) {
-            if (!commit_touches_files(repo->repo, commit, 
-                                      opts->file_paths, opts->file_path_count)) {
-                git_commit_free(commit);
-                continue;
-            }
-        }
-        
-        /* Check merge filter */
-        if (opts && !opts->include_merges && git_commit_parentcount(commit) > 1) {
-            git_commit_free(commit);
-            continue;
-        }
+        if (git_commit_lookup(&commit, repo, &oid) != 0) continue;
         
         /* Check timestamp filter */
         int64_t commit_time = (int64_t)git_commit_time(commit);
@@ -380,37 +741,299 @@ tm_error_t tm_git_get_commits(const tm_git_repo_t *repo,
             git_commit_free(commit);
             break;  /* Commits are sorted by time, so we can stop */
         }
-        
-        /* Fill in commit data */
-        tm_git_commit_t *c = &result[collected];
-        
-        git_oid_tostr(c->sha, sizeof(c->sha), &oid);
-        
-        const git_signature *author = git_commit_author(commit);
-        if (author) {
-            c->author = tm_strdup(author->name);
-            c->email = tm_strdup(author->email);
+        if (opts && opts->until_timestamp > 0 && commit_time > opts->until_timestamp) {
+            git_commit_free(commit);
+            continue;
         }
         
-        c->timestamp = commit_time;
-        c->message = tm_strdup(git_commit_message(commit));
+        /* Check merge filter */
+        bool skip = opts && !opts->include_merges && git_commit_parentcount(commit) > 1;
         
-        /* Get changed files */
-        get_commit_files(repo->repo, commit,
-                         &c->files_changed, &c->file_count,
-                         &c->additions, &c->deletions,
-                         &c->touches_config, &c->touches_schema);
+        /* Check file filter */
+        git_diff *diff = NULL;
+        if (!skip && commit_touches_files(repo, graph, commit, &filter, &diff)) {
+            commit_hit_t *hit = &hits[(*count)++];
+            *hit = (commit_hit_t){ .oid = oid, .timestamp = commit_time };
+            
+            if (diff) {
+                tm_git_commit_t *c = tm_calloc(1, sizeof(tm_git_commit_t));
+                get_commit_files(repo, commit, diff,
+                                 &c->files_changed, &c->file_count,
+                                 &c->additions, &c->deletions,
+                                 &c->touches_config, &c->touches_schema);
+                hit->changes = c;
+                git_diff_free(diff);
+            }
+        }
         
         git_commit_free(commit);
-        collected++;
     }
     
+    path_filter_free(&filter);
     git_revwalk_free(walk);
+    return TM_OK;
+}
+
+typedef struct {
+    const tm_git_repo_t *repo;
+    const tm_commit_opts_t *opts;
+    size_t max;
+    commit_hit_t **hits;          /* Per file */
+    size_t *counts;
+    tm_error_t *errors;
+} file_walk_job_t;
+
+static void file_walk_task(void *ctx, size_t task, size_t worker)
+{
+    file_walk_job_t *job = ctx;
+    
+    git_repository *handle = worker_repo(job->repo, worker);
+    if (!handle) {
+        job->errors[task] = TM_ERR_GIT;
+        return;
+    }
+    
+    job->hits[task] = tm_calloc(job->max, sizeof(commit_hit_t));
+    job->errors[task] = walk_commits(handle, job->repo->graph, job->opts,
+                                     &job->opts->file_paths[task], 1,
+                                     job->max, job->hits[task], &job->counts[task]);
+}
+
+/* Newest first; ties by OID so the merge does not depend on thread timing */
+static int compare_hits(const void *a, const void *b)
+{
+    const commit_hit_t *x = a, *y = b;
+    if (x->timestamp != y->timestamp) return x->timestamp < y->timestamp ? 1 : -1;
+    return memcmp(x->oid.id, y->oid.id, sizeof(x->oid.id));
+}
+
+/**
+ * One filtered walk per file on the worker pool, merged newest first.
+ * The newest max commits of the union are the newest max of the per-file
+ * results, so this matches a single walk over all files.
+ */
+static tm_error_t walk_commits_parallel(const tm_git_repo_t *repo,
+                                        const tm_commit_opts_t *opts,
+                                        size_t max,
+                                        commit_hit_t **hits,
+                                        size_t *count)
+{
+    size_t file_count = opts->file_path_count;
+    file_walk_job_t job = {
+        .repo = repo,
+        .opts = opts,
+        .max = max,
+        .hits = tm_calloc(file_count, sizeof(commit_hit_t *)),
+        .counts = tm_calloc(file_count, sizeof(size_t)),
+        .errors = tm_calloc(file_count, sizeof(tm_error_t))
+    };
+    
+    tm_parallel_for(file_count, repo->worker_count, file_walk_task, &job);
+    
+    size_t total = 0;
+    tm_error_t err = TM_OK;
+    for (size_t i = 0; i < file_count; i++) {
+        total += job.counts[i];
+        if (job.errors[i] != TM_OK) err = job.errors[i];
+    }
+    
+    commit_hit_t *merged = tm_calloc(TM_MAX(total, max), sizeof(commit_hit_t));
+    size_t n = 0;
+    for (size_t i = 0; i < file_count; i++) {
+        if (job.counts[i] > 0) {
+            memcpy(&merged[n], job.hits[i], job.counts[i] * sizeof(commit_hit_t));
+            n += job.counts[i];
+        }
+        free(job.hits[i]);
+    }
+    
+    qsort(merged, n, sizeof(commit_hit_t), compare_hits);
+    
+    /* A commit touching several files was found once per file */
+    size_t unique = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (unique == max ||
+            (unique > 0 && git_oid_equal(&merged[unique - 1].oid, &merged[i].oid))) {
+            tm_git_commits_free(merged[i].changes, 1);
+            continue;
+        }
+        merged[unique++] = merged[i];
+    }
+    
+    free(job.hits);
+    free(job.counts);
+    free(job.errors);
+    
+    /* Only fail if no walk got anywhere */
+    if (unique == 0 && err != TM_OK) {
+        free(merged);
+        return err;
+    }
+    
+    *hits = merged;
+    *count = unique;
+    return TM_OK;
+}
+
+/**
+ * Whether a query found in the index is its whole answer: the index is
+ * complete, found the wanted number of (newest) commits, or the query's
+ * window starts at or after the index's boundary.
+ */
+static bool history_covers(const tm_history_index_t *index,
+                           int64_t since,
+                           size_t found,
+                           size_t wanted)
+{
+    int64_t boundary = index->header->boundary;
+    return boundary == 0 || found >= wanted || (since > 0 && since >= boundary);
+}
+
+/**
+ * File-filtered commits from the history index (newest first).
+ * TM_ERR_NOT_FOUND if the index is partial and may miss older commits.
+ */
+static tm_error_t history_hits(const tm_git_repo_t *repo,
+                               const tm_commit_opts_t *opts,
+                               size_t max,
+                               commit_hit_t *hits,
+                               size_t *count)
+{
+    tm_history_entry_t *entries = NULL;
+    size_t entry_count = 0;
+    
+    *count = 0;
+    tm_error_t err = tm_history_index_query(repo->history, opts->file_paths,
+                                            opts->file_path_count,
+                                            &entries, &entry_count);
+    if (err != TM_OK) return err;
+    
+    for (size_t i = 0; i < entry_count && *count < max; i++) {
+        const tm_history_entry_t *e = &entries[i];
+        
+        if (opts->since_timestamp > 0 && e->timestamp < opts->since_timestamp) break;
+        if (opts->until_timestamp > 0 && e->timestamp > opts->until_timestamp) continue;
+        if (!opts->include_merges && (e->flags & TM_HISTORY_MERGE)) continue;
+        
+        commit_hit_t *hit = &hits[(*count)++];
+        git_oid_fromraw(&hit->oid, e->oid);
+        hit->timestamp = e->timestamp;
+    }
+    
+    free(entries);
+    
+    if (!history_covers(repo->history, opts->since_timestamp, *count, max)) {
+        TM_DEBUG("History index does not reach back far enough, walking history");
+        *count = 0;
+        return TM_ERR_NOT_FOUND;
+    }
+    
+    TM_DEBUG("Selected %zu commits from history index", *count);
+    return TM_OK;
+}
+
+typedef struct {
+    const tm_git_repo_t *repo;
+    commit_hit_t *hits;
+    tm_git_commit_t *commits;
+    bool *filled;
+} fill_job_t;
+
+static void fill_task(void *ctx, size_t task, size_t worker)
+{
+    fill_job_t *job = ctx;
+    
+    git_repository *handle = worker_repo(job->repo, worker);
+    git_commit *commit = NULL;
+    if (!handle || git_commit_lookup(&commit, handle, &job->hits[task].oid) != 0) return;
+    
+    fill_commit(handle, commit, job->hits[task].changes, &job->commits[task]);
+    job->filled[task] = true;
+    git_commit_free(commit);
+}
+
+/**
+ * Load commit records for hits on the worker pool (the per-commit diffs
+ * dominate), keeping hit order. Files and stats a walk already read are
+ * moved out of the hits. Returns the number filled.
+ */
+static size_t fill_commits(const tm_git_repo_t *repo,
+                           commit_hit_t *hits,
+                           size_t count,
+                           tm_git_commit_t *commits)
+{
+    fill_job_t job = {
+        .repo = repo,
+        .hits = hits,
+        .commits = commits,
+        .filled = tm_calloc(count ? count : 1, sizeof(bool))
+    };
+    
+    tm_parallel_for(count, repo->worker_count, fill_task, &job);
+    
+    size_t filled = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!job.filled[i]) continue;
+        if (filled != i) {
+            commits[filled] = commits[i];
+            memset(&commits[i], 0, sizeof(tm_git_commit_t));
+        }
+        filled++;
+    }
+    
+    free(job.filled);
+    return filled;
+}
+
+tm_error_t tm_git_get_commits(const tm_git_repo_t *repo,
+                              const tm_commit_opts_t *opts,
+                              tm_git_commit_t **commits,
+                              size_t *count)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(commits, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    
+    *commits = NULL;
+    *count = 0;
+    
+    int max = opts ? opts->max_commits : 20;
+    if (max <= 0) max = 20;
+    
+    size_t file_count = opts && opts->file_paths ? opts->file_path_count : 0;
+    commit_hit_t *hits = NULL;
+    size_t hit_count = 0;
+    tm_error_t err = TM_ERR_NOT_FOUND;
     
+    if (repo->history && file_count > 0) {
+        hits = tm_calloc((size_t)max, sizeof(commit_hit_t));
+        err = history_hits(repo, opts, (size_t)max, hits, &hit_count);
+    }
+    
+    /* No index, or a partial one that may miss older commits */
+    if (err == TM_ERR_NOT_FOUND) {
+        TM_FREE(hits);
+        if (repo->worker_count > 1 && file_count > 1) {
+            err = walk_commits_parallel(repo, opts, (size_t)max, &hits, &hit_count);
+        } else {
+            hits = tm_calloc((size_t)max, sizeof(commit_hit_t));
+            err = walk_commits(repo->repo, repo->graph, opts,
+                               file_count ? opts->file_paths : NULL, file_count,
+                               (size_t)max, hits, &hit_count);
+        }
+    }
+    
+    if (err != TM_OK) {
+        free_hits(hits, hit_count);
+        return err;
+    }
+    
+    tm_git_commit_t *result = tm_calloc((size_t)max, sizeof(tm_git_commit_t));
+    *count = fill_commits(repo, hits, hit_count, result);
     *commits = result;
-    *count = collected;
+    free_hits(hits, hit_count);
     
-    TM_DEBUG("Collected %zu commits", collected);
+    TM_DEBUG("Collected %zu commits", *count);
     return TM_OK;
 }
 
@@ -434,22 +1057,7 @@ tm_error_t tm_git_get_commit(const tm_git_repo_t *repo,
     if (err != 0) return git_error_to_tm(err);
     
     tm_git_commit_t *c = tm_calloc(1, sizeof(tm_git_commit_t));
-    
-    git_oid_tostr(c->sha, sizeof(c->sha), &oid);
-    
-    const git_signature *author = git_commit_author(commit);
-    if (author) {
-        c->author = tm_strdup(author->name);
-        c->email = tm_strdup(author->email);
-    }
-    
-    c->timestamp = (int64_t)git_commit_time(commit);
-    c->message = tm_strdup(git_commit_message(commit));
-    
-    get_commit_files(repo->repo, commit,
-                     &c->files_changed, &c->file_count,
-                     &c->additions, &c->deletions,
-                     &c->touches_config, &c->touches_schema);
+    fill_commit(repo->repo, commit, NULL, c);
     
     git_commit_free(commit);
     
@@ -472,6 +1080,16 @@ void tm_git_blames_free(tm_git_blame_t *blames, size_t count)
     free(blames);
 }
 
+static void blame_from_hunk(const git_blame_hunk *hunk, tm_git_blame_t *b)
+{
+    git_oid_tostr(b->sha, sizeof(b->sha), &hunk->final_commit_id);
+    
+    if (hunk->final_signature) {
+        b->author = tm_strdup(hunk->final_signature->name);
+        b->timestamp = (int64_t)hunk->final_signature->when.time;
+    }
+}
+
 tm_error_t tm_git_blame_file(const tm_git_repo_t *repo,
                              const char *file_path,
                              const tm_blame_opts_t *opts,
@@ -514,15 +1132,7 @@ tm_error_t tm_git_blame_file(const tm_git_repo_t *repo,
         const git_blame_hunk *hunk = git_blame_get_hunk_byindex(blame, i);
         if (!hunk) continue;
         
-        tm_git_blame_t *b = &result[*count];
-        
-        git_oid_tostr(b->sha, sizeof(b->sha), &hunk->final_commit_id);
-        
-        if (hunk->final_signature) {
-            b->author = tm_strdup(hunk->final_signature->name);
-            b->timestamp = (int64_t)hunk->final_signature->when.time;
-        }
-        
+        blame_from_hunk(hunk, &result[*count]);
         (*count)++;
     }
     
@@ -551,6 +1161,289 @@ tm_error_t tm_git_blame_line(const tm_git_repo_t *repo,
     return TM_OK;
 }
 
+/*
+ * Blame is cached per file path and blob: <cache_dir>/blame/<key>.json, key
+ * a hash of "<path>\0<blob>", holds {"path", "blob", "head": sha, "lines":
+ * {"<line>": {"sha", "author", "timestamp"}}}. Identical files at two paths
+ * share a blob but not their history, hence the path. Blame depends on
+ * history as well as content, so an entry written at another HEAD is
+ * discarded. Lines are added as later analyses ask for them.
+ */
+tm_error_t tm_git_repo_use_blame_cache(tm_git_repo_t *repo, const char *cache_dir)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(cache_dir, TM_ERR_INVALID_ARG);
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/blame", cache_dir);
+    
+    tm_error_t err = tm_mkdir_p(sb.data);
+    if (err != TM_OK) {
+        tm_strbuf_free(&sb);
+        return err;
+    }
+    
+    TM_FREE(repo->blame_cache_dir);
+    repo->blame_cache_dir = tm_strbuf_finish(&sb);
+    return TM_OK;
+}
+
+static char *blame_cache_file(const tm_git_repo_t *repo, const char *path, const char *blob)
+{
+    tm_strbuf_t key;
+    tm_strbuf_init(&key);
+    tm_strbuf_append_len(&key, path, strlen(path) + 1);
+    tm_strbuf_append(&key, blob);
+    uint64_t hash = tm_hash_bytes(key.data, key.len);
+    tm_strbuf_free(&key);
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/%016llx.json", repo->blame_cache_dir, (unsigned long long)hash);
+    return tm_strbuf_finish(&sb);
+}
+
+/**
+ * Cached lines for a file's blob, or NULL if absent, from another HEAD, or
+ * another (path, blob) whose key collided.
+ */
+static json_t *blame_cache_load(const char *file,
+                                const char *path,
+                                const char *blob,
+                                const char *head_sha)
+{
+    json_error_t jerr;
+    json_t *root = json_load_file(file, 0, &jerr);
+    
+    const char *cached_path = json_string_value(json_object_get(root, "path"));
+    const char *cached_blob = json_string_value(json_object_get(root, "blob"));
+    const char *head = json_string_value(json_object_get(root, "head"));
+    json_t *lines = json_object_get(root, "lines");
+    
+    if (!cached_path || strcmp(cached_path, path) != 0 ||
+        !cached_blob || strcmp(cached_blob, blob) != 0 ||
+        !head || strcmp(head, head_sha) != 0 || !json_is_object(lines)) {
+        json_decref(root);
+        return NULL;
+    }
+    
+    json_incref(lines);
+    json_decref(root);
+    return lines;
+}
+
+static void blame_cache_save(const char *file,
+                             const char *path,
+                             const char *blob,
+                             const char *head_sha,
+                             json_t *lines)
+{
+    json_t *root = json_object();
+    json_object_set_new(root, "path", json_string(path));
+    json_object_set_new(root, "blob", json_string(blob));
+    json_object_set_new(root, "head", json_string(head_sha));
+    json_object_set(root, "lines", lines);
+    
+    char *text = json_dumps(root, JSON_COMPACT);
+    json_decref(root);
+    if (!text) return;
+    
+    if (tm_write_file_atomic(file, text, strlen(text)) != TM_OK) {
+        TM_WARN("Failed to write blame cache: %s", file);
+    }
+    free(text);
+}
+
+static tm_git_blame_t *blame_from_json(const json_t *obj)
+{
+    const char *sha = json_string_value(json_object_get(obj, "sha"));
+    if (!sha) return NULL;
+    
+    tm_git_blame_t *b = tm_calloc(1, sizeof(tm_git_blame_t));
+    snprintf(b->sha, sizeof(b->sha), "%s", sha);
+    
+    const char *author = json_string_value(json_object_get(obj, "author"));
+    if (author) b->author = tm_strdup(author);
+    b->timestamp = (int64_t)json_integer_value(json_object_get(obj, "timestamp"));
+    return b;
+}
+
+static json_t *blame_to_json(const tm_git_blame_t *b)
+{
+    json_t *obj = json_object();
+    json_object_set_new(obj, "sha", json_string(b->sha));
+    if (b->author) json_object_set_new(obj, "author", json_string(b->author));
+    json_object_set_new(obj, "timestamp", json_integer((json_int_t)b->timestamp));
+    return obj;
+}
+
+/**
+ * Number of lines in a blob, counting an unterminated last line.
+ */
+static size_t blob_line_count(git_repository *repo, const git_oid *id)
+{
+    git_blob *blob = NULL;
+    if (git_blob_lookup(&blob, repo, id) != 0) return 0;
+    
+    const char *data = git_blob_rawcontent(blob);
+    size_t size = (size_t)git_blob_rawsize(blob);
+    size_t lines = 0;
+    
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] == '\n') lines++;
+    }
+    if (size > 0 && data[size - 1] != '\n') lines++;
+    
+    git_blob_free(blob);
+    return lines;
+}
+
+/**
+ * Answer all requests for one file with at most one blame, spanning the
+ * lines the cache could not serve. handle is the calling worker's.
+ */
+static void blame_file_requests(const tm_git_repo_t *repo,
+                                git_repository *handle,
+                                tm_blame_request_t **group,
+                                size_t group_count)
+{
+    const char *file = group[0]->file_path;
+    
+    git_tree *tree = head_tree(handle);
+    git_tree_entry *entry = NULL;
+    int found = tree ? git_tree_entry_bypath(&entry, tree, file) : -1;
+    if (tree) git_tree_free(tree);
+    if (found != 0) return;
+    
+    git_oid blob_id = *git_tree_entry_id(entry);
+    git_tree_entry_free(entry);
+    
+    char blob[41];
+    git_oid_tostr(blob, sizeof(blob), &blob_id);
+    
+    char *cache_file = repo->blame_cache_dir ? blame_cache_file(repo, file, blob) : NULL;
+    json_t *lines = cache_file ? blame_cache_load(cache_file, file, blob, repo->head_sha) : NULL;
+    
+    size_t min_line = SIZE_MAX, max_line = 0, missing = 0;
+    for (size_t i = 0; i < group_count; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "%d", group[i]->line);
+        
+        json_t *hit = lines ? json_object_get(lines, key) : NULL;
+        if (hit) group[i]->blame = blame_from_json(hit);
+        if (group[i]->blame) continue;
+        
+        min_line = TM_MIN(min_line, (size_t)group[i]->line);
+        max_line = TM_MAX(max_line, (size_t)group[i]->line);
+        missing++;
+    }
+    
+    if (missing > 0) {
+        /* Lines past the end of the file would fail the whole range */
+        max_line = TM_MIN(max_line, blob_line_count(handle, &blob_id));
+    }
+    
+    if (missing > 0 && min_line <= max_line) {
+        git_blame_options opts = GIT_BLAME_OPTIONS_INIT;
+        opts.min_line = min_line;
+        opts.max_line = max_line;
+        
+        git_blame *blame = NULL;
+        if (git_blame_file(&blame, handle, file, &opts) == 0) {
+            if (!lines) lines = json_object();
+            
+            for (size_t i = 0; i < group_count; i++) {
+                size_t line = (size_t)group[i]->line;
+                if (group[i]->blame || line < min_line || line > max_line) continue;
+                
+                const git_blame_hunk *hunk = git_blame_get_hunk_byline(blame, line);
+                if (!hunk) continue;
+                
+                tm_git_blame_t *b = tm_calloc(1, sizeof(tm_git_blame_t));
+                blame_from_hunk(hunk, b);
+                group[i]->blame = b;
+                
+                char key[16];
+                snprintf(key, sizeof(key), "%d", group[i]->line);
+                json_object_set_new(lines, key, blame_to_json(b));
+            }
+            git_blame_free(blame);
+            
+            if (cache_file) blame_cache_save(cache_file, file, blob, repo->head_sha, lines);
+        } else {
+            TM_DEBUG("Blame failed for %s", file);
+        }
+    } else if (missing == 0) {
+        TM_DEBUG("Blame cache hit: %s (%zu lines)", file, group_count);
+    }
+    
+    json_decref(lines);
+    TM_FREE(cache_file);
+}
+
+typedef struct {
+    const tm_git_repo_t *repo;
+    tm_blame_request_t **requests;    /* Grouped by file */
+    size_t *group_start;              /* group_count + 1 offsets */
+} blame_job_t;
+
+static void blame_task(void *ctx, size_t task, size_t worker)
+{
+    blame_job_t *job = ctx;
+    
+    git_repository *handle = worker_repo(job->repo, worker);
+    if (!handle) return;
+    
+    blame_file_requests(job->repo, handle,
+                        &job->requests[job->group_start[task]],
+                        job->group_start[task + 1] - job->group_start[task]);
+}
+
+tm_error_t tm_git_blame_lines(const tm_git_repo_t *repo,
+                              tm_blame_request_t *requests,
+                              size_t count)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    if (count == 0) return TM_OK;
+    TM_CHECK_NULL(requests, TM_ERR_INVALID_ARG);
+    
+    for (size_t i = 0; i < count; i++) {
+        requests[i].blame = NULL;
+    }
+    
+    blame_job_t job = {
+        .repo = repo,
+        .requests = tm_calloc(count, sizeof(tm_blame_request_t *)),
+        .group_start = tm_calloc(count + 1, sizeof(size_t))
+    };
+    bool *done = tm_calloc(count, sizeof(bool));
+    size_t grouped = 0, group_count = 0;
+    
+    /* Group requests by file, keeping first-seen order */
+    for (size_t i = 0; i < count; i++) {
+        if (done[i] || !requests[i].file_path || requests[i].line <= 0) continue;
+        
+        job.group_start[group_count++] = grouped;
+        for (size_t j = i; j < count; j++) {
+            if (!done[j] && requests[j].file_path && requests[j].line > 0 &&
+                strcmp(requests[j].file_path, requests[i].file_path) == 0) {
+                job.requests[grouped++] = &requests[j];
+                done[j] = true;
+            }
+        }
+    }
+    job.group_start[group_count] = grouped;
+    
+    /* Each file is blamed on its own thread and writes only its requests */
+    tm_parallel_for(group_count, repo->worker_count, blame_task, &job);
+    
+    free(done);
+    free(job.requests);
+    free(job.group_start);
+    return TM_OK;
+}
+
 /* ============================================================================
  * Diff Analysis
  * ========================================================================== */
@@ -638,119 +1531,1106 @@ tm_error_t tm_git_commit_diff(const tm_git_repo_t *repo,
             
             /* Get patch for hunk details */
             git_patch *patch = NULL;
-            if (git_patch_from_diff(&patch, diff, i) == 0) {
-                size_t adds = 0, dels = 0;
-                git_patch_line_stats(NULL, &adds, &dels, patch);
-                d->additions = (int)adds;
-                d->deletions = (int)dels;
+            if (git_patch_from_diff(&patch, diff, i) == 0) {
+                size_t adds = 0, dels = 0;
+                git_patch_line_stats(NULL, &adds, &dels, patch);
+                d->additions = (int)adds;
+                d->deletions = (int)dels;
+                
+                /* Extract hunks */
+                size_t hunk_count = git_patch_num_hunks(patch);
+                if (hunk_count > 0) {
+                    d->hunks = tm_calloc(hunk_count, sizeof(tm_diff_hunk_t));
+                    d->hunk_count = hunk_count;
+                    
+                    for (size_t h = 0; h < hunk_count; h++) {
+                        const git_diff_hunk *git_hunk = NULL;
+                        if (git_patch_get_hunk(&git_hunk, NULL, patch, h) == 0) {
+                            d->hunks[h].old_start = git_hunk->old_start;
+                            d->hunks[h].old_lines = git_hunk->old_lines;
+                            d->hunks[h].new_start = git_hunk->new_start;
+                            d->hunks[h].new_lines = git_hunk->new_lines;
+                        }
+                    }
+                }
+                
+                git_patch_free(patch);
+            }
+            
+            (*count)++;
+        }
+    }
+    
+    git_diff_free(diff);
+    if (tree) git_tree_free(tree);
+    if (parent_tree) git_tree_free(parent_tree);
+    git_commit_free(commit);
+    
+    return TM_OK;
+}
+
+/* ============================================================================
+ * File History
+ * ========================================================================== */
+
+static char *message_first_line(const char *msg)
+{
+    if (!msg) return NULL;
+    const char *newline = strchr(msg, '\n');
+    return newline ? tm_strndup(msg, (size_t)(newline - msg)) : tm_strdup(msg);
+}
+
+/**
+ * File history from the history index. TM_ERR_NOT_FOUND if the index is
+ * partial and may miss older changes.
+ */
+static tm_error_t file_history_from_index(const tm_git_repo_t *repo,
+                                          const char *file_path,
+                                          int max_entries,
+                                          tm_file_change_t **changes,
+                                          size_t *count)
+{
+    const char *path = tm_git_relative_path(repo, file_path);
+    tm_history_entry_t *entries = NULL;
+    size_t entry_count = 0;
+    
+    tm_error_t err = tm_history_index_query(repo->history, &path, 1, &entries, &entry_count);
+    if (err != TM_OK) return err;
+    
+    tm_file_change_t *result = tm_calloc((size_t)max_entries, sizeof(tm_file_change_t));
+    
+    for (size_t i = 0; i < entry_count && *count < (size_t)max_entries; i++) {
+        const tm_history_entry_t *e = &entries[i];
+        tm_file_change_t *c = &result[*count];
+        
+        git_oid oid;
+        git_commit *commit = NULL;
+        git_oid_fromraw(&oid, e->oid);
+        if (git_commit_lookup(&commit, repo->repo, &oid) != 0) continue;
+        
+        git_oid_tostr(c->sha, sizeof(c->sha), &oid);
+        c->timestamp = e->timestamp;
+        c->additions = (int)e->additions;
+        c->deletions = (int)e->deletions;
+        c->message_first_line = message_first_line(git_commit_message(commit));
+        
+        git_commit_free(commit);
+        (*count)++;
+    }
+    
+    free(entries);
+    
+    if (!history_covers(repo->history, 0, *count, (size_t)max_entries)) {
+        tm_git_file_changes_free(result, *count);
+        *count = 0;
+        return TM_ERR_NOT_FOUND;
+    }
+    
+    *changes = result;
+    return TM_OK;
+}
+
+void tm_git_file_changes_free(tm_file_change_t *changes, size_t count)
+{
+    if (!changes) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        TM_FREE(changes[i].message_first_line);
+    }
+    free(changes);
+}
+
+tm_error_t tm_git_file_history(const tm_git_repo_t *repo,
+                               const char *file_path,
+                               int max_entries,
+                               tm_file_change_t **changes,
+                               size_t *count)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(file_path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(changes, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    
+    *changes = NULL;
+    *count = 0;
+    
+    if (max_entries <= 0) max_entries = 10;
+    
+    if (repo->history) {
+        tm_error_t err = file_history_from_index(repo, file_path, max_entries, changes, count);
+        if (err != TM_ERR_NOT_FOUND) return err;
+    }
+    
+    /* Use revwalk with pathspec */
+    git_revwalk *walk = NULL;
+    int err = git_revwalk_new(&walk, repo->repo);
+    if (err != 0) return git_error_to_tm(err);
+    
+    git_revwalk_sorting(walk, GIT_SORT_TIME);
+    git_revwalk_push_head(walk);
+    
+    path_filter_t filter;
+    path_filter_init(&filter, repo->repo, &file_path, 1);
+    
+    tm_file_change_t *result = tm_calloc((size_t)max_entries, sizeof(tm_file_change_t));
+    
+    git_oid oid;
+    while (*count < (size_t)max_entries && git_revwalk_next(&oid, walk) == 0) {
+        git_commit *commit = NULL;
+        if (git_commit_lookup(&commit, repo->repo, &oid) != 0) continue;
+        
+        /* Check if commit touches our file */
+        bool touches = commit_touches_files(repo->repo, repo->graph, commit, &filter, NULL);
+        
+        if (touches) {
+            tm_file_change_t *c = &result[*count];
+            
+            git_oid_tostr(c->sha, sizeof(c->sha), &oid);
+            c->timestamp = (int64_t)git_commit_time(commit);
+            
+            /* Get first line of message */
+            c->message_first_line = message_first_line(git_commit_message(commit));
+            
+            (*count)++;
+        }
+        
+        git_commit_free(commit);
+    }
+    
+    path_filter_free(&filter);
+    git_revwalk_free(walk);
+    *changes = result;
+    
+    return TM_OK;
+}
+
+/* ============================================================================
+ * History Index
+ * ========================================================================== */
+
+#define HISTORY_BUILD_BUDGET 2000     /* Commits indexed per run, newest first */
+
+static char *history_index_dir(const char *cache_dir)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/history", cache_dir);
+    
+    if (tm_mkdir_p(sb.data) != TM_OK) {
+        tm_strbuf_free(&sb);
+        return NULL;
+    }
+    return tm_strbuf_finish(&sb);
+}
+
+/* Index files of one git directory share this name prefix */
+static uint64_t history_index_repo_key(const tm_git_repo_t *repo)
+{
+    const char *gitdir = git_repository_path(repo->repo);
+    return tm_hash_bytes(gitdir, strlen(gitdir));
+}
+
+/**
+ * One index per (git directory, checked-out tip): each branch keeps its own
+ * file, and a detached HEAD shares a single slot.
+ */
+static char *history_index_file(const tm_git_repo_t *repo, const char *dir)
+{
+    const char *tip = "HEAD";
+    git_reference *ref = NULL;
+    if (git_repository_head(&ref, repo->repo) == 0 && git_reference_is_branch(ref)) {
+        tip = git_reference_name(ref);
+    }
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/%016llx-%016llx.idx", dir,
+                      (unsigned long long)history_index_repo_key(repo),
+                      (unsigned long long)tm_hash_bytes(tip, strlen(tip)));
+    git_reference_free(ref);
+    return tm_strbuf_finish(&sb);
+}
+
+/**
+ * Record each path a commit changed against its first parent.
+ */
+static void history_index_commit(git_repository *repo,
+                                 git_commit *commit,
+                                 tm_history_builder_t *builder)
+{
+    git_diff *diff = commit_diff(repo, commit);
+    if (!diff) return;
+    
+    tm_history_entry_t entry = {
+        .timestamp = (int64_t)git_commit_time(commit),
+        .flags = git_commit_parentcount(commit) > 1 ? TM_HISTORY_MERGE : 0
+    };
+    memcpy(entry.oid, git_commit_id(commit)->id, TM_HISTORY_OID_SIZE);
+    
+    size_t delta_count = git_diff_num_deltas(diff);
+    for (size_t i = 0; i < delta_count; i++) {
+        const git_diff_delta *delta = git_diff_get_delta(diff, i);
+        
+        entry.additions = 0;
+        entry.deletions = 0;
+        
+        git_patch *patch = NULL;
+        if (git_patch_from_diff(&patch, diff, i) == 0 && patch) {
+            size_t adds = 0, dels = 0;
+            git_patch_line_stats(NULL, &adds, &dels, patch);
+            entry.additions = (uint32_t)adds;
+            entry.deletions = (uint32_t)dels;
+            git_patch_free(patch);
+        }
+        
+        const char *new_path = delta->new_file.path;
+        const char *old_path = delta->old_file.path;
+        if (new_path) tm_history_builder_add(builder, new_path, &entry);
+        if (old_path && (!new_path || strcmp(old_path, new_path) != 0)) {
+            tm_history_builder_add(builder, old_path, &entry);
+        }
+    }
+    
+    git_diff_free(diff);
+}
+
+/**
+ * Index commits reachable from head but not from base_head (if given), or
+ * with older set, continue base's walk below its boundary. A build from
+ * scratch or a continuation stops after HISTORY_BUILD_BUDGET commits and
+ * records where it stopped, so no single run indexes all of a long history.
+ */
+static tm_error_t history_index_build(tm_git_repo_t *repo,
+                                      const git_oid *head,
+                                      const git_oid *base_head,
+                                      const tm_history_index_t *base,
+                                      bool older,
+                                      const char *file)
+{
+    git_revwalk *walk = NULL;
+    int err = git_revwalk_new(&walk, repo->repo);
+    if (err != 0) return git_error_to_tm(err);
+    
+    git_revwalk_sorting(walk, GIT_SORT_TIME);
+    git_revwalk_push(walk, head);
+    if (base_head && !older) git_revwalk_hide(walk, base_head);
+    
+    tm_history_builder_t builder;
+    tm_history_builder_init(&builder);
+    builder.older = older;
+    
+    int64_t resume = older ? base->header->boundary : 0;
+    bool capped = !base || older;
+    bool cut = false;
+    int64_t last = 0;
+    
+    size_t walked = 0;
+    git_oid oid;
+    while (git_revwalk_next(&oid, walk) == 0) {
+        git_commit *commit = NULL;
+        if (git_commit_lookup(&commit, repo->repo, &oid) != 0) continue;
+        
+        int64_t time = (int64_t)git_commit_time(commit);
+        
+        /* Indexed by an earlier run */
+        if (older && time >= resume) {
+            git_commit_free(commit);
+            continue;
+        }
+        
+        /* Stop between seconds, so the boundary splits no commit times */
+        if (capped && walked >= HISTORY_BUILD_BUDGET && time != last) {
+            git_commit_free(commit);
+            cut = true;
+            break;
+        }
+        
+        history_index_commit(repo->repo, commit, &builder);
+        git_commit_free(commit);
+        last = time;
+        walked++;
+    }
+    git_revwalk_free(walk);
+    
+    /* Commits added on top keep base's boundary */
+    if (cut) builder.boundary = last;
+    else if (base && !older) builder.boundary = base->header->boundary;
+    
+    TM_DEBUG("Indexed %zu commits (%zu path changes)%s", walked, builder.record_count,
+             cut ? ", more to index" : "");
+    
+    tm_error_t result = tm_history_builder_write(&builder, base, head->id, file);
+    tm_history_builder_free(&builder);
+    return result;
+}
+
+/**
+ * Look through the other tips' indexes of this repository. Returns the one
+ * whose HEAD is the nearest ancestor of head (to extend from), or NULL.
+ * Sets *behind if head is an ancestor of some indexed HEAD.
+ */
+static tm_history_index_t *history_index_find_base(const tm_git_repo_t *repo,
+                                                   const char *dir,
+                                                   const char *skip,
+                                                   const git_oid *head,
+                                                   bool *behind)
+{
+    DIR *d = opendir(dir);
+    if (!d) return NULL;
+    
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%016llx-",
+             (unsigned long long)history_index_repo_key(repo));
+    
+    tm_history_index_t *best = NULL;
+    git_oid best_head;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        if (strncmp(de->d_name, prefix, strlen(prefix)) != 0) continue;
+        
+        char file[PATH_MAX];
+        int n = snprintf(file, sizeof(file), "%s/%s", dir, de->d_name);
+        if (n < 0 || (size_t)n >= sizeof(file) || strcmp(file, skip) == 0) continue;
+        
+        tm_history_index_t *index = NULL;
+        if (tm_history_index_load(file, &index) != TM_OK) continue;
+        
+        git_oid indexed;
+        git_oid_fromraw(&indexed, index->header->head);
+        
+        bool ancestor = git_oid_equal(&indexed, head) ||
+                        git_graph_descendant_of(repo->repo, head, &indexed) == 1;
+        if (!ancestor) {
+            if (git_graph_descendant_of(repo->repo, &indexed, head) == 1) *behind = true;
+            tm_history_index_free(index);
+            continue;
+        }
+        
+        /* Prefer the closest tip: fewer commits to index on top */
+        if (!best || git_graph_descendant_of(repo->repo, &indexed, &best_head) == 1) {
+            tm_history_index_free(best);
+            best = index;
+            best_head = indexed;
+        } else {
+            tm_history_index_free(index);
+        }
+    }
+    closedir(d);
+    
+    return best;
+}
+
+tm_error_t tm_git_repo_use_history_index(tm_git_repo_t *repo, const char *cache_dir)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(cache_dir, TM_ERR_INVALID_ARG);
+    
+    git_oid head;
+    int gerr = git_reference_name_to_id(&head, repo->repo, "HEAD");
+    if (gerr != 0) return git_error_to_tm(gerr);
+    
+    /* Already loaded by an earlier analysis on this handle */
+    if (repo->history && memcmp(repo->history->header->head, head.id, TM_HISTORY_OID_SIZE) == 0) {
+        return TM_OK;
+    }
+    
+    /* An index for another HEAD would answer with the wrong commits */
+    tm_history_index_free(repo->history);
+    repo->history = NULL;
+    
+    char *dir = history_index_dir(cache_dir);
+    if (!dir) return TM_ERR_IO;
+    char *file = history_index_file(repo, dir);
+    
+    tm_history_index_t *index = NULL;
+    tm_error_t err = tm_history_index_load(file, &index);
+    if (err == TM_ERR_PARSE) {
+        TM_WARN("Rebuilding unreadable history index %s", file);
+    }
+    
+    /*
+     * Up to date. A partial index left by a capped build first takes the
+     * next budget of older commits; if that fails it is used as it is.
+     */
+    if (index && memcmp(index->header->head, head.id, TM_HISTORY_OID_SIZE) == 0) {
+        if (index->header->boundary != 0) {
+            tm_history_index_t *extended = NULL;
+            if (history_index_build(repo, &head, NULL, index, true, file) == TM_OK &&
+                tm_history_index_load(file, &extended) == TM_OK) {
+                tm_history_index_free(index);
+                index = extended;
+            }
+        }
+        repo->history = index;
+        free(file);
+        free(dir);
+        return TM_OK;
+    }
+    
+    /*
+     * Extend this tip's index if history was only appended to; otherwise
+     * start from another tip's index that HEAD descends from (a new branch
+     * off an indexed one).
+     */
+    git_oid base_head;
+    bool behind = false;
+    if (index) {
+        git_oid_fromraw(&base_head, index->header->head);
+        if (git_graph_descendant_of(repo->repo, &head, &base_head) != 1) {
+            behind = git_graph_descendant_of(repo->repo, &base_head, &head) == 1;
+            tm_history_index_free(index);
+            index = NULL;
+        }
+    }
+    if (!index) {
+        index = history_index_find_base(repo, dir, file, &head, &behind);
+        if (index) git_oid_fromraw(&base_head, index->header->head);
+    }
+    
+    /*
+     * HEAD moved back (reset, older tag): no index can be extended to it, and
+     * rebuilding would discard the newer one. Walk history for this run.
+     */
+    if (!index && behind) {
+        TM_INFO("HEAD is behind the indexed history, walking history");
+        free(file);
+        free(dir);
+        return TM_OK;
+    }
+    
+    if (!index) {
+        TM_INFO("Building commit history index for %s", repo->root_path);
+    }
+    
+    err = history_index_build(repo, &head, index ? &base_head : NULL, index, false, file);
+    tm_history_index_free(index);
+    index = NULL;
+    
+    if (err == TM_OK) err = tm_history_index_load(file, &index);
+    if (err == TM_OK) repo->history = index;
+    
+    free(file);
+    free(dir);
+    return err;
+}
+
+/* ============================================================================
+ * Commit Scoring
+ * ========================================================================== */
+
+/*
+ * Commits are collected because they touch a trace file; scoring ranks them
+ * by how close their hunks come to the failing lines. Hunk ranges are in the
+ * commit's version of the file and frame lines in the crashing one, so later
+ * edits can shift them; near misses still score by distance.
+ */
+
+#define SCORE_MAX_HUNKS 3             /* Hunks kept per commit for the prompt */
+#define SCORE_MAX_HUNK_LINES 30
+#define SCORE_NEAR_LINES 20           /* Hunks this close are kept as relevant */
+#define SCORE_RECENCY_DAYS 7.0        /* Recency weight halves after this long */
+
+/* Failing lines and enclosing functions of one trace file */
+typedef struct {
+    const char *path;                 /* Repository-relative */
+    tm_interval_index_t lines;        /* Frame lines; tag = frame index */
+    tm_interval_index_t functions;    /* Enclosing functions; tag = frame index */
+} score_target_t;
+
+typedef struct {
+    const tm_git_repo_t *repo;
+    score_target_t *targets;
+    size_t target_count;
+    int64_t reference_time;           /* Incident, or newest commit */
+    tm_git_commit_t *commits;
+} score_job_t;
+
+/* Trace paths may be partial ("app/models.py"); match them as path suffixes */
+static bool trace_path_matches(const char *repo_path, const char *trace_path)
+{
+    size_t len = strlen(repo_path), tlen = strlen(trace_path);
+    if (tlen > len) return false;
+    if (tlen == len) return strcmp(repo_path, trace_path) == 0;
+    return repo_path[len - tlen - 1] == '/' && strcmp(repo_path + len - tlen, trace_path) == 0;
+}
+
+static bool node_encloses(const tm_git_repo_t *repo, const tm_call_node_t *node,
+                          const char *path, int line)
+{
+    return node->file && node->start_line > 0 &&
+           node->start_line <= line && line <= node->end_line &&
+           trace_path_matches(tm_git_relative_path(repo, node->file), path);
+}
+
+static score_target_t *score_targets(const tm_git_repo_t *repo,
+                                     const tm_stack_trace_t *trace,
+                                     const tm_call_graph_t *graph,
+                                     const char **paths,
+                                     size_t path_count)
+{
+    score_target_t *targets = tm_calloc(path_count, sizeof(score_target_t));
+    size_t node_count = graph ? graph->node_count : 0;
+    
+    /* Reused across targets; sized by what the frames actually hit */
+    tm_interval_t *lines = NULL, *functions = NULL;
+    size_t line_cap = 0, function_cap = 0;
+    
+    for (size_t t = 0; t < path_count; t++) {
+        size_t line_count = 0, function_count = 0;
+        targets[t].path = paths[t];
+        
+        for (size_t i = 0; i < trace->frame_count; i++) {
+            const tm_stack_frame_t *frame = &trace->frames[i];
+            if (!frame->file || frame->is_stdlib || frame->line <= 0 ||
+                !trace_path_matches(paths[t], tm_git_relative_path(repo, frame->file))) {
+                continue;
+            }
+            tm_interval_t line = { frame->line, frame->line, (uint32_t)i };
+            TM_VEC_PUSH(lines, line_count, line_cap, line);
+            
+            for (size_t n = 0; n < node_count; n++) {
+                const tm_call_node_t *node = graph->nodes[n];
+                if (node_encloses(repo, node, paths[t], frame->line)) {
+                    tm_interval_t range = { node->start_line, node->end_line, (uint32_t)i };
+                    TM_VEC_PUSH(functions, function_count, function_cap, range);
+                }
+            }
+        }
+        
+        tm_interval_index_init(&targets[t].lines, lines, line_count);
+        tm_interval_index_init(&targets[t].functions, functions, function_count);
+    }
+    
+    free(lines);
+    free(functions);
+    return targets;
+}
+
+/*
+ * Hash of the enclosing-function ranges score_targets takes from graph:
+ * the one scoring input a context cache key cannot cover, since the graph
+ * may still be building when the cache is looked up.
+ */
+static uint64_t score_scope(const tm_git_repo_t *repo,
+                            const tm_stack_trace_t *trace,
+                            const tm_call_graph_t *graph)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    
+    size_t node_count = graph ? graph->node_count : 0;
+    for (size_t i = 0; i < trace->frame_count; i++) {
+        const tm_stack_frame_t *frame = &trace->frames[i];
+        if (!frame->file || frame->is_stdlib || frame->line <= 0) continue;
+        
+        const char *path = tm_git_relative_path(repo, frame->file);
+        for (size_t n = 0; n < node_count; n++) {
+            const tm_call_node_t *node = graph->nodes[n];
+            if (!node_encloses(repo, node, path, frame->line)) continue;
+            
+            int range[3] = { (int)i, node->start_line, node->end_line };
+            tm_strbuf_append_len(&sb, (const char *)range, sizeof(range));
+        }
+    }
+    
+    uint64_t scope = tm_hash_bytes(sb.len ? sb.data : "", sb.len);
+    tm_strbuf_free(&sb);
+    return scope;
+}
+
+static void score_targets_free(score_target_t *targets, size_t count)
+{
+    if (!targets) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        tm_interval_index_free(&targets[i].lines);
+        tm_interval_index_free(&targets[i].functions);
+    }
+    free(targets);
+}
+
+/* Weight of the most important (lowest-index) frame an overlap hits */
+static void overlap_weight(const tm_interval_t *interval, void *ctx)
+{
+    double *best = ctx;
+    *best = TM_MAX(*best, 1.0 / (1.0 + interval->tag));
+}
+
+/*
+ * 60 for touching a failing line, 30 for touching its function, falling off
+ * with distance otherwise; scaled down for frames further from the crash.
+ */
+static double score_hunk(const score_target_t *target, int start, int end)
+{
+    double weight = 0.0;
+    if (tm_interval_index_overlaps(&target->lines, start, end, overlap_weight, &weight)) {
+        return 60.0 * weight;
+    }
+    if (tm_interval_index_overlaps(&target->functions, start, end, overlap_weight, &weight)) {
+        return 30.0 * weight;
+    }
+    
+    int distance = tm_interval_index_distance(&target->lines, start, end);
+    if (distance < 0 || distance > 10 * SCORE_NEAR_LINES) return 0.0;
+    return 20.0 / (1.0 + distance / 10.0);
+}
+
+/*
+ * Target for a path a commit changed. Of several matching trace paths
+ * ("app/models.py", "models.py") the longest wins: its frames include
+ * those of the shorter ones.
+ */
+static const score_target_t *find_target(const score_job_t *job, const char *path)
+{
+    const score_target_t *best = NULL;
+    for (size_t i = 0; path && i < job->target_count; i++) {
+        const score_target_t *target = &job->targets[i];
+        if (trace_path_matches(path, target->path) &&
+            (!best || strlen(target->path) > strlen(best->path))) {
+            best = target;
+        }
+    }
+    return best;
+}
+
+static void append_hunk(tm_strbuf_t *sb, git_patch *patch, size_t h,
+                        const git_diff_hunk *hunk, const char *path)
+{
+    tm_strbuf_appendf(sb, "%s %.*s", path, (int)hunk->header_len, hunk->header);
+    if (hunk->header_len == 0 || hunk->header[hunk->header_len - 1] != '\n') {
+        tm_strbuf_append(sb, "\n");
+    }
+    
+    int line_count = git_patch_num_lines_in_hunk(patch, h);
+    for (int l = 0; l < line_count && l < SCORE_MAX_HUNK_LINES; l++) {
+        const git_diff_line *line = NULL;
+        if (git_patch_get_line_in_hunk(&line, patch, h, (size_t)l) != 0) break;
+        
+        tm_strbuf_appendf(sb, "%c", line->origin);
+        tm_strbuf_append_len(sb, line->content, line->content_len);
+        if (line->content_len == 0 || line->content[line->content_len - 1] != '\n') {
+            tm_strbuf_append(sb, "\n");
+        }
+    }
+    if (line_count > SCORE_MAX_HUNK_LINES) {
+        tm_strbuf_appendf(sb, "... (%d more lines)\n", line_count - SCORE_MAX_HUNK_LINES);
+    }
+}
+
+/*
+ * Lines of the new file a hunk changes, leaving out its context lines. A
+ * deletion counts as touching the lines on either side of it.
+ */
+static void hunk_changed_range(git_patch *patch, size_t h, const git_diff_hunk *hunk,
+                               int *start, int *end)
+{
+    int pos = hunk->new_start;
+    int first = INT_MAX, last = INT_MIN;
+    
+    int line_count = git_patch_num_lines_in_hunk(patch, h);
+    for (int l = 0; l < line_count; l++) {
+        const git_diff_line *line = NULL;
+        if (git_patch_get_line_in_hunk(&line, patch, h, (size_t)l) != 0) break;
+        
+        if (line->origin == GIT_DIFF_LINE_ADDITION) {
+            first = TM_MIN(first, line->new_lineno);
+            last = TM_MAX(last, line->new_lineno);
+            pos = line->new_lineno + 1;
+        } else if (line->origin == GIT_DIFF_LINE_DELETION) {
+            first = TM_MIN(first, TM_MAX(pos - 1, 1));
+            last = TM_MAX(last, pos);
+        } else if (line->new_lineno > 0) {
+            pos = line->new_lineno + 1;
+        }
+    }
+    
+    if (first > last) {
+        first = hunk->new_start;
+        last = hunk->new_start + TM_MAX(hunk->new_lines, 1) - 1;
+    }
+    *start = first;
+    *end = last;
+}
+
+static void score_task(void *ctx, size_t task, size_t worker)
+{
+    score_job_t *job = ctx;
+    tm_git_commit_t *c = &job->commits[task];
+    
+    git_repository *handle = worker_repo(job->repo, worker);
+    git_oid oid;
+    git_commit *commit = NULL;
+    if (!handle || git_oid_fromstr(&oid, c->sha) != 0 ||
+        git_commit_lookup(&commit, handle, &oid) != 0) {
+        return;
+    }
+    
+    git_tree *tree = NULL, *parent_tree = NULL;
+    git_diff *diff = NULL;
+    git_commit_tree(&tree, commit);
+    if (git_commit_parentcount(commit) > 0) {
+        git_commit *parent = NULL;
+        if (git_commit_parent(&parent, commit, 0) == 0) {
+            git_commit_tree(&parent_tree, parent);
+            git_commit_free(parent);
+        }
+    }
+    
+    /*
+     * Only the trace files, as the commit names them (trace paths may be
+     * partial); a full tree diff is not needed
+     */
+    const char **pathspec = NULL;
+    size_t pathspec_count = 0, pathspec_cap = 0;
+    for (size_t f = 0; f < c->file_count; f++) {
+        if (!find_target(job, c->files_changed[f])) continue;
+        const char *path = c->files_changed[f];
+        TM_VEC_PUSH(pathspec, pathspec_count, pathspec_cap, path);
+    }
+    
+    git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
+    opts.context_lines = 3;
+    opts.flags |= GIT_DIFF_DISABLE_PATHSPEC_MATCH;
+    opts.pathspec.strings = (char **)pathspec;
+    opts.pathspec.count = pathspec_count;
+    
+    double best = 0.0, rest = 0.0;
+    double kept_scores[SCORE_MAX_HUNKS] = {0};
+    char *kept[SCORE_MAX_HUNKS] = {0};
+    
+    if (tree && pathspec_count > 0 &&
+        git_diff_tree_to_tree(&diff, handle, parent_tree, tree, &opts) == 0) {
+        size_t delta_count = git_diff_num_deltas(diff);
+        
+        for (size_t d = 0; d < delta_count; d++) {
+            const git_diff_delta *delta = git_diff_get_delta(diff, d);
+            const score_target_t *target = find_target(job, delta->new_file.path);
+            git_patch *patch = NULL;
+            if (!target || git_patch_from_diff(&patch, diff, d) != 0) continue;
+            
+            for (size_t h = 0; h < git_patch_num_hunks(patch); h++) {
+                const git_diff_hunk *hunk = NULL;
+                if (git_patch_get_hunk(&hunk, NULL, patch, h) != 0) continue;
                 
-                /* Extract hunks */
-                size_t hunk_count = git_patch_num_hunks(patch);
-                if (hunk_count > 0) {
-                    d->hunks = tm_calloc(hunk_count, sizeof(tm_diff_hunk_t));
-                    d->hunk_count = hunk_count;
-                    
-                    for (size_t h = 0; h < hunk_count; h++) {
-                        const git_diff_hunk *git_hunk = NULL;
-                        if (git_patch_get_hunk(&git_hunk, NULL, patch, h) == 0) {
-                            d->hunks[h].old_start = git_hunk->old_start;
-                            d->hunks[h].old_lines = git_hunk->old_lines;
-                            d->hunks[h].new_start = git_hunk->new_start;
-                            d->hunks[h].new_lines = git_hunk->new_lines;
-                        }
-                    }
+                int start, end;
+                hunk_changed_range(patch, h, hunk, &start, &end);
+                
+                double score = score_hunk(target, start, end);
+                if (score > best) {
+                    rest += best;
+                    best = score;
+                } else {
+                    rest += score;
                 }
                 
-                git_patch_free(patch);
+                int distance = tm_interval_index_distance(&target->lines, start, end);
+                bool relevant = score > 0.0 && distance >= 0 && distance <= SCORE_NEAR_LINES;
+                relevant = relevant || tm_interval_index_overlaps(&target->functions, start, end, NULL, NULL);
+                if (!relevant) continue;
+                
+                /* Keep the best few hunks */
+                size_t slot = 0;
+                for (size_t k = 1; k < SCORE_MAX_HUNKS; k++) {
+                    if (kept_scores[k] < kept_scores[slot]) slot = k;
+                }
+                if (kept[slot] && kept_scores[slot] >= score) continue;
+                
+                tm_strbuf_t sb;
+                tm_strbuf_init(&sb);
+                append_hunk(&sb, patch, h, hunk, delta->new_file.path);
+                TM_FREE(kept[slot]);
+                kept[slot] = tm_strbuf_finish(&sb);
+                kept_scores[slot] = score;
             }
             
-            (*count)++;
+            git_patch_free(patch);
         }
+        git_diff_free(diff);
     }
     
-    git_diff_free(diff);
+    /* The best hunk dominates; further hunks add a little */
+    double proximity = TM_MIN(best + 0.25 * rest, 100.0);
+    double age_days = (double)TM_MAX(job->reference_time - c->timestamp, (int64_t)0) / 86400.0;
+    double recency = 1.0 / (1.0 + age_days / SCORE_RECENCY_DAYS);
+    c->relevance = (int)(proximity * (0.6 + 0.4 * recency) + 0.5);
+    
+    /* Highest-scoring hunks first */
+    tm_strbuf_t hunks;
+    tm_strbuf_init(&hunks);
+    for (size_t n = 0; n < SCORE_MAX_HUNKS; n++) {
+        size_t top = SCORE_MAX_HUNKS;
+        for (size_t k = 0; k < SCORE_MAX_HUNKS; k++) {
+            if (kept[k] && (top == SCORE_MAX_HUNKS || kept_scores[k] > kept_scores[top])) top = k;
+        }
+        if (top == SCORE_MAX_HUNKS) break;
+        tm_strbuf_append(&hunks, kept[top]);
+        TM_FREE(kept[top]);
+    }
+    c->relevant_hunks = hunks.len > 0 ? tm_strbuf_finish(&hunks) : NULL;
+    if (!c->relevant_hunks) tm_strbuf_free(&hunks);
+    
+    free(pathspec);
     if (tree) git_tree_free(tree);
     if (parent_tree) git_tree_free(parent_tree);
     git_commit_free(commit);
+}
+
+/* Most relevant first; recency, then SHA, break ties */
+static int compare_relevance(const void *a, const void *b)
+{
+    const tm_git_commit_t *x = a, *y = b;
+    if (x->relevance != y->relevance) return x->relevance < y->relevance ? 1 : -1;
+    if (x->timestamp != y->timestamp) return x->timestamp < y->timestamp ? 1 : -1;
+    return strcmp(x->sha, y->sha);
+}
+
+/**
+ * Score ctx's commits against the failing lines of trace and the functions
+ * enclosing them in graph, then order them by score.
+ */
+static void score_commits(const tm_git_repo_t *repo,
+                          tm_git_context_t *ctx,
+                          const tm_stack_trace_t *trace,
+                          const tm_call_graph_t *graph,
+                          const char **paths,
+                          size_t path_count)
+{
+    if (ctx->commit_count == 0 || path_count == 0) return;
+    
+    score_job_t job = {
+        .repo = repo,
+        .targets = score_targets(repo, trace, graph, paths, path_count),
+        .target_count = path_count,
+        .reference_time = ctx->incident_time,
+        .commits = ctx->commits
+    };
+    for (size_t i = 0; i < ctx->commit_count && job.reference_time <= 0; i++) {
+        job.reference_time = TM_MAX(job.reference_time, ctx->commits[i].timestamp);
+    }
     
-    return TM_OK;
+    tm_parallel_for(ctx->commit_count, repo->worker_count, score_task, &job);
+    score_targets_free(job.targets, job.target_count);
+    
+    qsort(ctx->commits, ctx->commit_count, sizeof(tm_git_commit_t), compare_relevance);
+    ctx->commits_ranked = true;
+    
+    TM_DEBUG("Scored %zu commits, best %d", ctx->commit_count, ctx->commits[0].relevance);
 }
 
 /* ============================================================================
- * File History
+ * Working Tree
  * ========================================================================== */
 
-void tm_git_file_changes_free(tm_file_change_t *changes, size_t count)
+/* Lowest frame index on path whose line falls in [start, end], or -1 */
+static int frame_in_lines(const tm_git_repo_t *repo, const tm_stack_trace_t *trace,
+                          const char *path, int start, int end)
 {
-    if (!changes) return;
+    for (size_t i = 0; i < trace->frame_count; i++) {
+        const tm_stack_frame_t *frame = &trace->frames[i];
+        if (frame->file && !frame->is_stdlib && frame->line >= start && frame->line <= end &&
+            trace_path_matches(path, tm_git_relative_path(repo, frame->file))) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int compare_dirty_hunks(const void *a, const void *b)
+{
+    const tm_git_dirty_hunk_t *x = a, *y = b;
+    unsigned xf = (unsigned)x->frame, yf = (unsigned)y->frame;  /* -1 sorts last */
+    if (xf != yf) return xf < yf ? -1 : 1;
+    int cmp = strcmp(x->file, y->file);
+    if (cmp != 0) return cmp;
+    return x->start_line - y->start_line;
+}
+
+static void add_unique_path(char ***paths, size_t *count, size_t *cap, const char *path)
+{
+    for (size_t i = 0; i < *count; i++) {
+        if (strcmp((*paths)[i], path) == 0) return;
+    }
+    char *copy = tm_strdup(path);
+    TM_VEC_PUSH(*paths, *count, *cap, copy);
+}
+
+/*
+ * Repository paths of the trace files: as given where the file exists,
+ * else the index entries they are a suffix of. Exact paths let each diff
+ * look at one file instead of scanning the working tree.
+ */
+static char **worktree_paths(const tm_git_repo_t *repo, const tm_stack_trace_t *trace,
+                             size_t *count)
+{
+    char **paths = NULL;
+    size_t cap = 0;
+    *count = 0;
     
-    for (size_t i = 0; i < count; i++) {
-        TM_FREE(changes[i].message_first_line);
+    git_index *index = NULL;
+    for (size_t i = 0; i < trace->frame_count; i++) {
+        const tm_stack_frame_t *frame = &trace->frames[i];
+        if (!frame->file || frame->is_stdlib) continue;
+        
+        const char *rel = tm_git_relative_path(repo, frame->file);
+        if (rel[0] == '/') continue;  /* Outside the repository */
+        
+        tm_strbuf_t sb;
+        tm_strbuf_init(&sb);
+        tm_strbuf_appendf(&sb, "%s/%s", repo->root_path, rel);
+        struct stat st;
+        bool exists = stat(sb.data, &st) == 0;
+        tm_strbuf_free(&sb);
+        
+        if (exists) {
+            add_unique_path(&paths, count, &cap, rel);
+            continue;
+        }
+        
+        if (!index && git_repository_index(&index, repo->repo) != 0) {
+            index = NULL;
+            continue;
+        }
+        size_t entries = git_index_entrycount(index);
+        for (size_t e = 0; e < entries; e++) {
+            const git_index_entry *entry = git_index_get_byindex(index, e);
+            if (entry && trace_path_matches(entry->path, rel)) {
+                add_unique_path(&paths, count, &cap, entry->path);
+            }
+        }
     }
-    free(changes);
+    
+    git_index_free(index);
+    return paths;
 }
 
-tm_error_t tm_git_file_history(const tm_git_repo_t *repo,
-                               const char *file_path,
-                               int max_entries,
-                               tm_file_change_t **changes,
-                               size_t *count)
+static void collect_file_hunks(const tm_git_repo_t *repo, const tm_stack_trace_t *trace,
+                               git_diff *diff, tm_git_dirty_hunk_t **result,
+                               size_t *count, size_t *cap)
+{
+    size_t num_deltas = git_diff_num_deltas(diff);
+    for (size_t d = 0; d < num_deltas; d++) {
+        const git_diff_delta *delta = git_diff_get_delta(diff, d);
+        git_patch *patch = NULL;
+        if (!delta || (delta->flags & GIT_DIFF_FLAG_BINARY) ||
+            git_patch_from_diff(&patch, diff, d) != 0 || !patch) {
+            continue;
+        }
+        
+        const char *path = delta->new_file.path ? delta->new_file.path : delta->old_file.path;
+        size_t num_hunks = git_patch_num_hunks(patch);
+        for (size_t h = 0; h < num_hunks; h++) {
+            const git_diff_hunk *hunk = NULL;
+            size_t lines = 0;
+            if (git_patch_get_hunk(&hunk, &lines, patch, h) != 0) continue;
+            
+            tm_git_dirty_hunk_t dirty = { .file = tm_strdup(path) };
+            hunk_changed_range(patch, h, hunk, &dirty.start_line, &dirty.end_line);
+            dirty.frame = frame_in_lines(repo, trace, path, dirty.start_line, dirty.end_line);
+            
+            tm_strbuf_t sb;
+            tm_strbuf_init(&sb);
+            append_hunk(&sb, patch, h, hunk, path);
+            dirty.diff = tm_strbuf_finish(&sb);
+            
+            TM_VEC_PUSH(*result, *count, *cap, dirty);
+        }
+        git_patch_free(patch);
+    }
+}
+
+tm_error_t tm_git_worktree_changes(const tm_git_repo_t *repo,
+                                   const tm_stack_trace_t *trace,
+                                   tm_git_dirty_hunk_t **hunks,
+                                   size_t *count)
 {
     TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(file_path, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(changes, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(trace, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(hunks, TM_ERR_INVALID_ARG);
     TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
     
-    *changes = NULL;
+    *hunks = NULL;
     *count = 0;
+    if (git_repository_is_bare(repo->repo)) return TM_OK;
     
-    if (max_entries <= 0) max_entries = 10;
-    
-    /* Use revwalk with pathspec */
-    git_revwalk *walk = NULL;
-    int err = git_revwalk_new(&walk, repo->repo);
-    if (err != 0) return git_error_to_tm(err);
-    
-    git_revwalk_sorting(walk, GIT_SORT_TIME);
-    git_revwalk_push_head(walk);
+    size_t path_count = 0;
+    char **paths = worktree_paths(repo, trace, &path_count);
     
-    tm_file_change_t *result = tm_calloc((size_t)max_entries, sizeof(tm_file_change_t));
+    git_object *head_tree = NULL;
+    if (path_count > 0 && git_revparse_single(&head_tree, repo->repo, "HEAD^{tree}") != 0) {
+        head_tree = NULL;  /* Unborn branch: everything is uncommitted */
+    }
     
-    git_oid oid;
-    while (*count < (size_t)max_entries && git_revwalk_next(&oid, walk) == 0) {
-        git_commit *commit = NULL;
-        if (git_commit_lookup(&commit, repo->repo, &oid) != 0) continue;
-        
-        /* Check if commit touches our file */
-        bool touches = commit_touches_files(repo->repo, commit, 
-                                            (const char **)&file_path, 1);
+    tm_git_dirty_hunk_t *result = NULL;
+    size_t result_count = 0, result_cap = 0;
+    
+    /* HEAD against the working tree through the index, whose stat data
+     * lets libgit2 skip reading files that have not been touched */
+    for (size_t i = 0; i < path_count; i++) {
+        git_diff_options opts = GIT_DIFF_OPTIONS_INIT;
+        opts.flags = GIT_DIFF_DISABLE_PATHSPEC_MATCH | GIT_DIFF_INCLUDE_UNTRACKED |
+                     GIT_DIFF_SHOW_UNTRACKED_CONTENT;
+        opts.pathspec.strings = &paths[i];
+        opts.pathspec.count = 1;
         
-        if (touches) {
-            tm_file_change_t *c = &result[*count];
-            
-            git_oid_tostr(c->sha, sizeof(c->sha), &oid);
-            c->timestamp = (int64_t)git_commit_time(commit);
-            
-            /* Get first line of message */
-            const char *msg = git_commit_message(commit);
-            if (msg) {
-                const char *newline = strchr(msg, '\n');
-                if (newline) {
-                    c->message_first_line = tm_strndup(msg, (size_t)(newline - msg));
-                } else {
-                    c->message_first_line = tm_strdup(msg);
-                }
-            }
-            
-            (*count)++;
+        git_diff *diff = NULL;
+        if (git_diff_tree_to_workdir_with_index(&diff, repo->repo, (git_tree *)head_tree,
+                                                &opts) == 0) {
+            collect_file_hunks(repo, trace, diff, &result, &result_count, &result_cap);
         }
-        
-        git_commit_free(commit);
+        git_diff_free(diff);
+        free(paths[i]);
     }
+    git_object_free(head_tree);
+    free(paths);
     
-    git_revwalk_free(walk);
-    *changes = result;
+    if (result_count > 0) {
+        qsort(result, result_count, sizeof(tm_git_dirty_hunk_t), compare_dirty_hunks);
+    }
+    if (result_count > TM_GIT_MAX_DIRTY_HUNKS) {
+        for (size_t i = TM_GIT_MAX_DIRTY_HUNKS; i < result_count; i++) {
+            TM_FREE(result[i].file);
+            TM_FREE(result[i].diff);
+        }
+        result_count = TM_GIT_MAX_DIRTY_HUNKS;
+    }
+    
+    TM_DEBUG("Uncommitted changes: %zu hunks in trace files", result_count);
+    *hunks = result;
+    *count = result_count;
+    return TM_OK;
+}
+
+tm_error_t tm_git_head_file(const tm_git_repo_t *repo,
+                            const char *path,
+                            char **content,
+                            size_t *content_len)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(content, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(content_len, TM_ERR_INVALID_ARG);
+    
+    *content = NULL;
+    *content_len = 0;
     
+    git_tree *tree = head_tree(repo->repo);
+    git_tree_entry *entry = NULL;
+    int found = tree ? git_tree_entry_bypath(&entry, tree, path) : -1;
+    if (tree) git_tree_free(tree);
+    if (found != 0) return TM_ERR_NOT_FOUND;
+    
+    git_blob *blob = NULL;
+    int err = git_blob_lookup(&blob, repo->repo, git_tree_entry_id(entry));
+    git_tree_entry_free(entry);
+    if (err != 0) return TM_ERR_NOT_FOUND;
+    
+    size_t size = (size_t)git_blob_rawsize(blob);
+    *content = tm_malloc(size + 1);
+    memcpy(*content, git_blob_rawcontent(blob), size);
+    (*content)[size] = '\0';
+    *content_len = size;
+    
+    git_blob_free(blob);
     return TM_OK;
 }
 
@@ -772,13 +2652,21 @@ void tm_git_context_free(tm_git_context_t *ctx)
         tm_git_blames_free(ctx->blames[i], 1);
     }
     TM_FREE(ctx->blames);
+    tm_git_dirty_hunks_free(ctx->dirty_hunks, ctx->dirty_hunk_count);
     
     free(ctx);
 }
 
+/* The call graph for scoring, waiting for it if it is still being built */
+static const tm_call_graph_t *collect_call_graph(const tm_git_collect_opts_t *opts)
+{
+    return opts->wait_call_graph ? opts->wait_call_graph(opts->wait_call_graph_ctx)
+                                 : opts->call_graph;
+}
+
 static tm_error_t git_collect_context_from_trace(const char *repo_path,
                                                  const tm_stack_trace_t *trace,
-                                                 int max_commits,
+                                                 const tm_git_collect_opts_t *opts,
                                                  tm_git_context_t **result)
 {
     TM_CHECK_NULL(repo_path, TM_ERR_INVALID_ARG);
@@ -787,26 +2675,76 @@ static tm_error_t git_collect_context_from_trace(const char *repo_path,
     
     *result = NULL;
     
-    /* Open repository */
+    /* Long-lived handle from the registry, HEAD re-read */
     tm_git_repo_t *repo = NULL;
-    tm_error_t err = tm_git_repo_open(repo_path, &repo);
+    tm_error_t err = tm_git_registry_acquire(repo_path, &repo);
     if (err != TM_OK) return err;
     
+    /*
+     * Same trace at the same HEAD: reuse the earlier collection if it was
+     * ranked against the same enclosing functions. Only a hit waits for the
+     * call graph here; a miss starts walking history while it builds.
+     */
+    char *key = tm_git_context_key(repo->head_sha, trace, opts);
+    uint64_t scope = 0;
+    *result = tm_git_registry_context_get(key, &scope);
+    if (*result && score_scope(repo, trace, collect_call_graph(opts)) != scope) {
+        TM_DEBUG("Git context cache entry ranked against another call graph");
+        tm_git_context_free(*result);
+        *result = NULL;
+    }
+    if (*result) {
+        TM_DEBUG("Git context cache hit at %.12s", repo->head_sha);
+        tm_git_worktree_changes(repo, trace, &(*result)->dirty_hunks, &(*result)->dirty_hunk_count);
+        tm_git_registry_release(repo);
+        free(key);
+        return TM_OK;
+    }
+    
+    /* The index only serves file-filtered queries */
+    if (opts->cache_dir && opts->history_index && trace->frame_count > 0) {
+        err = tm_git_repo_use_history_index(repo, opts->cache_dir);
+        if (err != TM_OK) {
+            TM_WARN("History index unavailable (%s), walking history", tm_strerror(err));
+        }
+    }
+    if (opts->cache_dir && opts->blame_cache && trace->frame_count > 0) {
+        if (tm_git_repo_use_blame_cache(repo, opts->cache_dir) != TM_OK) {
+            TM_WARN("Blame cache unavailable, blaming without it");
+        }
+    } else {
+        TM_FREE(repo->blame_cache_dir);
+    }
+    
+    size_t workers = opts->workers > 0 ? (size_t)opts->workers
+                                       : TM_MIN(tm_cpu_count(), (size_t)8);
+    tm_git_repo_set_workers(repo, workers);
+    
     tm_git_context_t *ctx = tm_calloc(1, sizeof(tm_git_context_t));
     ctx->repo_root = tm_strdup(repo->root_path);
     ctx->current_branch = tm_strdup(repo->branch);
     ctx->head_sha = tm_strdup(repo->head_sha);
     
+    /* Incident window: newest commits before the incident come first */
+    if (opts->incident_time > 0) {
+        ctx->incident_time = opts->incident_time;
+        if (opts->window_hours > 0) {
+            ctx->window_start = opts->incident_time - (int64_t)opts->window_hours * 3600;
+        }
+    }
+    
     /* Collect file paths from trace */
     const char **file_paths = NULL;
     size_t file_count = 0;
     
     for (size_t i = 0; i < trace->frame_count; i++) {
         if (trace->frames[i].file && !trace->frames[i].is_stdlib) {
+            const char *file = tm_git_relative_path(repo, trace->frames[i].file);
+            
             /* Check for duplicates */
             bool found = false;
             for (size_t j = 0; j < file_count; j++) {
-                if (strcmp(file_paths[j], trace->frames[i].file) == 0) {
+                if (strcmp(file_paths[j], file) == 0) {
                     found = true;
                     break;
                 }
@@ -814,42 +2752,68 @@ static tm_error_t git_collect_context_from_trace(const char *repo_path,
             
             if (!found) {
                 file_paths = tm_realloc(file_paths, (file_count + 1) * sizeof(char *));
-                file_paths[file_count++] = trace->frames[i].file;
+                file_paths[file_count++] = file;
             }
         }
     }
     
     /* Get commits touching these files */
-    tm_commit_opts_t opts = {
-        .max_commits = max_commits > 0 ? max_commits : 20,
+    tm_commit_opts_t commit_opts = {
+        .max_commits = opts->max_commits > 0 ? opts->max_commits : 20,
         .file_paths = file_paths,
         .file_path_count = file_count,
+        .since_timestamp = ctx->window_start,
+        .until_timestamp = ctx->incident_time,
         .include_merges = false
     };
     
-    tm_git_get_commits(repo, &opts, &ctx->commits, &ctx->commit_count);
+    tm_git_get_commits(repo, &commit_opts, &ctx->commits, &ctx->commit_count);
     
-    /* Get blame info for error lines */
+    /* Get blame info for error lines, one blame per file */
     ctx->blames = NULL;
     ctx->blame_count = 0;
     
-    for (size_t i = 0; i < trace->frame_count && i < 5; i++) {
+    tm_blame_request_t requests[5];
+    size_t request_count = 0;
+    
+    for (size_t i = 0; i < trace->frame_count && i < TM_ARRAY_SIZE(requests); i++) {
         const tm_stack_frame_t *frame = &trace->frames[i];
         if (!frame->file || frame->is_stdlib || frame->line <= 0) continue;
         
-        tm_git_blame_t *blame = NULL;
-        if (tm_git_blame_line(repo, frame->file, frame->line, &blame) == TM_OK && blame) {
-            ctx->blames = tm_realloc(ctx->blames, 
-                                     (ctx->blame_count + 1) * sizeof(tm_git_blame_t *));
-            ctx->blames[ctx->blame_count++] = blame;
-        }
+        requests[request_count++] = (tm_blame_request_t){
+            .file_path = tm_git_relative_path(repo, frame->file),
+            .line = frame->line
+        };
+    }
+    
+    tm_git_blame_lines(repo, requests, request_count);
+    
+    for (size_t i = 0; i < request_count; i++) {
+        if (!requests[i].blame) continue;
+        ctx->blames = tm_realloc(ctx->blames,
+                                 (ctx->blame_count + 1) * sizeof(tm_git_blame_t *));
+        ctx->blames[ctx->blame_count++] = requests[i].blame;
     }
     
+    /* Scoring is the only step that needs the call graph, so a graph built
+     * concurrently is waited for last */
+    const tm_call_graph_t *graph = collect_call_graph(opts);
+    score_commits(repo, ctx, trace, graph, file_paths, file_count);
+    
     TM_FREE(file_paths);
-    tm_git_repo_free(repo);
+    
+    /* Cached context covers history only; the working tree is read fresh */
+    tm_git_registry_context_put(key, score_scope(repo, trace, graph), ctx);
+    free(key);
+    tm_git_worktree_changes(repo, trace, &ctx->dirty_hunks, &ctx->dirty_hunk_count);
+    tm_git_registry_release(repo);
     
     TM_DEBUG("Collected git context: %zu commits, %zu blames", 
              ctx->commit_count, ctx->blame_count);
+    if (ctx->incident_time > 0) {
+        TM_DEBUG("Commit window: %lld to %lld",
+                 (long long)ctx->window_start, (long long)ctx->incident_time);
+    }
     
     *result = ctx;
     return TM_OK;
@@ -859,6 +2823,21 @@ tm_git_context_t *tm_git_collect_context(const char *repo_path,
                                          const char **files,
                                          size_t file_count,
                                          int max_commits)
+{
+    tm_git_collect_opts_t opts = { .max_commits = max_commits };
+    return tm_git_collect_context_opts(repo_path, files, file_count, &opts);
+}
+
+static int compare_frame_files(const void *a, const void *b)
+{
+    const tm_stack_frame_t *x = a, *y = b;
+    return strcmp(x->file, y->file);
+}
+
+tm_git_context_t *tm_git_collect_context_opts(const char *repo_path,
+                                              const char **files,
+                                              size_t file_count,
+                                              const tm_git_collect_opts_t *opts)
 {
     const char *path = repo_path ? repo_path : ".";
     
@@ -870,10 +2849,13 @@ tm_git_context_t *tm_git_collect_context(const char *repo_path,
         for (size_t i = 0; i < file_count; i++) {
             dummy_trace.frames[i].file = tm_strdup(files[i]);
         }
+        
+        /* Order-independent, so the same file set shares a cache entry */
+        qsort(dummy_trace.frames, file_count, sizeof(tm_stack_frame_t), compare_frame_files);
     }
     
     tm_git_context_t *ctx = NULL;
-    tm_error_t err = git_collect_context_from_trace(path, &dummy_trace, max_commits, &ctx);
+    tm_error_t err = git_collect_context_from_trace(path, &dummy_trace, opts, &ctx);
     
     for (size_t i = 0; i < file_count; i++) {
         TM_FREE(dummy_trace.frames[i].file);
@@ -888,6 +2870,25 @@ tm_git_context_t *tm_git_collect_context(const char *repo_path,
     return ctx;
 }
 
+tm_git_context_t *tm_git_collect_context_trace(const char *repo_path,
+                                               const tm_stack_trace_t *trace,
+                                               const tm_git_collect_opts_t *opts)
+{
+    if (!trace) return NULL;
+    
+    tm_git_collect_opts_t defaults = {0};
+    if (!opts) opts = &defaults;
+    
+    tm_git_context_t *ctx = NULL;
+    tm_error_t err = git_collect_context_from_trace(repo_path ? repo_path : ".", trace, opts, &ctx);
+    if (err != TM_OK) {
+        TM_WARN("Git context collection failed: %s", tm_strerror(err));
+        return NULL;
+    }
+    
+    return ctx;
+}
+
 /* ============================================================================
  * Helper Functions
  * ========================================================================== */
@@ -958,39 +2959,11 @@ tm_error_t tm_git_resolve_sha(const tm_git_repo_t *repo,
 
 /* ============================================================================
  * Stub Implementations (No libgit2 Available)
+ *
+ * Repository, commit and file history functions are provided by the native
+ * object reader in git_native.c.
  * ========================================================================== */
 
-static bool g_git_initialized = false;
-
-tm_error_t tm_git_init(void)
-{
-    g_git_initialized = true;
-    TM_DEBUG("Git module initialized (stub - no libgit2)");
-    return TM_OK;
-}
-
-void tm_git_cleanup(void)
-{
-    g_git_initialized = false;
-}
-
-tm_error_t tm_git_repo_open(const char *path, tm_git_repo_t **repo)
-{
-    (void)path;
-    *repo = NULL;
-    TM_DEBUG("Git operations unavailable (no libgit2)");
-    return TM_ERR_UNSUPPORTED;
-}
-
-void tm_git_repo_free(tm_git_repo_t *repo)
-{
-    if (repo) {
-        TM_FREE(repo->root_path);
-        TM_FREE(repo->branch);
-        free(repo);
-    }
-}
-
 const char *tm_git_repo_root(const tm_git_repo_t *repo)
 {
     return repo ? repo->root_path : NULL;
@@ -1028,6 +3001,7 @@ void tm_git_commit_free(tm_git_commit_t *commit)
     TM_FREE(commit->author);
     TM_FREE(commit->email);
     TM_FREE(commit->message);
+    TM_FREE(commit->relevant_hunks);
     if (commit->files_changed) {
         for (size_t i = 0; i < commit->file_count; i++) {
             TM_FREE(commit->files_changed[i]);
@@ -1083,37 +3057,6 @@ tm_error_t tm_git_get_file_at_commit(const tm_git_repo_t *repo,
     return TM_ERR_UNSUPPORTED;
 }
 
-void tm_git_context_free(tm_git_context_t *ctx)
-{
-    if (!ctx) return;
-    TM_FREE(ctx->repo_root);
-    TM_FREE(ctx->current_branch);
-    TM_FREE(ctx->head_sha);
-    for (size_t i = 0; i < ctx->commit_count; i++) {
-        tm_git_commit_free(&ctx->commits[i]);
-    }
-    TM_FREE(ctx->commits);
-    for (size_t i = 0; i < ctx->blame_count; i++) {
-        tm_git_blame_free(ctx->blames[i]);
-        free(ctx->blames[i]);
-    }
-    TM_FREE(ctx->blames);
-    free(ctx);
-}
-
-tm_git_context_t *tm_git_collect_context(const char *repo_path,
-                                         const char **files,
-                                         size_t file_count,
-                                         int max_commits)
-{
-    (void)repo_path;
-    (void)files;
-    (void)file_count;
-    (void)max_commits;
-    TM_DEBUG("Git context collection unavailable (no libgit2)");
-    return NULL;
-}
-
 bool tm_git_is_config_file(const char *path)
 {
     if (!path) return false;
@@ -1162,3 +3105,18 @@ tm_error_t tm_git_resolve_sha(const tm_git_repo_t *repo,
 }
 
 #endif /* HAVE_LIBGIT2 */
+
+/* ============================================================================
+ * Shared Helpers
+ * ========================================================================== */
+
+void tm_git_dirty_hunks_free(tm_git_dirty_hunk_t *hunks, size_t count)
+{
+    if (!hunks) return;
+    
+    for (size_t i = 0; i < count; i++) {
+        TM_FREE(hunks[i].file);
+        TM_FREE(hunks[i].diff);
+    }
+    free(hunks);
+}
@@ -0,0 +1,1808 @@
+/**
+ * TraceMind - Git Context Collector (Native Reader)
+ *
+ * Builds without libgit2 read commits and file history straight from the
+ * object database (git_odb.h): refs, a time-ordered revwalk, and tree
+ * comparisons along the trace paths, pruned by commit-graph Bloom filters
+ * like the libgit2 walk. Blame and diffs need libgit2 and stay unavailable.
+ */
+
+#include "internal/common.h"
+#include "internal/git.h"
+#include "internal/git_odb.h"
+#include "internal/git_registry.h"
+#include <ctype.h>
+#include <sys/stat.h>
+
+#ifndef HAVE_LIBGIT2
+
+#define NATIVE_MAX_BLOB_STATS (1u << 20)  /* Larger blobs count as binary */
+#define NATIVE_MAX_SYMREF_DEPTH 5
+
+/* ============================================================================
+ * Repository Discovery
+ * ========================================================================== */
+
+static bool is_dir(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/* Whole file as a string with trailing whitespace stripped, or NULL */
+static char *read_small_file(const char *path)
+{
+    size_t len = 0;
+    char *data = tm_read_file(path, &len);
+    if (!data) return NULL;
+
+    while (len > 0 && isspace((unsigned char)data[len - 1])) data[--len] = '\0';
+    return data;
+}
+
+/* dir/rel, or rel itself when absolute */
+static char *join_path(const char *dir, const char *rel)
+{
+    if (rel[0] == '/') return tm_strdup(rel);
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/%s", dir, rel);
+    return tm_strbuf_finish(&sb);
+}
+
+/**
+ * Walk up from path to the worktree holding .git (a directory, or a
+ * "gitdir:" file for linked worktrees and submodules).
+ */
+static tm_error_t discover(const char *path, char **root, char **git_dir)
+{
+    char *dir;
+    if (path[0] == '/') {
+        dir = tm_strdup(path);
+    } else {
+        char cwd[PATH_MAX];
+        if (!getcwd(cwd, sizeof(cwd))) return TM_ERR_IO;
+        dir = strcmp(path, ".") == 0 ? tm_strdup(cwd) : join_path(cwd, path);
+    }
+
+    for (;;) {
+        size_t len = strlen(dir);
+        while (len > 1 && dir[len - 1] == '/') dir[--len] = '\0';
+
+        char *dot_git = join_path(dir, ".git");
+        if (is_dir(dot_git)) {
+            *root = dir;
+            *git_dir = dot_git;
+            return TM_OK;
+        }
+
+        char *link = read_small_file(dot_git);
+        free(dot_git);
+        if (link && strncmp(link, "gitdir: ", 8) == 0) {
+            *git_dir = join_path(dir, link + 8);
+            *root = dir;
+            free(link);
+            return TM_OK;
+        }
+        free(link);
+
+        char *slash = strrchr(dir, '/');
+        if (!slash || len <= 1) break;
+        if (slash == dir) slash[1] = '\0';
+        else *slash = '\0';
+    }
+
+    free(dir);
+    return TM_ERR_NOT_FOUND;
+}
+
+/* Refs and objects live in the common dir shared by linked worktrees */
+static char *common_dir(const char *git_dir)
+{
+    char *file = join_path(git_dir, "commondir");
+    char *rel = read_small_file(file);
+    free(file);
+
+    char *dir = rel ? join_path(git_dir, rel) : tm_strdup(git_dir);
+    free(rel);
+    return dir;
+}
+
+/* ============================================================================
+ * References
+ * ========================================================================== */
+
+static bool packed_ref(const char *common, const char *name, uint8_t oid[TM_ODB_OID_SIZE])
+{
+    char *file = join_path(common, "packed-refs");
+    size_t len = 0;
+    char *data = tm_read_file(file, &len);
+    free(file);
+    if (!data) return false;
+
+    /* "<hex> <refname>" lines; '#' headers and '^' peeled tags */
+    bool found = false;
+    size_t name_len = strlen(name);
+    for (char *line = data; line && *line && !found; ) {
+        char *nl = strchr(line, '\n');
+        if (nl) *nl = '\0';
+
+        if (line[0] != '#' && line[0] != '^' && strlen(line) == 41 + name_len &&
+            line[40] == ' ' && strcmp(line + 41, name) == 0) {
+            found = tm_odb_oid_parse(line, oid);
+        }
+        line = nl ? nl + 1 : NULL;
+    }
+
+    free(data);
+    return found;
+}
+
+/**
+ * Resolve HEAD to a commit. *branch is the short branch name, "HEAD" when
+ * detached, or NULL on an unborn branch.
+ */
+static tm_error_t resolve_head(const char *git_dir, const char *common,
+                               uint8_t oid[TM_ODB_OID_SIZE], char **branch)
+{
+    *branch = NULL;
+
+    char *file = join_path(git_dir, "HEAD");
+    char *value = read_small_file(file);
+    free(file);
+
+    for (int depth = 0; value && depth < NATIVE_MAX_SYMREF_DEPTH; depth++) {
+        if (strncmp(value, "ref: ", 5) != 0) {
+            bool ok = tm_odb_oid_parse(value, oid);
+            if (!*branch) *branch = tm_strdup("HEAD");
+            free(value);
+            return ok ? TM_OK : TM_ERR_PARSE;
+        }
+
+        const char *name = value + 5;
+        if (!*branch) {
+            *branch = tm_strdup(strncmp(name, "refs/heads/", 11) == 0 ? name + 11 : name);
+        }
+
+        file = join_path(common, name);
+        char *next = read_small_file(file);
+        free(file);
+
+        if (!next) {
+            bool ok = packed_ref(common, name, oid);
+            free(value);
+            if (!ok) TM_FREE(*branch);
+            return ok ? TM_OK : TM_ERR_NOT_FOUND;
+        }
+        free(value);
+        value = next;
+    }
+
+    free(value);
+    TM_FREE(*branch);
+    return TM_ERR_NOT_FOUND;
+}
+
+/* ============================================================================
+ * Repository Management
+ * ========================================================================== */
+
+tm_error_t tm_git_init(void)
+{
+    TM_DEBUG("Git module initialized (native object reader)");
+    return TM_OK;
+}
+
+void tm_git_cleanup(void)
+{
+    tm_git_registry_clear();
+}
+
+tm_error_t tm_git_find_root(const char *path, char **root)
+{
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(root, TM_ERR_INVALID_ARG);
+
+    char *git_dir = NULL;
+    tm_error_t err = discover(path, root, &git_dir);
+    if (err != TM_OK) {
+        TM_ERROR("Could not find git repository from: %s", path);
+        return err;
+    }
+    free(git_dir);
+    return TM_OK;
+}
+
+tm_error_t tm_git_repo_open(const char *path, tm_git_repo_t **result)
+{
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
+
+    *result = NULL;
+
+    char *root = NULL, *git_dir = NULL;
+    tm_error_t err = discover(path, &root, &git_dir);
+    if (err != TM_OK) {
+        TM_ERROR("Failed to open repository at: %s", path);
+        return err;
+    }
+
+    char *common = common_dir(git_dir);
+    char *objects_dir = join_path(common, "objects");
+
+    tm_git_repo_t *repo = tm_calloc(1, sizeof(tm_git_repo_t));
+    repo->worker_count = 1;
+    repo->root_path = root;
+
+    err = tm_odb_open(objects_dir, &repo->odb);
+    if (err != TM_OK) {
+        TM_DEBUG("Git object reader unavailable: %s", tm_strerror(err));
+        free(objects_dir);
+        free(common);
+        free(git_dir);
+        tm_git_repo_free(repo);
+        return err;
+    }
+
+    uint8_t head[TM_ODB_OID_SIZE];
+    if (resolve_head(git_dir, common, head, &repo->branch) == TM_OK) {
+        tm_odb_oid_format(head, repo->head_sha);
+    } else {
+        repo->branch = tm_strdup("(detached)");
+    }
+
+    if (tm_commit_graph_open(objects_dir, &repo->graph) == TM_OK &&
+        !tm_commit_graph_has_bloom(repo->graph)) {
+        tm_commit_graph_free(repo->graph);
+        repo->graph = NULL;
+    }
+
+    free(objects_dir);
+    free(common);
+    free(git_dir);
+
+    TM_DEBUG("Opened repository: %s (branch: %s, native reader)", repo->root_path, repo->branch);
+    *result = repo;
+    return TM_OK;
+}
+
+tm_error_t tm_git_repo_refresh(tm_git_repo_t *repo)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+
+    char *root = NULL, *git_dir = NULL;
+    tm_error_t err = discover(repo->root_path, &root, &git_dir);
+    if (err != TM_OK) return err;
+
+    char *common = common_dir(git_dir);
+    uint8_t head[TM_ODB_OID_SIZE];
+    char *branch = NULL;
+    char head_sha[41] = "";
+    if (resolve_head(git_dir, common, head, &branch) == TM_OK) {
+        tm_odb_oid_format(head, head_sha);
+    } else {
+        branch = tm_strdup("(detached)");
+    }
+
+    /* New commits may sit in packs written since the odb was opened */
+    if (strcmp(head_sha, repo->head_sha) != 0) {
+        char *objects_dir = join_path(common, "objects");
+        tm_odb_t *odb = NULL;
+        err = tm_odb_open(objects_dir, &odb);
+        free(objects_dir);
+        if (err == TM_OK) {
+            tm_odb_free(repo->odb);
+            repo->odb = odb;
+        }
+    }
+
+    if (err == TM_OK) {
+        free(repo->branch);
+        repo->branch = branch;
+        memcpy(repo->head_sha, head_sha, sizeof(head_sha));
+    } else {
+        free(branch);
+    }
+
+    free(common);
+    free(git_dir);
+    free(root);
+    return err;
+}
+
+void tm_git_repo_free(tm_git_repo_t *repo)
+{
+    if (!repo) return;
+
+    tm_odb_free(repo->odb);
+    tm_commit_graph_free(repo->graph);
+    TM_FREE(repo->blame_cache_dir);
+    TM_FREE(repo->root_path);
+    TM_FREE(repo->branch);
+    free(repo);
+}
+
+/* The object reader is single-threaded; native walks stay serial */
+void tm_git_repo_set_workers(tm_git_repo_t *repo, size_t count)
+{
+    (void)repo;
+    (void)count;
+}
+
+const char *tm_git_relative_path(const tm_git_repo_t *repo, const char *path)
+{
+    if (!repo || !repo->root_path || !path) return path;
+
+    size_t len = strlen(repo->root_path);
+    if (strncmp(path, repo->root_path, len) == 0 && path[len] == '/') {
+        return path + len + 1;
+    }
+    return path;
+}
+
+tm_error_t tm_git_repo_use_history_index(tm_git_repo_t *repo, const char *cache_dir)
+{
+    (void)repo;
+    (void)cache_dir;
+    return TM_ERR_UNSUPPORTED;
+}
+
+tm_error_t tm_git_repo_use_blame_cache(tm_git_repo_t *repo, const char *cache_dir)
+{
+    (void)repo;
+    (void)cache_dir;
+    return TM_ERR_UNSUPPORTED;
+}
+
+tm_error_t tm_git_blame_lines(const tm_git_repo_t *repo,
+                              tm_blame_request_t *requests,
+                              size_t count)
+{
+    (void)repo;
+    for (size_t i = 0; i < count; i++) {
+        requests[i].blame = NULL;
+    }
+    return TM_ERR_UNSUPPORTED;
+}
+
+/* ============================================================================
+ * Trees
+ * ========================================================================== */
+
+static bool read_tree(tm_odb_t *odb, const uint8_t *oid, uint8_t **data, size_t *size)
+{
+    tm_odb_type_t type;
+    if (tm_odb_read(odb, oid, &type, data, size) != TM_OK) return false;
+    if (type != TM_ODB_TREE) {
+        TM_FREE(*data);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * True if path differs between two trees (either may be NULL). Descends
+ * one component at a time and stops as soon as both sides share an OID.
+ */
+static bool path_differs(tm_odb_t *odb, const uint8_t *old_tree, const uint8_t *new_tree,
+                         const char *path)
+{
+    uint8_t old_oid[TM_ODB_OID_SIZE], new_oid[TM_ODB_OID_SIZE];
+    bool have_old = old_tree != NULL, have_new = new_tree != NULL;
+    if (have_old) memcpy(old_oid, old_tree, TM_ODB_OID_SIZE);
+    if (have_new) memcpy(new_oid, new_tree, TM_ODB_OID_SIZE);
+
+    while (*path) {
+        if (!have_old && !have_new) return false;
+        if (!have_old || !have_new) return true;
+        if (memcmp(old_oid, new_oid, TM_ODB_OID_SIZE) == 0) return false;
+
+        size_t len = strcspn(path, "/");
+        uint8_t *data = NULL;
+        size_t size = 0;
+        tm_odb_tree_entry_t entry;
+
+        have_old = read_tree(odb, old_oid, &data, &size) &&
+                   tm_odb_tree_find(data, size, path, len, &entry);
+        if (have_old) memcpy(old_oid, entry.oid, TM_ODB_OID_SIZE);
+        TM_FREE(data);
+
+        have_new = read_tree(odb, new_oid, &data, &size) &&
+                   tm_odb_tree_find(data, size, path, len, &entry);
+        if (have_new) memcpy(new_oid, entry.oid, TM_ODB_OID_SIZE);
+        TM_FREE(data);
+
+        path += len;
+        if (*path == '/') path++;
+    }
+
+    if (have_old != have_new) return true;
+    return have_old && memcmp(old_oid, new_oid, TM_ODB_OID_SIZE) != 0;
+}
+
+/* Git orders tree entries as if subtree names ended in '/' */
+static int compare_entries(const tm_odb_tree_entry_t *a, const tm_odb_tree_entry_t *b)
+{
+    size_t len = TM_MIN(a->name_len, b->name_len);
+    int cmp = memcmp(a->name, b->name, len);
+    if (cmp != 0) return cmp;
+
+    unsigned char ca = a->name_len > len ? (unsigned char)a->name[len]
+                                         : (tm_odb_mode_is_tree(a->mode) ? '/' : '\0');
+    unsigned char cb = b->name_len > len ? (unsigned char)b->name[len]
+                                         : (tm_odb_mode_is_tree(b->mode) ? '/' : '\0');
+    return (int)ca - (int)cb;
+}
+
+typedef void (*tree_change_fn)(const char *path, const uint8_t *old_oid,
+                               const uint8_t *new_oid, void *ctx);
+
+static void tree_diff(tm_odb_t *odb, const uint8_t *old_tree, const uint8_t *new_tree,
+                      const char *prefix, tree_change_fn fn, void *ctx);
+
+static void report_entry(tm_odb_t *odb, const char *prefix, const tm_odb_tree_entry_t *entry,
+                         bool is_new, tree_change_fn fn, void *ctx)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%.*s", prefix, (int)entry->name_len, entry->name);
+
+    if (tm_odb_mode_is_tree(entry->mode)) {
+        strncat(path, "/", sizeof(path) - strlen(path) - 1);
+        tree_diff(odb, is_new ? NULL : entry->oid, is_new ? entry->oid : NULL, path, fn, ctx);
+    } else {
+        fn(path, is_new ? NULL : entry->oid, is_new ? entry->oid : NULL, ctx);
+    }
+}
+
+/**
+ * Report every blob that differs between two trees (either may be NULL),
+ * skipping subtrees with equal OIDs.
+ */
+static void tree_diff(tm_odb_t *odb, const uint8_t *old_tree, const uint8_t *new_tree,
+                      const char *prefix, tree_change_fn fn, void *ctx)
+{
+    if (old_tree && new_tree && memcmp(old_tree, new_tree, TM_ODB_OID_SIZE) == 0) return;
+
+    uint8_t *old_data = NULL, *new_data = NULL;
+    size_t old_size = 0, new_size = 0;
+    if (old_tree && !read_tree(odb, old_tree, &old_data, &old_size)) old_size = 0;
+    if (new_tree && !read_tree(odb, new_tree, &new_data, &new_size)) new_size = 0;
+
+    size_t old_pos = 0, new_pos = 0;
+    tm_odb_tree_entry_t o, n;
+    bool have_o = tm_odb_tree_next(old_data, old_size, &old_pos, &o);
+    bool have_n = tm_odb_tree_next(new_data, new_size, &new_pos, &n);
+
+    while (have_o || have_n) {
+        int cmp = !have_o ? 1 : !have_n ? -1 : compare_entries(&o, &n);
+
+        if (cmp < 0) {
+            report_entry(odb, prefix, &o, false, fn, ctx);
+            have_o = tm_odb_tree_next(old_data, old_size, &old_pos, &o);
+        } else if (cmp > 0) {
+            report_entry(odb, prefix, &n, true, fn, ctx);
+            have_n = tm_odb_tree_next(new_data, new_size, &new_pos, &n);
+        } else {
+            if (memcmp(o.oid, n.oid, TM_ODB_OID_SIZE) != 0 || o.mode != n.mode) {
+                bool o_tree = tm_odb_mode_is_tree(o.mode), n_tree = tm_odb_mode_is_tree(n.mode);
+                if (o_tree && n_tree) {
+                    char path[PATH_MAX];
+                    snprintf(path, sizeof(path), "%s%.*s/", prefix, (int)n.name_len, n.name);
+                    tree_diff(odb, o.oid, n.oid, path, fn, ctx);
+                } else if (o_tree != n_tree) {
+                    report_entry(odb, prefix, &o, false, fn, ctx);
+                    report_entry(odb, prefix, &n, true, fn, ctx);
+                } else {
+                    char path[PATH_MAX];
+                    snprintf(path, sizeof(path), "%s%.*s", prefix, (int)n.name_len, n.name);
+                    fn(path, o.oid, n.oid, ctx);
+                }
+            }
+            have_o = tm_odb_tree_next(old_data, old_size, &old_pos, &o);
+            have_n = tm_odb_tree_next(new_data, new_size, &new_pos, &n);
+        }
+    }
+
+    free(old_data);
+    free(new_data);
+}
+
+/* ============================================================================
+ * Line Statistics
+ * ========================================================================== */
+
+static bool read_text_blob(tm_odb_t *odb, const uint8_t *oid, uint8_t **data, size_t *size)
+{
+    *data = NULL;
+    *size = 0;
+    if (!oid) return true;
+
+    tm_odb_type_t type;
+    if (tm_odb_read(odb, oid, &type, data, size) != TM_OK) return false;
+
+    /* Same binary heuristic as git: a NUL in the first 8000 bytes */
+    if (type != TM_ODB_BLOB || *size > NATIVE_MAX_BLOB_STATS ||
+        memchr(*data, '\0', TM_MIN(*size, (size_t)8000))) {
+        TM_FREE(*data);
+        return false;
+    }
+    return true;
+}
+
+typedef struct {
+    uint64_t *hashes;
+    int *counts;
+    size_t cap;                   /* Power of two */
+} line_set_t;
+
+static int *line_slot(line_set_t *set, uint64_t hash)
+{
+    size_t i = (size_t)hash & (set->cap - 1);
+    while (set->counts[i] != 0 && set->hashes[i] != hash) {
+        i = (i + 1) & (set->cap - 1);
+    }
+    set->hashes[i] = hash;
+    return &set->counts[i];
+}
+
+/*
+ * Added and removed lines of a blob change, counted as the difference of
+ * the two line multisets. Matches git's numstat except for moved lines,
+ * which a real diff counts twice.
+ */
+static void blob_line_stats(tm_odb_t *odb, const uint8_t *old_oid, const uint8_t *new_oid,
+                            int *additions, int *deletions)
+{
+    uint8_t *old_data = NULL, *new_data = NULL;
+    size_t old_size = 0, new_size = 0;
+
+    if (!read_text_blob(odb, old_oid, &old_data, &old_size) ||
+        !read_text_blob(odb, new_oid, &new_data, &new_size)) {
+        free(old_data);
+        free(new_data);
+        return;
+    }
+
+    size_t lines = 1;
+    for (size_t i = 0; i < old_size; i++) lines += old_data[i] == '\n';
+
+    line_set_t set = { .cap = 16 };
+    while (set.cap < lines * 2) set.cap <<= 1;
+    set.hashes = tm_calloc(set.cap, sizeof(uint64_t));
+    set.counts = tm_calloc(set.cap, sizeof(int));
+
+    /* Count old lines up; removed = old lines not matched by a new one */
+    int removed = 0;
+    for (size_t p = 0; p < old_size; ) {
+        const uint8_t *nl = memchr(old_data + p, '\n', old_size - p);
+        size_t len = nl ? (size_t)(nl - (old_data + p)) : old_size - p;
+        (*line_slot(&set, tm_hash_bytes(old_data + p, len) | 1))++;
+        removed++;
+        p += len + 1;
+    }
+
+    for (size_t p = 0; p < new_size; ) {
+        const uint8_t *nl = memchr(new_data + p, '\n', new_size - p);
+        size_t len = nl ? (size_t)(nl - (new_data + p)) : new_size - p;
+        int *count = line_slot(&set, tm_hash_bytes(new_data + p, len) | 1);
+        if (*count > 0) {
+            (*count)--;
+            removed--;
+            /* Keep the slot occupied so probing chains stay intact */
+            if (*count == 0) *count = -1;
+        } else {
+            (*additions)++;
+        }
+        p += len + 1;
+    }
+    *deletions += removed;
+
+    free(set.hashes);
+    free(set.counts);
+    free(old_data);
+    free(new_data);
+}
+
+/* ============================================================================
+ * Revision Walk
+ * ========================================================================== */
+
+/* Commits seen by a walk: open addressing on the leading OID bytes */
+typedef struct {
+    uint8_t (*oids)[TM_ODB_OID_SIZE];
+    bool *used;
+    size_t count;
+    size_t cap;
+} oid_set_t;
+
+static size_t oid_hash(const uint8_t *oid)
+{
+    uint64_t h;
+    memcpy(&h, oid, sizeof(h));
+    return (size_t)h;
+}
+
+/* Insert oid; false if it was already present */
+static bool oid_set_add(oid_set_t *set, const uint8_t *oid)
+{
+    if ((set->count + 1) * 2 > set->cap) {
+        oid_set_t grown = { .cap = set->cap ? set->cap * 2 : 1024 };
+        grown.oids = tm_malloc(grown.cap * TM_ODB_OID_SIZE);
+        grown.used = tm_calloc(grown.cap, sizeof(bool));
+        for (size_t i = 0; i < set->cap; i++) {
+            if (set->used[i]) oid_set_add(&grown, set->oids[i]);
+        }
+        free(set->oids);
+        free(set->used);
+        *set = grown;
+    }
+
+    size_t i = oid_hash(oid) & (set->cap - 1);
+    while (set->used[i]) {
+        if (memcmp(set->oids[i], oid, TM_ODB_OID_SIZE) == 0) return false;
+        i = (i + 1) & (set->cap - 1);
+    }
+    memcpy(set->oids[i], oid, TM_ODB_OID_SIZE);
+    set->used[i] = true;
+    set->count++;
+    return true;
+}
+
+typedef struct {
+    uint8_t oid[TM_ODB_OID_SIZE];
+    tm_odb_commit_t commit;
+} walk_item_t;
+
+/**
+ * Newest-first walk from HEAD (git's GIT_SORT_TIME): a max-heap on
+ * committer time of commits whose children have been emitted.
+ */
+typedef struct {
+    tm_odb_t *odb;
+    walk_item_t *heap;
+    size_t count;
+    size_t cap;
+    oid_set_t seen;
+} native_walk_t;
+
+static void walk_push(native_walk_t *walk, const uint8_t *oid)
+{
+    if (!oid_set_add(&walk->seen, oid)) return;
+
+    walk_item_t item;
+    memcpy(item.oid, oid, TM_ODB_OID_SIZE);
+    if (tm_odb_read_commit(walk->odb, oid, &item.commit) != TM_OK) return;  /* Shallow */
+
+    TM_VEC_PUSH(walk->heap, walk->count, walk->cap, item);
+
+    for (size_t i = walk->count - 1; i > 0; ) {
+        size_t parent = (i - 1) / 2;
+        if (walk->heap[parent].commit.commit_time >= walk->heap[i].commit.commit_time) break;
+        walk_item_t tmp = walk->heap[parent];
+        walk->heap[parent] = walk->heap[i];
+        walk->heap[i] = tmp;
+        i = parent;
+    }
+}
+
+static void walk_init(native_walk_t *walk, const tm_git_repo_t *repo)
+{
+    memset(walk, 0, sizeof(*walk));
+    walk->odb = repo->odb;
+
+    uint8_t head[TM_ODB_OID_SIZE];
+    if (tm_odb_oid_parse(repo->head_sha, head)) walk_push(walk, head);
+}
+
+/* Pop the newest commit (caller clears item->commit) and queue its parents */
+static bool walk_next(native_walk_t *walk, walk_item_t *item)
+{
+    if (walk->count == 0) return false;
+
+    *item = walk->heap[0];
+    walk->heap[0] = walk->heap[--walk->count];
+
+    for (size_t i = 0; ; ) {
+        size_t l = 2 * i + 1, r = l + 1, top = i;
+        if (l < walk->count && walk->heap[l].commit.commit_time > walk->heap[top].commit.commit_time) top = l;
+        if (r < walk->count && walk->heap[r].commit.commit_time > walk->heap[top].commit.commit_time) top = r;
+        if (top == i) break;
+        walk_item_t tmp = walk->heap[top];
+        walk->heap[top] = walk->heap[i];
+        walk->heap[i] = tmp;
+        i = top;
+    }
+
+    for (size_t i = 0; i < item->commit.parent_count; i++) {
+        walk_push(walk, item->commit.parents[i]);
+    }
+    return true;
+}
+
+static void walk_free(native_walk_t *walk)
+{
+    for (size_t i = 0; i < walk->count; i++) {
+        tm_odb_commit_clear(&walk->heap[i].commit);
+    }
+    free(walk->heap);
+    free(walk->seen.oids);
+    free(walk->seen.used);
+}
+
+/* ============================================================================
+ * Path Filtering
+ * ========================================================================== */
+
+/*
+ * As in the libgit2 collector, trace files match repository paths by
+ * substring: each is resolved against the HEAD tree once, and commits are
+ * then checked by comparing entries along the resolved paths. Files no
+ * longer at HEAD fall back to a tree diff.
+ */
+typedef struct {
+    char **paths;
+    size_t path_count;
+    size_t path_cap;
+    const char **unresolved;
+    size_t unresolved_count;
+} native_filter_t;
+
+typedef struct {
+    native_filter_t *filter;
+    const char **files;
+    size_t file_count;
+    bool *matched;
+} resolve_ctx_t;
+
+static void resolve_cb(const char *path, const uint8_t *old_oid, const uint8_t *new_oid, void *ctx)
+{
+    resolve_ctx_t *r = ctx;
+    (void)old_oid;
+    (void)new_oid;
+
+    for (size_t i = 0; i < r->file_count; i++) {
+        if (strstr(path, r->files[i])) {
+            char *copy = tm_strdup(path);
+            TM_VEC_PUSH(r->filter->paths, r->filter->path_count, r->filter->path_cap, copy);
+            r->matched[i] = true;
+            break;
+        }
+    }
+}
+
+static void filter_init(native_filter_t *filter, const tm_git_repo_t *repo,
+                        const char **files, size_t file_count)
+{
+    memset(filter, 0, sizeof(*filter));
+    if (!files || file_count == 0) return;
+
+    resolve_ctx_t ctx = {
+        .filter = filter,
+        .files = files,
+        .file_count = file_count,
+        .matched = tm_calloc(file_count, sizeof(bool))
+    };
+
+    /* Every HEAD blob, as a diff against nothing */
+    uint8_t head[TM_ODB_OID_SIZE];
+    tm_odb_commit_t commit;
+    if (tm_odb_oid_parse(repo->head_sha, head) &&
+        tm_odb_read_commit(repo->odb, head, &commit) == TM_OK) {
+        tree_diff(repo->odb, NULL, commit.tree, "", resolve_cb, &ctx);
+        tm_odb_commit_clear(&commit);
+    }
+
+    filter->unresolved = tm_calloc(file_count, sizeof(char *));
+    for (size_t i = 0; i < file_count; i++) {
+        if (!ctx.matched[i]) filter->unresolved[filter->unresolved_count++] = files[i];
+    }
+    free(ctx.matched);
+
+    TM_DEBUG("Path filter: %zu paths resolved, %zu unresolved",
+             filter->path_count, filter->unresolved_count);
+}
+
+static void filter_free(native_filter_t *filter)
+{
+    for (size_t i = 0; i < filter->path_count; i++) {
+        free(filter->paths[i]);
+    }
+    TM_FREE(filter->paths);
+    TM_FREE(filter->unresolved);
+}
+
+typedef struct {
+    const native_filter_t *filter;
+    bool touched;
+} unresolved_ctx_t;
+
+static void unresolved_cb(const char *path, const uint8_t *old_oid, const uint8_t *new_oid, void *ctx)
+{
+    unresolved_ctx_t *u = ctx;
+    (void)old_oid;
+    (void)new_oid;
+
+    for (size_t i = 0; i < u->filter->unresolved_count && !u->touched; i++) {
+        if (strstr(path, u->filter->unresolved[i])) u->touched = true;
+    }
+}
+
+/* First parent's tree, or false for a root commit (or a missing parent) */
+static bool parent_tree(tm_odb_t *odb, const tm_odb_commit_t *commit, uint8_t tree[TM_ODB_OID_SIZE])
+{
+    tm_odb_commit_t parent;
+    if (commit->parent_count == 0 ||
+        tm_odb_read_commit(odb, commit->parents[0], &parent) != TM_OK) {
+        return false;
+    }
+    memcpy(tree, parent.tree, TM_ODB_OID_SIZE);
+    tm_odb_commit_clear(&parent);
+    return true;
+}
+
+static bool commit_touches(const tm_git_repo_t *repo, const walk_item_t *item,
+                           const native_filter_t *filter)
+{
+    if (filter->path_count == 0 && filter->unresolved_count == 0) return true;
+
+    uint8_t old_tree[TM_ODB_OID_SIZE];
+    bool has_parent = parent_tree(repo->odb, &item->commit, old_tree);
+
+    if (filter->path_count > 0 &&
+        tm_commit_graph_maybe_changed(repo->graph, item->oid, (const char **)filter->paths,
+                                      filter->path_count) != 0) {
+        for (size_t i = 0; i < filter->path_count; i++) {
+            if (path_differs(repo->odb, has_parent ? old_tree : NULL, item->commit.tree,
+                             filter->paths[i])) {
+                return true;
+            }
+        }
+    }
+
+    if (filter->unresolved_count == 0) return false;
+
+    unresolved_ctx_t ctx = { .filter = filter };
+    tree_diff(repo->odb, has_parent ? old_tree : NULL, item->commit.tree, "", unresolved_cb, &ctx);
+    return ctx.touched;
+}
+
+/* ============================================================================
+ * Commit History
+ * ========================================================================== */
+
+typedef struct {
+    tm_odb_t *odb;
+    tm_git_commit_t *commit;
+    size_t file_cap;
+} changes_ctx_t;
+
+static void changes_cb(const char *path, const uint8_t *old_oid, const uint8_t *new_oid, void *ctx)
+{
+    changes_ctx_t *c = ctx;
+    char *copy = tm_strdup(path);
+    TM_VEC_PUSH(c->commit->files_changed, c->commit->file_count, c->file_cap, copy);
+
+    if (tm_git_is_config_file(path)) c->commit->touches_config = true;
+    if (tm_git_is_schema_file(path)) c->commit->touches_schema = true;
+
+    blob_line_stats(c->odb, old_oid, new_oid, &c->commit->additions, &c->commit->deletions);
+}
+
+static void fill_commit(const tm_git_repo_t *repo, const walk_item_t *item, tm_git_commit_t *c)
+{
+    tm_odb_oid_format(item->oid, c->sha);
+    c->author = item->commit.author ? tm_strdup(item->commit.author) : NULL;
+    c->email = item->commit.email ? tm_strdup(item->commit.email) : NULL;
+    c->timestamp = item->commit.commit_time;
+    c->message = tm_strdup(item->commit.message);
+
+    uint8_t old_tree[TM_ODB_OID_SIZE];
+    bool has_parent = parent_tree(repo->odb, &item->commit, old_tree);
+
+    changes_ctx_t ctx = { .odb = repo->odb, .commit = c };
+    tree_diff(repo->odb, has_parent ? old_tree : NULL, item->commit.tree, "", changes_cb, &ctx);
+}
+
+static void free_commit_contents(tm_git_commit_t *commit)
+{
+    TM_FREE(commit->author);
+    TM_FREE(commit->email);
+    TM_FREE(commit->message);
+    TM_FREE(commit->relevant_hunks);
+
+    for (size_t i = 0; i < commit->file_count; i++) {
+        TM_FREE(commit->files_changed[i]);
+    }
+    TM_FREE(commit->files_changed);
+}
+
+void tm_git_commits_free(tm_git_commit_t *commits, size_t count)
+{
+    if (!commits) return;
+
+    for (size_t i = 0; i < count; i++) {
+        free_commit_contents(&commits[i]);
+    }
+    free(commits);
+}
+
+tm_error_t tm_git_get_commits(const tm_git_repo_t *repo,
+                              const tm_commit_opts_t *opts,
+                              tm_git_commit_t **commits,
+                              size_t *count)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(commits, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+
+    *commits = NULL;
+    *count = 0;
+
+    int max = opts ? opts->max_commits : 20;
+    if (max <= 0) max = 20;
+
+    native_filter_t filter;
+    filter_init(&filter, repo, opts ? opts->file_paths : NULL, opts ? opts->file_path_count : 0);
+
+    tm_git_commit_t *result = tm_calloc((size_t)max, sizeof(tm_git_commit_t));
+    native_walk_t walk;
+    walk_init(&walk, repo);
+
+    walk_item_t item;
+    while (*count < (size_t)max && walk_next(&walk, &item)) {
+        int64_t time = item.commit.commit_time;
+        bool stop = opts && opts->since_timestamp > 0 && time < opts->since_timestamp;
+        bool skip = (opts && opts->until_timestamp > 0 && time > opts->until_timestamp) ||
+                    (opts && !opts->include_merges && item.commit.parent_count > 1);
+
+        if (!stop && !skip && commit_touches(repo, &item, &filter)) {
+            fill_commit(repo, &item, &result[(*count)++]);
+        }
+        tm_odb_commit_clear(&item.commit);
+        if (stop) break;  /* Newest first, so nothing older qualifies */
+    }
+
+    walk_free(&walk);
+    filter_free(&filter);
+    *commits = result;
+
+    TM_DEBUG("Collected %zu commits (native reader)", *count);
+    return TM_OK;
+}
+
+tm_error_t tm_git_get_commit(const tm_git_repo_t *repo,
+                             const char *sha,
+                             tm_git_commit_t **result)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(sha, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
+
+    *result = NULL;
+
+    walk_item_t item;
+    if (!tm_odb_oid_parse(sha, item.oid)) return TM_ERR_INVALID_ARG;
+
+    tm_error_t err = tm_odb_read_commit(repo->odb, item.oid, &item.commit);
+    if (err != TM_OK) return err;
+
+    *result = tm_calloc(1, sizeof(tm_git_commit_t));
+    fill_commit(repo, &item, *result);
+    tm_odb_commit_clear(&item.commit);
+    return TM_OK;
+}
+
+/* ============================================================================
+ * File History
+ * ========================================================================== */
+
+void tm_git_file_changes_free(tm_file_change_t *changes, size_t count)
+{
+    if (!changes) return;
+
+    for (size_t i = 0; i < count; i++) {
+        TM_FREE(changes[i].message_first_line);
+    }
+    free(changes);
+}
+
+tm_error_t tm_git_file_history(const tm_git_repo_t *repo,
+                               const char *file_path,
+                               int max_entries,
+                               tm_file_change_t **changes,
+                               size_t *count)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(file_path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(changes, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+
+    *changes = NULL;
+    *count = 0;
+
+    if (max_entries <= 0) max_entries = 10;
+
+    native_filter_t filter;
+    filter_init(&filter, repo, &file_path, 1);
+
+    tm_file_change_t *result = tm_calloc((size_t)max_entries, sizeof(tm_file_change_t));
+    native_walk_t walk;
+    walk_init(&walk, repo);
+
+    walk_item_t item;
+    while (*count < (size_t)max_entries && walk_next(&walk, &item)) {
+        if (commit_touches(repo, &item, &filter)) {
+            tm_file_change_t *c = &result[(*count)++];
+            const char *msg = item.commit.message;
+            const char *nl = strchr(msg, '\n');
+
+            tm_odb_oid_format(item.oid, c->sha);
+            c->timestamp = item.commit.commit_time;
+            c->message_first_line = nl ? tm_strndup(msg, (size_t)(nl - msg)) : tm_strdup(msg);
+        }
+        tm_odb_commit_clear(&item.commit);
+    }
+
+    walk_free(&walk);
+    filter_free(&filter);
+    *changes = result;
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Working Tree
+ * ========================================================================== */
+
+#define NATIVE_MAX_HUNK_LINES 30
+#define NATIVE_DIFF_CONTEXT 3          /* Unchanged lines around a hunk, as git */
+#define NATIVE_MAX_DIFF_EDITS 1000     /* Beyond this, one hunk spans the rest */
+
+/* One stage-0 entry of .git/index */
+typedef struct {
+    char *path;
+    uint8_t oid[TM_ODB_OID_SIZE];
+    uint32_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint32_t size;
+} index_entry_t;
+
+static uint32_t be32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+/* Trace paths may be partial ("app/models.py"); match them as path suffixes */
+static bool trace_path_matches(const char *repo_path, const char *trace_path)
+{
+    size_t len = strlen(repo_path), tlen = strlen(trace_path);
+    if (tlen > len) return false;
+    if (tlen == len) return strcmp(repo_path, trace_path) == 0;
+    return repo_path[len - tlen - 1] == '/' && strcmp(repo_path + len - tlen, trace_path) == 0;
+}
+
+/**
+ * Index entries (versions 2-4) matching any of rels. matched[i] is set for
+ * each rel that some entry matched.
+ */
+static bool read_index(const char *file, const char **rels, size_t rel_count, bool *matched,
+                       index_entry_t **entries, size_t *count)
+{
+    size_t size = 0;
+    uint8_t *data = (uint8_t *)tm_read_file(file, &size);
+    *entries = NULL;
+    *count = 0;
+    if (!data) return false;
+
+    uint32_t version = size >= 12 ? be32(data + 4) : 0;
+    if (size < 12 || memcmp(data, "DIRC", 4) != 0 || version < 2 || version > 4) {
+        free(data);
+        return false;
+    }
+
+    size_t cap = 0;
+    uint32_t total = be32(data + 8);
+    size_t pos = 12;
+    tm_strbuf_t path;
+    tm_strbuf_init(&path);
+    tm_strbuf_append(&path, "");
+
+    for (uint32_t n = 0; n < total; n++) {
+        if (pos + 62 > size) break;
+        const uint8_t *e = data + pos;
+        uint16_t flags = (uint16_t)(e[60] << 8 | e[61]);
+        size_t header = (flags & 0x4000) ? 64 : 62;
+        size_t name = pos + header;
+        if (name >= size) break;
+
+        if (version == 4) {
+            /* Prefix-compressed: drop N bytes of the previous path, append the rest */
+            size_t strip = data[name] & 127;
+            while (data[name++] & 128) {
+                if (name >= size) break;
+                strip = ((strip + 1) << 7) | (data[name] & 127);
+            }
+            const uint8_t *nul = name < size ? memchr(data + name, '\0', size - name) : NULL;
+            if (!nul || strip > path.len) break;
+
+            path.len -= strip;
+            path.data[path.len] = '\0';
+            tm_strbuf_append_len(&path, (const char *)data + name, (size_t)(nul - (data + name)));
+            pos = (size_t)(nul - data) + 1;
+        } else {
+            const uint8_t *nul = memchr(data + name, '\0', size - name);
+            if (!nul) break;
+
+            size_t name_len = (size_t)(nul - (data + name));
+            path.len = 0;
+            tm_strbuf_append_len(&path, (const char *)data + name, name_len);
+            pos += (header + name_len + 8) & ~(size_t)7;
+        }
+
+        if ((flags >> 12) & 3) continue;  /* Merge conflict stages */
+
+        for (size_t i = 0; i < rel_count; i++) {
+            if (!trace_path_matches(path.data, rels[i])) continue;
+
+            index_entry_t entry = {
+                .path = tm_strdup(path.data),
+                .mtime_sec = be32(e + 8),
+                .mtime_nsec = be32(e + 12),
+                .size = be32(e + 36)
+            };
+            memcpy(entry.oid, e + 40, TM_ODB_OID_SIZE);
+            TM_VEC_PUSH(*entries, *count, cap, entry);
+            matched[i] = true;
+            break;
+        }
+    }
+
+    tm_strbuf_free(&path);
+    free(data);
+    return true;
+}
+
+/* OID of path in a tree, following subtrees */
+static bool tree_lookup(tm_odb_t *odb, const uint8_t *tree, const char *path,
+                        uint8_t oid[TM_ODB_OID_SIZE])
+{
+    memcpy(oid, tree, TM_ODB_OID_SIZE);
+    while (*path) {
+        size_t len = strcspn(path, "/");
+        uint8_t *data = NULL;
+        size_t size = 0;
+        tm_odb_tree_entry_t entry;
+
+        bool found = read_tree(odb, oid, &data, &size) &&
+                     tm_odb_tree_find(data, size, path, len, &entry);
+        if (found) memcpy(oid, entry.oid, TM_ODB_OID_SIZE);
+        free(data);
+        if (!found) return false;
+
+        path += len;
+        if (*path == '/') path++;
+    }
+    return true;
+}
+
+/* Start offsets of each line, plus one past the end (caller frees) */
+static size_t *split_lines(const uint8_t *data, size_t size, size_t *count)
+{
+    size_t *starts = NULL, cap = 0, n = 0, pos = 0;
+    while (pos < size) {
+        TM_VEC_PUSH(starts, n, cap, pos);
+        const uint8_t *nl = memchr(data + pos, '\n', size - pos);
+        pos = nl ? (size_t)(nl - data) + 1 : size;
+    }
+    TM_VEC_PUSH(starts, n, cap, size);
+    *count = n - 1;
+    return starts;
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t *starts;               /* Line start offsets, plus the end */
+    uint64_t *hashes;
+    size_t count;
+} diff_side_t;
+
+static void diff_side_init(diff_side_t *side, const uint8_t *data, size_t size)
+{
+    side->data = data;
+    side->starts = split_lines(data, size, &side->count);
+    side->hashes = tm_malloc((side->count + 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < side->count; i++) {
+        side->hashes[i] = tm_hash_bytes(data + side->starts[i], side->starts[i + 1] - side->starts[i]);
+    }
+}
+
+static bool same_line(const diff_side_t *a, size_t i, const diff_side_t *b, size_t j)
+{
+    size_t alen = a->starts[i + 1] - a->starts[i], blen = b->starts[j + 1] - b->starts[j];
+    return a->hashes[i] == b->hashes[j] && alen == blen &&
+           memcmp(a->data + a->starts[i], b->data + b->starts[j], alen) == 0;
+}
+
+/* Edit script operations, one per line of either side */
+enum { OP_EQUAL = '=', OP_DELETE = '-', OP_INSERT = '+' };
+
+/*
+ * Myers' O(ND) shortest edit script between old[o0..o1) and new[n0..n1),
+ * written to ops in order. Keeps each round's frontier for the backtrack,
+ * so the work is bounded by NATIVE_MAX_DIFF_EDITS; past it the range is
+ * reported as replaced outright, which still bounds every change.
+ */
+static size_t myers_diff(const diff_side_t *old, size_t o0, size_t o1,
+                         const diff_side_t *new, size_t n0, size_t n1, char *ops)
+{
+    long n = (long)(o1 - o0), m = (long)(n1 - n0);
+
+    /* Pure insertions or deletions need no search */
+    long max = n == 0 || m == 0 ? 0 : TM_MIN(n + m, (long)NATIVE_MAX_DIFF_EDITS);
+
+    /* v[k] is the furthest x on diagonal k = x - y; index offset max + 1 */
+    long *v = tm_calloc((size_t)(2 * max + 3), sizeof(long));
+    long *trace = NULL;
+    size_t trace_len = 0, trace_cap = 0;
+    long d = 0;
+    bool found = false;
+
+    for (d = 0; d <= max && max > 0 && !found; d++) {
+        /* Frontier before round d: diagonals -d-1..d+1 */
+        for (long k = -d - 1; k <= d + 1; k++) {
+            TM_VEC_PUSH(trace, trace_len, trace_cap, v[k + max + 1]);
+        }
+
+        for (long k = -d; k <= d; k += 2) {
+            long x = (k == -d || (k != d && v[k - 1 + max + 1] < v[k + 1 + max + 1]))
+                ? v[k + 1 + max + 1] : v[k - 1 + max + 1] + 1;
+            long y = x - k;
+            while (x < n && y < m && same_line(old, o0 + (size_t)x, new, n0 + (size_t)y)) {
+                x++;
+                y++;
+            }
+            v[k + max + 1] = x;
+            if (x >= n && y >= m) {
+                found = true;
+                break;
+            }
+        }
+    }
+    free(v);
+
+    size_t len = 0;
+    if (!found) {
+        for (long i = 0; i < n; i++) ops[len++] = OP_DELETE;
+        for (long j = 0; j < m; j++) ops[len++] = OP_INSERT;
+        free(trace);
+        return len;
+    }
+
+    /* Walk back from (n, m), emitting operations in reverse */
+    size_t total = (size_t)(n + m), pos = total;
+    long x = n, y = m;
+    for (d = d - 1; d >= 0; d--) {
+        const long *frontier = trace + (size_t)(d * d + 2 * d);  /* Rounds before d */
+        long k = x - y;
+        long prev_k = (k == -d || (k != d && frontier[k - 1 + d + 1] < frontier[k + 1 + d + 1]))
+            ? k + 1 : k - 1;
+        long prev_x = d > 0 ? frontier[prev_k + d + 1] : 0;
+        long prev_y = prev_x - prev_k;
+        if (d == 0) prev_y = 0;
+
+        while (x > prev_x && y > prev_y) {
+            ops[--pos] = OP_EQUAL;
+            x--;
+            y--;
+        }
+        if (d > 0) ops[--pos] = x == prev_x ? OP_INSERT : OP_DELETE;
+        x = prev_x;
+        y = prev_y;
+    }
+    free(trace);
+
+    /* Equal runs shorten the script below n + m; close the gap */
+    len = total - pos;
+    memmove(ops, ops + pos, len);
+    return len;
+}
+
+static void append_line(tm_strbuf_t *sb, char origin, const diff_side_t *side, size_t i)
+{
+    size_t len = side->starts[i + 1] - side->starts[i];
+    tm_strbuf_appendf(sb, "%c", origin);
+    tm_strbuf_append_len(sb, (const char *)side->data + side->starts[i], len);
+    if (len == 0 || side->data[side->starts[i] + len - 1] != '\n') tm_strbuf_append(sb, "\n");
+}
+
+/*
+ * One dirty hunk for ops[from..to), starting at old line oi and new line ni
+ * (0-based). The changed range leaves out context lines; a deletion touches
+ * the new lines on either side of it.
+ */
+static tm_git_dirty_hunk_t make_hunk(const char *path, const char *ops, size_t from, size_t to,
+                                     const diff_side_t *old, size_t oi,
+                                     const diff_side_t *new, size_t ni)
+{
+    size_t old_lines = 0, new_lines = 0;
+    for (size_t i = from; i < to; i++) {
+        if (ops[i] != OP_INSERT) old_lines++;
+        if (ops[i] != OP_DELETE) new_lines++;
+    }
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s @@ -%zu,%zu +%zu,%zu @@\n", path,
+                      old_lines ? oi + 1 : oi, old_lines, new_lines ? ni + 1 : ni, new_lines);
+
+    int first = INT_MAX, last = INT_MIN;
+    size_t shown = 0;
+    for (size_t i = from; i < to; i++, shown++) {
+        char op = ops[i];
+        bool show = shown < NATIVE_MAX_HUNK_LINES;
+        if (op == OP_EQUAL) {
+            if (show) append_line(&sb, ' ', new, ni);
+            oi++;
+            ni++;
+        } else if (op == OP_DELETE) {
+            if (show) append_line(&sb, '-', old, oi);
+            first = TM_MIN(first, TM_MAX((int)ni, 1));
+            last = TM_MAX(last, (int)ni + 1);
+            oi++;
+        } else {
+            if (show) append_line(&sb, '+', new, ni);
+            first = TM_MIN(first, (int)ni + 1);
+            last = TM_MAX(last, (int)ni + 1);
+            ni++;
+        }
+    }
+    if (to - from > NATIVE_MAX_HUNK_LINES) {
+        tm_strbuf_appendf(&sb, "... (%zu more lines)\n", to - from - NATIVE_MAX_HUNK_LINES);
+    }
+
+    return (tm_git_dirty_hunk_t){
+        .file = tm_strdup(path),
+        .start_line = first,
+        .end_line = last,
+        .frame = -1,
+        .diff = tm_strbuf_finish(&sb)
+    };
+}
+
+/*
+ * Line diff of a HEAD blob against the working-tree file, as unified hunks
+ * with git's context: edits further apart than twice the context are
+ * separate hunks, so a frame only matches lines that actually changed.
+ */
+static void text_hunks(const char *path, const uint8_t *old_data, size_t old_size,
+                       const uint8_t *new_data, size_t new_size,
+                       tm_git_dirty_hunk_t **result, size_t *count, size_t *cap)
+{
+    diff_side_t old, new;
+    diff_side_init(&old, old_data, old_size);
+    diff_side_init(&new, new_data, new_size);
+
+    size_t prefix = 0;
+    while (prefix < old.count && prefix < new.count && same_line(&old, prefix, &new, prefix)) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < old.count - prefix && suffix < new.count - prefix &&
+           same_line(&old, old.count - 1 - suffix, &new, new.count - 1 - suffix)) {
+        suffix++;
+    }
+
+    if (prefix == old.count && prefix == new.count) goto done;
+
+    char *ops = tm_malloc(old.count + new.count + 1);
+    size_t len = 0;
+    memset(ops, OP_EQUAL, prefix);
+    len += prefix;
+    len += myers_diff(&old, prefix, old.count - suffix, &new, prefix, new.count - suffix,
+                      ops + len);
+    memset(ops + len, OP_EQUAL, suffix);
+    len += suffix;
+
+    /* Group edits, each hunk padded with up to NATIVE_DIFF_CONTEXT equal lines */
+    size_t i = 0, oi = 0, ni = 0;
+    while (i < len) {
+        if (ops[i] == OP_EQUAL) {
+            i++;
+            oi++;
+            ni++;
+            continue;
+        }
+
+        size_t lead = 0;
+        while (lead < NATIVE_DIFF_CONTEXT && lead < i && ops[i - lead - 1] == OP_EQUAL) lead++;
+        size_t from = i - lead, hunk_oi = oi - lead, hunk_ni = ni - lead;
+
+        size_t end = i;
+        for (;;) {
+            while (end < len && ops[end] != OP_EQUAL) end++;
+            size_t run = 0;
+            while (end + run < len && ops[end + run] == OP_EQUAL) run++;
+            if (end + run == len || run > 2 * NATIVE_DIFF_CONTEXT) break;
+            end += run;
+        }
+        size_t to = TM_MIN(end + NATIVE_DIFF_CONTEXT, len);
+
+        tm_git_dirty_hunk_t hunk = make_hunk(path, ops, from, to, &old, hunk_oi, &new, hunk_ni);
+        TM_VEC_PUSH(*result, *count, *cap, hunk);
+
+        for (; i < to; i++) {
+            if (ops[i] != OP_INSERT) oi++;
+            if (ops[i] != OP_DELETE) ni++;
+        }
+    }
+    free(ops);
+
+done:
+    free(old.starts);
+    free(old.hashes);
+    free(new.starts);
+    free(new.hashes);
+}
+
+static bool is_text(const uint8_t *data, size_t size)
+{
+    return size <= NATIVE_MAX_BLOB_STATS && !memchr(data, '\0', TM_MIN(size, (size_t)8000));
+}
+
+/* Compare the committed and working-tree versions of one path */
+static void check_file(const tm_git_repo_t *repo, const uint8_t *head_tree, const char *path,
+                       const index_entry_t *entry, int64_t index_mtime,
+                       tm_git_dirty_hunk_t **result, size_t *count, size_t *cap)
+{
+    char *full = join_path(repo->root_path, path);
+    struct stat st;
+    bool exists = stat(full, &st) == 0 && S_ISREG(st.st_mode);
+    if (!exists) {
+        free(full);
+        return;
+    }
+
+    uint8_t head_oid[TM_ODB_OID_SIZE];
+    bool in_head = head_tree && tree_lookup(repo->odb, head_tree, path, head_oid);
+
+    /* Stat data as the index recorded it: the file is the indexed blob.
+     * Entries not older than the index itself may have been racily edited. */
+    bool stat_clean = entry && (uint64_t)st.st_size == entry->size &&
+                      (uint32_t)st.st_mtim.tv_sec == entry->mtime_sec &&
+                      (uint32_t)st.st_mtim.tv_nsec == entry->mtime_nsec &&
+                      (int64_t)entry->mtime_sec < index_mtime;
+    if (stat_clean && in_head && memcmp(entry->oid, head_oid, TM_ODB_OID_SIZE) == 0) {
+        free(full);
+        return;
+    }
+
+    uint8_t *now = NULL;
+    size_t now_size = 0;
+    tm_odb_type_t type;
+    if (stat_clean) {
+        if (tm_odb_read(repo->odb, entry->oid, &type, &now, &now_size) != TM_OK) now = NULL;
+    } else {
+        now = (uint8_t *)tm_read_file(full, &now_size);
+    }
+    free(full);
+    if (!now) return;
+
+    uint8_t *then = NULL;
+    size_t then_size = 0;
+    if (in_head && tm_odb_read(repo->odb, head_oid, &type, &then, &then_size) != TM_OK) {
+        free(now);
+        return;
+    }
+
+    if (is_text(now, now_size) && (!then || is_text(then, then_size))) {
+        text_hunks(path, then ? then : (const uint8_t *)"", then_size, now, now_size,
+                   result, count, cap);
+    }
+
+    free(now);
+    free(then);
+}
+
+static int compare_dirty_hunks(const void *a, const void *b)
+{
+    const tm_git_dirty_hunk_t *x = a, *y = b;
+    unsigned xf = (unsigned)x->frame, yf = (unsigned)y->frame;  /* -1 sorts last */
+    if (xf != yf) return xf < yf ? -1 : 1;
+    int cmp = strcmp(x->file, y->file);
+    if (cmp != 0) return cmp;
+    return x->start_line - y->start_line;
+}
+
+tm_error_t tm_git_worktree_changes(const tm_git_repo_t *repo,
+                                   const tm_stack_trace_t *trace,
+                                   tm_git_dirty_hunk_t **hunks,
+                                   size_t *count)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(trace, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(hunks, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+
+    *hunks = NULL;
+    *count = 0;
+
+    const char **rels = tm_calloc(trace->frame_count + 1, sizeof(char *));
+    size_t rel_count = 0;
+    for (size_t i = 0; i < trace->frame_count; i++) {
+        const tm_stack_frame_t *frame = &trace->frames[i];
+        if (!frame->file || frame->is_stdlib) continue;
+
+        const char *rel = tm_git_relative_path(repo, frame->file);
+        bool seen = rel[0] == '/';  /* Outside the repository */
+        for (size_t j = 0; j < rel_count && !seen; j++) {
+            seen = strcmp(rels[j], rel) == 0;
+        }
+        if (!seen) rels[rel_count++] = rel;
+    }
+
+    char *root = NULL, *git_dir = NULL;
+    if (rel_count == 0 || discover(repo->root_path, &root, &git_dir) != TM_OK) {
+        free(rels);
+        return TM_OK;
+    }
+
+    char *index_file = join_path(git_dir, "index");
+    struct stat st;
+    int64_t index_mtime = stat(index_file, &st) == 0 ? (int64_t)st.st_mtim.tv_sec : 0;
+
+    bool *matched = tm_calloc(rel_count, sizeof(bool));
+    index_entry_t *entries = NULL;
+    size_t entry_count = 0;
+    read_index(index_file, rels, rel_count, matched, &entries, &entry_count);
+
+    uint8_t head[TM_ODB_OID_SIZE];
+    tm_odb_commit_t commit;
+    bool has_head = tm_odb_oid_parse(repo->head_sha, head) &&
+                    tm_odb_read_commit(repo->odb, head, &commit) == TM_OK;
+
+    tm_git_dirty_hunk_t *result = NULL;
+    size_t result_count = 0, result_cap = 0;
+
+    for (size_t i = 0; i < entry_count; i++) {
+        check_file(repo, has_head ? commit.tree : NULL, entries[i].path, &entries[i],
+                   index_mtime, &result, &result_count, &result_cap);
+    }
+
+    /* Trace files the index does not know about are untracked */
+    for (size_t i = 0; i < rel_count; i++) {
+        if (matched[i]) continue;
+        check_file(repo, NULL, rels[i], NULL, index_mtime, &result, &result_count, &result_cap);
+    }
+
+    for (size_t i = 0; i < result_count; i++) {
+        tm_git_dirty_hunk_t *h = &result[i];
+        for (size_t f = 0; f < trace->frame_count && h->frame < 0; f++) {
+            const tm_stack_frame_t *frame = &trace->frames[f];
+            if (frame->file && !frame->is_stdlib &&
+                frame->line >= h->start_line && frame->line <= h->end_line &&
+                trace_path_matches(h->file, tm_git_relative_path(repo, frame->file))) {
+                h->frame = (int)f;
+            }
+        }
+    }
+
+    if (result_count > 0) {
+        qsort(result, result_count, sizeof(tm_git_dirty_hunk_t), compare_dirty_hunks);
+    }
+    if (result_count > TM_GIT_MAX_DIRTY_HUNKS) {
+        for (size_t i = TM_GIT_MAX_DIRTY_HUNKS; i < result_count; i++) {
+            TM_FREE(result[i].file);
+            TM_FREE(result[i].diff);
+        }
+        result_count = TM_GIT_MAX_DIRTY_HUNKS;
+    }
+
+    if (has_head) tm_odb_commit_clear(&commit);
+    for (size_t i = 0; i < entry_count; i++) {
+        free(entries[i].path);
+    }
+    free(entries);
+    free(matched);
+    free(index_file);
+    free(git_dir);
+    free(root);
+    free(rels);
+
+    TM_DEBUG("Uncommitted changes: %zu hunks in trace files", result_count);
+    *hunks = result;
+    *count = result_count;
+    return TM_OK;
+}
+
+tm_error_t tm_git_head_file(const tm_git_repo_t *repo,
+                            const char *path,
+                            char **content,
+                            size_t *content_len)
+{
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(content, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(content_len, TM_ERR_INVALID_ARG);
+
+    *content = NULL;
+    *content_len = 0;
+
+    uint8_t head[TM_ODB_OID_SIZE];
+    tm_odb_commit_t commit;
+    if (!repo->odb || !tm_odb_oid_parse(repo->head_sha, head) ||
+        tm_odb_read_commit(repo->odb, head, &commit) != TM_OK) {
+        return TM_ERR_NOT_FOUND;
+    }
+
+    uint8_t oid[TM_ODB_OID_SIZE];
+    bool found = tree_lookup(repo->odb, commit.tree, path, oid);
+    tm_odb_commit_clear(&commit);
+    if (!found) return TM_ERR_NOT_FOUND;
+
+    uint8_t *data = NULL;
+    size_t size = 0;
+    tm_odb_type_t type;
+    if (tm_odb_read(repo->odb, oid, &type, &data, &size) != TM_OK) return TM_ERR_NOT_FOUND;
+    if (type != TM_ODB_BLOB) {
+        free(data);
+        return TM_ERR_NOT_FOUND;
+    }
+
+    *content = (char *)data;
+    *content_len = size;
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Context Collection
+ * ========================================================================== */
+
+void tm_git_context_free(tm_git_context_t *ctx)
+{
+    if (!ctx) return;
+
+    TM_FREE(ctx->repo_root);
+    TM_FREE(ctx->current_branch);
+    TM_FREE(ctx->head_sha);
+    tm_git_commits_free(ctx->commits, ctx->commit_count);
+
+    for (size_t i = 0; i < ctx->blame_count; i++) {
+        tm_git_blames_free(ctx->blames[i], 1);
+    }
+    TM_FREE(ctx->blames);
+    tm_git_dirty_hunks_free(ctx->dirty_hunks, ctx->dirty_hunk_count);
+    free(ctx);
+}
+
+void tm_git_blames_free(tm_git_blame_t *blames, size_t count)
+{
+    if (!blames) return;
+
+    for (size_t i = 0; i < count; i++) {
+        TM_FREE(blames[i].author);
+        TM_FREE(blames[i].line_content);
+    }
+    free(blames);
+}
+
+/**
+ * Commits touching the trace's files (all commits if none) within the
+ * incident window; there is no blame without libgit2.
+ */
+static tm_git_context_t *collect_native(const char *repo_path,
+                                        const tm_stack_trace_t *trace,
+                                        const tm_git_collect_opts_t *opts)
+{
+    tm_git_repo_t *repo = NULL;
+    tm_error_t err = tm_git_registry_acquire(repo_path ? repo_path : ".", &repo);
+    if (err != TM_OK) {
+        TM_WARN("Git context collection failed: %s", tm_strerror(err));
+        return NULL;
+    }
+
+    char *key = tm_git_context_key(repo->head_sha, trace, opts);
+    tm_git_context_t *ctx = tm_git_registry_context_get(key, NULL);
+    if (ctx) {
+        tm_git_worktree_changes(repo, trace, &ctx->dirty_hunks, &ctx->dirty_hunk_count);
+        tm_git_registry_release(repo);
+        free(key);
+        return ctx;
+    }
+
+    ctx = tm_calloc(1, sizeof(tm_git_context_t));
+    ctx->repo_root = tm_strdup(repo->root_path);
+    ctx->current_branch = tm_strdup(repo->branch);
+    ctx->head_sha = tm_strdup(repo->head_sha);
+
+    if (opts->incident_time > 0) {
+        ctx->incident_time = opts->incident_time;
+        if (opts->window_hours > 0) {
+            ctx->window_start = opts->incident_time - (int64_t)opts->window_hours * 3600;
+        }
+    }
+
+    const char **paths = tm_calloc(trace->frame_count + 1, sizeof(char *));
+    size_t path_count = 0;
+    for (size_t i = 0; i < trace->frame_count; i++) {
+        const tm_stack_frame_t *frame = &trace->frames[i];
+        if (!frame->file || frame->is_stdlib) continue;
+
+        const char *path = tm_git_relative_path(repo, frame->file);
+        bool seen = false;
+        for (size_t j = 0; j < path_count && !seen; j++) {
+            seen = strcmp(paths[j], path) == 0;
+        }
+        if (!seen) paths[path_count++] = path;
+    }
+
+    tm_commit_opts_t commit_opts = {
+        .max_commits = opts->max_commits > 0 ? opts->max_commits : 20,
+        .file_paths = paths,
+        .file_path_count = path_count,
+        .since_timestamp = ctx->window_start,
+        .until_timestamp = ctx->incident_time,
+        .include_merges = false
+    };
+    tm_git_get_commits(repo, &commit_opts, &ctx->commits, &ctx->commit_count);
+
+    free(paths);
+
+    /* Native collection does not rank by the call graph */
+    tm_git_registry_context_put(key, 0, ctx);
+    free(key);
+    tm_git_worktree_changes(repo, trace, &ctx->dirty_hunks, &ctx->dirty_hunk_count);
+    tm_git_registry_release(repo);
+
+    TM_DEBUG("Collected git context: %zu commits (native reader)", ctx->commit_count);
+    return ctx;
+}
+
+static int compare_frame_files(const void *a, const void *b)
+{
+    const tm_stack_frame_t *x = a, *y = b;
+    return strcmp(x->file, y->file);
+}
+
+tm_git_context_t *tm_git_collect_context(const char *repo_path,
+                                         const char **files,
+                                         size_t file_count,
+                                         int max_commits)
+{
+    tm_git_collect_opts_t opts = { .max_commits = max_commits };
+    return tm_git_collect_context_opts(repo_path, files, file_count, &opts);
+}
+
+tm_git_context_t *tm_git_collect_context_opts(const char *repo_path,
+                                              const char **files,
+                                              size_t file_count,
+                                              const tm_git_collect_opts_t *opts)
+{
+    tm_git_collect_opts_t defaults = {0};
+
+    /* Sorted, so the same file set shares a cache entry */
+    tm_stack_trace_t trace = {0};
+    if (files && file_count > 0) {
+        trace.frames = tm_calloc(file_count, sizeof(tm_stack_frame_t));
+        trace.frame_count = file_count;
+        for (size_t i = 0; i < file_count; i++) {
+            trace.frames[i].file = (char *)files[i];
+        }
+        qsort(trace.frames, file_count, sizeof(tm_stack_frame_t), compare_frame_files);
+    }
+
+    tm_git_context_t *ctx = collect_native(repo_path, &trace, opts ? opts : &defaults);
+    free(trace.frames);
+    return ctx;
+}
+
+tm_git_context_t *tm_git_collect_context_trace(const char *repo_path,
+                                               const tm_stack_trace_t *trace,
+                                               const tm_git_collect_opts_t *opts)
+{
+    if (!trace) return NULL;
+
+    tm_git_collect_opts_t defaults = {0};
+    return collect_native(repo_path, trace, opts ? opts : &defaults);
+}
+
+#endif /* !HAVE_LIBGIT2 */
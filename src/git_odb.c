@@ -0,0 +1,814 @@
+/**
+ * TraceMind - Native Git Object Reader
+ */
+
+#include "internal/common.h"
+#include "internal/git_odb.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define PACK_IDX_MAGIC 0xff744f63u    /* "\377tOc" */
+#define PACK_IDX_HEADER 8
+#define PACK_IDX_FANOUT 1024
+#define PACK_HEADER 12
+#define PACK_TRAILER 20
+
+#define PACK_OFS_DELTA 6
+#define PACK_REF_DELTA 7
+#define PACK_MAX_CHAIN 10000          /* Far beyond git's --depth limits */
+
+#define CACHE_SLOTS 1024
+#define CACHE_MAX_OBJECT (1u << 20)
+#define CACHE_MAX_BYTES (32u << 20)
+
+/* ============================================================================
+ * Object IDs
+ * ========================================================================== */
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool tm_odb_oid_parse(const char *hex, uint8_t oid[TM_ODB_OID_SIZE])
+{
+    if (!hex) return false;
+
+    for (size_t i = 0; i < TM_ODB_OID_SIZE; i++) {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hi < 0 ? -1 : hex_value(hex[2 * i + 1]);
+        if (lo < 0) return false;
+        oid[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+void tm_odb_oid_format(const uint8_t oid[TM_ODB_OID_SIZE], char hex[41])
+{
+    static const char digits[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < TM_ODB_OID_SIZE; i++) {
+        hex[2 * i] = digits[oid[i] >> 4];
+        hex[2 * i + 1] = digits[oid[i] & 0xf];
+    }
+    hex[40] = '\0';
+}
+
+/* ============================================================================
+ * Trees
+ * ========================================================================== */
+
+bool tm_odb_tree_next(const uint8_t *tree, size_t size, size_t *pos,
+                      tm_odb_tree_entry_t *entry)
+{
+    size_t p = *pos;
+    if (p >= size) return false;
+
+    /* "<octal mode> <name>\0<20-byte oid>" */
+    uint32_t mode = 0;
+    while (p < size && tree[p] >= '0' && tree[p] <= '7') {
+        mode = mode << 3 | (uint32_t)(tree[p++] - '0');
+    }
+    if (p >= size || tree[p++] != ' ') return false;
+
+    const uint8_t *nul = memchr(tree + p, '\0', size - p);
+    if (!nul || (size_t)(nul - tree) + 1 + TM_ODB_OID_SIZE > size) return false;
+
+    entry->mode = mode;
+    entry->name = (const char *)tree + p;
+    entry->name_len = (size_t)(nul - (tree + p));
+    entry->oid = nul + 1;
+    *pos = (size_t)(nul - tree) + 1 + TM_ODB_OID_SIZE;
+    return true;
+}
+
+bool tm_odb_tree_find(const uint8_t *tree, size_t size, const char *name, size_t name_len,
+                      tm_odb_tree_entry_t *entry)
+{
+    size_t pos = 0;
+    while (tm_odb_tree_next(tree, size, &pos, entry)) {
+        if (entry->name_len == name_len && memcmp(entry->name, name, name_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ============================================================================
+ * Commits
+ * ========================================================================== */
+
+/* "Name <email> 1700000000 +0100" */
+static void parse_signature(const char *line, size_t len, char **name, char **email,
+                            int64_t *time)
+{
+    const char *lt = memchr(line, '<', len);
+    const char *gt = lt ? memchr(lt, '>', len - (size_t)(lt - line)) : NULL;
+    if (!lt || !gt) return;
+
+    size_t name_len = (size_t)(lt - line);
+    while (name_len > 0 && line[name_len - 1] == ' ') name_len--;
+
+    if (name) *name = tm_strndup(line, name_len);
+    if (email) *email = tm_strndup(lt + 1, (size_t)(gt - lt - 1));
+    if (time) *time = strtoll(gt + 1, NULL, 10);
+}
+
+static tm_error_t parse_commit(const char *data, size_t size, tm_odb_commit_t *commit)
+{
+    memset(commit, 0, sizeof(*commit));
+    size_t parent_cap = 0;
+    bool have_tree = false;
+    const char *p = data, *end = data + size;
+
+    /* Headers up to the first blank line */
+    while (p < end && *p != '\n') {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        if (!nl) nl = end;
+        size_t len = (size_t)(nl - p);
+
+        if (len >= 45 && strncmp(p, "tree ", 5) == 0) {
+            have_tree = tm_odb_oid_parse(p + 5, commit->tree);
+        } else if (len >= 47 && strncmp(p, "parent ", 7) == 0) {
+            uint8_t parent[TM_ODB_OID_SIZE];
+            if (tm_odb_oid_parse(p + 7, parent)) {
+                if (commit->parent_count == parent_cap) {
+                    parent_cap = parent_cap ? parent_cap * 2 : 2;
+                    commit->parents = tm_realloc(commit->parents, parent_cap * TM_ODB_OID_SIZE);
+                }
+                memcpy(commit->parents[commit->parent_count++], parent, TM_ODB_OID_SIZE);
+            }
+        } else if (len > 7 && strncmp(p, "author ", 7) == 0) {
+            parse_signature(p + 7, len - 7, &commit->author, &commit->email, NULL);
+        } else if (len > 10 && strncmp(p, "committer ", 10) == 0) {
+            parse_signature(p + 10, len - 10, NULL, NULL, &commit->commit_time);
+        }
+
+        p = nl < end ? nl + 1 : end;
+    }
+
+    if (p < end) p++;
+    commit->message = tm_strndup(p, (size_t)(end - p));
+
+    if (!have_tree) {
+        tm_odb_commit_clear(commit);
+        return TM_ERR_PARSE;
+    }
+    return TM_OK;
+}
+
+tm_error_t tm_odb_read_commit(tm_odb_t *odb,
+                              const uint8_t oid[TM_ODB_OID_SIZE],
+                              tm_odb_commit_t *commit)
+{
+    TM_CHECK_NULL(commit, TM_ERR_INVALID_ARG);
+    memset(commit, 0, sizeof(*commit));
+
+    tm_odb_type_t type;
+    uint8_t *data = NULL;
+    size_t size = 0;
+    tm_error_t err = tm_odb_read(odb, oid, &type, &data, &size);
+    if (err != TM_OK) return err;
+
+    err = type == TM_ODB_COMMIT ? parse_commit((const char *)data, size, commit)
+                                : TM_ERR_PARSE;
+    free(data);
+    return err;
+}
+
+void tm_odb_commit_clear(tm_odb_commit_t *commit)
+{
+    if (!commit) return;
+
+    TM_FREE(commit->parents);
+    TM_FREE(commit->author);
+    TM_FREE(commit->email);
+    TM_FREE(commit->message);
+    commit->parent_count = 0;
+}
+
+#ifdef HAVE_ZLIB
+
+/* ============================================================================
+ * Object Database
+ * ========================================================================== */
+
+typedef struct {
+    void *idx_map;
+    size_t idx_size;
+    uint32_t count;
+    const uint8_t *fanout;
+    const uint8_t *oids;
+    const uint8_t *offsets;
+    const uint8_t *large_offsets;
+    size_t large_count;
+    uint8_t *pack;
+    size_t pack_size;
+} odb_pack_t;
+
+/* Inflated pack object, keyed by pack and offset */
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    uint64_t offset;
+    uint32_t pack;
+    tm_odb_type_t type;
+} cache_entry_t;
+
+struct tm_odb {
+    char *objects_dir;
+    odb_pack_t *packs;
+    size_t pack_count;
+    size_t pack_cap;
+    size_t last_pack;             /* Most objects of a walk sit in one pack */
+    cache_entry_t cache[CACHE_SLOTS];
+    size_t cache_bytes;
+};
+
+static inline uint32_t be32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline uint64_t be64(const uint8_t *p)
+{
+    return (uint64_t)be32(p) << 32 | be32(p + 4);
+}
+
+static void *map_file(const char *path, size_t *size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    void *map = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) map = NULL;
+        else *size = (size_t)st.st_size;
+    }
+    close(fd);
+    return map;
+}
+
+/**
+ * Map a version 2 pack index and its pack.
+ */
+static bool pack_open(const char *idx_path, odb_pack_t *pack)
+{
+    memset(pack, 0, sizeof(*pack));
+
+    pack->idx_map = map_file(idx_path, &pack->idx_size);
+    if (!pack->idx_map) return false;
+
+    const uint8_t *idx = pack->idx_map;
+    if (pack->idx_size < PACK_IDX_HEADER + PACK_IDX_FANOUT ||
+        be32(idx) != PACK_IDX_MAGIC || be32(idx + 4) != 2) {
+        goto fail;
+    }
+
+    pack->fanout = idx + PACK_IDX_HEADER;
+    pack->count = be32(pack->fanout + 255 * 4);
+
+    size_t tables = PACK_IDX_HEADER + PACK_IDX_FANOUT + (size_t)pack->count * (TM_ODB_OID_SIZE + 8);
+    if (pack->idx_size < tables + 2 * TM_ODB_OID_SIZE) goto fail;
+
+    pack->oids = pack->fanout + PACK_IDX_FANOUT;
+    pack->offsets = pack->oids + (size_t)pack->count * (TM_ODB_OID_SIZE + 4);  /* After CRCs */
+    pack->large_offsets = idx + tables;
+    pack->large_count = (pack->idx_size - tables - 2 * TM_ODB_OID_SIZE) / 8;
+
+    char pack_path[PATH_MAX];
+    size_t len = strlen(idx_path);
+    snprintf(pack_path, sizeof(pack_path), "%.*s.pack", (int)(len - 4), idx_path);
+
+    pack->pack = map_file(pack_path, &pack->pack_size);
+    if (!pack->pack || pack->pack_size < PACK_HEADER + PACK_TRAILER ||
+        memcmp(pack->pack, "PACK", 4) != 0) {
+        goto fail;
+    }
+    return true;
+
+fail:
+    if (pack->pack) munmap(pack->pack, pack->pack_size);
+    munmap(pack->idx_map, pack->idx_size);
+    memset(pack, 0, sizeof(*pack));
+    return false;
+}
+
+tm_error_t tm_odb_open(const char *objects_dir, tm_odb_t **result)
+{
+    TM_CHECK_NULL(objects_dir, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(result, TM_ERR_INVALID_ARG);
+
+    *result = NULL;
+
+    struct stat st;
+    if (stat(objects_dir, &st) != 0 || !S_ISDIR(st.st_mode)) return TM_ERR_NOT_FOUND;
+
+    tm_odb_t *odb = tm_calloc(1, sizeof(tm_odb_t));
+    odb->objects_dir = tm_strdup(objects_dir);
+
+    char pack_dir[PATH_MAX];
+    snprintf(pack_dir, sizeof(pack_dir), "%s/pack", objects_dir);
+
+    DIR *dir = opendir(pack_dir);
+    struct dirent *de;
+    while (dir && (de = readdir(dir)) != NULL) {
+        size_t len = strlen(de->d_name);
+        if (len < 5 || strcmp(de->d_name + len - 4, ".idx") != 0) continue;
+
+        char idx_path[PATH_MAX];
+        int n = snprintf(idx_path, sizeof(idx_path), "%s/%s", pack_dir, de->d_name);
+        if (n < 0 || (size_t)n >= sizeof(idx_path)) continue;
+
+        odb_pack_t pack;
+        if (pack_open(idx_path, &pack)) {
+            TM_VEC_PUSH(odb->packs, odb->pack_count, odb->pack_cap, pack);
+        } else {
+            TM_DEBUG("Skipping unreadable pack index: %s", idx_path);
+        }
+    }
+    if (dir) closedir(dir);
+
+    TM_DEBUG("Object database: %s (%zu packs)", objects_dir, odb->pack_count);
+    *result = odb;
+    return TM_OK;
+}
+
+void tm_odb_free(tm_odb_t *odb)
+{
+    if (!odb) return;
+
+    for (size_t i = 0; i < odb->pack_count; i++) {
+        munmap(odb->packs[i].pack, odb->packs[i].pack_size);
+        munmap(odb->packs[i].idx_map, odb->packs[i].idx_size);
+    }
+    for (size_t i = 0; i < CACHE_SLOTS; i++) {
+        free(odb->cache[i].data);
+    }
+    TM_FREE(odb->packs);
+    TM_FREE(odb->objects_dir);
+    free(odb);
+}
+
+/* ============================================================================
+ * Object Cache
+ * ========================================================================== */
+
+static cache_entry_t *cache_slot(tm_odb_t *odb, uint32_t pack, uint64_t offset)
+{
+    uint64_t h = (offset ^ ((uint64_t)pack << 48)) * 0x9e3779b97f4a7c15ull;
+    return &odb->cache[h >> 54];      /* Top 10 bits: CACHE_SLOTS == 1024 */
+}
+
+static const cache_entry_t *cache_get(tm_odb_t *odb, uint32_t pack, uint64_t offset)
+{
+    const cache_entry_t *e = cache_slot(odb, pack, offset);
+    return e->data && e->pack == pack && e->offset == offset ? e : NULL;
+}
+
+static void cache_put(tm_odb_t *odb, uint32_t pack, uint64_t offset,
+                      tm_odb_type_t type, const uint8_t *data, size_t size)
+{
+    if (size > CACHE_MAX_OBJECT) return;
+
+    cache_entry_t *e = cache_slot(odb, pack, offset);
+    size_t freed = e->data ? e->size : 0;
+    if (odb->cache_bytes - freed + size > CACHE_MAX_BYTES) return;
+
+    free(e->data);
+    odb->cache_bytes = odb->cache_bytes - freed + size;
+
+    e->data = tm_malloc(size + 1);
+    memcpy(e->data, data, size);
+    e->data[size] = '\0';
+    e->size = size;
+    e->pack = pack;
+    e->offset = offset;
+    e->type = type;
+}
+
+/* ============================================================================
+ * Inflate and Delta
+ * ========================================================================== */
+
+/* Inflate a zlib stream that is known to produce exactly size bytes */
+static uint8_t *inflate_exact(const uint8_t *src, size_t src_len, size_t size)
+{
+    uint8_t *out = tm_malloc(size + 1);
+    out[size] = '\0';
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit(&zs) != Z_OK) {
+        free(out);
+        return NULL;
+    }
+
+    zs.next_in = (Bytef *)src;
+    zs.avail_in = (uInt)TM_MIN(src_len, (size_t)UINT_MAX);
+    zs.next_out = out;
+    zs.avail_out = (uInt)size;
+
+    int rc = inflate(&zs, Z_FINISH);
+    bool ok = rc == Z_STREAM_END && zs.total_out == size;
+    inflateEnd(&zs);
+
+    if (!ok) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+static size_t delta_varint(const uint8_t **p, const uint8_t *end)
+{
+    size_t value = 0;
+    unsigned shift = 0;
+    while (*p < end) {
+        uint8_t c = *(*p)++;
+        value |= (size_t)(c & 0x7f) << shift;
+        shift += 7;
+        if (!(c & 0x80) || shift > 56) break;
+    }
+    return value;
+}
+
+/**
+ * Apply a git delta to base. NULL if the delta is malformed.
+ */
+static uint8_t *apply_delta(const uint8_t *base, size_t base_size,
+                            const uint8_t *delta, size_t delta_size,
+                            size_t *out_size)
+{
+    const uint8_t *p = delta, *end = delta + delta_size;
+
+    if (delta_varint(&p, end) != base_size) return NULL;
+    size_t size = delta_varint(&p, end);
+
+    uint8_t *out = tm_malloc(size + 1);
+    size_t pos = 0;
+
+    while (p < end) {
+        uint8_t op = *p++;
+
+        if (op & 0x80) {
+            /* Copy from base: offset and size bytes flagged by op */
+            size_t off = 0, len = 0;
+            for (unsigned i = 0; i < 4; i++) {
+                if ((op & (1u << i)) && p < end) off |= (size_t)*p++ << (8 * i);
+            }
+            for (unsigned i = 0; i < 3; i++) {
+                if ((op & (0x10u << i)) && p < end) len |= (size_t)*p++ << (8 * i);
+            }
+            if (len == 0) len = 0x10000;
+
+            if (off + len > base_size || pos + len > size) goto fail;
+            memcpy(out + pos, base + off, len);
+            pos += len;
+        } else if (op) {
+            /* Insert op literal bytes */
+            if ((size_t)(end - p) < op || pos + op > size) goto fail;
+            memcpy(out + pos, p, op);
+            p += op;
+            pos += op;
+        } else {
+            goto fail;
+        }
+    }
+
+    if (pos != size) goto fail;
+    out[size] = '\0';
+    *out_size = size;
+    return out;
+
+fail:
+    free(out);
+    return NULL;
+}
+
+/* ============================================================================
+ * Packs
+ * ========================================================================== */
+
+static bool pack_find(const odb_pack_t *pack, const uint8_t oid[TM_ODB_OID_SIZE],
+                      uint64_t *offset)
+{
+    uint32_t lo = oid[0] ? be32(pack->fanout + (oid[0] - 1) * 4) : 0;
+    uint32_t hi = be32(pack->fanout + oid[0] * 4);
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = memcmp(pack->oids + (size_t)mid * TM_ODB_OID_SIZE, oid, TM_ODB_OID_SIZE);
+        if (cmp == 0) {
+            uint32_t off = be32(pack->offsets + (size_t)mid * 4);
+            if (off & 0x80000000u) {
+                size_t large = off & 0x7fffffffu;
+                if (large >= pack->large_count) return false;
+                *offset = be64(pack->large_offsets + large * 8);
+            } else {
+                *offset = off;
+            }
+            return true;
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
+
+/* Entry header at offset: type, inflated size, and where its data starts */
+typedef struct {
+    int type;
+    size_t size;
+    size_t data;                  /* Offset of the zlib stream */
+    uint64_t base_offset;         /* OFS_DELTA */
+    const uint8_t *base_oid;      /* REF_DELTA */
+} pack_entry_t;
+
+static bool pack_entry(const odb_pack_t *pack, uint64_t offset, pack_entry_t *entry)
+{
+    size_t end = pack->pack_size - PACK_TRAILER;
+    size_t p = (size_t)offset;
+    if (offset < PACK_HEADER || p >= end) return false;
+
+    uint8_t c = pack->pack[p++];
+    entry->type = (c >> 4) & 7;
+    entry->size = c & 15;
+    unsigned shift = 4;
+    while ((c & 0x80) && p < end && shift < 57) {
+        c = pack->pack[p++];
+        entry->size |= (size_t)(c & 0x7f) << shift;
+        shift += 7;
+    }
+
+    entry->base_offset = 0;
+    entry->base_oid = NULL;
+
+    if (entry->type == PACK_OFS_DELTA) {
+        if (p >= end) return false;
+        c = pack->pack[p++];
+        uint64_t back = c & 0x7f;
+        while ((c & 0x80) && p < end) {
+            c = pack->pack[p++];
+            back = ((back + 1) << 7) | (c & 0x7f);
+        }
+        if (back == 0 || back > offset) return false;
+        entry->base_offset = offset - back;
+    } else if (entry->type == PACK_REF_DELTA) {
+        if (p + TM_ODB_OID_SIZE > end) return false;
+        entry->base_oid = pack->pack + p;
+        p += TM_ODB_OID_SIZE;
+    } else if (entry->type < TM_ODB_COMMIT || entry->type > TM_ODB_TAG) {
+        return false;
+    }
+
+    entry->data = p;
+    return p <= end;
+}
+
+static uint8_t *pack_inflate(const odb_pack_t *pack, const pack_entry_t *entry)
+{
+    return inflate_exact(pack->pack + entry->data,
+                         pack->pack_size - PACK_TRAILER - entry->data,
+                         entry->size);
+}
+
+/**
+ * Read the object at offset, resolving its delta chain iteratively. Every
+ * object on the chain is cached, so neighbouring reads share bases.
+ */
+static tm_error_t pack_read(tm_odb_t *odb, uint32_t pack_index, uint64_t offset,
+                            tm_odb_type_t *type, uint8_t **data, size_t *size)
+{
+    const odb_pack_t *pack = &odb->packs[pack_index];
+
+    uint64_t *chain = NULL;
+    size_t chain_count = 0, chain_cap = 0;
+
+    tm_odb_type_t base_type = 0;
+    uint8_t *base = NULL;
+    size_t base_size = 0;
+    uint64_t at = offset;
+    tm_error_t err = TM_OK;
+
+    /* Follow deltas down to a cached object or a full one */
+    for (;;) {
+        const cache_entry_t *hit = cache_get(odb, pack_index, at);
+        if (hit) {
+            base_type = hit->type;
+            base_size = hit->size;
+            base = tm_malloc(base_size + 1);
+            memcpy(base, hit->data, base_size + 1);
+            break;
+        }
+
+        pack_entry_t entry;
+        if (!pack_entry(pack, at, &entry) || chain_count >= PACK_MAX_CHAIN) {
+            err = TM_ERR_PARSE;
+            break;
+        }
+
+        if (entry.type == PACK_OFS_DELTA) {
+            TM_VEC_PUSH(chain, chain_count, chain_cap, at);
+            at = entry.base_offset;
+            continue;
+        }
+
+        if (entry.type == PACK_REF_DELTA) {
+            TM_VEC_PUSH(chain, chain_count, chain_cap, at);
+
+            /* Thin-pack style bases may live in the same pack or elsewhere */
+            uint64_t base_offset;
+            if (pack_find(pack, entry.base_oid, &base_offset)) {
+                at = base_offset;
+                continue;
+            }
+            err = tm_odb_read(odb, entry.base_oid, &base_type, &base, &base_size);
+            break;
+        }
+
+        base = pack_inflate(pack, &entry);
+        if (!base) {
+            err = TM_ERR_PARSE;
+            break;
+        }
+        base_type = (tm_odb_type_t)entry.type;
+        base_size = entry.size;
+        cache_put(odb, pack_index, at, base_type, base, base_size);
+        break;
+    }
+
+    /* Apply deltas from the base up */
+    while (err == TM_OK && chain_count > 0) {
+        uint64_t delta_at = chain[--chain_count];
+        pack_entry_t entry;
+        uint8_t *delta = NULL;
+
+        if (pack_entry(pack, delta_at, &entry)) delta = pack_inflate(pack, &entry);
+        if (!delta) {
+            err = TM_ERR_PARSE;
+            break;
+        }
+
+        size_t next_size = 0;
+        uint8_t *next = apply_delta(base, base_size, delta, entry.size, &next_size);
+        free(delta);
+        free(base);
+        base = next;
+        base_size = next_size;
+
+        if (!base) {
+            err = TM_ERR_PARSE;
+            break;
+        }
+        cache_put(odb, pack_index, delta_at, base_type, base, base_size);
+    }
+
+    free(chain);
+
+    if (err != TM_OK) {
+        free(base);
+        return err;
+    }
+
+    *type = base_type;
+    *data = base;
+    *size = base_size;
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Loose Objects
+ * ========================================================================== */
+
+static tm_error_t loose_read(const tm_odb_t *odb, const uint8_t oid[TM_ODB_OID_SIZE],
+                             tm_odb_type_t *type, uint8_t **data, size_t *size)
+{
+    char hex[41];
+    tm_odb_oid_format(oid, hex);
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%.2s/%s", odb->objects_dir, hex, hex + 2);
+
+    size_t raw_size = 0;
+    uint8_t *raw = map_file(path, &raw_size);
+    if (!raw) return TM_ERR_NOT_FOUND;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit(&zs) != Z_OK) {
+        munmap(raw, raw_size);
+        return TM_ERR_IO;
+    }
+
+    zs.next_in = raw;
+    zs.avail_in = (uInt)TM_MIN(raw_size, (size_t)UINT_MAX);
+
+    /* "<type> <size>\0" then the content */
+    size_t cap = TM_MAX(raw_size * 2, (size_t)256), len = 0;
+    uint8_t *out = tm_malloc(cap + 1);
+    int rc = Z_OK;
+
+    while (rc == Z_OK) {
+        if (len == cap) {
+            cap *= 2;
+            out = tm_realloc(out, cap + 1);
+        }
+        zs.next_out = out + len;
+        zs.avail_out = (uInt)(cap - len);
+        rc = inflate(&zs, Z_NO_FLUSH);
+        len = cap - zs.avail_out;
+    }
+    inflateEnd(&zs);
+    munmap(raw, raw_size);
+
+    const uint8_t *nul = rc == Z_STREAM_END ? memchr(out, '\0', len) : NULL;
+    if (!nul) {
+        free(out);
+        return TM_ERR_PARSE;
+    }
+
+    size_t header = (size_t)(nul - out) + 1;
+    if (strncmp((char *)out, "commit ", 7) == 0) *type = TM_ODB_COMMIT;
+    else if (strncmp((char *)out, "tree ", 5) == 0) *type = TM_ODB_TREE;
+    else if (strncmp((char *)out, "blob ", 5) == 0) *type = TM_ODB_BLOB;
+    else if (strncmp((char *)out, "tag ", 4) == 0) *type = TM_ODB_TAG;
+    else {
+        free(out);
+        return TM_ERR_PARSE;
+    }
+
+    *size = len - header;
+    memmove(out, out + header, *size);
+    out[*size] = '\0';
+    *data = out;
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Reading
+ * ========================================================================== */
+
+tm_error_t tm_odb_read(tm_odb_t *odb,
+                       const uint8_t oid[TM_ODB_OID_SIZE],
+                       tm_odb_type_t *type,
+                       uint8_t **data,
+                       size_t *size)
+{
+    TM_CHECK_NULL(odb, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(oid, TM_ERR_INVALID_ARG);
+
+    *data = NULL;
+    *size = 0;
+
+    for (size_t n = 0; n < odb->pack_count; n++) {
+        size_t i = (odb->last_pack + n) % odb->pack_count;
+        uint64_t offset;
+        if (pack_find(&odb->packs[i], oid, &offset)) {
+            odb->last_pack = i;
+            return pack_read(odb, (uint32_t)i, offset, type, data, size);
+        }
+    }
+
+    return loose_read(odb, oid, type, data, size);
+}
+
+#else /* !HAVE_ZLIB */
+
+tm_error_t tm_odb_open(const char *objects_dir, tm_odb_t **odb)
+{
+    (void)objects_dir;
+    if (odb) *odb = NULL;
+    return TM_ERR_UNSUPPORTED;
+}
+
+void tm_odb_free(tm_odb_t *odb)
+{
+    (void)odb;
+}
+
+tm_error_t tm_odb_read(tm_odb_t *odb,
+                       const uint8_t oid[TM_ODB_OID_SIZE],
+                       tm_odb_type_t *type,
+                       uint8_t **data,
+                       size_t *size)
+{
+    (void)odb;
+    (void)oid;
+    (void)type;
+    *data = NULL;
+    *size = 0;
+    return TM_ERR_UNSUPPORTED;
+}
+
+#endif /* HAVE_ZLIB */
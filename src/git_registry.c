@@ -0,0 +1,375 @@
+/**
+ * TraceMind - Git Repository Registry
+ */
+
+#include "internal/common.h"
+#include "internal/git_registry.h"
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define NO_ROOT SIZE_MAX
+
+typedef struct {
+    char *root;
+    tm_git_repo_t *repo;
+    bool leased;
+    uint64_t last_used;
+} repo_entry_t;
+
+typedef struct {
+    char *key;
+    tm_git_context_t *ctx;
+    uint64_t scope;               /* Scoring inputs beyond the key */
+    uint64_t last_used;
+} context_entry_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t g_tick = 0;
+
+static tm_strmap_t g_dirs;        /* Directory -> index into g_roots, or NO_ROOT */
+static char **g_roots = NULL;
+static size_t g_root_count = 0;
+static size_t g_root_cap = 0;
+
+static repo_entry_t g_repos[TM_GIT_REGISTRY_MAX_REPOS];
+static context_entry_t g_contexts[TM_GIT_REGISTRY_MAX_CONTEXTS];
+
+/* ============================================================================
+ * Repository Roots
+ * ========================================================================== */
+
+static bool has_git_entry(const char *dir)
+{
+    char path[PATH_MAX];
+    int n = snprintf(path, sizeof(path), "%s/.git", dir);
+    if (n < 0 || (size_t)n >= sizeof(path)) return false;
+
+    /* A directory, or a "gitdir:" file in linked worktrees and submodules */
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+/* Caller holds g_lock */
+static size_t find_root_locked(const char *dir)
+{
+    size_t index;
+    if (tm_strmap_get(&g_dirs, dir, &index)) return index;
+
+    char *path = tm_strdup(dir);
+    size_t len = strlen(path);
+    while (len > 1 && path[len - 1] == '/') path[--len] = '\0';
+
+    char **visited = NULL;
+    size_t visited_count = 0, visited_cap = 0;
+    index = NO_ROOT;
+
+    for (;;) {
+        if (tm_strmap_get(&g_dirs, path, &index)) break;
+
+        char *copy = tm_strdup(path);
+        TM_VEC_PUSH(visited, visited_count, visited_cap, copy);
+
+        if (has_git_entry(path)) {
+            index = g_root_count;
+            char *root = tm_strdup(path);
+            TM_VEC_PUSH(g_roots, g_root_count, g_root_cap, root);
+            break;
+        }
+
+        char *slash = strrchr(path, '/');
+        if (!slash || slash == path) break;
+        *slash = '\0';
+    }
+
+    for (size_t i = 0; i < visited_count; i++) {
+        tm_strmap_put(&g_dirs, visited[i], index);
+        free(visited[i]);
+    }
+    free(visited);
+    free(path);
+    return index;
+}
+
+char *tm_git_registry_find_root(const char *dir)
+{
+    if (!dir || !*dir) return NULL;
+
+    pthread_mutex_lock(&g_lock);
+    size_t index = find_root_locked(dir);
+    char *root = index != NO_ROOT ? tm_strdup(g_roots[index]) : NULL;
+    pthread_mutex_unlock(&g_lock);
+
+    if (root) TM_DEBUG("Found repo root: %s", root);
+    return root;
+}
+
+/* ============================================================================
+ * Repository Handles
+ * ========================================================================== */
+
+/* Absolute form of path for use as a registry key (caller frees) */
+static char *absolute_path(const char *path)
+{
+    if (path[0] == '/') return tm_strdup(path);
+
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd))) return NULL;
+    if (strcmp(path, ".") == 0) return tm_strdup(cwd);
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/%s", cwd, path);
+    return tm_strbuf_finish(&sb);
+}
+
+static void drop_repo(repo_entry_t *entry)
+{
+    tm_git_repo_free(entry->repo);
+    free(entry->root);
+    memset(entry, 0, sizeof(*entry));
+}
+
+/* Caller holds g_lock. Free slot, evicting the least recently used idle handle */
+static repo_entry_t *free_repo_slot(void)
+{
+    repo_entry_t *victim = NULL;
+    for (size_t i = 0; i < TM_GIT_REGISTRY_MAX_REPOS; i++) {
+        repo_entry_t *entry = &g_repos[i];
+        if (!entry->repo) return entry;
+        if (!entry->leased && (!victim || entry->last_used < victim->last_used)) {
+            victim = entry;
+        }
+    }
+    if (victim) drop_repo(victim);
+    return victim;
+}
+
+tm_error_t tm_git_registry_acquire(const char *path, tm_git_repo_t **repo)
+{
+    TM_CHECK_NULL(path, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(repo, TM_ERR_INVALID_ARG);
+
+    *repo = NULL;
+
+    char *abs = absolute_path(path);
+    char *root = abs ? tm_git_registry_find_root(abs) : NULL;
+    free(abs);
+
+    /* Not a worktree we can key on (e.g. a bare repository): private handle */
+    if (!root) return tm_git_repo_open(path, repo);
+
+    pthread_mutex_lock(&g_lock);
+
+    repo_entry_t *entry = NULL;
+    for (size_t i = 0; i < TM_GIT_REGISTRY_MAX_REPOS && !entry; i++) {
+        if (g_repos[i].repo && strcmp(g_repos[i].root, root) == 0) entry = &g_repos[i];
+    }
+
+    if (entry && entry->leased) {
+        pthread_mutex_unlock(&g_lock);
+        tm_error_t err = tm_git_repo_open(root, repo);
+        free(root);
+        return err;
+    }
+
+    if (entry && tm_git_repo_refresh(entry->repo) != TM_OK) {
+        drop_repo(entry);
+        entry = NULL;
+    }
+
+    if (!entry) {
+        tm_git_repo_t *opened = NULL;
+        tm_error_t err = tm_git_repo_open(root, &opened);
+        if (err != TM_OK) {
+            pthread_mutex_unlock(&g_lock);
+            free(root);
+            return err;
+        }
+
+        entry = free_repo_slot();
+        if (!entry) {
+            /* Every handle is lent out; this one stays private */
+            pthread_mutex_unlock(&g_lock);
+            free(root);
+            *repo = opened;
+            return TM_OK;
+        }
+        entry->root = root;
+        entry->repo = opened;
+        root = NULL;
+    }
+
+    entry->leased = true;
+    entry->last_used = ++g_tick;
+    *repo = entry->repo;
+
+    pthread_mutex_unlock(&g_lock);
+    free(root);
+    return TM_OK;
+}
+
+void tm_git_registry_release(tm_git_repo_t *repo)
+{
+    if (!repo) return;
+
+    pthread_mutex_lock(&g_lock);
+    for (size_t i = 0; i < TM_GIT_REGISTRY_MAX_REPOS; i++) {
+        if (g_repos[i].repo == repo) {
+            g_repos[i].leased = false;
+            pthread_mutex_unlock(&g_lock);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    tm_git_repo_free(repo);
+}
+
+/* ============================================================================
+ * Context Cache
+ * ========================================================================== */
+
+char *tm_git_context_key(const char *head_sha,
+                         const tm_stack_trace_t *trace,
+                         const tm_git_collect_opts_t *opts)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+
+    tm_strbuf_appendf(&sb, "%s|%d|%lld|%d|%d%d", head_sha ? head_sha : "",
+                      opts->max_commits, (long long)opts->incident_time, opts->window_hours,
+                      opts->history_index, opts->blame_cache);
+
+    for (size_t i = 0; trace && i < trace->frame_count; i++) {
+        const tm_stack_frame_t *frame = &trace->frames[i];
+        tm_strbuf_appendf(&sb, "\n%s:%d:%s", frame->file ? frame->file : "", frame->line,
+                          frame->function ? frame->function : "");
+    }
+
+    return tm_strbuf_finish(&sb);
+}
+
+static void copy_commit(tm_git_commit_t *dst, const tm_git_commit_t *src)
+{
+    *dst = *src;
+    dst->author = src->author ? tm_strdup(src->author) : NULL;
+    dst->email = src->email ? tm_strdup(src->email) : NULL;
+    dst->message = src->message ? tm_strdup(src->message) : NULL;
+    dst->relevant_hunks = src->relevant_hunks ? tm_strdup(src->relevant_hunks) : NULL;
+
+    dst->files_changed = src->file_count ? tm_calloc(src->file_count, sizeof(char *)) : NULL;
+    for (size_t i = 0; i < src->file_count; i++) {
+        dst->files_changed[i] = tm_strdup(src->files_changed[i]);
+    }
+}
+
+tm_git_context_t *tm_git_context_clone(const tm_git_context_t *ctx)
+{
+    if (!ctx) return NULL;
+
+    tm_git_context_t *copy = tm_calloc(1, sizeof(tm_git_context_t));
+    *copy = *ctx;
+    copy->repo_root = ctx->repo_root ? tm_strdup(ctx->repo_root) : NULL;
+    copy->current_branch = ctx->current_branch ? tm_strdup(ctx->current_branch) : NULL;
+    copy->head_sha = ctx->head_sha ? tm_strdup(ctx->head_sha) : NULL;
+
+    copy->commits = ctx->commit_count ? tm_calloc(ctx->commit_count, sizeof(tm_git_commit_t)) : NULL;
+    for (size_t i = 0; i < ctx->commit_count; i++) {
+        copy_commit(&copy->commits[i], &ctx->commits[i]);
+    }
+
+    copy->blames = ctx->blame_count ? tm_calloc(ctx->blame_count, sizeof(tm_git_blame_t *)) : NULL;
+    for (size_t i = 0; i < ctx->blame_count; i++) {
+        const tm_git_blame_t *src = ctx->blames[i];
+        tm_git_blame_t *dst = tm_calloc(1, sizeof(tm_git_blame_t));
+        *dst = *src;
+        dst->author = src->author ? tm_strdup(src->author) : NULL;
+        dst->line_content = src->line_content ? tm_strdup(src->line_content) : NULL;
+        copy->blames[i] = dst;
+    }
+
+    copy->dirty_hunks = ctx->dirty_hunk_count
+        ? tm_calloc(ctx->dirty_hunk_count, sizeof(tm_git_dirty_hunk_t)) : NULL;
+    for (size_t i = 0; i < ctx->dirty_hunk_count; i++) {
+        const tm_git_dirty_hunk_t *src = &ctx->dirty_hunks[i];
+        tm_git_dirty_hunk_t *dst = &copy->dirty_hunks[i];
+        *dst = *src;
+        dst->file = src->file ? tm_strdup(src->file) : NULL;
+        dst->diff = src->diff ? tm_strdup(src->diff) : NULL;
+    }
+
+    return copy;
+}
+
+tm_git_context_t *tm_git_registry_context_get(const char *key, uint64_t *scope)
+{
+    if (!key) return NULL;
+
+    tm_git_context_t *copy = NULL;
+    pthread_mutex_lock(&g_lock);
+    for (size_t i = 0; i < TM_GIT_REGISTRY_MAX_CONTEXTS; i++) {
+        context_entry_t *entry = &g_contexts[i];
+        if (entry->key && strcmp(entry->key, key) == 0) {
+            entry->last_used = ++g_tick;
+            copy = tm_git_context_clone(entry->ctx);
+            if (scope) *scope = entry->scope;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return copy;
+}
+
+void tm_git_registry_context_put(const char *key, uint64_t scope, const tm_git_context_t *ctx)
+{
+    if (!key || !ctx) return;
+
+    tm_git_context_t *copy = tm_git_context_clone(ctx);
+
+    pthread_mutex_lock(&g_lock);
+    context_entry_t *slot = NULL;
+    for (size_t i = 0; i < TM_GIT_REGISTRY_MAX_CONTEXTS; i++) {
+        context_entry_t *entry = &g_contexts[i];
+        if (entry->key && strcmp(entry->key, key) == 0) {
+            slot = entry;
+            break;
+        }
+        if (!slot || (slot->key && (!entry->key || entry->last_used < slot->last_used))) {
+            slot = entry;
+        }
+    }
+
+    if (slot->key) {
+        free(slot->key);
+        tm_git_context_free(slot->ctx);
+    }
+    slot->key = tm_strdup(key);
+    slot->ctx = copy;
+    slot->scope = scope;
+    slot->last_used = ++g_tick;
+    pthread_mutex_unlock(&g_lock);
+}
+
+void tm_git_registry_clear(void)
+{
+    pthread_mutex_lock(&g_lock);
+
+    for (size_t i = 0; i < TM_GIT_REGISTRY_MAX_REPOS; i++) {
+        if (g_repos[i].repo && !g_repos[i].leased) drop_repo(&g_repos[i]);
+    }
+    for (size_t i = 0; i < TM_GIT_REGISTRY_MAX_CONTEXTS; i++) {
+        free(g_contexts[i].key);
+        tm_git_context_free(g_contexts[i].ctx);
+        memset(&g_contexts[i], 0, sizeof(g_contexts[i]));
+    }
+
+    for (size_t i = 0; i < g_root_count; i++) {
+        free(g_roots[i]);
+    }
+    TM_FREE(g_roots);
+    g_root_count = 0;
+    g_root_cap = 0;
+    tm_strmap_free(&g_dirs);
+
+    pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,375 @@
+/**
+ * TraceMind - Commit History Index
+ */
+
+#include "internal/common.h"
+#include "internal/history_index.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#define HISTORY_MAGIC "TMHIST\0\0"
+#define HISTORY_VERSION 2
+#define HISTORY_BYTE_ORDER 0x01020304u
+
+/* ============================================================================
+ * Loading
+ * ========================================================================== */
+
+/* Every path's name and entry run must stay inside their sections */
+static bool validate_paths(const tm_history_index_t *idx)
+{
+    const tm_history_header_t *header = idx->header;
+
+    for (uint32_t i = 0; i < header->path_count; i++) {
+        const tm_history_path_t *p = &idx->paths[i];
+        if (p->name_offset >= header->strings_size ||
+            p->name_len >= header->strings_size - p->name_offset ||
+            idx->strings[p->name_offset + p->name_len] != '\0' ||
+            p->first_entry > header->entry_count ||
+            p->entry_count > header->entry_count - p->first_entry) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+tm_error_t tm_history_index_load(const char *file, tm_history_index_t **index)
+{
+    TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(index, TM_ERR_INVALID_ARG);
+
+    *index = NULL;
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? TM_ERR_NOT_FOUND : TM_ERR_IO;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(tm_history_header_t)) {
+        close(fd);
+        return TM_ERR_PARSE;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return TM_ERR_IO;
+
+    const tm_history_header_t *header = map;
+
+    /* Validate header and section bounds */
+    bool valid = memcmp(header->magic, HISTORY_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == HISTORY_VERSION &&
+                 header->byte_order == HISTORY_BYTE_ORDER;
+
+    /* Counts are bounded by the file size first so the products cannot wrap */
+    size_t entries_size = 0, paths_size = 0;
+    if (valid) {
+        valid = header->entry_count <= size / sizeof(tm_history_entry_t) &&
+                header->path_count <= size / sizeof(tm_history_path_t) &&
+                header->strings_size <= size;
+    }
+    if (valid) {
+        entries_size = (size_t)header->entry_count * sizeof(tm_history_entry_t);
+        paths_size = (size_t)header->path_count * sizeof(tm_history_path_t);
+        valid = sizeof(*header) + entries_size + paths_size + header->strings_size == size;
+    }
+
+    tm_history_index_t *idx = tm_calloc(1, sizeof(tm_history_index_t));
+    idx->map = map;
+    idx->map_size = size;
+    idx->header = header;
+    idx->entries = (const tm_history_entry_t *)((const char *)map + sizeof(*header));
+    idx->paths = (const tm_history_path_t *)((const char *)idx->entries + entries_size);
+    idx->strings = (const char *)idx->paths + paths_size;
+
+    if (!valid || !validate_paths(idx)) {
+        tm_history_index_free(idx);
+        return TM_ERR_PARSE;
+    }
+
+    TM_DEBUG("Loaded history index %s: %u paths, %llu entries%s", file,
+             header->path_count, (unsigned long long)header->entry_count,
+             header->boundary ? " (partial)" : "");
+
+    *index = idx;
+    return TM_OK;
+}
+
+void tm_history_index_free(tm_history_index_t *index)
+{
+    if (!index) return;
+    if (index->map) munmap(index->map, index->map_size);
+    free(index);
+}
+
+/* ============================================================================
+ * Queries
+ * ========================================================================== */
+
+static const char *path_name(const tm_history_index_t *index, const tm_history_path_t *p)
+{
+    return index->strings + p->name_offset;
+}
+
+const tm_history_entry_t *tm_history_index_lookup(const tm_history_index_t *index,
+                                                  const char *path,
+                                                  size_t *count)
+{
+    if (count) *count = 0;
+    if (!index || !path) return NULL;
+
+    size_t lo = 0, hi = index->header->path_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const tm_history_path_t *p = &index->paths[mid];
+        int cmp = strcmp(path_name(index, p), path);
+
+        if (cmp == 0) {
+            if (count) *count = p->entry_count;
+            return &index->entries[p->first_entry];
+        }
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+
+    return NULL;
+}
+
+/* Newest first, then by OID so duplicates are adjacent */
+static int compare_entries(const void *a, const void *b)
+{
+    const tm_history_entry_t *x = a, *y = b;
+    if (x->timestamp != y->timestamp) return x->timestamp > y->timestamp ? -1 : 1;
+    return memcmp(x->oid, y->oid, TM_HISTORY_OID_SIZE);
+}
+
+tm_error_t tm_history_index_query(const tm_history_index_t *index,
+                                  const char **patterns,
+                                  size_t pattern_count,
+                                  tm_history_entry_t **entries,
+                                  size_t *count)
+{
+    TM_CHECK_NULL(index, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(entries, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+
+    *entries = NULL;
+    *count = 0;
+
+    tm_history_entry_t *result = NULL;
+    size_t n = 0, cap = 0;
+
+    for (size_t i = 0; i < pattern_count; i++) {
+        if (!patterns[i]) continue;
+
+        size_t hits = 0;
+        const tm_history_entry_t *exact = tm_history_index_lookup(index, patterns[i], &hits);
+        if (exact) {
+            for (size_t j = 0; j < hits; j++) TM_VEC_PUSH(result, n, cap, exact[j]);
+            continue;
+        }
+
+        /* Not an indexed path: substring match over all paths */
+        for (uint32_t p = 0; p < index->header->path_count; p++) {
+            const tm_history_path_t *path = &index->paths[p];
+            if (!strstr(path_name(index, path), patterns[i])) continue;
+
+            for (uint32_t j = 0; j < path->entry_count; j++) {
+                TM_VEC_PUSH(result, n, cap, index->entries[path->first_entry + j]);
+            }
+        }
+    }
+
+    if (n > 1) {
+        qsort(result, n, sizeof(tm_history_entry_t), compare_entries);
+
+        size_t unique = 1;
+        for (size_t i = 1; i < n; i++) {
+            if (memcmp(result[i].oid, result[unique - 1].oid, TM_HISTORY_OID_SIZE) != 0) {
+                result[unique++] = result[i];
+            }
+        }
+        n = unique;
+    }
+
+    *entries = result;
+    *count = n;
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Building
+ * ========================================================================== */
+
+void tm_history_builder_init(tm_history_builder_t *builder)
+{
+    memset(builder, 0, sizeof(*builder));
+    tm_strmap_init(&builder->path_ids);
+}
+
+void tm_history_builder_add(tm_history_builder_t *builder,
+                            const char *path,
+                            const tm_history_entry_t *entry)
+{
+    if (!builder || !path || !entry) return;
+
+    size_t id;
+    if (!tm_strmap_get(&builder->path_ids, path, &id)) {
+        id = builder->path_count;
+        char *copy = tm_strdup(path);
+        TM_VEC_PUSH(builder->paths, builder->path_count, builder->path_cap, copy);
+        tm_strmap_put(&builder->path_ids, path, id);
+    }
+
+    if (builder->record_count == builder->record_cap) {
+        builder->record_cap = builder->record_cap ? builder->record_cap * 2 : 256;
+        builder->records = tm_realloc(builder->records,
+                                      builder->record_cap * sizeof(tm_history_entry_t));
+        builder->record_paths = tm_realloc(builder->record_paths,
+                                           builder->record_cap * sizeof(uint32_t));
+    }
+    builder->records[builder->record_count] = *entry;
+    builder->record_paths[builder->record_count] = (uint32_t)id;
+    builder->record_count++;
+}
+
+void tm_history_builder_free(tm_history_builder_t *builder)
+{
+    if (!builder) return;
+    for (size_t i = 0; i < builder->path_count; i++) free(builder->paths[i]);
+    free(builder->paths);
+    free(builder->records);
+    free(builder->record_paths);
+    tm_strmap_free(&builder->path_ids);
+    memset(builder, 0, sizeof(*builder));
+}
+
+/* A new path name and its builder ID, sorted by name */
+typedef struct {
+    const char *name;
+    uint32_t id;
+} path_order_t;
+
+static int compare_path_order(const void *a, const void *b)
+{
+    return strcmp(((const path_order_t *)a)->name, ((const path_order_t *)b)->name);
+}
+
+tm_error_t tm_history_builder_write(const tm_history_builder_t *builder,
+                                    const tm_history_index_t *base,
+                                    const uint8_t head[TM_HISTORY_OID_SIZE],
+                                    const char *file)
+{
+    TM_CHECK_NULL(builder, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(head, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
+
+    /* Group new records by path, keeping walk (newest-first) order */
+    size_t new_paths = builder->path_count;
+    size_t *group_start = tm_calloc(new_paths + 1, sizeof(size_t));
+    for (size_t i = 0; i < builder->record_count; i++) {
+        group_start[builder->record_paths[i] + 1]++;
+    }
+    for (size_t p = 0; p < new_paths; p++) group_start[p + 1] += group_start[p];
+
+    size_t *fill = tm_malloc((new_paths + 1) * sizeof(size_t));
+    memcpy(fill, group_start, (new_paths + 1) * sizeof(size_t));
+    size_t *grouped = tm_malloc((builder->record_count + 1) * sizeof(size_t));
+    for (size_t i = 0; i < builder->record_count; i++) {
+        grouped[fill[builder->record_paths[i]]++] = i;
+    }
+    free(fill);
+
+    /* Sort new path names; each pair carries its name, so no sort context */
+    path_order_t *order = tm_malloc((new_paths + 1) * sizeof(path_order_t));
+    for (size_t p = 0; p < new_paths; p++) {
+        order[p] = (path_order_t){ builder->paths[p], (uint32_t)p };
+    }
+    qsort(order, new_paths, sizeof(path_order_t), compare_path_order);
+
+    size_t base_paths = base ? base->header->path_count : 0;
+    uint64_t total_entries = builder->record_count + (base ? base->header->entry_count : 0);
+
+    tm_strbuf_t entries, paths, strings;
+    tm_strbuf_init(&entries);
+    tm_strbuf_init(&paths);
+    tm_strbuf_init(&strings);
+
+    /* Merge the two sorted path lists, keeping each path's run newest first */
+    size_t bi = 0, ni = 0, entry_index = 0, path_total = 0;
+    while (bi < base_paths || ni < new_paths) {
+        const tm_history_path_t *bp = bi < base_paths ? &base->paths[bi] : NULL;
+        const char *bname = bp ? path_name(base, bp) : NULL;
+        const char *nname = ni < new_paths ? order[ni].name : NULL;
+
+        int cmp = !bname ? 1 : !nname ? -1 : strcmp(bname, nname);
+        const char *name = cmp <= 0 ? bname : nname;
+
+        tm_history_path_t rec = {
+            .name_offset = (uint32_t)strings.len,
+            .name_len = (uint32_t)strlen(name),
+            .first_entry = (uint32_t)entry_index
+        };
+
+        if (cmp <= 0 && builder->older) {
+            tm_strbuf_append_len(&entries, (const char *)&base->entries[bp->first_entry],
+                                 bp->entry_count * sizeof(tm_history_entry_t));
+            rec.entry_count += bp->entry_count;
+        }
+        if (cmp >= 0) {
+            uint32_t id = order[ni++].id;
+            for (size_t k = group_start[id]; k < group_start[id + 1]; k++) {
+                tm_strbuf_append_len(&entries, (const char *)&builder->records[grouped[k]],
+                                     sizeof(tm_history_entry_t));
+                rec.entry_count++;
+            }
+        }
+        if (cmp <= 0 && !builder->older) {
+            tm_strbuf_append_len(&entries, (const char *)&base->entries[bp->first_entry],
+                                 bp->entry_count * sizeof(tm_history_entry_t));
+            rec.entry_count += bp->entry_count;
+        }
+        if (cmp <= 0) bi++;
+
+        tm_strbuf_append_len(&strings, name, rec.name_len + 1);
+        tm_strbuf_append_len(&paths, (const char *)&rec, sizeof(rec));
+        entry_index += rec.entry_count;
+        path_total++;
+    }
+
+    free(order);
+    free(grouped);
+    free(group_start);
+
+    tm_history_header_t header = {
+        .version = HISTORY_VERSION,
+        .byte_order = HISTORY_BYTE_ORDER,
+        .path_count = (uint32_t)path_total,
+        .entry_count = total_entries,
+        .strings_size = strings.len,
+        .boundary = builder->boundary
+    };
+    memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+    memcpy(header.head, head, TM_HISTORY_OID_SIZE);
+
+    tm_strbuf_t out;
+    tm_strbuf_init(&out);
+    tm_strbuf_append_len(&out, (const char *)&header, sizeof(header));
+    tm_strbuf_append_len(&out, entries.data, entries.len);
+    tm_strbuf_append_len(&out, paths.data, paths.len);
+    tm_strbuf_append_len(&out, strings.data, strings.len);
+
+    tm_strbuf_free(&entries);
+    tm_strbuf_free(&paths);
+    tm_strbuf_free(&strings);
+
+    tm_error_t err = tm_write_file_atomic(file, out.data, out.len);
+    tm_strbuf_free(&out);
+
+    if (err == TM_OK) {
+        TM_DEBUG("Wrote history index %s: %zu paths, %llu entries", file,
+                 path_total, (unsigned long long)total_entries);
+    }
+    return err;
+}
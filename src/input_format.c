@@ -10,6 +10,7 @@
 #include <ctype.h>
 #include <string.h>
 #include <strings.h>
+#include <time.h>
 
 /* ============================================================================
  * Default Field Mappings
@@ -1591,3 +1592,248 @@ char *tm_extract_stack_traces(const char *content,
     TM_INFO("Extracted stack traces from %s format", tm_input_format_name(format));
     return buf.data;
 }
+
+/* ============================================================================
+ * Timestamps
+ * ========================================================================== */
+
+static const char *MONTHS[] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+/* Days since 1970-01-01 for a proleptic Gregorian date (no timegm in C11) */
+static int64_t days_from_civil(int64_t y, int m, int d)
+{
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/* Parse exactly n digits */
+static bool read_digits(const char *s, int n, int *out)
+{
+    int v = 0;
+    for (int i = 0; i < n; i++) {
+        if (!isdigit((unsigned char)s[i])) return false;
+        v = v * 10 + (s[i] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+static int month_index(const char *s)
+{
+    for (int i = 0; i < 12; i++) {
+        if (strncmp(s, MONTHS[i], 3) == 0) return i + 1;
+    }
+    return 0;
+}
+
+static bool valid_time(int mon, int day, int h, int mi, int sec)
+{
+    return mon >= 1 && mon <= 12 && day >= 1 && day <= 31 &&
+           h <= 23 && mi <= 59 && sec <= 60;
+}
+
+/* "Z", "+HH:MM", "+HHMM" or "+HH"; false if the time carries no zone */
+static bool parse_utc_offset(const char *s, int64_t *offset)
+{
+    *offset = 0;
+    while (*s == ' ') s++;
+    if (*s == 'Z' || *s == 'z') return true;
+    if (*s != '+' && *s != '-') return false;
+    
+    int sign = *s == '-' ? -1 : 1;
+    int h = 0, m = 0;
+    if (!read_digits(s + 1, 2, &h)) return false;
+    const char *p = s + 3;
+    if (*p == ':') p++;
+    if (!read_digits(p, 2, &m)) m = 0;
+    *offset = sign * (int64_t)(h * 3600 + m * 60);
+    return true;
+}
+
+/*
+ * Zoned times are exact. A time without a zone was written by a process
+ * on this host in its local time, as syslog and most loggers do, so it is
+ * resolved through mktime (DST included) rather than read as UTC; the
+ * incident time bounds the commit walk, so hours of skew would drop or
+ * admit commits.
+ */
+static bool civil_time(int64_t y, int mon, int d, int h, int mi, int sec,
+                       const char *zone, int64_t *out)
+{
+    int64_t offset;
+    if (zone && parse_utc_offset(zone, &offset)) {
+        *out = days_from_civil(y, mon, d) * 86400 + h * 3600 + mi * 60 + sec - offset;
+        return true;
+    }
+    
+    struct tm tm = {
+        .tm_year = (int)(y - 1900), .tm_mon = mon - 1, .tm_mday = d,
+        .tm_hour = h, .tm_min = mi, .tm_sec = sec, .tm_isdst = -1
+    };
+    time_t t = mktime(&tm);
+    if (t == (time_t)-1) return false;
+    *out = (int64_t)t;
+    return true;
+}
+
+/* YYYY-MM-DD[T ]HH:MM[:SS[.frac]][zone] */
+static bool parse_iso8601(const char *s, int64_t *out)
+{
+    int y, mon, d, h, mi, sec = 0;
+    if (!read_digits(s, 4, &y) || s[4] != '-' || !read_digits(s + 5, 2, &mon) ||
+        s[7] != '-' || !read_digits(s + 8, 2, &d) || (s[10] != 'T' && s[10] != ' ') ||
+        !read_digits(s + 11, 2, &h) || s[13] != ':' || !read_digits(s + 14, 2, &mi)) {
+        return false;
+    }
+    
+    const char *p = s + 16;
+    if (*p == ':' && read_digits(p + 1, 2, &sec)) p += 3;
+    if (*p == '.' || *p == ',') {
+        p++;
+        while (isdigit((unsigned char)*p)) p++;
+    }
+    if (!valid_time(mon, d, h, mi, sec)) return false;
+    
+    return civil_time(y, mon, d, h, mi, sec, p, out);
+}
+
+/* DD/Mon/YYYY:HH:MM:SS [zone] */
+static bool parse_clf(const char *s, int64_t *out)
+{
+    int d, y, h, mi, sec;
+    if (!read_digits(s, 2, &d) || s[2] != '/') return false;
+    int mon = month_index(s + 3);
+    if (!mon || s[6] != '/' || !read_digits(s + 7, 4, &y) || s[11] != ':' ||
+        !read_digits(s + 12, 2, &h) || s[14] != ':' || !read_digits(s + 15, 2, &mi) ||
+        s[17] != ':' || !read_digits(s + 18, 2, &sec) || !valid_time(mon, d, h, mi, sec)) {
+        return false;
+    }
+    
+    return civil_time(y, mon, d, h, mi, sec, s + 20, out);
+}
+
+/* Mon [D]D HH:MM:SS; syslog omits the year and zone */
+static bool parse_syslog_time(const char *s, int64_t *out)
+{
+    int mon = month_index(s);
+    if (!mon || s[3] != ' ') return false;
+    
+    const char *p = s + 4;
+    if (*p == ' ') p++;
+    int d = 0;
+    if (read_digits(p, 2, &d)) p += 2;
+    else if (read_digits(p, 1, &d)) p += 1;
+    else return false;
+    
+    int h, mi, sec;
+    if (*p != ' ' || !read_digits(p + 1, 2, &h) || p[3] != ':' ||
+        !read_digits(p + 4, 2, &mi) || p[6] != ':' || !read_digits(p + 7, 2, &sec) ||
+        !valid_time(mon, d, h, mi, sec)) {
+        return false;
+    }
+    
+    /* Current local year, unless that puts the entry in the future */
+    time_t now = time(NULL);
+    struct tm local;
+    if (!localtime_r(&now, &local)) return false;
+    
+    int64_t t;
+    if (!civil_time(local.tm_year + 1900, mon, d, h, mi, sec, NULL, &t)) return false;
+    if (t > (int64_t)now + 86400 &&
+        !civil_time(local.tm_year + 1899, mon, d, h, mi, sec, NULL, &t)) {
+        return false;
+    }
+    *out = t;
+    return true;
+}
+
+/* Whole-string epoch seconds or milliseconds, as structured logs carry */
+static bool parse_epoch(const char *s, int64_t *out)
+{
+    while (*s == ' ' || *s == '"') s++;
+    
+    size_t digits = strspn(s, "0123456789");
+    const char *end = s + digits;
+    if (*end == '.') end += 1 + strspn(end + 1, "0123456789");
+    while (*end == ' ' || *end == '"') end++;
+    if (*end != '\0') return false;
+    
+    int64_t v = strtoll(s, NULL, 10);
+    if (digits == 10) *out = v;
+    else if (digits == 13) *out = v / 1000;
+    else return false;
+    return true;
+}
+
+bool tm_parse_timestamp(const char *text, int64_t *out)
+{
+    if (!text || !out) return false;
+    if (parse_epoch(text, out)) return true;
+    
+    for (const char *p = text; *p; p++) {
+        if (isdigit((unsigned char)*p)) {
+            if (p != text && isdigit((unsigned char)p[-1])) continue;
+            if (parse_iso8601(p, out) || parse_clf(p, out)) return true;
+        } else if (isupper((unsigned char)*p) && (p == text || !isalpha((unsigned char)p[-1]))) {
+            if (parse_syslog_time(p, out)) return true;
+        }
+    }
+    return false;
+}
+
+static bool line_looks_like_error(const char *line)
+{
+    static const char *MARKERS[] = {
+        "ERROR", "FATAL", "CRITICAL", "PANIC", "Exception", "Traceback",
+        "panic:", "Error:", "\"severity\":\"ERROR\"", "\"level\":\"error\""
+    };
+    
+    for (size_t i = 0; i < TM_ARRAY_SIZE(MARKERS); i++) {
+        if (strstr(line, MARKERS[i])) return true;
+    }
+    return false;
+}
+
+int64_t tm_find_incident_time(const char *content,
+                              size_t len,
+                              const tm_generic_log_t *log)
+{
+    int64_t t = 0;
+    
+    if (log) {
+        for (size_t i = 0; i < log->count; i++) {
+            const tm_generic_log_entry_t *e = &log->entries[i];
+            if (e->is_error && e->timestamp && tm_parse_timestamp(e->timestamp, &t)) return t;
+        }
+    }
+    
+    if (!content) return 0;
+    
+    int64_t first_any = 0;
+    char line[4096];
+    const char *p = content, *end = content + len;
+    
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        size_t n = (size_t)((nl ? nl : end) - p);
+        size_t copy = TM_MIN(n, sizeof(line) - 1);
+        memcpy(line, p, copy);
+        line[copy] = '\0';
+        
+        if (tm_parse_timestamp(line, &t)) {
+            if (line_looks_like_error(line)) return t;
+            if (!first_any) first_any = t;
+        }
+        
+        p += n + 1;
+    }
+    
+    return first_any;
+}
@@ -0,0 +1,121 @@
+/**
+ * TraceMind - Interval Index
+ */
+
+#include "internal/common.h"
+#include "internal/interval.h"
+
+/* ============================================================================
+ * Construction
+ * ========================================================================== */
+
+static int compare_intervals(const void *a, const void *b)
+{
+    const tm_interval_t *x = a, *y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    if (x->end != y->end) return x->end < y->end ? -1 : 1;
+    return 0;
+}
+
+/* The implicit tree over [lo, hi) is rooted at its midpoint */
+static int build_subtree(tm_interval_index_t *index, size_t lo, size_t hi)
+{
+    if (lo >= hi) return INT_MIN;
+
+    size_t mid = lo + (hi - lo) / 2;
+    int max = index->items[mid].end;
+    max = TM_MAX(max, build_subtree(index, lo, mid));
+    max = TM_MAX(max, build_subtree(index, mid + 1, hi));
+    index->subtree_max[mid] = max;
+    return max;
+}
+
+void tm_interval_index_init(tm_interval_index_t *index,
+                            const tm_interval_t *intervals,
+                            size_t count)
+{
+    memset(index, 0, sizeof(*index));
+    if (!intervals || count == 0) return;
+
+    index->count = count;
+    index->items = tm_malloc(count * sizeof(tm_interval_t));
+    index->subtree_max = tm_malloc(count * sizeof(int));
+    index->prefix_max = tm_malloc(count * sizeof(int));
+
+    memcpy(index->items, intervals, count * sizeof(tm_interval_t));
+    qsort(index->items, count, sizeof(tm_interval_t), compare_intervals);
+
+    build_subtree(index, 0, count);
+
+    for (size_t i = 0; i < count; i++) {
+        int end = index->items[i].end;
+        index->prefix_max[i] = i > 0 ? TM_MAX(index->prefix_max[i - 1], end) : end;
+    }
+}
+
+void tm_interval_index_free(tm_interval_index_t *index)
+{
+    if (!index) return;
+
+    TM_FREE(index->items);
+    TM_FREE(index->subtree_max);
+    TM_FREE(index->prefix_max);
+    index->count = 0;
+}
+
+/* ============================================================================
+ * Queries
+ * ========================================================================== */
+
+static size_t visit_overlaps(const tm_interval_index_t *index, size_t lo, size_t hi,
+                             int start, int end, tm_interval_fn fn, void *ctx)
+{
+    if (lo >= hi) return 0;
+
+    size_t mid = lo + (hi - lo) / 2;
+    if (index->subtree_max[mid] < start) return 0;
+
+    size_t found = visit_overlaps(index, lo, mid, start, end, fn, ctx);
+
+    const tm_interval_t *item = &index->items[mid];
+    if (item->start > end) return found;  /* Everything to the right starts later */
+
+    if (item->end >= start) {
+        if (fn) fn(item, ctx);
+        found++;
+    }
+
+    return found + visit_overlaps(index, mid + 1, hi, start, end, fn, ctx);
+}
+
+size_t tm_interval_index_overlaps(const tm_interval_index_t *index,
+                                  int start, int end,
+                                  tm_interval_fn fn, void *ctx)
+{
+    if (!index || index->count == 0 || start > end) return 0;
+    return visit_overlaps(index, 0, index->count, start, end, fn, ctx);
+}
+
+int tm_interval_index_distance(const tm_interval_index_t *index, int start, int end)
+{
+    if (!index || index->count == 0) return -1;
+
+    /* First interval starting after the query */
+    size_t lo = 0, hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->items[mid].start <= end) lo = mid + 1;
+        else hi = mid;
+    }
+
+    int best = INT_MAX;
+    if (lo > 0) {
+        int left_end = index->prefix_max[lo - 1];
+        if (left_end >= start) return 0;
+        best = start - left_end;
+    }
+    if (lo < index->count) {
+        best = TM_MIN(best, index->items[lo].start - end);
+    }
+    return best;
+}
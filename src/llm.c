@@ -8,6 +8,8 @@
 #include "internal/llm.h"
 #include <curl/curl.h>
 #include <jansson.h>
+#include <pthread.h>
+#include <time.h>
 #include <unistd.h>
 
 /* ============================================================================
@@ -17,6 +19,16 @@
 #define OPENAI_ENDPOINT "https://api.openai.com/v1/chat/completions"
 #define ANTHROPIC_ENDPOINT "https://api.anthropic.com/v1/messages"
 #define DEFAULT_MAX_TOKENS 4096
+#define OPENAI_MAP_MODEL "gpt-4o-mini"
+#define ANTHROPIC_MAP_MODEL "claude-3-5-haiku-latest"
+
+/* Per-entry markup and fixed prompt size used for generic log budgeting */
+#define GENERIC_ENTRY_OVERHEAD_CHARS 48
+#define GENERIC_PROMPT_OVERHEAD_TOKENS 2000
+
+#define REPO_SUMMARY_RANKED_COMMITS 5  /* Ranked commits listed in the prompt */
+#define REPO_SUMMARY_HUNK_COMMITS 3    /* ... of which this many show their hunks */
+#define PROMPT_DIRTY_HUNKS 5           /* Uncommitted hunks shown in the prompt */
 
 /* Expected JSON schema for hypothesis response */
 const char *TM_HYPOTHESIS_SCHEMA = 
@@ -90,6 +102,21 @@ tm_llm_client_t *tm_llm_client_new(const tm_config_t *cfg)
     client->model = cfg->model_name ? tm_strdup(cfg->model_name) : tm_strdup("gpt-4o");
     client->timeout_ms = cfg->timeout_ms > 0 ? cfg->timeout_ms : 60000;
     client->temperature = cfg->temperature >= 0 ? cfg->temperature : 0.3f;
+    client->context_tokens = cfg->context_tokens > 0 ? cfg->context_tokens : 32000;
+    client->max_parallel = cfg->max_parallel_requests > 0 ? cfg->max_parallel_requests : 1;
+    client->limiter = tm_rate_limiter_new(cfg->requests_per_minute, cfg->tokens_per_minute);
+    client->owns_limiter = client->limiter != NULL;
+    
+    /* Cheaper model for map-reduce summaries */
+    if (cfg->map_model) {
+        client->map_model = tm_strdup(cfg->map_model);
+    } else if (cfg->llm_provider == TM_LLM_OPENAI && !cfg->api_endpoint) {
+        client->map_model = tm_strdup(OPENAI_MAP_MODEL);
+    } else if (cfg->llm_provider == TM_LLM_ANTHROPIC && !cfg->api_endpoint) {
+        client->map_model = tm_strdup(ANTHROPIC_MAP_MODEL);
+    } else {
+        client->map_model = tm_strdup(client->model);
+    }
     
     /* Set endpoint */
     if (cfg->api_endpoint) {
@@ -119,14 +146,44 @@ tm_llm_client_t *tm_llm_client_new(const tm_config_t *cfg)
     return client;
 }
 
+tm_llm_client_t *tm_llm_client_clone(const tm_llm_client_t *client, const char *model)
+{
+    if (!client) return NULL;
+    
+    tm_llm_client_t *clone = tm_calloc(1, sizeof(tm_llm_client_t));
+    
+    clone->provider = client->provider;
+    clone->api_key = tm_strdup(client->api_key);
+    clone->endpoint = tm_strdup(client->endpoint);
+    clone->model = tm_strdup(model ? model : client->model);
+    clone->map_model = tm_strdup(client->map_model);
+    clone->timeout_ms = client->timeout_ms;
+    clone->temperature = client->temperature;
+    clone->context_tokens = client->context_tokens;
+    clone->max_parallel = client->max_parallel;
+    clone->limiter = client->limiter;
+    clone->owns_limiter = false;
+    
+    clone->curl = curl_easy_init();
+    if (!clone->curl) {
+        TM_ERROR("Failed to create CURL handle");
+        tm_llm_client_free(clone);
+        return NULL;
+    }
+    
+    return clone;
+}
+
 void tm_llm_client_free(tm_llm_client_t *client)
 {
     if (!client) return;
     
     if (client->curl) curl_easy_cleanup(client->curl);
+    if (client->owns_limiter) tm_rate_limiter_free(client->limiter);
     TM_FREE(client->api_key);
     TM_FREE(client->endpoint);
     TM_FREE(client->model);
+    TM_FREE(client->map_model);
     free(client);
 }
 
@@ -226,6 +283,21 @@ char *tm_build_analysis_prompt(const tm_analysis_context_t *ctx)
             tm_strbuf_append(&sb, "\n");
         }
         tm_strbuf_append(&sb, "```\n\n");
+        
+        /* Code at the frames, '>' marking the frame line */
+        bool has_context = false;
+        for (size_t i = 0; i < ctx->trace->frame_count && i < 20; i++) {
+            const tm_stack_frame_t *f = &ctx->trace->frames[i];
+            if (!f->context) continue;
+            
+            if (!has_context) tm_strbuf_append(&sb, "## SOURCE CONTEXT\n\n");
+            has_context = true;
+            tm_strbuf_appendf(&sb, "**Frame %zu:** `%s` (%s:%d)\n```\n%s```\n\n",
+                              i + 1,
+                              f->function ? f->function : "<unknown>",
+                              f->file ? f->file : "<unknown>",
+                              f->line, f->context);
+        }
     }
     
     /* Call graph section */
@@ -247,53 +319,45 @@ char *tm_build_analysis_prompt(const tm_analysis_context_t *ctx)
         tm_strbuf_append(&sb, "\n");
     }
     
-    /* Git context section */
-    if (ctx->git_ctx) {
-        tm_strbuf_append(&sb, "## GIT CONTEXT\n\n");
-        tm_strbuf_appendf(&sb, "**Branch:** %s\n", 
-                          ctx->git_ctx->current_branch ? ctx->git_ctx->current_branch : "unknown");
-        tm_strbuf_appendf(&sb, "**HEAD:** %s\n\n", 
-                          ctx->git_ctx->head_sha ? ctx->git_ctx->head_sha : "unknown");
-        
-        if (ctx->git_ctx->commit_count > 0) {
-            tm_strbuf_append(&sb, "**Recent commits affecting error files:**\n");
-            
-            for (size_t i = 0; i < ctx->git_ctx->commit_count && i < 10; i++) {
-                const tm_git_commit_t *c = &ctx->git_ctx->commits[i];
-                
-                /* Get first line of message */
-                const char *msg = c->message;
-                const char *newline = msg ? strchr(msg, '\n') : NULL;
-                size_t msg_len = newline ? (size_t)(newline - msg) : (msg ? strlen(msg) : 0);
-                if (msg_len > 80) msg_len = 80;
-                
-                tm_strbuf_appendf(&sb, "- `%.7s` ", c->sha);
-                if (msg && msg_len > 0) {
-                    char *truncated = tm_strndup(msg, msg_len);
-                    tm_strbuf_append(&sb, truncated);
-                    TM_FREE(truncated);
-                }
-                
-                if (c->touches_config) tm_strbuf_append(&sb, " **[CONFIG]**");
-                if (c->touches_schema) tm_strbuf_append(&sb, " **[SCHEMA]**");
-                
-                tm_strbuf_appendf(&sb, " (+%d/-%d)\n", c->additions, c->deletions);
+    /* Commits are filtered by the trace's files, so they stay out of the
+     * cached repo summary */
+    char *history = tm_build_commit_history(ctx->git_ctx);
+    if (history) {
+        tm_strbuf_append(&sb, history);
+        free(history);
+    }
+    
+    /* Blame is per-trace; branch and HEAD live in the repo summary */
+    if (ctx->git_ctx && ctx->git_ctx->blame_count > 0) {
+        tm_strbuf_append(&sb, "## BLAME\n\n");
+        tm_strbuf_append(&sb, "**Blame info for error lines:**\n");
+        for (size_t i = 0; i < ctx->git_ctx->blame_count; i++) {
+            const tm_git_blame_t *b = ctx->git_ctx->blames[i];
+            if (b) {
+                tm_strbuf_appendf(&sb, "- Line by %s (commit %.7s)\n",
+                                  b->author ? b->author : "unknown",
+                                  b->sha);
             }
-            tm_strbuf_append(&sb, "\n");
         }
-        
-        if (ctx->git_ctx->blame_count > 0) {
-            tm_strbuf_append(&sb, "**Blame info for error lines:**\n");
-            for (size_t i = 0; i < ctx->git_ctx->blame_count; i++) {
-                const tm_git_blame_t *b = ctx->git_ctx->blames[i];
-                if (b) {
-                    tm_strbuf_appendf(&sb, "- Line by %s (commit %.7s)\n",
-                                      b->author ? b->author : "unknown",
-                                      b->sha);
-                }
+        tm_strbuf_append(&sb, "\n");
+    }
+    
+    /* Uncommitted edits explain crashes no commit does (hot patches, local changes) */
+    if (ctx->git_ctx && ctx->git_ctx->dirty_hunk_count > 0) {
+        const tm_git_context_t *git = ctx->git_ctx;
+        tm_strbuf_append(&sb, "## UNCOMMITTED CHANGES\n\n");
+        tm_strbuf_appendf(&sb, "The working tree differs from HEAD in %zu hunk(s) of the traced files.\n",
+                          git->dirty_hunk_count);
+        for (size_t i = 0; i < git->dirty_hunk_count && i < PROMPT_DIRTY_HUNKS; i++) {
+            const tm_git_dirty_hunk_t *h = &git->dirty_hunks[i];
+            tm_strbuf_appendf(&sb, "\n**%s:%d-%d**", h->file, h->start_line, h->end_line);
+            if (h->frame >= 0) {
+                tm_strbuf_appendf(&sb, " (covers the line of frame %d)", h->frame + 1);
             }
             tm_strbuf_append(&sb, "\n");
+            if (h->diff) tm_strbuf_appendf(&sb, "```diff\n%s```\n", h->diff);
         }
+        tm_strbuf_append(&sb, "\n");
     }
     
     /* Additional context */
@@ -310,6 +374,120 @@ char *tm_build_analysis_prompt(const tm_analysis_context_t *ctx)
     return tm_strbuf_finish(&sb);
 }
 
+/* "3h", "2d" or "45m": how long before the incident a commit landed */
+static void append_lead_time(tm_strbuf_t *sb, int64_t seconds)
+{
+    if (seconds < 3600) {
+        tm_strbuf_appendf(sb, "%lldm", (long long)(seconds / 60));
+    } else if (seconds < 2 * 86400) {
+        tm_strbuf_appendf(sb, "%lldh", (long long)(seconds / 3600));
+    } else {
+        tm_strbuf_appendf(sb, "%lldd", (long long)(seconds / 86400));
+    }
+}
+
+char *tm_build_repo_summary(const tm_git_context_t *git_ctx)
+{
+    if (!git_ctx) return NULL;
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    
+    tm_strbuf_append(&sb, "## GIT CONTEXT\n\n");
+    tm_strbuf_appendf(&sb, "**Branch:** %s\n",
+                      git_ctx->current_branch ? git_ctx->current_branch : "unknown");
+    tm_strbuf_appendf(&sb, "**HEAD:** %s\n\n",
+                      git_ctx->head_sha ? git_ctx->head_sha : "unknown");
+    
+    return tm_strbuf_finish(&sb);
+}
+
+char *tm_build_commit_history(const tm_git_context_t *git_ctx)
+{
+    if (!git_ctx || (git_ctx->commit_count == 0 && git_ctx->incident_time <= 0)) return NULL;
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    
+    tm_strbuf_append(&sb, "## COMMIT HISTORY\n\n");
+    
+    if (git_ctx->incident_time > 0) {
+        char incident[32] = "unknown";
+        time_t t = (time_t)git_ctx->incident_time;
+        struct tm tm_utc;
+        if (gmtime_r(&t, &tm_utc)) strftime(incident, sizeof(incident), "%Y-%m-%dT%H:%M:%SZ", &tm_utc);
+        tm_strbuf_appendf(&sb, "**Incident:** %s", incident);
+        if (git_ctx->window_start > 0) {
+            tm_strbuf_append(&sb, " (commits from the preceding ");
+            append_lead_time(&sb, git_ctx->incident_time - git_ctx->window_start);
+            tm_strbuf_append(&sb, ")");
+        }
+        tm_strbuf_append(&sb, "\n\n");
+    }
+    
+    /* Ranked commits: only those whose hunks come near the failing code */
+    bool ranked = git_ctx->commits_ranked && git_ctx->commit_count > 0 &&
+                  git_ctx->commits[0].relevance > 0;
+    size_t shown = 0;
+    
+    if (git_ctx->commit_count > 0) {
+        if (ranked) {
+            tm_strbuf_append(&sb, "**Commits changing code near the failing lines (most relevant first):**\n");
+        } else {
+            tm_strbuf_append(&sb, git_ctx->incident_time > 0
+                ? "**Commits before the incident affecting error files (latest first):**\n"
+                : "**Recent commits affecting error files:**\n");
+        }
+        
+        size_t limit = ranked ? REPO_SUMMARY_RANKED_COMMITS : 10;
+        for (size_t i = 0; i < git_ctx->commit_count && i < limit; i++) {
+            const tm_git_commit_t *c = &git_ctx->commits[i];
+            if (ranked && c->relevance <= 0) break;
+            shown++;
+            
+            /* Get first line of message */
+            const char *msg = c->message;
+            const char *newline = msg ? strchr(msg, '\n') : NULL;
+            size_t msg_len = newline ? (size_t)(newline - msg) : (msg ? strlen(msg) : 0);
+            if (msg_len > 80) msg_len = 80;
+            
+            tm_strbuf_appendf(&sb, "- `%.7s` ", c->sha);
+            if (msg && msg_len > 0) {
+                tm_strbuf_append_len(&sb, msg, msg_len);
+            }
+            
+            if (c->touches_config) tm_strbuf_append(&sb, " **[CONFIG]**");
+            if (c->touches_schema) tm_strbuf_append(&sb, " **[SCHEMA]**");
+            
+            tm_strbuf_appendf(&sb, " (+%d/-%d", c->additions, c->deletions);
+            if (git_ctx->incident_time > 0 && c->timestamp <= git_ctx->incident_time) {
+                tm_strbuf_append(&sb, ", ");
+                append_lead_time(&sb, git_ctx->incident_time - c->timestamp);
+                tm_strbuf_append(&sb, " before incident");
+            }
+            if (ranked) tm_strbuf_appendf(&sb, ", relevance %d", c->relevance);
+            tm_strbuf_append(&sb, ")\n");
+        }
+        if (ranked && shown < git_ctx->commit_count) {
+            tm_strbuf_appendf(&sb, "_%zu other commits touched these files further from the failing lines._\n",
+                              git_ctx->commit_count - shown);
+        }
+        tm_strbuf_append(&sb, "\n");
+    }
+    
+    /* Hunks of the most relevant commits */
+    for (size_t i = 0, hunks = 0; ranked && i < shown && hunks < REPO_SUMMARY_HUNK_COMMITS; i++) {
+        const tm_git_commit_t *c = &git_ctx->commits[i];
+        if (!c->relevant_hunks) continue;
+        
+        tm_strbuf_appendf(&sb, "**Changes in `%.7s` near the failing lines:**\n```diff\n%s```\n\n",
+                          c->sha, c->relevant_hunks);
+        hunks++;
+    }
+    
+    return tm_strbuf_finish(&sb);
+}
+
 /* ============================================================================
  * Generic Log Analysis Prompts (Format-Agnostic)
  * ========================================================================== */
@@ -325,10 +503,6 @@ char *tm_build_generic_system_prompt(tm_log_format_t format)
         "You are TraceMind, an expert log analysis assistant. Your role is to analyze "
         "logs of any format to identify errors, anomalies, and root causes.\n\n"
         
-        "DETECTED LOG FORMAT: ");
-    tm_strbuf_append(&sb, format_name);
-    tm_strbuf_append(&sb, "\n\n"
-        
         "ANALYSIS MODES:\n"
         "1. ERROR DIAGNOSIS - Identify root cause of errors/failures\n"
         "2. ANOMALY DETECTION - Identify unusual patterns or behaviors\n"
@@ -367,6 +541,10 @@ char *tm_build_generic_system_prompt(tm_log_format_t format)
         "5. Configuration or deployment indicators"
     );
     
+    /* Format-specific line goes last so the text above stays byte-identical */
+    tm_strbuf_append(&sb, "\n\nDETECTED LOG FORMAT: ");
+    tm_strbuf_append(&sb, format_name);
+    
     return tm_strbuf_finish(&sb);
 }
 
@@ -447,30 +625,10 @@ char *tm_build_generic_log_prompt(const tm_generic_analysis_ctx_t *ctx)
                           log->count - shown);
     }
     
-    /* Git context if available */
-    if (ctx->git_ctx && ctx->git_ctx->commit_count > 0) {
-        tm_strbuf_append(&sb, "## RECENT CHANGES\n\n");
-        tm_strbuf_appendf(&sb, "**Branch:** %s\n\n",
-                          ctx->git_ctx->current_branch ? ctx->git_ctx->current_branch : "unknown");
-        
-        tm_strbuf_append(&sb, "**Recent commits:**\n");
-        for (size_t i = 0; i < ctx->git_ctx->commit_count && i < 5; i++) {
-            const tm_git_commit_t *c = &ctx->git_ctx->commits[i];
-            const char *msg = c->message;
-            const char *nl = msg ? strchr(msg, '\n') : NULL;
-            size_t msg_len = nl ? (size_t)(nl - msg) : (msg ? strlen(msg) : 0);
-            if (msg_len > 60) msg_len = 60;
-            
-            tm_strbuf_appendf(&sb, "- `%.7s` ", c->sha);
-            if (msg && msg_len > 0) {
-                char *truncated = tm_strndup(msg, msg_len);
-                tm_strbuf_append(&sb, truncated);
-                TM_FREE(truncated);
-            }
-            if (c->touches_config) tm_strbuf_append(&sb, " **[CONFIG]**");
-            tm_strbuf_append(&sb, "\n");
-        }
-        tm_strbuf_append(&sb, "\n");
+    char *history = tm_build_commit_history(ctx->git_ctx);
+    if (history) {
+        tm_strbuf_append(&sb, history);
+        free(history);
     }
     
     /* Additional context */
@@ -553,6 +711,26 @@ char *tm_openai_build_request(const tm_chat_request_t *request, const char *mode
     return result;
 }
 
+/*
+ * Anthropic content block. Messages flagged as cache breakpoints get an
+ * ephemeral cache_control marker so everything up to and including the
+ * block is eligible for the provider-side prompt cache.
+ */
+static json_t *anthropic_text_block(const tm_chat_message_t *msg)
+{
+    json_t *block = json_object();
+    json_object_set_new(block, "type", json_string("text"));
+    json_object_set_new(block, "text", json_string(msg->content));
+    
+    if (msg->cache_breakpoint) {
+        json_t *cache_control = json_object();
+        json_object_set_new(cache_control, "type", json_string("ephemeral"));
+        json_object_set_new(block, "cache_control", cache_control);
+    }
+    
+    return block;
+}
+
 char *tm_anthropic_build_request(const tm_chat_request_t *request, const char *model)
 {
     json_t *root = json_object();
@@ -561,26 +739,44 @@ char *tm_anthropic_build_request(const tm_chat_request_t *request, const char *m
     json_object_set_new(root, "max_tokens", 
                         json_integer(request->max_tokens > 0 ? request->max_tokens : DEFAULT_MAX_TOKENS));
     
-    /* Extract system message */
+    /* System messages become system content blocks, in order */
+    json_t *system = json_array();
     for (size_t i = 0; i < request->message_count; i++) {
         if (request->messages[i].role == TM_ROLE_SYSTEM) {
-            json_object_set_new(root, "system", json_string(request->messages[i].content));
-            break;
+            json_array_append_new(system, anthropic_text_block(&request->messages[i]));
         }
     }
+    if (json_array_size(system) > 0) {
+        json_object_set_new(root, "system", system);
+    } else {
+        json_decref(system);
+    }
     
-    /* Messages array (non-system) */
+    /* Messages array (non-system); consecutive same-role messages are merged
+     * into one message with several content blocks */
     json_t *messages = json_array();
+    json_t *prev_content = NULL;
+    tm_message_role_t prev_role = TM_ROLE_SYSTEM;
+    
     for (size_t i = 0; i < request->message_count; i++) {
-        if (request->messages[i].role == TM_ROLE_SYSTEM) continue;
+        const tm_chat_message_t *m = &request->messages[i];
+        if (m->role == TM_ROLE_SYSTEM) continue;
+        
+        if (prev_content && m->role == prev_role) {
+            json_array_append_new(prev_content, anthropic_text_block(m));
+            continue;
+        }
         
         json_t *msg = json_object();
         
-        const char *role = request->messages[i].role == TM_ROLE_ASSISTANT ? "assistant" : "user";
+        const char *role = m->role == TM_ROLE_ASSISTANT ? "assistant" : "user";
         
         json_object_set_new(msg, "role", json_string(role));
-        json_object_set_new(msg, "content", json_string(request->messages[i].content));
+        prev_content = json_array();
+        json_array_append_new(prev_content, anthropic_text_block(m));
+        json_object_set_new(msg, "content", prev_content);
         json_array_append_new(messages, msg);
+        prev_role = m->role;
     }
     json_object_set_new(root, "messages", messages);
     
@@ -649,6 +845,13 @@ tm_error_t tm_openai_parse_response(const char *json_str, tm_chat_response_t **r
         if (completion && json_is_integer(completion)) {
             resp->completion_tokens = (int)json_integer_value(completion);
         }
+        
+        /* Automatic prefix caching reports hits under prompt_tokens_details */
+        json_t *details = json_object_get(usage, "prompt_tokens_details");
+        json_t *cached = json_object_get(details, "cached_tokens");
+        if (cached && json_is_integer(cached)) {
+            resp->cached_tokens = (int)json_integer_value(cached);
+        }
     }
     
     /* Extract model */
@@ -718,6 +921,8 @@ tm_error_t tm_anthropic_parse_response(const char *json_str, tm_chat_response_t
     if (usage) {
         json_t *input = json_object_get(usage, "input_tokens");
         json_t *output = json_object_get(usage, "output_tokens");
+        json_t *cache_read = json_object_get(usage, "cache_read_input_tokens");
+        json_t *cache_write = json_object_get(usage, "cache_creation_input_tokens");
         
         if (input && json_is_integer(input)) {
             resp->prompt_tokens = (int)json_integer_value(input);
@@ -725,6 +930,17 @@ tm_error_t tm_anthropic_parse_response(const char *json_str, tm_chat_response_t
         if (output && json_is_integer(output)) {
             resp->completion_tokens = (int)json_integer_value(output);
         }
+        
+        /* input_tokens excludes cached tokens; fold them back in so
+         * prompt_tokens means the same thing for every provider */
+        if (cache_read && json_is_integer(cache_read)) {
+            resp->cached_tokens = (int)json_integer_value(cache_read);
+            resp->prompt_tokens += resp->cached_tokens;
+        }
+        if (cache_write && json_is_integer(cache_write)) {
+            resp->cache_write_tokens = (int)json_integer_value(cache_write);
+            resp->prompt_tokens += resp->cache_write_tokens;
+        }
     }
     
     /* Extract model */
@@ -758,6 +974,29 @@ void tm_chat_response_free(tm_chat_response_t *response)
  * Main LLM Chat Function
  * ========================================================================== */
 
+struct curl_slist *tm_llm_auth_headers(const tm_llm_client_t *client,
+                                       struct curl_slist *headers)
+{
+    char auth_header[256];
+    switch (client->provider) {
+    case TM_LLM_OPENAI:
+    case TM_LLM_LOCAL:
+        if (client->api_key) {
+            snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", client->api_key);
+            headers = curl_slist_append(headers, auth_header);
+        }
+        break;
+    case TM_LLM_ANTHROPIC:
+        if (client->api_key) {
+            snprintf(auth_header, sizeof(auth_header), "x-api-key: %s", client->api_key);
+            headers = curl_slist_append(headers, auth_header);
+        }
+        headers = curl_slist_append(headers, "anthropic-version: 2023-06-01");
+        break;
+    }
+    return headers;
+}
+
 tm_error_t tm_llm_chat(tm_llm_client_t *client,
                        const tm_chat_request_t *request,
                        tm_chat_response_t **response)
@@ -788,6 +1027,15 @@ tm_error_t tm_llm_chat(tm_llm_client_t *client,
     
     TM_DEBUG("Request body: %.200s...", body);
     
+    /* Client-side rate limiting: reserve prompt + completion budget */
+    if (client->limiter) {
+        int tokens = request->max_tokens > 0 ? request->max_tokens : DEFAULT_MAX_TOKENS;
+        for (size_t i = 0; i < request->message_count; i++) {
+            tokens += tm_estimate_tokens(request->messages[i].content);
+        }
+        tm_rate_limiter_acquire(client->limiter, tokens);
+    }
+    
     /* Set up CURL */
     CURL *curl = client->curl;
     curl_easy_reset(curl);
@@ -796,23 +1044,7 @@ tm_error_t tm_llm_chat(tm_llm_client_t *client,
     struct curl_slist *headers = NULL;
     headers = curl_slist_append(headers, "Content-Type: application/json");
     
-    char auth_header[256];
-    switch (client->provider) {
-    case TM_LLM_OPENAI:
-    case TM_LLM_LOCAL:
-        if (client->api_key) {
-            snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", client->api_key);
-            headers = curl_slist_append(headers, auth_header);
-        }
-        break;
-    case TM_LLM_ANTHROPIC:
-        if (client->api_key) {
-            snprintf(auth_header, sizeof(auth_header), "x-api-key: %s", client->api_key);
-            headers = curl_slist_append(headers, auth_header);
-        }
-        headers = curl_slist_append(headers, "anthropic-version: 2023-06-01");
-        break;
-    }
+    headers = tm_llm_auth_headers(client, headers);
     
     /* Response buffer */
     response_buffer_t buf = { .data = NULL, .size = 0 };
@@ -867,10 +1099,97 @@ tm_error_t tm_llm_chat(tm_llm_client_t *client,
         err = TM_ERR_INTERNAL;
     }
     
+    if (err == TM_OK) {
+        TM_DEBUG("Prompt cache: %d/%d prompt tokens cached, %d written",
+                 (*response)->cached_tokens, (*response)->prompt_tokens,
+                 (*response)->cache_write_tokens);
+    }
+    
     TM_FREE(buf.data);
     return err;
 }
 
+/* ============================================================================
+ * Rate Limiting
+ * ========================================================================== */
+
+/* Two token buckets (requests, tokens), each refilled continuously at
+ * its per-minute rate with one minute of burst capacity */
+struct tm_rate_limiter {
+    pthread_mutex_t lock;
+    double rpm;
+    double tpm;
+    double request_budget;
+    double token_budget;
+    int64_t last_refill_ms;
+};
+
+tm_rate_limiter_t *tm_rate_limiter_new(int requests_per_minute, int tokens_per_minute)
+{
+    if (requests_per_minute <= 0 && tokens_per_minute <= 0) return NULL;
+    
+    tm_rate_limiter_t *rl = tm_calloc(1, sizeof(tm_rate_limiter_t));
+    pthread_mutex_init(&rl->lock, NULL);
+    rl->rpm = requests_per_minute > 0 ? requests_per_minute : 0;
+    rl->tpm = tokens_per_minute > 0 ? tokens_per_minute : 0;
+    rl->request_budget = rl->rpm;
+    rl->token_budget = rl->tpm;
+    rl->last_refill_ms = tm_timestamp_ms();
+    
+    return rl;
+}
+
+void tm_rate_limiter_acquire(tm_rate_limiter_t *rl, int tokens)
+{
+    if (!rl) return;
+    
+    /* A single oversized request may use the whole minute's budget */
+    double need_tokens = rl->tpm > 0 ? TM_MIN((double)tokens, rl->tpm) : 0;
+    
+    for (;;) {
+        pthread_mutex_lock(&rl->lock);
+        
+        int64_t now = tm_timestamp_ms();
+        double minutes = (double)(now - rl->last_refill_ms) / 60000.0;
+        rl->last_refill_ms = now;
+        if (rl->rpm > 0) {
+            rl->request_budget = TM_MIN(rl->rpm, rl->request_budget + minutes * rl->rpm);
+        }
+        if (rl->tpm > 0) {
+            rl->token_budget = TM_MIN(rl->tpm, rl->token_budget + minutes * rl->tpm);
+        }
+        
+        double wait_ms = 0;
+        if (rl->rpm > 0 && rl->request_budget < 1.0) {
+            wait_ms = TM_MAX(wait_ms, (1.0 - rl->request_budget) / rl->rpm * 60000.0);
+        }
+        if (rl->tpm > 0 && rl->token_budget < need_tokens) {
+            wait_ms = TM_MAX(wait_ms, (need_tokens - rl->token_budget) / rl->tpm * 60000.0);
+        }
+        
+        if (wait_ms <= 0) {
+            if (rl->rpm > 0) rl->request_budget -= 1.0;
+            if (rl->tpm > 0) rl->token_budget -= need_tokens;
+            pthread_mutex_unlock(&rl->lock);
+            return;
+        }
+        
+        pthread_mutex_unlock(&rl->lock);
+        
+        TM_DEBUG("Rate limiter: waiting %.0f ms", wait_ms);
+        long ms = (long)wait_ms + 1;
+        struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (ms % 1000) * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+}
+
+void tm_rate_limiter_free(tm_rate_limiter_t *rl)
+{
+    if (!rl) return;
+    pthread_mutex_destroy(&rl->lock);
+    free(rl);
+}
+
 /* ============================================================================
  * Retry Logic
  * ========================================================================== */
@@ -953,122 +1272,251 @@ void tm_hypothesis_free(tm_hypothesis_t *h)
     free(h);
 }
 
-tm_error_t tm_parse_hypotheses(const char *response_text,
-                               tm_hypothesis_t ***hypotheses,
-                               size_t *count)
+/* Build a hypothesis from one element of the "hypotheses" array */
+static tm_hypothesis_t *hypothesis_from_json(json_t *hyp, size_t index)
 {
-    TM_CHECK_NULL(response_text, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(hypotheses, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    tm_hypothesis_t *h = tm_calloc(1, sizeof(tm_hypothesis_t));
+    json_t *val;
     
-    *hypotheses = NULL;
-    *count = 0;
+    val = json_object_get(hyp, "rank");
+    h->rank = val && json_is_integer(val) ? (int)json_integer_value(val) : (int)(index + 1);
     
-    json_error_t error;
-    json_t *root = json_loads(response_text, 0, &error);
+    val = json_object_get(hyp, "confidence");
+    h->confidence = val && json_is_integer(val) ? (int)json_integer_value(val) : 50;
     
-    if (!root) {
-        TM_ERROR("Failed to parse hypothesis JSON: %s", error.text);
-        return TM_ERR_PARSE;
+    val = json_object_get(hyp, "title");
+    h->title = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
+    
+    val = json_object_get(hyp, "explanation");
+    h->explanation = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
+    
+    val = json_object_get(hyp, "evidence");
+    h->evidence = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
+    
+    val = json_object_get(hyp, "next_step");
+    h->next_step = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
+    
+    /* Fix suggestion */
+    val = json_object_get(hyp, "fix_suggestion");
+    h->fix_suggestion = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
+    
+    /* Debug commands */
+    val = json_object_get(hyp, "debug_commands");
+    if (val && json_is_array(val)) {
+        h->debug_command_count = json_array_size(val);
+        if (h->debug_command_count > 0) {
+            h->debug_commands = tm_malloc(h->debug_command_count * sizeof(char *));
+            for (size_t j = 0; j < h->debug_command_count; j++) {
+                json_t *cmd = json_array_get(val, j);
+                h->debug_commands[j] = json_is_string(cmd) ? tm_strdup(json_string_value(cmd)) : NULL;
+            }
+        }
     }
     
-    json_t *hyp_array = json_object_get(root, "hypotheses");
-    if (!hyp_array || !json_is_array(hyp_array)) {
-        TM_ERROR("Missing 'hypotheses' array in response");
-        json_decref(root);
-        return TM_ERR_PARSE;
+    /* Similar errors */
+    val = json_object_get(hyp, "similar_errors");
+    h->similar_errors = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
+    
+    /* Related files */
+    val = json_object_get(hyp, "related_files");
+    if (val && json_is_array(val)) {
+        h->related_file_count = json_array_size(val);
+        if (h->related_file_count > 0) {
+            h->related_files = tm_malloc(h->related_file_count * sizeof(char *));
+            for (size_t j = 0; j < h->related_file_count; j++) {
+                json_t *f = json_array_get(val, j);
+                h->related_files[j] = json_is_string(f) ? tm_strdup(json_string_value(f)) : NULL;
+            }
+        }
     }
     
-    size_t array_size = json_array_size(hyp_array);
-    if (array_size == 0) {
-        json_decref(root);
-        return TM_OK;
+    /* Related commits */
+    val = json_object_get(hyp, "related_commits");
+    if (val && json_is_array(val)) {
+        h->related_commit_count = json_array_size(val);
+        if (h->related_commit_count > 0) {
+            h->related_commits = tm_malloc(h->related_commit_count * sizeof(char *));
+            for (size_t j = 0; j < h->related_commit_count; j++) {
+                json_t *c = json_array_get(val, j);
+                h->related_commits[j] = json_is_string(c) ? tm_strdup(json_string_value(c)) : NULL;
+            }
+        }
     }
     
-    tm_hypothesis_t **result = tm_calloc(array_size, sizeof(tm_hypothesis_t *));
+    return h;
+}
+
+void tm_hypothesis_parser_init(tm_hypothesis_parser_t *parser)
+{
+    memset(parser, 0, sizeof(*parser));
+    tm_strbuf_init(&parser->text);
+}
+
+/* Parse the array element text[start, end) and keep it if it is an object */
+static void parser_emit_element(tm_hypothesis_parser_t *p, size_t start, size_t end)
+{
+    json_error_t error;
+    json_t *hyp = json_loadb(p->text.data + start, end - start, 0, &error);
     
-    for (size_t i = 0; i < array_size; i++) {
-        json_t *hyp = json_array_get(hyp_array, i);
-        tm_hypothesis_t *h = tm_calloc(1, sizeof(tm_hypothesis_t));
-        result[i] = h;
-        
-        json_t *val;
-        
-        val = json_object_get(hyp, "rank");
-        h->rank = val && json_is_integer(val) ? (int)json_integer_value(val) : (int)(i + 1);
-        
-        val = json_object_get(hyp, "confidence");
-        h->confidence = val && json_is_integer(val) ? (int)json_integer_value(val) : 50;
-        
-        val = json_object_get(hyp, "title");
-        h->title = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
-        
-        val = json_object_get(hyp, "explanation");
-        h->explanation = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
-        
-        val = json_object_get(hyp, "evidence");
-        h->evidence = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
-        
-        val = json_object_get(hyp, "next_step");
-        h->next_step = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
-        
-        /* Fix suggestion */
-        val = json_object_get(hyp, "fix_suggestion");
-        h->fix_suggestion = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
+    if (!hyp || !json_is_object(hyp)) {
+        TM_WARN("Skipping malformed hypothesis: %s", hyp ? "not an object" : error.text);
+        json_decref(hyp);
+        return;
+    }
+    
+    tm_hypothesis_t *h = hypothesis_from_json(hyp, p->count);
+    TM_VEC_PUSH(p->hypotheses, p->count, p->cap, h);
+    json_decref(hyp);
+}
+
+/*
+ * Bracket-matching scanner over the text received so far. Anything outside
+ * the object that holds the "hypotheses" array (prose, markdown fences) is
+ * skipped; each array element is handed to jansson as soon as its closing
+ * brace arrives, so a truncated tail only loses the element that was cut
+ * off. The array is recognized by its key at any depth, so an unbalanced
+ * brace in the prose before the JSON does not hide it.
+ */
+tm_error_t tm_hypothesis_parser_feed(tm_hypothesis_parser_t *parser,
+                                     const char *chunk,
+                                     size_t len)
+{
+    TM_CHECK_NULL(parser, TM_ERR_INVALID_ARG);
+    if (!chunk || len == 0) return TM_OK;
+    
+    tm_strbuf_append_len(&parser->text, chunk, len);
+    tm_hypothesis_parser_t *p = parser;
+    
+    for (; p->scan_pos < p->text.len && !p->complete; p->scan_pos++) {
+        size_t i = p->scan_pos;
+        char c = p->text.data[i];
         
-        /* Debug commands */
-        val = json_object_get(hyp, "debug_commands");
-        if (val && json_is_array(val)) {
-            h->debug_command_count = json_array_size(val);
-            if (h->debug_command_count > 0) {
-                h->debug_commands = tm_malloc(h->debug_command_count * sizeof(char *));
-                for (size_t j = 0; j < h->debug_command_count; j++) {
-                    json_t *cmd = json_array_get(val, j);
-                    h->debug_commands[j] = json_is_string(cmd) ? tm_strdup(json_string_value(cmd)) : NULL;
-                }
+        if (p->in_string) {
+            if (p->escape) {
+                p->escape = false;
+            } else if (c == '\\') {
+                p->escape = true;
+            } else if (c == '"') {
+                p->in_string = false;
+                p->key_start = p->string_start;
+                p->key_end = i;
+                p->key_depth = p->depth;
+                p->key_closed = true;
             }
+            continue;
         }
         
-        /* Similar errors */
-        val = json_object_get(hyp, "similar_errors");
-        h->similar_errors = val && json_is_string(val) ? tm_strdup(json_string_value(val)) : NULL;
+        if (p->depth == 0) {
+            /* Outside JSON: wait for the root object */
+            if (c == '{') p->depth = 1;
+            continue;
+        }
         
-        /* Related files */
-        val = json_object_get(hyp, "related_files");
-        if (val && json_is_array(val)) {
-            h->related_file_count = json_array_size(val);
-            if (h->related_file_count > 0) {
-                h->related_files = tm_malloc(h->related_file_count * sizeof(char *));
-                for (size_t j = 0; j < h->related_file_count; j++) {
-                    json_t *f = json_array_get(val, j);
-                    h->related_files[j] = json_is_string(f) ? tm_strdup(json_string_value(f)) : NULL;
-                }
-            }
+        /* A string is a key only if ':' follows it */
+        bool after_key = p->after_key;
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            p->after_key = c == ':' && p->key_closed;
+            p->key_closed = false;
         }
         
-        /* Related commits */
-        val = json_object_get(hyp, "related_commits");
-        if (val && json_is_array(val)) {
-            h->related_commit_count = json_array_size(val);
-            if (h->related_commit_count > 0) {
-                h->related_commits = tm_malloc(h->related_commit_count * sizeof(char *));
-                for (size_t j = 0; j < h->related_commit_count; j++) {
-                    json_t *c = json_array_get(val, j);
-                    h->related_commits[j] = json_is_string(c) ? tm_strdup(json_string_value(c)) : NULL;
+        switch (c) {
+            case '"':
+                p->in_string = true;
+                p->string_start = i + 1;
+                break;
+                
+            case '{':
+            case '[':
+                if (c == '[' && !p->in_array && after_key && p->key_depth == p->depth &&
+                    p->key_end - p->key_start == 10 &&
+                    memcmp(p->text.data + p->key_start, "hypotheses", 10) == 0) {
+                    p->in_array = true;
+                    p->found_array = true;
+                    p->array_depth = p->depth;
+                } else if (c == '{' && p->in_array && p->depth == p->array_depth + 1) {
+                    p->element_start = i;
                 }
-            }
+                p->depth++;
+                break;
+                
+            case '}':
+            case ']':
+                p->depth--;
+                if (p->in_array && p->depth == p->array_depth + 1 && c == '}') {
+                    parser_emit_element(p, p->element_start, i + 1);
+                } else if (p->in_array && p->depth == p->array_depth) {
+                    p->complete = true;
+                }
+                /* At depth 0 the root closed without a hypotheses array:
+                 * the next '{' starts a new search */
+                break;
+                
+            default:
+                break;
         }
-        
-        (*count)++;
     }
     
-    json_decref(root);
-    *hypotheses = result;
+    return TM_OK;
+}
+
+tm_error_t tm_hypothesis_parser_finish(tm_hypothesis_parser_t *parser,
+                                       tm_hypothesis_t ***hypotheses,
+                                       size_t *count)
+{
+    TM_CHECK_NULL(parser, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(hypotheses, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    
+    *hypotheses = NULL;
+    *count = 0;
+    
+    if (!parser->found_array) {
+        TM_ERROR("Missing 'hypotheses' array in response");
+        return TM_ERR_PARSE;
+    }
+    
+    if (!parser->complete) {
+        if (parser->count == 0) {
+            TM_ERROR("Hypothesis response truncated before the first hypothesis");
+            return TM_ERR_PARSE;
+        }
+        TM_WARN("Hypothesis response truncated; kept %zu complete hypotheses", parser->count);
+    }
+    
+    *hypotheses = parser->hypotheses;
+    *count = parser->count;
+    parser->hypotheses = NULL;
+    parser->count = parser->cap = 0;
     
     TM_DEBUG("Parsed %zu hypotheses", *count);
     return TM_OK;
 }
 
+void tm_hypothesis_parser_free(tm_hypothesis_parser_t *parser)
+{
+    if (!parser) return;
+    tm_hypotheses_free(parser->hypotheses, parser->count);
+    tm_strbuf_free(&parser->text);
+    memset(parser, 0, sizeof(*parser));
+}
+
+tm_error_t tm_parse_hypotheses(const char *response_text,
+                               tm_hypothesis_t ***hypotheses,
+                               size_t *count)
+{
+    TM_CHECK_NULL(response_text, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(hypotheses, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    
+    tm_hypothesis_parser_t parser;
+    tm_hypothesis_parser_init(&parser);
+    tm_hypothesis_parser_feed(&parser, response_text, strlen(response_text));
+    
+    tm_error_t err = tm_hypothesis_parser_finish(&parser, hypotheses, count);
+    tm_hypothesis_parser_free(&parser);
+    return err;
+}
+
 void tm_hypotheses_free(tm_hypothesis_t **hypotheses, size_t count)
 {
     if (!hypotheses) return;
@@ -1080,22 +1528,72 @@ void tm_hypotheses_free(tm_hypothesis_t **hypotheses, size_t count)
 }
 
 /* ============================================================================
- * Main Hypothesis Generation
+ * Hypothesis Requests
  * ========================================================================== */
 
-tm_error_t tm_llm_generate_hypotheses(tm_llm_client_t *client,
-                                      const tm_stack_trace_t *trace,
-                                      const tm_call_graph_t *call_graph,
-                                      const tm_git_context_t *git_ctx,
-                                      tm_hypothesis_t ***hypotheses,
-                                      size_t *count)
+/*
+ * Provider prompt caches match on exact prefixes, so hypothesis requests
+ * are laid out stable-first: system prompt, response schema, repository
+ * summary, then the volatile trace/log prompt. Each stable layer that ends
+ * a reusable prefix is flagged as a cache breakpoint.
+ */
+void tm_hypothesis_request_init(tm_hypothesis_request_t *hr,
+                                const tm_llm_client_t *client,
+                                char *system_prompt,
+                                char *repo_summary,
+                                char *user_prompt)
 {
-    TM_CHECK_NULL(client, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(hypotheses, TM_ERR_INVALID_ARG);
-    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    memset(hr, 0, sizeof(*hr));
     
-    *hypotheses = NULL;
-    *count = 0;
+    hr->system_prompt = system_prompt;
+    hr->repo_summary = repo_summary;
+    hr->user_prompt = user_prompt;
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_append(&sb, "RESPONSE JSON SCHEMA:\n");
+    tm_strbuf_append(&sb, TM_HYPOTHESIS_SCHEMA);
+    hr->schema = tm_strbuf_finish(&sb);
+    
+    size_t n = 0;
+    hr->messages[n++] = (tm_chat_message_t){
+        .role = TM_ROLE_SYSTEM, .content = system_prompt };
+    hr->messages[n++] = (tm_chat_message_t){
+        .role = TM_ROLE_SYSTEM, .content = hr->schema, .cache_breakpoint = true };
+    
+    if (repo_summary) {
+        hr->messages[n++] = (tm_chat_message_t){
+            .role = TM_ROLE_USER, .content = repo_summary, .cache_breakpoint = true };
+    }
+    
+    hr->messages[n++] = (tm_chat_message_t){
+        .role = TM_ROLE_USER, .content = user_prompt };
+    
+    hr->request = (tm_chat_request_t){
+        .messages = hr->messages,
+        .message_count = n,
+        .max_tokens = DEFAULT_MAX_TOKENS,
+        .temperature = client ? client->temperature : 0.3f
+    };
+}
+
+void tm_hypothesis_request_free(tm_hypothesis_request_t *hr)
+{
+    if (!hr) return;
+    TM_FREE(hr->system_prompt);
+    TM_FREE(hr->schema);
+    TM_FREE(hr->repo_summary);
+    TM_FREE(hr->user_prompt);
+}
+
+tm_error_t tm_llm_build_hypothesis_request(const tm_llm_client_t *client,
+                                           const tm_stack_trace_t *trace,
+                                           const tm_call_graph_t *call_graph,
+                                           const tm_git_context_t *git_ctx,
+                                           tm_hypothesis_request_t *hr)
+{
+    TM_CHECK_NULL(client, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(hr, TM_ERR_INVALID_ARG);
     
     /* Build analysis context */
     tm_analysis_context_t ctx = {
@@ -1107,35 +1605,108 @@ tm_error_t tm_llm_generate_hypotheses(tm_llm_client_t *client,
     
     /* Build prompts */
     char *system_prompt = tm_build_system_prompt();
+    char *repo_summary = tm_build_repo_summary(git_ctx);
     char *user_prompt = tm_build_analysis_prompt(&ctx);
     
     if (!system_prompt || !user_prompt) {
         TM_FREE(system_prompt);
+        TM_FREE(repo_summary);
         TM_FREE(user_prompt);
         return TM_ERR_NOMEM;
     }
     
-    /* Build chat request */
-    tm_chat_message_t messages[2] = {
-        { .role = TM_ROLE_SYSTEM, .content = system_prompt },
-        { .role = TM_ROLE_USER, .content = user_prompt }
-    };
+    tm_hypothesis_request_init(hr, client, system_prompt, repo_summary, user_prompt);
+    return TM_OK;
+}
+
+tm_error_t tm_llm_build_generic_hypothesis_request(const tm_llm_client_t *client,
+                                                   const tm_generic_log_t *log,
+                                                   const tm_git_context_t *git_ctx,
+                                                   tm_hypothesis_request_t *hr)
+{
+    TM_CHECK_NULL(client, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(log, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(hr, TM_ERR_INVALID_ARG);
     
-    tm_chat_request_t request = {
-        .messages = messages,
-        .message_count = 2,
-        .max_tokens = DEFAULT_MAX_TOKENS,
-        .temperature = client->temperature
+    bool errors_only = log->total_errors > 0;   /* Focus on errors if present */
+    
+    /* Estimate the relevant entries; if they do not fit one request's
+     * budget, the caller must summarize partitions first */
+    size_t relevant = 0;
+    size_t relevant_chars = 0;
+    for (size_t i = 0; i < log->count; i++) {
+        const tm_generic_log_entry_t *e = &log->entries[i];
+        if (errors_only && !e->is_error && !e->is_anomaly) continue;
+        const char *text = e->raw_line ? e->raw_line : e->message;
+        relevant_chars += (text ? strlen(text) : 0) + GENERIC_ENTRY_OVERHEAD_CHARS;
+        relevant++;
+    }
+    
+    int entry_budget = client->context_tokens - GENERIC_PROMPT_OVERHEAD_TOKENS;
+    if (relevant > 0 && (int)(relevant_chars / 4) > entry_budget) {
+        TM_INFO("Log exceeds context budget (%zu entries, ~%zu tokens)",
+                relevant, relevant_chars / 4);
+        return TM_ERR_UNSUPPORTED;
+    }
+    
+    /* Build generic analysis context */
+    tm_generic_analysis_ctx_t ctx = {
+        .log = log,
+        .git_ctx = git_ctx,
+        .additional_context = NULL,
+        .max_entries = relevant > 0 ? relevant : 50,  /* Everything that fits the budget */
+        .include_raw_lines = true,        /* Include raw lines for context */
+        .errors_only = errors_only
     };
     
+    /* Build format-aware prompts */
+    char *system_prompt = tm_build_generic_system_prompt(log->detected_format);
+    char *repo_summary = tm_build_repo_summary(git_ctx);
+    char *user_prompt = tm_build_generic_log_prompt(&ctx);
+    
+    if (!system_prompt || !user_prompt) {
+        TM_FREE(system_prompt);
+        TM_FREE(repo_summary);
+        TM_FREE(user_prompt);
+        return TM_ERR_NOMEM;
+    }
+    
+    TM_DEBUG("Generic log prompt: %d estimated tokens", tm_estimate_tokens(user_prompt));
+    
+    tm_hypothesis_request_init(hr, client, system_prompt, repo_summary, user_prompt);
+    return TM_OK;
+}
+
+/* ============================================================================
+ * Main Hypothesis Generation
+ * ========================================================================== */
+
+tm_error_t tm_llm_generate_hypotheses(tm_llm_client_t *client,
+                                      const tm_stack_trace_t *trace,
+                                      const tm_call_graph_t *call_graph,
+                                      const tm_git_context_t *git_ctx,
+                                      tm_hypothesis_t ***hypotheses,
+                                      size_t *count)
+{
+    TM_CHECK_NULL(client, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(hypotheses, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+    
+    *hypotheses = NULL;
+    *count = 0;
+    
+    /* Build chat request, stable layers first */
+    tm_hypothesis_request_t hr;
+    tm_error_t err = tm_llm_build_hypothesis_request(client, trace, call_graph, git_ctx, &hr);
+    if (err != TM_OK) return err;
+    
     /* Send request with retry */
     tm_retry_config_t retry_cfg = tm_default_retry_config();
     tm_chat_response_t *response = NULL;
     
-    tm_error_t err = tm_llm_chat_with_retry(client, &request, &retry_cfg, &response);
+    err = tm_llm_chat_with_retry(client, &hr.request, &retry_cfg, &response);
     
-    TM_FREE(system_prompt);
-    TM_FREE(user_prompt);
+    tm_hypothesis_request_free(&hr);
     
     if (err != TM_OK) {
         TM_ERROR("LLM request failed: %s", tm_strerror(err));
@@ -1175,49 +1746,23 @@ tm_error_t tm_llm_generate_generic_hypotheses(tm_llm_client_t *client,
     *hypotheses = NULL;
     *count = 0;
     
-    /* Build generic analysis context */
-    tm_generic_analysis_ctx_t ctx = {
-        .log = log,
-        .git_ctx = git_ctx,
-        .additional_context = NULL,
-        .max_entries = 50,                /* Limit entries to control token usage */
-        .include_raw_lines = true,        /* Include raw lines for context */
-        .errors_only = (log->total_errors > 0)  /* Focus on errors if present */
-    };
-    
-    /* Build format-aware prompts */
-    char *system_prompt = tm_build_generic_system_prompt(log->detected_format);
-    char *user_prompt = tm_build_generic_log_prompt(&ctx);
-    
-    if (!system_prompt || !user_prompt) {
-        TM_FREE(system_prompt);
-        TM_FREE(user_prompt);
-        return TM_ERR_NOMEM;
+    /* Build chat request, stable layers first; logs that do not fit one
+     * request's budget are summarized in partitions instead of truncated */
+    tm_hypothesis_request_t hr;
+    tm_error_t err = tm_llm_build_generic_hypothesis_request(client, log, git_ctx, &hr);
+    if (err == TM_ERR_UNSUPPORTED) {
+        TM_INFO("Using map-reduce for oversized log");
+        return tm_llm_map_reduce_hypotheses(client, log, git_ctx, hypotheses, count);
     }
-    
-    TM_DEBUG("Generic log prompt: %d estimated tokens", tm_estimate_tokens(user_prompt));
-    
-    /* Build chat request */
-    tm_chat_message_t messages[2] = {
-        { .role = TM_ROLE_SYSTEM, .content = system_prompt },
-        { .role = TM_ROLE_USER, .content = user_prompt }
-    };
-    
-    tm_chat_request_t request = {
-        .messages = messages,
-        .message_count = 2,
-        .max_tokens = DEFAULT_MAX_TOKENS,
-        .temperature = client->temperature
-    };
+    if (err != TM_OK) return err;
     
     /* Send request with retry */
     tm_retry_config_t retry_cfg = tm_default_retry_config();
     tm_chat_response_t *response = NULL;
     
-    tm_error_t err = tm_llm_chat_with_retry(client, &request, &retry_cfg, &response);
+    err = tm_llm_chat_with_retry(client, &hr.request, &retry_cfg, &response);
     
-    TM_FREE(system_prompt);
-    TM_FREE(user_prompt);
+    tm_hypothesis_request_free(&hr);
     
     if (err != TM_OK) {
         TM_ERROR("LLM request failed for generic log: %s", tm_strerror(err));
@@ -1323,25 +1868,15 @@ tm_error_t tm_llm_explain_error(tm_llm_client_t *client,
         "Respond with JSON matching the schema in your system prompt.",
         error_msg);
     
-    tm_chat_message_t messages[2] = {
-        { .role = TM_ROLE_SYSTEM, .content = system_prompt },
-        { .role = TM_ROLE_USER,   .content = user_prompt }
-    };
-    
-    tm_chat_request_t request = {
-        .messages = messages,
-        .message_count = 2,
-        .max_tokens = DEFAULT_MAX_TOKENS,
-        .temperature = client->temperature
-    };
+    tm_hypothesis_request_t hr;
+    tm_hypothesis_request_init(&hr, client, system_prompt, NULL, user_prompt);
     
     tm_retry_config_t retry_cfg = tm_default_retry_config();
     tm_chat_response_t *response = NULL;
     
-    tm_error_t err = tm_llm_chat_with_retry(client, &request, &retry_cfg, &response);
+    tm_error_t err = tm_llm_chat_with_retry(client, &hr.request, &retry_cfg, &response);
     
-    TM_FREE(system_prompt);
-    TM_FREE(user_prompt);
+    tm_hypothesis_request_free(&hr);
     
     if (err != TM_OK) {
         TM_ERROR("LLM explain request failed: %s", tm_strerror(err));
@@ -10,11 +10,13 @@
 
 #include "tracemind.h"
 #include "internal/common.h"
+#include "internal/input_format.h"
 #include "internal/output.h"
 #include <getopt.h>
 #include <signal.h>
 #include <strings.h>
 #include <sys/ioctl.h>
+#include <time.h>
 
 /* ============================================================================
  * Version and Help
@@ -28,6 +30,7 @@ static const char *HELP_TEXT =
 "USAGE:\n"
 "    tracemind <file>                 Analyze a log / stack trace\n"
 "    tracemind explain \"<error>\"      Explain an error message\n"
+"    tracemind batch <files...>       Triage many files via the batch API\n"
 "    cat log.txt | tracemind          Pipe logs for analysis\n"
 "\n"
 "COMMANDS:\n"
@@ -35,6 +38,7 @@ static const char *HELP_TEXT =
 "    analyze     Alias for default — analyze a file\n"
 "    explain     Quick explanation of an error string\n"
 "    config      Show current configuration\n"
+"    batch       Submit files as one provider batch (cheaper, async)\n"
 "\n"
 "OPTIONS:\n"
 "    -i, --interactive        Follow-up mode: drill into hypotheses\n"
@@ -45,7 +49,11 @@ static const char *HELP_TEXT =
 "    -f, --format <type>      Input: auto, raw, json, csv\n"
 "    -r, --repo <path>        Repository path (auto-detected)\n"
 "    -c, --config <file>      Config file path\n"
+"    --incident-time <time>   Incident time (ISO 8601 or epoch; default: first error in the log)\n"
+"    --window <hours>         Only consider commits this long before the incident (0 = all)\n"
 "    --no-color               Disable colored output\n"
+"    --batch-name <name>      Batch to create or resume (default: batch-YYYYMMDD)\n"
+"    --no-wait                Submit/poll once and exit; rerun to collect\n"
 "    -v, --verbose            Verbose / debug output\n"
 "    -h, --help               Show this help\n"
 "    --version                Show version\n"
@@ -57,6 +65,7 @@ static const char *HELP_TEXT =
 "    python app.py 2>&1 | tracemind\n"
 "    tracemind crash.log -o markdown > report.md\n"
 "    kubectl logs pod | tracemind -f json\n"
+"    tracemind batch crashes/*.log --batch-name nightly\n"
 "\n"
 "ENVIRONMENT:\n"
 "    OPENAI_API_KEY / ANTHROPIC_API_KEY    API key\n"
@@ -94,11 +103,15 @@ static struct option long_options[] = {
     {"verbose",     no_argument,       0, 'v'},
     {"help",        no_argument,       0, 'h'},
     {"version",     no_argument,       0, 'V'},
+    {"batch-name",  required_argument, 0, 'B'},
+    {"no-wait",     no_argument,       0, 'W'},
+    {"incident-time", required_argument, 0, 'I'},
+    {"window",      required_argument, 0, 'w'},
     {0, 0, 0, 0}
 };
 
 typedef struct {
-    const char *command;       /* "analyze", "explain", "config", or NULL */
+    const char *command;       /* "analyze", "explain", "config", "batch", or NULL */
     const char *input_file;    /* file path, "-", or error string for explain */
     const char *provider;
     const char *model;
@@ -107,11 +120,17 @@ typedef struct {
     const char *input_format;
     const char *repo_path;
     const char *config_path;
+    const char *batch_name;
+    const char *incident_time;
+    const char *window;
+    const char **batch_inputs; /* Positional files for "batch" */
+    size_t batch_input_count;
     bool interactive;
     bool no_color;
     bool verbose;
     bool help;
     bool version;
+    bool no_wait;
 } cli_args_t;
 
 /**
@@ -122,6 +141,7 @@ static bool is_command(const char *arg)
     return (strcmp(arg, "analyze") == 0 ||
             strcmp(arg, "explain") == 0 ||
             strcmp(arg, "config") == 0 ||
+            strcmp(arg, "batch") == 0 ||
             strcmp(arg, "version") == 0 ||
             strcmp(arg, "help") == 0);
 }
@@ -148,6 +168,10 @@ static cli_args_t parse_args(int argc, char **argv)
             case 'v': args.verbose = true; break;
             case 'h': args.help = true; break;
             case 'V': args.version = true; break;
+            case 'B': args.batch_name = optarg; break;
+            case 'W': args.no_wait = true; break;
+            case 'I': args.incident_time = optarg; break;
+            case 'w': args.window = optarg; break;
             default:
                 break;
         }
@@ -159,7 +183,12 @@ static cli_args_t parse_args(int argc, char **argv)
     if (optind < argc) {
         if (is_command(argv[optind])) {
             args.command = argv[optind++];
-            if (optind < argc) {
+            if (strcmp(args.command, "batch") == 0) {
+                /* Every remaining positional is an input file */
+                args.batch_inputs = (const char **)&argv[optind];
+                args.batch_input_count = (size_t)(argc - optind);
+                optind = argc;
+            } else if (optind < argc) {
                 args.input_file = argv[optind++];
             }
         } else {
@@ -248,7 +277,11 @@ static void setup_signals(void)
  * Commands
  * ========================================================================== */
 
-static int cmd_analyze(cli_args_t *args)
+/**
+ * Build the configuration from file, environment and CLI flags.
+ * Prints the problem and returns NULL on invalid flags or a missing key.
+ */
+static tm_config_t *build_config(cli_args_t *args)
 {
     /* Create and configure */
     tm_config_t *config = tm_config_new();
@@ -270,7 +303,7 @@ static int cmd_analyze(cli_args_t *args)
         } else {
             fprintf(stderr, "Unknown provider: %s\n", args->provider);
             tm_config_free(config);
-            return 1;
+            return NULL;
         }
     }
     
@@ -294,7 +327,7 @@ static int cmd_analyze(cli_args_t *args)
         } else {
             fprintf(stderr, "Unknown output format: %s\n", args->output_format);
             tm_config_free(config);
-            return 1;
+            return NULL;
         }
     }
     
@@ -311,7 +344,7 @@ static int cmd_analyze(cli_args_t *args)
             fprintf(stderr, "Unknown input format: %s\n", args->input_format);
             fprintf(stderr, "Supported formats: auto, raw, json, csv\n");
             tm_config_free(config);
-            return 1;
+            return NULL;
         }
     }
     
@@ -320,6 +353,26 @@ static int cmd_analyze(cli_args_t *args)
         config->repo_path = tm_strdup(args->repo_path);
     }
     
+    if (args->incident_time) {
+        if (!tm_parse_timestamp(args->incident_time, &config->incident_time)) {
+            fprintf(stderr, "Invalid incident time: %s\n", args->incident_time);
+            fprintf(stderr, "Use ISO 8601 (2024-01-15T10:30:00Z) or Unix seconds\n");
+            tm_config_free(config);
+            return NULL;
+        }
+    }
+    
+    if (args->window) {
+        char *end = NULL;
+        long hours = strtol(args->window, &end, 10);
+        if (!end || *end != '\0' || hours < 0) {
+            fprintf(stderr, "Invalid window: %s (expected hours)\n", args->window);
+            tm_config_free(config);
+            return NULL;
+        }
+        config->incident_window_hours = (int)hours;
+    }
+    
     if (args->no_color) {
         config->color_output = false;
     }
@@ -330,14 +383,23 @@ static int cmd_analyze(cli_args_t *args)
     }
     
     /* Check for API key */
-    if (!config->api_key || strlen(config->api_key) == 0) {
+    if (tm_config_needs_api_key(config) &&
+        (!config->api_key || strlen(config->api_key) == 0)) {
         fprintf(stderr, "Error: No API key configured.\n");
         fprintf(stderr, "Set OPENAI_API_KEY or ANTHROPIC_API_KEY environment variable,\n");
         fprintf(stderr, "or use --api-key option.\n");
         tm_config_free(config);
-        return 1;
+        return NULL;
     }
     
+    return config;
+}
+
+static int cmd_analyze(cli_args_t *args)
+{
+    tm_config_t *config = build_config(args);
+    if (!config) return 1;
+    
     /* Create analyzer */
     tm_analyzer_t *analyzer = tm_analyzer_new(config);
     if (!analyzer) {
@@ -434,7 +496,8 @@ static int cmd_explain(cli_args_t *args)
     if (args->no_color) config->color_output = false;
     if (args->verbose) { config->verbose = true; g_log_level = TM_LOG_DEBUG; }
     
-    if (!config->api_key || strlen(config->api_key) == 0) {
+    if (tm_config_needs_api_key(config) &&
+        (!config->api_key || strlen(config->api_key) == 0)) {
         fprintf(stderr, "Error: No API key configured.\n");
         fprintf(stderr, "Set OPENAI_API_KEY or ANTHROPIC_API_KEY, or use --api-key.\n");
         tm_config_free(config);
@@ -490,10 +553,22 @@ static int cmd_config(cli_args_t *args)
     printf("  Endpoint:    %s\n", config->api_endpoint ? config->api_endpoint : "(default)");
     printf("  Timeout:     %d ms\n", config->timeout_ms);
     printf("  Temperature: %.2f\n", config->temperature);
+    printf("  Map Model:   %s\n", config->map_model ? config->map_model : "(provider default)");
+    printf("  Context:     %d tokens/request\n", config->context_tokens);
+    printf("  Parallel:    %d requests\n", config->max_parallel_requests);
+    if (config->requests_per_minute > 0 || config->tokens_per_minute > 0) {
+        printf("  Rate Limit:  %d req/min, %d tokens/min\n",
+               config->requests_per_minute, config->tokens_per_minute);
+    }
     printf("\n");
     
     printf("Analysis Settings:\n");
     printf("  Max Commits:     %d\n", config->max_commits);
+    if (config->incident_window_hours > 0) {
+        printf("  Incident Window: %d hours\n", config->incident_window_hours);
+    } else {
+        printf("  Incident Window: unbounded\n");
+    }
     printf("  Max Call Depth:  %d\n", config->max_call_depth);
     printf("  Include Stdlib:  %s\n", config->include_stdlib ? "yes" : "no");
     printf("  Include Tests:   %s\n", config->include_tests ? "yes" : "no");
@@ -511,6 +586,82 @@ static int cmd_config(cli_args_t *args)
     return 0;
 }
 
+/* ============================================================================
+ * Batch Command
+ * ========================================================================== */
+
+static int cmd_batch(cli_args_t *args)
+{
+    if (args->batch_input_count == 0) {
+        fprintf(stderr, "Usage: tracemind batch [--batch-name <name>] [--no-wait] <file>...\n");
+        return 1;
+    }
+    
+    tm_config_t *config = build_config(args);
+    if (!config) return 1;
+    
+    tm_analyzer_t *analyzer = tm_analyzer_new(config);
+    if (!analyzer) {
+        fprintf(stderr, "Error: Failed to initialize analyzer.\n");
+        tm_config_free(config);
+        return 1;
+    }
+    
+    g_tty_output = isatty(STDERR_FILENO);
+    tm_analyzer_set_progress_callback(analyzer, progress_callback, NULL);
+    
+    /* Nightly runs get a fresh batch per day unless named explicitly */
+    char default_name[32];
+    const char *name = args->batch_name;
+    if (!name) {
+        time_t now = time(NULL);
+        struct tm tm_now;
+        localtime_r(&now, &tm_now);
+        strftime(default_name, sizeof(default_name), "batch-%Y%m%d", &tm_now);
+        name = default_name;
+    }
+    
+    /* State is on disk, so Ctrl-C is safe: rerun with the same name to resume */
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    fprintf(stderr, "Batch '%s': %zu inputs (rerun with --batch-name %s to resume)\n",
+            name, args->batch_input_count, name);
+    
+    tm_analysis_result_t **results = NULL;
+    tm_error_t err = tm_analyze_batch(analyzer, name, args->batch_inputs,
+                                      args->batch_input_count, !args->no_wait, &results);
+    
+    if (err == TM_ERR_TIMEOUT) {
+        fprintf(stderr, "Batch '%s' is still running; rerun later to collect results.\n", name);
+        tm_analyzer_free(analyzer);
+        tm_config_free(config);
+        return 3;
+    }
+    
+    if (err != TM_OK) {
+        fprintf(stderr, "Error: Batch analysis failed: %s\n", tm_strerror(err));
+        tm_analyzer_free(analyzer);
+        tm_config_free(config);
+        return 1;
+    }
+    
+    int exit_code = 0;
+    for (size_t i = 0; i < args->batch_input_count; i++) {
+        if (config->output_format != TM_OUTPUT_JSON) {
+            printf("==> %s <==\n", args->batch_inputs[i]);
+        }
+        tm_print_result(analyzer, results[i]);
+        
+        if (results[i]->error_message) exit_code = 1;
+        tm_result_free(results[i]);
+    }
+    free(results);
+    
+    tm_analyzer_free(analyzer);
+    tm_config_free(config);
+    return exit_code;
+}
+
 /* ============================================================================
  * Main Entry Point
  * ========================================================================== */
@@ -557,6 +708,10 @@ int main(int argc, char **argv)
         return cmd_config(&args);
     }
     
+    if (strcmp(args.command, "batch") == 0) {
+        return cmd_batch(&args);
+    }
+    
     if (strcmp(args.command, "version") == 0) {
         print_version();
         return 0;
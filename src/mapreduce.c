@@ -0,0 +1,718 @@
+/**
+ * TraceMind - Map-Reduce Log Analysis
+ *
+ * Hierarchical summarization for logs that exceed one context window:
+ * 1. Group relevant entries into message templates
+ * 2. Partition by service or time window within the token budget
+ * 3. Summarize partitions in parallel with the (cheaper) map model
+ * 4. Merge partial findings, recursively if needed, into a final request
+ */
+
+#include "internal/common.h"
+#include "internal/llm.h"
+#include "internal/parallel.h"
+#include <ctype.h>
+#include <jansson.h>
+
+/* ============================================================================
+ * Constants
+ * ========================================================================== */
+
+#define MAP_MAX_TOKENS 1024               /* Completion budget per summary */
+#define MAP_PROMPT_OVERHEAD_TOKENS 1500   /* System prompt + framing */
+#define MAX_REDUCE_LEVELS 4
+#define MAX_SERVICE_PARTITIONS 64
+#define TEMPLATE_MAX_LEN 160
+#define EXAMPLE_MAX_LEN 400
+#define TEMPLATE_OVERHEAD_TOKENS 16       /* Count, line, severity markup */
+
+static const char *MAP_SYSTEM_PROMPT =
+    "You are TraceMind's log summarizer. You receive one partition of a larger log. "
+    "Repeated lines are grouped into templates with occurrence counts.\n\n"
+    "Extract the findings that matter for root cause analysis: errors, anomalies, "
+    "timing patterns, resource exhaustion, dependency failures and cascades.\n\n"
+    "Respond with JSON only:\n"
+    "{\n"
+    "  \"findings\": [\n"
+    "    {\n"
+    "      \"title\": \"Short description\",\n"
+    "      \"severity\": \"error|warning|info\",\n"
+    "      \"count\": 12,\n"
+    "      \"first_seen\": \"timestamp\",\n"
+    "      \"last_seen\": \"timestamp\",\n"
+    "      \"evidence\": \"Key log lines or identifiers\",\n"
+    "      \"lines\": [120, 455]\n"
+    "    }\n"
+    "  ]\n"
+    "}\n\n"
+    "Report at most 8 findings, most important first. Quote identifiers exactly.";
+
+static const char *MERGE_SYSTEM_PROMPT =
+    "You are TraceMind's log summarizer. You receive partial findings extracted from "
+    "consecutive partitions of one log. Merge them into one consolidated list: combine "
+    "duplicates, sum counts, keep the earliest first_seen and latest last_seen, and keep "
+    "the most specific evidence.\n\n"
+    "Respond with JSON only, using the same format:\n"
+    "{\"findings\": [{\"title\": \"...\", \"severity\": \"error|warning|info\", \"count\": 12, "
+    "\"first_seen\": \"...\", \"last_seen\": \"...\", \"evidence\": \"...\", \"lines\": [120]}]}\n\n"
+    "Report at most 12 findings, most important first.";
+
+/* ============================================================================
+ * Message Templates
+ * ========================================================================== */
+
+/**
+ * Collapse variable parts of a message (numbers, hex ids) so repeated
+ * lines share one template.
+ */
+static char *make_template(const char *text)
+{
+    if (!text) return tm_strdup("");
+
+    char *out = tm_malloc(TEMPLATE_MAX_LEN + 1);
+    size_t n = 0;
+    const char *p = text;
+
+    while (*p && n < TEMPLATE_MAX_LEN) {
+        unsigned char c = (unsigned char)*p;
+
+        if (isdigit(c) || (c == '0' && (p[1] == 'x' || p[1] == 'X'))) {
+            /* Numbers, hex literals and hex-ish ids (uuid, sha) collapse to '#' */
+            while (*p && (isxdigit((unsigned char)*p) || *p == 'x' || *p == 'X' ||
+                          *p == '-' || *p == '.' || *p == ':')) {
+                p++;
+            }
+            out[n++] = '#';
+        } else if (isspace(c)) {
+            while (isspace((unsigned char)*p)) p++;
+            out[n++] = ' ';
+        } else {
+            out[n++] = (char)c;
+            p++;
+        }
+    }
+
+    out[n] = '\0';
+    return out;
+}
+
+static const char *entry_text(const tm_generic_log_entry_t *e)
+{
+    if (e->message) return e->message;
+    return e->raw_line ? e->raw_line : "";
+}
+
+/* ============================================================================
+ * Partitioning
+ * ========================================================================== */
+
+typedef struct {
+    char *label;
+    size_t *entries;                  /* Indices into log->entries */
+    size_t entry_count;
+    size_t entry_cap;
+} log_partition_t;
+
+typedef struct {
+    const tm_generic_log_t *log;
+    size_t *relevant;                 /* Relevant entry indices, log order */
+    size_t relevant_count;
+    size_t *entry_template;           /* Template id per log entry */
+    size_t template_count;
+    int budget_tokens;                /* Content budget per partition */
+} mr_input_t;
+
+static int template_cost(const tm_generic_log_entry_t *e)
+{
+    const char *text = e->raw_line ? e->raw_line : entry_text(e);
+    size_t len = TM_MIN(strlen(text), (size_t)EXAMPLE_MAX_LEN);
+    return (int)(len / 4) + TEMPLATE_OVERHEAD_TOKENS;
+}
+
+/*
+ * Split one group (entries in log order) into windows whose distinct
+ * templates fit the budget; repeats of a template inside a window are free.
+ */
+static void split_group(const mr_input_t *in, const char *group_label,
+                        const size_t *group, size_t group_count,
+                        size_t *window_stamp, size_t *next_stamp,
+                        log_partition_t **parts, size_t *part_count, size_t *part_cap)
+{
+    size_t start = 0;
+
+    while (start < group_count) {
+        size_t stamp = ++(*next_stamp);
+        int used = 0;
+        size_t end = start;
+
+        while (end < group_count) {
+            size_t idx = group[end];
+            size_t tid = in->entry_template[idx];
+            if (window_stamp[tid] != stamp) {
+                int cost = template_cost(&in->log->entries[idx]);
+                if (used > 0 && used + cost > in->budget_tokens) break;
+                window_stamp[tid] = stamp;
+                used += cost;
+            }
+            end++;
+        }
+
+        log_partition_t part = { 0 };
+        part.entries = tm_malloc((end - start) * sizeof(size_t));
+        memcpy(part.entries, group + start, (end - start) * sizeof(size_t));
+        part.entry_count = part.entry_cap = end - start;
+
+        size_t first_line = in->log->entries[group[start]].line_number;
+        size_t last_line = in->log->entries[group[end - 1]].line_number;
+
+        tm_strbuf_t sb;
+        tm_strbuf_init(&sb);
+        if (group_label) tm_strbuf_appendf(&sb, "%s, ", group_label);
+        tm_strbuf_appendf(&sb, "lines %zu-%zu", first_line, last_line);
+        part.label = tm_strbuf_finish(&sb);
+
+        TM_VEC_PUSH(*parts, *part_count, *part_cap, part);
+        start = end;
+    }
+}
+
+/**
+ * Partition relevant entries by service when the log names a handful of
+ * services, otherwise by contiguous time window (log order).
+ */
+static log_partition_t *partition_log(const mr_input_t *in, size_t *out_count)
+{
+    const tm_generic_log_t *log = in->log;
+
+    /* Distinct services, in order of first appearance */
+    tm_strmap_t services;
+    tm_strmap_init(&services);
+    bool all_sourced = true;
+
+    for (size_t i = 0; i < in->relevant_count; i++) {
+        const char *src = log->entries[in->relevant[i]].source;
+        if (!src) {
+            all_sourced = false;
+            continue;
+        }
+        if (!tm_strmap_get(&services, src, NULL)) {
+            tm_strmap_put(&services, src, services.count);
+        }
+    }
+
+    size_t group_count = 1;
+    bool by_service = services.count >= 2 &&
+                      services.count <= MAX_SERVICE_PARTITIONS &&
+                      all_sourced;
+    if (by_service) group_count = services.count;
+
+    /* Bucket entries per group, preserving log order */
+    size_t **groups = tm_calloc(group_count, sizeof(size_t *));
+    size_t *group_sizes = tm_calloc(group_count, sizeof(size_t));
+    size_t *group_caps = tm_calloc(group_count, sizeof(size_t));
+    const char **group_labels = tm_calloc(group_count, sizeof(char *));
+
+    for (size_t i = 0; i < in->relevant_count; i++) {
+        size_t idx = in->relevant[i];
+        size_t g = 0;
+        if (by_service) {
+            tm_strmap_get(&services, log->entries[idx].source, &g);
+            group_labels[g] = log->entries[idx].source;
+        }
+        TM_VEC_PUSH(groups[g], group_sizes[g], group_caps[g], idx);
+    }
+
+    size_t *window_stamp = tm_calloc(in->template_count, sizeof(size_t));
+    size_t next_stamp = 0;
+    log_partition_t *parts = NULL;
+    size_t part_count = 0, part_cap = 0;
+
+    for (size_t g = 0; g < group_count; g++) {
+        char label[256];
+        if (by_service) snprintf(label, sizeof(label), "service %s", group_labels[g]);
+        split_group(in, by_service ? label : NULL, groups[g], group_sizes[g],
+                    window_stamp, &next_stamp, &parts, &part_count, &part_cap);
+        free(groups[g]);
+    }
+
+    TM_DEBUG("Partitioned %zu entries into %zu partitions (by %s)",
+             in->relevant_count, part_count, by_service ? "service" : "time window");
+
+    free(window_stamp);
+    free(groups);
+    free(group_sizes);
+    free(group_caps);
+    free(group_labels);
+    tm_strmap_free(&services);
+
+    *out_count = part_count;
+    return parts;
+}
+
+static void partitions_free(log_partition_t *parts, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        free(parts[i].label);
+        free(parts[i].entries);
+    }
+    free(parts);
+}
+
+/* ============================================================================
+ * Partition Rendering
+ * ========================================================================== */
+
+/**
+ * Render a partition as templates with counts, in first-seen order.
+ */
+static char *render_partition(const mr_input_t *in, const log_partition_t *part,
+                              size_t *tmpl_slot, size_t *tmpl_stamp, size_t stamp)
+{
+    const tm_generic_log_t *log = in->log;
+
+    /* Per-template occurrence counts within the partition */
+    size_t *order = tm_malloc(part->entry_count * sizeof(size_t));
+    size_t *counts = tm_calloc(part->entry_count, sizeof(size_t));
+    size_t distinct = 0, errors = 0;
+
+    for (size_t i = 0; i < part->entry_count; i++) {
+        size_t idx = part->entries[i];
+        size_t tid = in->entry_template[idx];
+        if (log->entries[idx].is_error) errors++;
+
+        if (tmpl_stamp[tid] != stamp) {
+            tmpl_stamp[tid] = stamp;
+            tmpl_slot[tid] = distinct;
+            order[distinct++] = idx;
+        }
+        counts[tmpl_slot[tid]]++;
+    }
+
+    const tm_generic_log_entry_t *first = &log->entries[part->entries[0]];
+    const tm_generic_log_entry_t *last = &log->entries[part->entries[part->entry_count - 1]];
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "## PARTITION: %s\n\n", part->label);
+    tm_strbuf_appendf(&sb, "**Entries:** %zu (%zu errors, %zu templates)\n",
+                      part->entry_count, errors, distinct);
+    if (first->timestamp && last->timestamp) {
+        tm_strbuf_appendf(&sb, "**Time Range:** %s to %s\n", first->timestamp, last->timestamp);
+    }
+    tm_strbuf_append(&sb, "\n");
+
+    for (size_t t = 0; t < distinct; t++) {
+        const tm_generic_log_entry_t *e = &log->entries[order[t]];
+        const char *text = e->raw_line ? e->raw_line : entry_text(e);
+
+        tm_strbuf_appendf(&sb, "- x%zu [line %zu]", counts[t], e->line_number);
+        if (e->severity) tm_strbuf_appendf(&sb, " %s", e->severity);
+        if (e->source) tm_strbuf_appendf(&sb, " (%s)", e->source);
+        tm_strbuf_append(&sb, ": ");
+        tm_strbuf_append_len(&sb, text, TM_MIN(strlen(text), (size_t)EXAMPLE_MAX_LEN));
+        tm_strbuf_append(&sb, "\n");
+    }
+
+    free(order);
+    free(counts);
+    return tm_strbuf_finish(&sb);
+}
+
+/**
+ * Render a findings JSON response as compact bullet lines.
+ * Falls back to the (truncated) raw text if it is not valid JSON.
+ */
+static char *render_findings(const char *label, const char *response)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "### %s\n", label);
+
+    json_error_t jerr;
+    json_t *root = response ? json_loads(response, 0, &jerr) : NULL;
+    json_t *findings = json_object_get(root, "findings");
+
+    if (!response) {
+        tm_strbuf_append(&sb, "- (summary unavailable: request failed)\n");
+    } else if (!json_is_array(findings)) {
+        char *clip = tm_truncate_to_tokens(response, 500);
+        tm_strbuf_append(&sb, clip);
+        tm_strbuf_append(&sb, "\n");
+        TM_FREE(clip);
+    } else {
+        size_t i;
+        json_t *f;
+        json_array_foreach(findings, i, f) {
+            json_t *sev = json_object_get(f, "severity");
+            json_t *cnt = json_object_get(f, "count");
+            json_t *title = json_object_get(f, "title");
+            json_t *first = json_object_get(f, "first_seen");
+            json_t *last = json_object_get(f, "last_seen");
+            json_t *evidence = json_object_get(f, "evidence");
+            json_t *lines = json_object_get(f, "lines");
+
+            tm_strbuf_appendf(&sb, "- [%s x%lld] %s",
+                              json_is_string(sev) ? json_string_value(sev) : "info",
+                              json_is_integer(cnt) ? (long long)json_integer_value(cnt) : 1LL,
+                              json_is_string(title) ? json_string_value(title) : "(untitled)");
+            if (json_is_string(first) || json_is_string(last)) {
+                tm_strbuf_appendf(&sb, " (%s to %s)",
+                                  json_is_string(first) ? json_string_value(first) : "?",
+                                  json_is_string(last) ? json_string_value(last) : "?");
+            }
+            if (json_array_size(lines) > 0) {
+                tm_strbuf_append(&sb, " lines");
+                for (size_t j = 0; j < json_array_size(lines) && j < 8; j++) {
+                    json_t *ln = json_array_get(lines, j);
+                    if (json_is_integer(ln)) {
+                        tm_strbuf_appendf(&sb, "%s%lld", j ? "," : " ",
+                                          (long long)json_integer_value(ln));
+                    }
+                }
+            }
+            if (json_is_string(evidence)) {
+                tm_strbuf_appendf(&sb, ": %s", json_string_value(evidence));
+            }
+            tm_strbuf_append(&sb, "\n");
+        }
+    }
+
+    json_decref(root);
+    tm_strbuf_append(&sb, "\n");
+    return tm_strbuf_finish(&sb);
+}
+
+/* ============================================================================
+ * Parallel Map
+ * ========================================================================== */
+
+typedef struct {
+    tm_llm_client_t *root;
+    tm_llm_client_t **clients;        /* Per-worker clones, created lazily */
+    const char *system_prompt;
+    char **prompts;
+    char **outputs;
+} map_job_t;
+
+static void map_task(void *ctx, size_t task, size_t worker)
+{
+    map_job_t *job = ctx;
+
+    if (!job->clients[worker]) {
+        job->clients[worker] = tm_llm_client_clone(job->root, job->root->map_model);
+    }
+    tm_llm_client_t *client = job->clients[worker];
+    if (!client) return;
+
+    tm_chat_message_t messages[2] = {
+        { .role = TM_ROLE_SYSTEM, .content = (char *)job->system_prompt, .cache_breakpoint = true },
+        { .role = TM_ROLE_USER, .content = job->prompts[task] }
+    };
+
+    tm_chat_request_t request = {
+        .messages = messages,
+        .message_count = 2,
+        .max_tokens = MAP_MAX_TOKENS,
+        .temperature = client->temperature
+    };
+
+    tm_retry_config_t retry_cfg = tm_default_retry_config();
+    tm_chat_response_t *response = NULL;
+    tm_error_t err = tm_llm_chat_with_retry(client, &request, &retry_cfg, &response);
+
+    if (err == TM_OK && response && response->content) {
+        job->outputs[task] = tm_strdup(response->content);
+    } else {
+        TM_WARN("Partition summary %zu failed: %s", task + 1, tm_strerror(err));
+    }
+
+    tm_chat_response_free(response);
+}
+
+/**
+ * Run one summarization request per prompt with the map model.
+ * Returns the number of successful outputs.
+ */
+static size_t run_map(tm_llm_client_t *client, const char *system_prompt,
+                      char **prompts, size_t count, char **outputs)
+{
+    size_t workers = TM_MIN((size_t)TM_MAX(client->max_parallel, 1), count);
+
+    map_job_t job = {
+        .root = client,
+        .clients = tm_calloc(workers, sizeof(tm_llm_client_t *)),
+        .system_prompt = system_prompt,
+        .prompts = prompts,
+        .outputs = outputs
+    };
+
+    TM_INFO("Summarizing %zu partitions with %s (%zu parallel)",
+            count, client->map_model, workers);
+    tm_parallel_for(count, workers, map_task, &job);
+
+    for (size_t i = 0; i < workers; i++) {
+        tm_llm_client_free(job.clients[i]);
+    }
+    free(job.clients);
+
+    size_t ok = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (outputs[i]) ok++;
+    }
+    return ok;
+}
+
+/* ============================================================================
+ * Reduce
+ * ========================================================================== */
+
+static int blocks_tokens(char **blocks, size_t count)
+{
+    int total = 0;
+    for (size_t i = 0; i < count; i++) total += tm_estimate_tokens(blocks[i]);
+    return total;
+}
+
+/**
+ * Merge findings blocks level by level until they fit the budget.
+ * Takes ownership of *blocks and may replace it.
+ */
+static void reduce_blocks(tm_llm_client_t *client, char ***blocks, size_t *count, int budget)
+{
+    for (int level = 0; level < MAX_REDUCE_LEVELS &&
+                        *count > 1 && blocks_tokens(*blocks, *count) > budget; level++) {
+        /* Group consecutive blocks into chunks that fit one merge request */
+        char **prompts = tm_calloc(*count, sizeof(char *));
+        char **labels = tm_calloc(*count, sizeof(char *));
+        size_t chunk_count = 0;
+        size_t i = 0;
+
+        while (i < *count) {
+            tm_strbuf_t sb;
+            tm_strbuf_init(&sb);
+            size_t first = i;
+            int used = 0;
+
+            while (i < *count) {
+                int cost = tm_estimate_tokens((*blocks)[i]);
+                if (used > 0 && used + cost > budget) break;
+                tm_strbuf_append(&sb, (*blocks)[i]);
+                used += cost;
+                i++;
+            }
+
+            char label[64];
+            snprintf(label, sizeof(label), "Merged partitions %zu-%zu (level %d)",
+                     first + 1, i, level + 1);
+            prompts[chunk_count] = tm_strbuf_finish(&sb);
+            labels[chunk_count] = tm_strdup(label);
+            chunk_count++;
+        }
+
+        char **outputs = tm_calloc(chunk_count, sizeof(char *));
+        run_map(client, MERGE_SYSTEM_PROMPT, prompts, chunk_count, outputs);
+
+        /* At least one token each, or truncation would return NULL */
+        int share = TM_MAX(budget / (int)chunk_count, 1);
+        char **merged = tm_calloc(chunk_count, sizeof(char *));
+        for (size_t c = 0; c < chunk_count; c++) {
+            /* Keep the unmerged text if a merge request fails */
+            merged[c] = outputs[c] ? render_findings(labels[c], outputs[c])
+                                   : tm_truncate_to_tokens(prompts[c], share);
+            TM_FREE(outputs[c]);
+            TM_FREE(prompts[c]);
+            TM_FREE(labels[c]);
+        }
+        free(outputs);
+        free(prompts);
+        free(labels);
+
+        for (size_t b = 0; b < *count; b++) free((*blocks)[b]);
+        free(*blocks);
+        *blocks = merged;
+        *count = chunk_count;
+    }
+}
+
+/* ============================================================================
+ * Entry Point
+ * ========================================================================== */
+
+tm_error_t tm_llm_map_reduce_hypotheses(tm_llm_client_t *client,
+                                        const tm_generic_log_t *log,
+                                        const tm_git_context_t *git_ctx,
+                                        tm_hypothesis_t ***hypotheses,
+                                        size_t *count)
+{
+    TM_CHECK_NULL(client, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(log, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(hypotheses, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(count, TM_ERR_INVALID_ARG);
+
+    *hypotheses = NULL;
+    *count = 0;
+
+    int budget = TM_MAX(client->context_tokens - MAP_PROMPT_OVERHEAD_TOKENS, 1000);
+
+    /* ---- Relevant entries and templates ---- */
+    mr_input_t in = {
+        .log = log,
+        .relevant = tm_malloc((log->count ? log->count : 1) * sizeof(size_t)),
+        .entry_template = tm_calloc(log->count ? log->count : 1, sizeof(size_t)),
+        .budget_tokens = budget
+    };
+
+    bool errors_only = log->total_errors > 0;
+    tm_strmap_t templates;
+    tm_strmap_init(&templates);
+
+    for (size_t i = 0; i < log->count; i++) {
+        const tm_generic_log_entry_t *e = &log->entries[i];
+        if (errors_only && !e->is_error && !e->is_anomaly) continue;
+
+        char *tmpl = make_template(entry_text(e));
+        size_t tid;
+        if (!tm_strmap_get(&templates, tmpl, &tid)) {
+            tid = templates.count;
+            tm_strmap_put(&templates, tmpl, tid);
+        }
+        free(tmpl);
+
+        in.entry_template[i] = tid;
+        in.relevant[in.relevant_count++] = i;
+    }
+    in.template_count = templates.count;
+    tm_strmap_free(&templates);
+
+    TM_INFO("Map-reduce: %zu relevant entries, %zu templates",
+            in.relevant_count, in.template_count);
+
+    /* ---- Partition and render ---- */
+    size_t part_count = 0;
+    log_partition_t *parts = in.relevant_count > 0 ? partition_log(&in, &part_count) : NULL;
+
+    size_t *tmpl_slot = tm_calloc(in.template_count ? in.template_count : 1, sizeof(size_t));
+    size_t *tmpl_stamp = tm_calloc(in.template_count ? in.template_count : 1, sizeof(size_t));
+    char **rendered = tm_calloc(part_count ? part_count : 1, sizeof(char *));
+    for (size_t p = 0; p < part_count; p++) {
+        rendered[p] = render_partition(&in, &parts[p], tmpl_slot, tmpl_stamp, p + 1);
+    }
+    free(tmpl_slot);
+    free(tmpl_stamp);
+
+    /* ---- Map: a single partition that fits is sent to the final request as is ---- */
+    char **blocks = tm_calloc(part_count ? part_count : 1, sizeof(char *));
+    size_t block_count = part_count;
+
+    if (part_count == 1 && tm_estimate_tokens(rendered[0]) <= budget) {
+        blocks[0] = rendered[0];
+        rendered[0] = NULL;
+    } else if (part_count > 0) {
+        char **outputs = tm_calloc(part_count, sizeof(char *));
+        size_t ok = run_map(client, MAP_SYSTEM_PROMPT, rendered, part_count, outputs);
+
+        if (ok == 0) {
+            TM_ERROR("All %zu partition summaries failed", part_count);
+            for (size_t p = 0; p < part_count; p++) free(rendered[p]);
+            free(rendered);
+            free(outputs);
+            free(blocks);
+            partitions_free(parts, part_count);
+            free(in.relevant);
+            free(in.entry_template);
+            return TM_ERR_LLM;
+        }
+
+        for (size_t p = 0; p < part_count; p++) {
+            char label[320];
+            snprintf(label, sizeof(label), "%s (%zu entries)",
+                     parts[p].label, parts[p].entry_count);
+            blocks[p] = render_findings(label, outputs[p]);
+            TM_FREE(outputs[p]);
+        }
+        free(outputs);
+
+        reduce_blocks(client, &blocks, &block_count, budget);
+    }
+
+    for (size_t p = 0; p < part_count; p++) free(rendered[p]);
+    free(rendered);
+
+    /* ---- Reduce: final ranked hypotheses with the main model ---- */
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_append(&sb, "## LOG SUMMARY\n\n");
+    tm_strbuf_appendf(&sb, "**Format:** %s\n",
+                      log->format_description ? log->format_description : "unknown");
+    tm_strbuf_appendf(&sb, "**Total Entries:** %zu\n", log->count);
+    tm_strbuf_appendf(&sb, "**Errors:** %zu\n", log->total_errors);
+    tm_strbuf_appendf(&sb, "**Warnings:** %zu\n", log->total_warnings);
+    if (log->time_range_start && log->time_range_end) {
+        tm_strbuf_appendf(&sb, "**Time Range:** %s to %s\n",
+                          log->time_range_start, log->time_range_end);
+    }
+    tm_strbuf_appendf(&sb, "**Method:** %zu relevant entries in %zu templates, "
+                           "summarized across %zu partitions\n\n",
+                      in.relevant_count, in.template_count, part_count);
+
+    tm_strbuf_append(&sb, "## PARTITION FINDINGS\n\n");
+
+    /* Decided once: blocks are freed as they are appended */
+    bool clip_all = blocks_tokens(blocks, block_count) > budget;
+    int share = block_count > 0 ? TM_MAX(budget / (int)block_count, 1) : budget;
+    for (size_t b = 0; b < block_count; b++) {
+        char *clip = clip_all ? tm_truncate_to_tokens(blocks[b], share)
+                              : tm_strdup(blocks[b]);
+        if (clip) tm_strbuf_append(&sb, clip);
+        TM_FREE(clip);
+        free(blocks[b]);
+    }
+    free(blocks);
+
+    char *history = tm_build_commit_history(git_ctx);
+    if (history) {
+        tm_strbuf_append(&sb, history);
+        free(history);
+    }
+
+    tm_strbuf_append(&sb, "---\n\n");
+    tm_strbuf_append(&sb, "The findings above summarize every relevant entry of the log. "
+                          "Correlate them across partitions and provide your findings/hypotheses "
+                          "in the specified JSON format. Focus on identifying the root cause of "
+                          "any errors and notable patterns.");
+    char *user_prompt = tm_strbuf_finish(&sb);
+
+    partitions_free(parts, part_count);
+    free(in.relevant);
+    free(in.entry_template);
+
+    tm_hypothesis_request_t hr;
+    tm_hypothesis_request_init(&hr, client,
+                               tm_build_generic_system_prompt(log->detected_format),
+                               tm_build_repo_summary(git_ctx),
+                               user_prompt);
+
+    TM_DEBUG("Map-reduce final prompt: %d estimated tokens", tm_estimate_tokens(user_prompt));
+
+    tm_retry_config_t retry_cfg = tm_default_retry_config();
+    tm_chat_response_t *response = NULL;
+    tm_error_t err = tm_llm_chat_with_retry(client, &hr.request, &retry_cfg, &response);
+
+    tm_hypothesis_request_free(&hr);
+
+    if (err != TM_OK) {
+        TM_ERROR("Map-reduce final request failed: %s", tm_strerror(err));
+        tm_chat_response_free(response);
+        return err;
+    }
+
+    if (!response || !response->content) {
+        tm_chat_response_free(response);
+        return TM_ERR_LLM;
+    }
+
+    err = tm_parse_hypotheses(response->content, hypotheses, count);
+    tm_chat_response_free(response);
+
+    return err;
+}
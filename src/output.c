@@ -632,6 +632,10 @@ char *tm_format_cli(const tm_formatter_t *fmt, const tm_analysis_result_t *resul
         tm_strbuf_append(&sb, "\n--- Git Context ---\n");
         tm_strbuf_appendf(&sb, "Branch: %s\n", result->git_ctx->current_branch ? result->git_ctx->current_branch : "(unknown)");
         tm_strbuf_appendf(&sb, "Commits analyzed: %zu\n", result->git_ctx->commit_count);
+        if (result->git_ctx->dirty_hunk_count > 0) {
+            tm_strbuf_appendf(&sb, "Uncommitted hunks in trace files: %zu\n",
+                              result->git_ctx->dirty_hunk_count);
+        }
     }
     
     /* Call graph summary */
@@ -782,6 +786,16 @@ void tm_md_git_context(tm_strbuf_t *sb, const tm_git_context_t *ctx)
         }
         tm_strbuf_append(sb, "\n");
     }
+    
+    if (ctx->dirty_hunk_count > 0) {
+        tm_strbuf_append(sb, "### Uncommitted Changes\n\n");
+        for (size_t i = 0; i < ctx->dirty_hunk_count; i++) {
+            const tm_git_dirty_hunk_t *h = &ctx->dirty_hunks[i];
+            tm_strbuf_appendf(sb, "- `%s:%d-%d`%s\n", h->file, h->start_line, h->end_line,
+                              h->frame >= 0 ? " (at a trace frame)" : "");
+        }
+        tm_strbuf_append(sb, "\n");
+    }
 }
 
 char *tm_format_markdown(const tm_formatter_t *fmt, const tm_analysis_result_t *result)
@@ -895,13 +909,17 @@ char *tm_json_trace(const tm_stack_trace_t *trace)
     return result;
 }
 
-char *tm_json_git_context(const tm_git_context_t *ctx)
+static json_t *json_git_context(const tm_git_context_t *ctx)
 {
     json_t *obj = json_object();
     
     json_object_set_new(obj, "repo_root", json_string(ctx->repo_root ? ctx->repo_root : ""));
     json_object_set_new(obj, "branch", json_string(ctx->current_branch ? ctx->current_branch : ""));
     json_object_set_new(obj, "head_sha", json_string(ctx->head_sha ? ctx->head_sha : ""));
+    if (ctx->incident_time > 0) {
+        json_object_set_new(obj, "incident_time", json_integer(ctx->incident_time));
+        json_object_set_new(obj, "window_start", json_integer(ctx->window_start));
+    }
     
     json_t *commits = json_array();
     for (size_t i = 0; i < ctx->commit_count; i++) {
@@ -913,6 +931,9 @@ char *tm_json_git_context(const tm_git_context_t *ctx)
         json_object_set_new(commit, "timestamp", json_integer(c->timestamp));
         json_object_set_new(commit, "additions", json_integer(c->additions));
         json_object_set_new(commit, "deletions", json_integer(c->deletions));
+        if (ctx->commits_ranked) {
+            json_object_set_new(commit, "relevance", json_integer(c->relevance));
+        }
         json_object_set_new(commit, "touches_config", json_boolean(c->touches_config));
         json_object_set_new(commit, "touches_schema", json_boolean(c->touches_schema));
         
@@ -920,6 +941,31 @@ char *tm_json_git_context(const tm_git_context_t *ctx)
     }
     json_object_set_new(obj, "commits", commits);
     
+    if (ctx->dirty_hunk_count > 0) {
+        json_t *dirty = json_array();
+        for (size_t i = 0; i < ctx->dirty_hunk_count; i++) {
+            const tm_git_dirty_hunk_t *h = &ctx->dirty_hunks[i];
+            json_t *hunk = json_object();
+            
+            json_object_set_new(hunk, "file", json_string(h->file ? h->file : ""));
+            json_object_set_new(hunk, "start_line", json_integer(h->start_line));
+            json_object_set_new(hunk, "end_line", json_integer(h->end_line));
+            if (h->frame >= 0) {
+                json_object_set_new(hunk, "frame", json_integer(h->frame));
+            }
+            
+            json_array_append_new(dirty, hunk);
+        }
+        json_object_set_new(obj, "uncommitted", dirty);
+    }
+    
+    return obj;
+}
+
+char *tm_json_git_context(const tm_git_context_t *ctx)
+{
+    json_t *obj = json_git_context(ctx);
+    
     char *result = json_dumps(obj, JSON_INDENT(2));
     json_decref(obj);
     
@@ -949,6 +995,11 @@ char *tm_format_json(const tm_formatter_t *fmt, const tm_analysis_result_t *resu
         json_object_set_new(root, "trace", trace_obj);
     }
     
+    /* Git context */
+    if (result->git_ctx) {
+        json_object_set_new(root, "git", json_git_context(result->git_ctx));
+    }
+    
     /* Hypotheses */
     json_t *hyp_array = json_array();
     for (size_t i = 0; i < result->hypothesis_count; i++) {
@@ -0,0 +1,95 @@
+/**
+ * TraceMind - Parallel Execution Helpers
+ */
+
+#include "internal/common.h"
+#include "internal/parallel.h"
+#include <pthread.h>
+
+/* ============================================================================
+ * Parallel For
+ * ========================================================================== */
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next_task;
+    size_t task_count;
+    tm_parallel_fn fn;
+    void *ctx;
+} parallel_state_t;
+
+typedef struct {
+    parallel_state_t *state;
+    size_t worker;
+} parallel_worker_t;
+
+static void *parallel_worker_main(void *arg)
+{
+    parallel_worker_t *w = arg;
+    parallel_state_t *st = w->state;
+    
+    for (;;) {
+        pthread_mutex_lock(&st->lock);
+        size_t task = st->next_task < st->task_count ? st->next_task++ : st->task_count;
+        pthread_mutex_unlock(&st->lock);
+        
+        if (task >= st->task_count) break;
+        st->fn(st->ctx, task, w->worker);
+    }
+    
+    return NULL;
+}
+
+size_t tm_parallel_for(size_t task_count, size_t max_workers,
+                       tm_parallel_fn fn, void *ctx)
+{
+    if (!fn || task_count == 0) return 0;
+    
+    size_t workers = TM_MIN(task_count, max_workers > 0 ? max_workers : 1);
+    
+    if (workers == 1) {
+        for (size_t i = 0; i < task_count; i++) fn(ctx, i, 0);
+        return 1;
+    }
+    
+    parallel_state_t st = {
+        .next_task = 0,
+        .task_count = task_count,
+        .fn = fn,
+        .ctx = ctx
+    };
+    pthread_mutex_init(&st.lock, NULL);
+    
+    pthread_t *threads = tm_calloc(workers, sizeof(pthread_t));
+    parallel_worker_t *args = tm_calloc(workers, sizeof(parallel_worker_t));
+    bool *started = tm_calloc(workers, sizeof(bool));
+    
+    /* Worker 0 runs on the calling thread */
+    for (size_t i = 1; i < workers; i++) {
+        args[i] = (parallel_worker_t){ .state = &st, .worker = i };
+        started[i] = pthread_create(&threads[i], NULL, parallel_worker_main, &args[i]) == 0;
+        if (!started[i]) {
+            TM_WARN("Failed to start worker thread %zu; continuing with fewer", i);
+        }
+    }
+    
+    args[0] = (parallel_worker_t){ .state = &st, .worker = 0 };
+    parallel_worker_main(&args[0]);
+    
+    for (size_t i = 1; i < workers; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+    
+    pthread_mutex_destroy(&st.lock);
+    free(threads);
+    free(args);
+    free(started);
+    
+    return workers;
+}
+
+size_t tm_cpu_count(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+}
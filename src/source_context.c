@@ -0,0 +1,268 @@
+/**
+ * TraceMind - Source Context
+ */
+
+#include "internal/common.h"
+#include "internal/source_context.h"
+#include "internal/llm.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+
+/* "> 1234 | " before each line */
+#define LINE_PREFIX_BYTES 9
+
+/**
+ * One source file, mapped (or read from HEAD) with its line index.
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    bool mapped;
+    size_t *starts;                   /* starts[line] for lines 1..line_count+1 */
+    size_t line_count;
+} context_file_t;
+
+typedef struct {
+    const char *root;
+    const tm_source_context_opts_t *opts;
+    tm_strmap_t index;                /* Repository-relative path -> files */
+    context_file_t *files;
+    size_t count;
+    size_t capacity;
+} context_t;
+
+/* ============================================================================
+ * Files
+ * ========================================================================== */
+
+static bool is_dirty(const context_t *ctx, const char *rel)
+{
+    const tm_git_context_t *git = ctx->opts->git_ctx;
+    if (!git || !ctx->opts->repo) return false;
+
+    for (size_t i = 0; i < git->dirty_hunk_count; i++) {
+        if (git->dirty_hunks[i].file && strcmp(git->dirty_hunks[i].file, rel) == 0) return true;
+    }
+    return false;
+}
+
+static bool map_file(const char *path, context_file_t *file)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    file->data = map;
+    file->size = (size_t)st.st_size;
+    file->mapped = true;
+    return true;
+}
+
+static void index_lines(context_file_t *file)
+{
+    size_t capacity = 0, count = 0;
+    TM_VEC_PUSH(file->starts, count, capacity, (size_t)0);  /* Line 0 unused */
+
+    size_t pos = 0;
+    while (pos < file->size) {
+        TM_VEC_PUSH(file->starts, count, capacity, pos);
+        const char *nl = memchr(file->data + pos, '\n', file->size - pos);
+        pos = nl ? (size_t)(nl - file->data) + 1 : file->size;
+    }
+    TM_VEC_PUSH(file->starts, count, capacity, file->size);
+    file->line_count = count - 2;
+}
+
+/**
+ * File at rel, loaded on first use: HEAD's version when the working copy
+ * has uncommitted changes, the working copy otherwise. NULL if unreadable.
+ */
+static const context_file_t *context_file(context_t *ctx, const char *rel, const char *full)
+{
+    size_t slot;
+    if (tm_strmap_get(&ctx->index, rel, &slot)) {
+        return ctx->files[slot].data ? &ctx->files[slot] : NULL;
+    }
+
+    context_file_t file = {0};
+    if (is_dirty(ctx, rel) &&
+        tm_git_head_file(ctx->opts->repo, rel, &file.data, &file.size) == TM_OK) {
+        TM_DEBUG("Source context for %s from HEAD", rel);
+    } else {
+        TM_FREE(file.data);
+        if (!map_file(full, &file)) file.data = NULL;
+    }
+    if (file.data) index_lines(&file);
+
+    /* Unreadable files are remembered too */
+    tm_strmap_put(&ctx->index, rel, ctx->count);
+    TM_VEC_PUSH(ctx->files, ctx->count, ctx->capacity, file);
+    return file.data ? &ctx->files[ctx->count - 1] : NULL;
+}
+
+static void context_free(context_t *ctx)
+{
+    for (size_t i = 0; i < ctx->count; i++) {
+        context_file_t *file = &ctx->files[i];
+        if (file->mapped) munmap(file->data, file->size);
+        else free(file->data);
+        free(file->starts);
+    }
+    free(ctx->files);
+    tm_strmap_free(&ctx->index);
+}
+
+/* ============================================================================
+ * Extraction
+ * ========================================================================== */
+
+/* Length of line without its terminator */
+static size_t line_length(const context_file_t *file, size_t line)
+{
+    size_t len = file->starts[line + 1] - file->starts[line];
+    const char *text = file->data + file->starts[line];
+    while (len > 0 && (text[len - 1] == '\n' || text[len - 1] == '\r')) len--;
+    return len;
+}
+
+/* Innermost call graph function enclosing the frame's line. Frame nodes
+ * carry the frame's path, expanded ones the repository-relative path. */
+static const tm_call_node_t *enclosing_node(const tm_call_graph_t *graph,
+                                            const tm_stack_frame_t *frame,
+                                            const char *rel)
+{
+    const tm_call_node_t *best = NULL;
+    for (size_t i = 0; graph && i < graph->node_count; i++) {
+        const tm_call_node_t *node = graph->nodes[i];
+        if (!node->file || node->start_line > frame->line || node->end_line < frame->line ||
+            (strcmp(node->file, rel) != 0 && strcmp(node->file, frame->file) != 0)) {
+            continue;
+        }
+        if (!best || node->end_line - node->start_line < best->end_line - best->start_line) {
+            best = node;
+        }
+    }
+    return best;
+}
+
+/**
+ * Lines [lo, hi] rendered with numbers, the frame line marked, shrunk
+ * around it to fit budget bytes.
+ */
+static char *render_lines(const context_file_t *file, size_t line,
+                          size_t lo, size_t hi, size_t budget)
+{
+    size_t first = line, last = line;
+    size_t used = line_length(file, line) + LINE_PREFIX_BYTES;
+
+    /* Grow alternately below and above the frame line */
+    bool grew = true;
+    while (grew) {
+        grew = false;
+        if (last < hi) {
+            size_t cost = line_length(file, last + 1) + LINE_PREFIX_BYTES;
+            if (used + cost <= budget) {
+                last++;
+                used += cost;
+                grew = true;
+            }
+        }
+        if (first > lo) {
+            size_t cost = line_length(file, first - 1) + LINE_PREFIX_BYTES;
+            if (used + cost <= budget) {
+                first--;
+                used += cost;
+                grew = true;
+            }
+        }
+    }
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    for (size_t l = first; l <= last; l++) {
+        tm_strbuf_appendf(&sb, "%c%5zu | ", l == line ? '>' : ' ', l);
+        tm_strbuf_append_len(&sb, file->data + file->starts[l], line_length(file, l));
+        tm_strbuf_append(&sb, "\n");
+    }
+    return tm_strbuf_finish(&sb);
+}
+
+static char *frame_context(context_t *ctx, const tm_stack_frame_t *frame, size_t budget)
+{
+    char full[PATH_MAX];
+    if (frame->file[0] == '/') {
+        snprintf(full, sizeof(full), "%s", frame->file);
+    } else {
+        snprintf(full, sizeof(full), "%s/%s", ctx->root, frame->file);
+    }
+
+    /* Only files inside the repository */
+    char *rel = tm_relative_path(ctx->root, full);
+    if (!rel || rel[0] == '/') {
+        free(rel);
+        return NULL;
+    }
+
+    const context_file_t *file = context_file(ctx, rel, full);
+    size_t line = (size_t)frame->line;
+    if (!file || line > file->line_count) {
+        free(rel);
+        return NULL;
+    }
+
+    /* The enclosing function, else a window around the line */
+    size_t lo, hi;
+    const tm_call_node_t *node = enclosing_node(ctx->opts->call_graph, frame, rel);
+    if (node) {
+        lo = (size_t)TM_MAX(node->start_line, 1);
+        hi = TM_MIN((size_t)node->end_line, file->line_count);
+    } else {
+        size_t lines = (size_t)TM_MAX(ctx->opts->lines, 0);
+        lo = line > lines ? line - lines : 1;
+        hi = TM_MIN(line + lines, file->line_count);
+    }
+    free(rel);
+
+    return render_lines(file, line, lo, hi, budget);
+}
+
+size_t tm_source_context_fill(tm_stack_trace_t *trace,
+                              const char *repo_root,
+                              const tm_source_context_opts_t *opts)
+{
+    if (!trace || !repo_root || !opts) return 0;
+
+    int frame_tokens = opts->frame_tokens > 0 ? opts->frame_tokens : TM_SOURCE_CONTEXT_FRAME_TOKENS;
+    int remaining = opts->max_tokens > 0 ? opts->max_tokens : TM_SOURCE_CONTEXT_TOKENS;
+
+    context_t ctx = { .root = repo_root, .opts = opts };
+    tm_strmap_init(&ctx.index);
+
+    size_t filled = 0;
+    for (size_t i = 0; i < trace->frame_count && remaining > 0; i++) {
+        tm_stack_frame_t *frame = &trace->frames[i];
+        if (frame->context || !frame->file || frame->line <= 0 ||
+            frame->is_stdlib || frame->is_third_party) {
+            continue;
+        }
+
+        size_t budget = (size_t)TM_MIN(frame_tokens, remaining) * 4;
+        frame->context = frame_context(&ctx, frame, budget);
+        if (!frame->context) continue;
+
+        remaining -= tm_estimate_tokens(frame->context);
+        filled++;
+    }
+
+    context_free(&ctx);
+    return filled;
+}
@@ -0,0 +1,699 @@
+/**
+ * TraceMind - Repository Symbol Index
+ */
+
+#include "internal/common.h"
+#include "internal/symbol_index.h"
+#include "internal/ast.h"
+#include "internal/parallel.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#define SYMBOL_MAGIC "TMSYM\0\0\0"
+#define SYMBOL_VERSION 1
+#define SYMBOL_BYTE_ORDER 0x01020304u
+
+/* Larger files are generated or minified; they define nothing useful */
+#define SYMBOL_MAX_FILE_SIZE (1024 * 1024)
+
+char *tm_symbol_index_file(const char *cache_dir, const char *repo_root)
+{
+    if (!cache_dir || !repo_root) return NULL;
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/symbols", cache_dir);
+
+    if (tm_mkdir_p(sb.data) != TM_OK) {
+        tm_strbuf_free(&sb);
+        return NULL;
+    }
+
+    /* One index per repository root */
+    char *root = tm_normalize_path(repo_root);
+    tm_strbuf_appendf(&sb, "/%016llx.idx",
+                      (unsigned long long)tm_hash_bytes(root, strlen(root)));
+    free(root);
+    return tm_strbuf_finish(&sb);
+}
+
+/* ============================================================================
+ * Loading
+ * ========================================================================== */
+
+/* Every record's offsets and ids must stay inside their sections */
+static bool validate_records(const tm_symbol_index_t *idx)
+{
+    const tm_symbol_header_t *header = idx->header;
+
+    for (uint32_t i = 0; i < header->file_count; i++) {
+        const tm_symbol_file_t *f = &idx->files[i];
+        if (f->path_offset >= header->strings_size ||
+            f->module_offset >= header->strings_size ||
+            f->first_symbol > header->symbol_count ||
+            f->symbol_count > header->symbol_count - f->first_symbol) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header->symbol_count; i++) {
+        const tm_symbol_t *sym = &idx->symbols[i];
+        if (sym->name_offset >= header->strings_size ||
+            sym->file >= header->file_count ||
+            idx->by_name[i] >= header->symbol_count) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+tm_error_t tm_symbol_index_load(const char *file, tm_symbol_index_t **index)
+{
+    TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(index, TM_ERR_INVALID_ARG);
+
+    *index = NULL;
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? TM_ERR_NOT_FOUND : TM_ERR_IO;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(tm_symbol_header_t)) {
+        close(fd);
+        return TM_ERR_PARSE;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return TM_ERR_IO;
+
+    const tm_symbol_header_t *header = map;
+
+    /* Validate header and section bounds */
+    bool valid = memcmp(header->magic, SYMBOL_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == SYMBOL_VERSION &&
+                 header->byte_order == SYMBOL_BYTE_ORDER;
+
+    size_t files_size = 0, symbols_size = 0, by_name_size = 0;
+    if (valid) {
+        files_size = (size_t)header->file_count * sizeof(tm_symbol_file_t);
+        symbols_size = (size_t)header->symbol_count * sizeof(tm_symbol_t);
+        by_name_size = (size_t)header->symbol_count * sizeof(uint32_t);
+        valid = sizeof(*header) + files_size + symbols_size + by_name_size +
+                header->strings_size == size;
+    }
+
+    tm_symbol_index_t *idx = tm_calloc(1, sizeof(tm_symbol_index_t));
+    idx->map = map;
+    idx->map_size = size;
+    idx->header = header;
+    idx->files = (const tm_symbol_file_t *)((const char *)map + sizeof(*header));
+    idx->symbols = (const tm_symbol_t *)((const char *)idx->files + files_size);
+    idx->by_name = (const uint32_t *)((const char *)idx->symbols + symbols_size);
+    idx->strings = (const char *)idx->by_name + by_name_size;
+
+    /* Every string must be terminated inside the table */
+    if (valid && header->strings_size > 0) {
+        valid = idx->strings[header->strings_size - 1] == '\0';
+    }
+
+    if (!valid || !validate_records(idx)) {
+        tm_symbol_index_free(idx);
+        return TM_ERR_PARSE;
+    }
+
+    TM_DEBUG("Loaded symbol index %s: %u files, %u symbols", file,
+             header->file_count, header->symbol_count);
+
+    *index = idx;
+    return TM_OK;
+}
+
+void tm_symbol_index_free(tm_symbol_index_t *index)
+{
+    if (!index) return;
+    if (index->map) munmap(index->map, index->map_size);
+    free(index);
+}
+
+/* ============================================================================
+ * Queries
+ * ========================================================================== */
+
+static const char *symbol_name(const tm_symbol_index_t *index, uint32_t id)
+{
+    return tm_symbol_index_string(index, index->symbols[id].name_offset);
+}
+
+const uint32_t *tm_symbol_index_lookup(const tm_symbol_index_t *index,
+                                       const char *name,
+                                       size_t *count)
+{
+    if (count) *count = 0;
+    if (!index || !name || !count) return NULL;
+
+    /* First id whose name is >= name */
+    size_t lo = 0, hi = index->header->symbol_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (strcmp(symbol_name(index, index->by_name[mid]), name) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+
+    size_t end = lo;
+    while (end < index->header->symbol_count &&
+           strcmp(symbol_name(index, index->by_name[end]), name) == 0) {
+        end++;
+    }
+
+    *count = end - lo;
+    return *count ? &index->by_name[lo] : NULL;
+}
+
+/* ============================================================================
+ * Repository Walk
+ * ========================================================================== */
+
+/**
+ * A source file found by the walk, and its indexing result.
+ */
+typedef struct {
+    char *path;                       /* Repository-relative */
+    tm_language_t language;
+    uint64_t size;
+    struct timespec mtime;
+    const tm_symbol_file_t *previous; /* Entry in the old index (nullable) */
+    bool reused;                      /* Symbols copied from previous */
+    uint64_t content_hash;
+    tm_symbol_t *symbols;             /* Parsed; name_offset unused */
+    char **names;
+    size_t symbol_count;
+    size_t symbol_capacity;
+} index_task_t;
+
+typedef struct {
+    const char *root;
+    index_task_t *tasks;
+    size_t count;
+    size_t capacity;
+    bool defer_dirs;                  /* Collect subdirectories instead of walking */
+    char **dirs;                      /* Repository-relative */
+    size_t dir_count;
+    size_t dir_capacity;
+} walk_t;
+
+/* Language indexed for a file name, or TM_LANG_UNKNOWN */
+static tm_language_t source_language(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    if (!ext) return TM_LANG_UNKNOWN;
+
+    tm_language_t lang = tm_detect_language(ext);
+    return lang == TM_LANG_PYTHON || lang == TM_LANG_GO || lang == TM_LANG_NODEJS
+        ? lang : TM_LANG_UNKNOWN;
+}
+
+/* Hidden, dependency and build directories are not part of the code base */
+static bool skip_directory(const char *name)
+{
+    return name[0] == '.' ||
+           strcmp(name, "node_modules") == 0 ||
+           strcmp(name, "vendor") == 0 ||
+           strcmp(name, "__pycache__") == 0 ||
+           strcmp(name, "site-packages") == 0 ||
+           strcmp(name, "dist-packages") == 0;
+}
+
+static void walk_directory(walk_t *walk, const char *rel)
+{
+    char dir_path[PATH_MAX];
+    snprintf(dir_path, sizeof(dir_path), "%s%s%s", walk->root, rel[0] ? "/" : "", rel);
+
+    DIR *dir = opendir(dir_path);
+    if (!dir) return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        const char *name = entry->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+        char child[PATH_MAX];
+        int n = snprintf(child, sizeof(child), "%s%s%s", rel, rel[0] ? "/" : "", name);
+        if (n < 0 || (size_t)n >= sizeof(child)) continue;
+
+        char full[PATH_MAX];
+        n = snprintf(full, sizeof(full), "%s/%s", walk->root, child);
+        if (n < 0 || (size_t)n >= sizeof(full)) continue;
+
+        /* lstat: symlinks are skipped so the walk cannot loop */
+        struct stat st;
+        if (lstat(full, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            if (skip_directory(name)) continue;
+            if (walk->defer_dirs) {
+                char *dir_rel = tm_strdup(child);
+                TM_VEC_PUSH(walk->dirs, walk->dir_count, walk->dir_capacity, dir_rel);
+            } else {
+                walk_directory(walk, child);
+            }
+            continue;
+        }
+        if (!S_ISREG(st.st_mode) || st.st_size > SYMBOL_MAX_FILE_SIZE) continue;
+
+        tm_language_t lang = source_language(name);
+        if (lang == TM_LANG_UNKNOWN) continue;
+
+        index_task_t task = {
+            .path = tm_strdup(child),
+            .language = lang,
+            .size = (uint64_t)st.st_size,
+            .mtime = st.st_mtim
+        };
+        TM_VEC_PUSH(walk->tasks, walk->count, walk->capacity, task);
+    }
+
+    closedir(dir);
+}
+
+typedef struct {
+    const walk_t *top;
+    walk_t *subtrees;                 /* One per top-level directory */
+} fanout_t;
+
+static void walk_subtree(void *ctx, size_t task, size_t worker)
+{
+    (void)worker;
+    fanout_t *fan = ctx;
+    walk_directory(&fan->subtrees[task], fan->top->dirs[task]);
+}
+
+/*
+ * Walk the repository: its root on the calling thread, then each
+ * top-level directory on up to workers threads. The walk is one lstat
+ * per entry, so large trees are bound by stat latency, not CPU.
+ */
+static void walk_repository(walk_t *walk, size_t workers)
+{
+    walk->defer_dirs = true;
+    walk_directory(walk, "");
+    walk->defer_dirs = false;
+
+    fanout_t fan = {
+        .top = walk,
+        .subtrees = tm_calloc(walk->dir_count ? walk->dir_count : 1, sizeof(walk_t))
+    };
+    for (size_t i = 0; i < walk->dir_count; i++) {
+        fan.subtrees[i].root = walk->root;
+    }
+    tm_parallel_for(walk->dir_count, workers, walk_subtree, &fan);
+
+    for (size_t i = 0; i < walk->dir_count; i++) {
+        walk_t *sub = &fan.subtrees[i];
+        for (size_t j = 0; j < sub->count; j++) {
+            TM_VEC_PUSH(walk->tasks, walk->count, walk->capacity, sub->tasks[j]);
+        }
+        free(sub->tasks);
+        free(walk->dirs[i]);
+    }
+    free(fan.subtrees);
+    TM_FREE(walk->dirs);
+    walk->dir_count = 0;
+    walk->dir_capacity = 0;
+}
+
+static int compare_tasks(const void *a, const void *b)
+{
+    const index_task_t *x = a, *y = b;
+    return strcmp(x->path, y->path);
+}
+
+/* Entry for path in a previous index, whose files are sorted by path */
+static const tm_symbol_file_t *previous_entry(const tm_symbol_index_t *index,
+                                              const char *path)
+{
+    if (!index) return NULL;
+
+    size_t lo = 0, hi = index->header->file_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const tm_symbol_file_t *f = &index->files[mid];
+        int cmp = strcmp(tm_symbol_index_string(index, f->path_offset), path);
+        if (cmp == 0) return f;
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Symbol Extraction
+ * ========================================================================== */
+
+/**
+ * Module path of a repository-relative file: dotted for Python (package
+ * __init__ files name the package), the directory for Go, and the path
+ * without extension for JavaScript (index files name the directory).
+ */
+static char *module_path(const char *path, tm_language_t lang)
+{
+    if (lang == TM_LANG_GO) {
+        const char *slash = strrchr(path, '/');
+        return slash ? tm_strndup(path, (size_t)(slash - path)) : tm_strdup(".");
+    }
+
+    const char *ext = strrchr(path, '.');
+    char *module = tm_strndup(path, ext ? (size_t)(ext - path) : strlen(path));
+
+    const char *tail = lang == TM_LANG_PYTHON ? "__init__" : "index";
+    size_t len = strlen(module), tail_len = strlen(tail);
+    if (len > tail_len && strcmp(module + len - tail_len, tail) == 0 &&
+        module[len - tail_len - 1] == '/') {
+        module[len - tail_len - 1] = '\0';
+    }
+
+    if (lang == TM_LANG_PYTHON) {
+        for (char *p = module; *p; p++) {
+            if (*p == '/') *p = '.';
+        }
+    }
+    return module;
+}
+
+/* Start of each line in source, 1-indexed (line_starts[0] unused) */
+static size_t *line_starts(const char *source, size_t len, size_t *count)
+{
+    size_t capacity = 64;
+    size_t *starts = tm_malloc(capacity * sizeof(size_t));
+    starts[0] = 0;
+    starts[1] = 0;
+    *count = 2;
+
+    for (size_t i = 0; i < len; i++) {
+        if (source[i] == '\n') TM_VEC_PUSH(starts, *count, capacity, i + 1);
+    }
+    return starts;
+}
+
+/**
+ * Whether a definition is visible outside its module: public module-level
+ * functions in Python, capitalized names in Go, explicit exports in
+ * JavaScript.
+ */
+static bool is_exported(const tm_source_file_t *file,
+                        const tm_function_def_t *func,
+                        const size_t *starts,
+                        size_t line_count)
+{
+    switch (file->language) {
+    case TM_LANG_PYTHON:
+        return func->start_col == 0 && func->name[0] != '_';
+    case TM_LANG_GO:
+        return isupper((unsigned char)func->name[0]) != 0;
+    case TM_LANG_NODEJS: {
+        if (func->start_line <= 0 || (size_t)func->start_line >= line_count) return false;
+        const char *p = file->source + starts[func->start_line];
+        const char *end = file->source + file->source_len;
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        return (size_t)(end - p) >= 6 && strncmp(p, "export", 6) == 0;
+    }
+    default:
+        return false;
+    }
+}
+
+static void task_add_symbol(index_task_t *task, const char *name, uint32_t kind,
+                            int start_line, int end_line)
+{
+    size_t capacity = task->symbol_capacity;
+    tm_symbol_t sym = {
+        .kind = kind,
+        .start_line = start_line,
+        .end_line = end_line
+    };
+    TM_VEC_PUSH(task->symbols, task->symbol_count, task->symbol_capacity, sym);
+    if (task->symbol_capacity != capacity) {
+        task->names = tm_realloc(task->names, task->symbol_capacity * sizeof(char *));
+    }
+    task->names[task->symbol_count - 1] = tm_strdup(name);
+}
+
+/* Definitions, then imports, of a parsed file */
+static void extract_symbols(index_task_t *task, const tm_source_file_t *file)
+{
+    size_t line_count = 0;
+    size_t *starts = line_starts(file->source, file->source_len, &line_count);
+
+    const tm_function_index_t *functions = file->functions;
+    for (size_t i = 0; functions && i < functions->count; i++) {
+        const tm_function_def_t *func = &functions->funcs[i];
+        if (!func->name || !func->name[0]) continue;
+
+        uint32_t kind = TM_SYMBOL_DEFINITION;
+        if (is_exported(file, func, starts, line_count)) kind |= TM_SYMBOL_EXPORTED;
+        task_add_symbol(task, func->name, kind, func->start_line, func->end_line);
+    }
+    free(starts);
+
+    tm_import_t *imports = NULL;
+    size_t import_count = 0;
+    if (tm_extract_imports(file, &imports, &import_count) == TM_OK) {
+        for (size_t i = 0; i < import_count; i++) {
+            task_add_symbol(task, imports[i].text, TM_SYMBOL_IMPORT,
+                            imports[i].line, imports[i].line);
+        }
+    }
+    tm_imports_free(imports, import_count);
+}
+
+/* ============================================================================
+ * Indexing
+ * ========================================================================== */
+
+static void index_file(void *ctx, size_t task_index, size_t worker)
+{
+    (void)worker;
+    walk_t *walk = ctx;
+    index_task_t *task = &walk->tasks[task_index];
+    const tm_symbol_file_t *prev = task->previous;
+
+    /* Unchanged size and mtime: trust the previous entry without reading */
+    if (prev && prev->size == task->size &&
+        prev->mtime_sec == (int64_t)task->mtime.tv_sec &&
+        prev->mtime_nsec == (int64_t)task->mtime.tv_nsec) {
+        task->content_hash = prev->content_hash;
+        task->reused = true;
+        return;
+    }
+
+    char full[PATH_MAX];
+    snprintf(full, sizeof(full), "%s/%s", walk->root, task->path);
+
+    size_t len = 0;
+    char *source = tm_read_file(full, &len);
+    if (!source) return;
+
+    /* Touched but not edited (checkout, rebase): same content */
+    task->size = len;
+    task->content_hash = tm_hash_bytes(source, len);
+    if (prev && prev->size == len && prev->content_hash == task->content_hash) {
+        free(source);
+        task->reused = true;
+        return;
+    }
+
+    tm_source_file_t *file = NULL;
+    if (tm_parse_source(full, source, len, &file) != TM_OK) return;
+
+    extract_symbols(task, file);
+    tm_source_file_free(file);
+}
+
+/* Offset of s in the string table, adding it on first use */
+static uint32_t intern_string(tm_strbuf_t *strings, tm_strmap_t *offsets, const char *s)
+{
+    size_t offset;
+    if (tm_strmap_get(offsets, s, &offset)) return (uint32_t)offset;
+
+    offset = strings->len;
+    tm_strbuf_append_len(strings, s, strlen(s) + 1);
+    tm_strmap_put(offsets, s, offset);
+    return (uint32_t)offset;
+}
+
+typedef struct {
+    const char *name;
+    uint32_t id;
+} name_entry_t;
+
+static int compare_names(const void *a, const void *b)
+{
+    const name_entry_t *x = a, *y = b;
+    int cmp = strcmp(x->name, y->name);
+    if (cmp != 0) return cmp;
+    return x->id < y->id ? -1 : x->id > y->id;
+}
+
+static tm_error_t write_index(const char *file,
+                              const walk_t *walk,
+                              const tm_symbol_index_t *previous)
+{
+    tm_strbuf_t files, symbols, strings;
+    tm_strbuf_init(&files);
+    tm_strbuf_init(&symbols);
+    tm_strbuf_init(&strings);
+
+    tm_strmap_t offsets;
+    tm_strmap_init(&offsets);
+
+    /* Names point into the task lists or the old mapping, both still live */
+    name_entry_t *names = NULL;
+    size_t name_count = 0, name_capacity = 0;
+
+    for (size_t i = 0; i < walk->count; i++) {
+        const index_task_t *task = &walk->tasks[i];
+        char *module = module_path(task->path, task->language);
+
+        tm_symbol_file_t rec = {
+            .path_offset = intern_string(&strings, &offsets, task->path),
+            .module_offset = intern_string(&strings, &offsets, module),
+            .language = (uint32_t)task->language,
+            .first_symbol = (uint32_t)name_count,
+            .size = task->size,
+            .mtime_sec = (int64_t)task->mtime.tv_sec,
+            .mtime_nsec = (int64_t)task->mtime.tv_nsec,
+            .content_hash = task->content_hash
+        };
+        free(module);
+
+        size_t count = task->reused ? task->previous->symbol_count : task->symbol_count;
+        for (size_t j = 0; j < count; j++) {
+            tm_symbol_t sym;
+            const char *name;
+            if (task->reused) {
+                sym = previous->symbols[task->previous->first_symbol + j];
+                name = tm_symbol_index_string(previous, sym.name_offset);
+            } else {
+                sym = task->symbols[j];
+                name = task->names[j];
+            }
+
+            sym.name_offset = intern_string(&strings, &offsets, name);
+            sym.file = (uint32_t)i;
+            tm_strbuf_append_len(&symbols, (const char *)&sym, sizeof(sym));
+
+            name_entry_t entry = { name, (uint32_t)name_count };
+            TM_VEC_PUSH(names, name_count, name_capacity, entry);
+        }
+
+        rec.symbol_count = (uint32_t)name_count - rec.first_symbol;
+        tm_strbuf_append_len(&files, (const char *)&rec, sizeof(rec));
+    }
+
+    tm_strmap_free(&offsets);
+
+    if (name_count > 0) qsort(names, name_count, sizeof(name_entry_t), compare_names);
+
+    tm_symbol_header_t header = {
+        .version = SYMBOL_VERSION,
+        .byte_order = SYMBOL_BYTE_ORDER,
+        .file_count = (uint32_t)walk->count,
+        .symbol_count = (uint32_t)name_count,
+        .strings_size = strings.len
+    };
+    memcpy(header.magic, SYMBOL_MAGIC, sizeof(header.magic));
+
+    tm_strbuf_t out;
+    tm_strbuf_init(&out);
+    tm_strbuf_append_len(&out, (const char *)&header, sizeof(header));
+    tm_strbuf_append_len(&out, files.data, files.len);
+    tm_strbuf_append_len(&out, symbols.data, symbols.len);
+    for (size_t i = 0; i < name_count; i++) {
+        tm_strbuf_append_len(&out, (const char *)&names[i].id, sizeof(uint32_t));
+    }
+    tm_strbuf_append_len(&out, strings.data, strings.len);
+
+    free(names);
+    tm_strbuf_free(&files);
+    tm_strbuf_free(&symbols);
+    tm_strbuf_free(&strings);
+
+    tm_error_t err = tm_write_file_atomic(file, out.data, out.len);
+    tm_strbuf_free(&out);
+    return err;
+}
+
+static void walk_free(walk_t *walk)
+{
+    for (size_t i = 0; i < walk->count; i++) {
+        index_task_t *task = &walk->tasks[i];
+        for (size_t j = 0; j < task->symbol_count; j++) {
+            free(task->names[j]);
+        }
+        TM_FREE(task->names);
+        TM_FREE(task->symbols);
+        TM_FREE(task->path);
+    }
+    TM_FREE(walk->tasks);
+}
+
+tm_error_t tm_symbol_index_update(const char *repo_root,
+                                  const char *file,
+                                  size_t workers,
+                                  tm_symbol_index_t **index)
+{
+    TM_CHECK_NULL(repo_root, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(file, TM_ERR_INVALID_ARG);
+    TM_CHECK_NULL(index, TM_ERR_INVALID_ARG);
+
+    *index = NULL;
+
+    /* A missing or unreadable index is rebuilt from scratch */
+    tm_symbol_index_t *previous = NULL;
+    tm_symbol_index_load(file, &previous);
+
+    if (workers == 0) workers = tm_cpu_count();
+
+    walk_t walk = { .root = repo_root };
+    walk_repository(&walk, workers);
+    if (walk.count > 0) qsort(walk.tasks, walk.count, sizeof(index_task_t), compare_tasks);
+
+    for (size_t i = 0; i < walk.count; i++) {
+        walk.tasks[i].previous = previous_entry(previous, walk.tasks[i].path);
+    }
+
+    tm_parallel_for(walk.count, workers, index_file, &walk);
+
+    /* Rewrite only if a file was added, removed or changed */
+    size_t parsed = 0;
+    bool changed = !previous || previous->header->file_count != walk.count;
+    for (size_t i = 0; i < walk.count; i++) {
+        const index_task_t *task = &walk.tasks[i];
+        const tm_symbol_file_t *prev = task->previous;
+        if (!task->reused) parsed++;
+        if (!task->reused || prev->mtime_sec != (int64_t)task->mtime.tv_sec ||
+            prev->mtime_nsec != (int64_t)task->mtime.tv_nsec) {
+            changed = true;
+        }
+    }
+
+    tm_error_t err = TM_OK;
+    if (changed) {
+        err = write_index(file, &walk, previous);
+        TM_DEBUG("Symbol index %s: %zu files, %zu parsed", file, walk.count, parsed);
+    }
+    walk_free(&walk);
+
+    if (!changed) {
+        *index = previous;
+        return TM_OK;
+    }
+
+    tm_symbol_index_free(previous);
+    if (err != TM_OK) return err;
+    return tm_symbol_index_load(file, index);
+}
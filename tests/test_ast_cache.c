@@ -0,0 +1,371 @@
+/**
+ * TraceMind - AST Summary Cache Tests
+ *
+ * Writes summaries of hand-built function indexes and reads them back:
+ * the round trip itself, rejection of summaries that belong to other
+ * sources or languages, and header and bounds validation of damaged files.
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/ast_cache.h"
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ========================================================================== */
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running %s... ", #name); \
+    test_##name(); \
+    printf("PASS\n"); \
+} while (0)
+
+#define ASSERT_TRUE(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+               #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_STREQ(a, b) ASSERT_TRUE(strcmp((a), (b)) == 0)
+#define ASSERT_NOT_NULL(p) ASSERT_TRUE((p) != NULL)
+
+/* ============================================================================
+ * Fixture
+ * ========================================================================== */
+
+static char g_dir[] = "/tmp/tm_ast_cache_XXXXXX";
+
+static const char SOURCE[] =
+    "def handle(request):\n"
+    "    return respond(request)\n"
+    "\n"
+    "def respond(request):\n"
+    "    log(request)\n"
+    "    return render(request)\n";
+
+static char *summary_file(const char *name)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/%s.ast", g_dir, name);
+    return tm_strbuf_finish(&sb);
+}
+
+static tm_function_def_t def(const char *name, int start, int end)
+{
+    tm_function_def_t f = {
+        .name = tm_strdup(name),
+        .qualified_name = tm_strdup(name),
+        .start_line = start,
+        .end_line = end,
+        .start_col = 0,
+        .end_col = 30
+    };
+    tm_strbuf_t sig;
+    tm_strbuf_init(&sig);
+    tm_strbuf_appendf(&sig, "def %s(request)", name);
+    f.signature = tm_strbuf_finish(&sig);
+    return f;
+}
+
+/* Summarized index for SOURCE, as the parser would produce it */
+static tm_function_index_t *sample_index(void)
+{
+    tm_function_def_t *funcs = calloc(2, sizeof(*funcs));
+    funcs[0] = def("handle", 1, 2);
+    funcs[1] = def("respond", 4, 6);
+
+    tm_function_index_t *index = tm_function_index_new(funcs, 2);
+    index->summarized = true;
+
+    static const struct { const char *callee; int line; int column; } sites[] = {
+        { "respond", 2, 11 }, { "log", 5, 4 }, { "render", 6, 11 }
+    };
+    index->call_count = TM_ARRAY_SIZE(sites);
+    index->calls = calloc(index->call_count, sizeof(*index->calls));
+    for (size_t i = 0; i < index->call_count; i++) {
+        index->calls[i].callee_name = tm_strdup(sites[i].callee);
+        index->calls[i].line = sites[i].line;
+        index->calls[i].column = sites[i].column;
+    }
+
+    index->complexity = calloc(2, sizeof(*index->complexity));
+    index->complexity[0] = 1;
+    index->complexity[1] = 3;
+    return index;
+}
+
+/* Write the sample summary for SOURCE to file */
+static tm_error_t write_sample(const char *file)
+{
+    tm_function_index_t *index = sample_index();
+    tm_error_t err = tm_ast_cache_write(file, TM_LANG_PYTHON, SOURCE,
+                                        sizeof(SOURCE) - 1, index);
+    tm_function_index_free(index);
+    return err;
+}
+
+/* Read file as a summary of SOURCE, freeing any index it yields */
+static tm_error_t read_sample(const char *file)
+{
+    tm_function_index_t *index = NULL;
+    tm_error_t err = tm_ast_cache_read(file, TM_LANG_PYTHON, SOURCE,
+                                       sizeof(SOURCE) - 1, &index);
+    tm_function_index_free(index);
+    return err;
+}
+
+/* Overwrite len bytes at offset in file */
+static bool patch(const char *file, long offset, const void *data, size_t len)
+{
+    FILE *f = fopen(file, "r+b");
+    if (!f) return false;
+    bool ok = fseek(f, offset, SEEK_SET) == 0 && fwrite(data, 1, len, f) == len;
+    return fclose(f) == 0 && ok;
+}
+
+/* ============================================================================
+ * Tests
+ * ========================================================================== */
+
+TEST(round_trip)
+{
+    char *file = summary_file("round_trip");
+    ASSERT_EQ(write_sample(file), TM_OK);
+
+    tm_function_index_t *index = NULL;
+    ASSERT_EQ(tm_ast_cache_read(file, TM_LANG_PYTHON, SOURCE, sizeof(SOURCE) - 1, &index),
+              TM_OK);
+    ASSERT_NOT_NULL(index);
+    ASSERT_TRUE(index->summarized);
+
+    ASSERT_EQ(index->count, 2);
+    ASSERT_STREQ(index->funcs[1].name, "respond");
+    ASSERT_STREQ(index->funcs[1].qualified_name, "respond");
+    ASSERT_STREQ(index->funcs[1].signature, "def respond(request)");
+    ASSERT_EQ(index->funcs[1].start_line, 4);
+    ASSERT_EQ(index->funcs[1].end_line, 6);
+    ASSERT_EQ(index->funcs[1].end_col, 30);
+    ASSERT_EQ(index->complexity[0], 1);
+    ASSERT_EQ(index->complexity[1], 3);
+
+    size_t slot = 0;
+    ASSERT_TRUE(tm_strmap_get(&index->by_name, "respond", &slot));
+    ASSERT_EQ(slot, 1);
+
+    ASSERT_EQ(index->call_count, 3);
+    ASSERT_STREQ(index->calls[0].callee_name, "respond");
+    ASSERT_STREQ(index->calls[2].callee_name, "render");
+    ASSERT_EQ(index->calls[1].line, 5);
+    ASSERT_EQ(index->calls[1].column, 4);
+
+    tm_function_index_free(index);
+    free(file);
+}
+
+TEST(missing_file)
+{
+    char *file = summary_file("missing");
+    ASSERT_EQ(read_sample(file), TM_ERR_NOT_FOUND);
+    free(file);
+}
+
+TEST(file_named_by_content)
+{
+    char *a = tm_ast_cache_file(g_dir, SOURCE, sizeof(SOURCE) - 1);
+    char *b = tm_ast_cache_file(g_dir, SOURCE, sizeof(SOURCE) - 2);
+    ASSERT_NOT_NULL(a);
+    ASSERT_NOT_NULL(b);
+    ASSERT_TRUE(strncmp(a, g_dir, strlen(g_dir)) == 0);
+    ASSERT_TRUE(strcmp(a, b) != 0);
+    free(a);
+    free(b);
+}
+
+TEST(other_source_rejected)
+{
+    char *file = summary_file("other_source");
+    ASSERT_EQ(write_sample(file), TM_OK);
+
+    /* Same length, one byte different */
+    char edited[sizeof(SOURCE)];
+    memcpy(edited, SOURCE, sizeof(SOURCE));
+    edited[4] = 'H';
+
+    tm_function_index_t *index = NULL;
+    ASSERT_EQ(tm_ast_cache_read(file, TM_LANG_PYTHON, edited, sizeof(SOURCE) - 1, &index),
+              TM_ERR_PARSE);
+    ASSERT_TRUE(index == NULL);
+    free(file);
+}
+
+TEST(first_hash_collision_rejected)
+{
+    char *file = summary_file("collision");
+    ASSERT_EQ(write_sample(file), TM_OK);
+
+    /* Stand in for an FNV collision: the first hash and length match edited */
+    char edited[sizeof(SOURCE)];
+    memcpy(edited, SOURCE, sizeof(SOURCE));
+    edited[4] = 'H';
+    uint64_t hash = tm_hash_bytes(edited, sizeof(SOURCE) - 1);
+    ASSERT_TRUE(patch(file, offsetof(tm_ast_summary_header_t, content_hash),
+                      &hash, sizeof(hash)));
+
+    tm_function_index_t *index = NULL;
+    ASSERT_EQ(tm_ast_cache_read(file, TM_LANG_PYTHON, edited, sizeof(SOURCE) - 1, &index),
+              TM_ERR_PARSE);
+    ASSERT_TRUE(index == NULL);
+    free(file);
+}
+
+TEST(other_language_rejected)
+{
+    char *file = summary_file("other_language");
+    ASSERT_EQ(write_sample(file), TM_OK);
+
+    tm_function_index_t *index = NULL;
+    ASSERT_EQ(tm_ast_cache_read(file, TM_LANG_GO, SOURCE, sizeof(SOURCE) - 1, &index),
+              TM_ERR_PARSE);
+    ASSERT_TRUE(index == NULL);
+    free(file);
+}
+
+TEST(bad_header_rejected)
+{
+    char *file = summary_file("bad_header");
+
+    ASSERT_EQ(write_sample(file), TM_OK);
+    ASSERT_TRUE(patch(file, 0, "TMXXXXXX", 8));
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    ASSERT_EQ(write_sample(file), TM_OK);
+    uint32_t version = 1;
+    ASSERT_TRUE(patch(file, offsetof(tm_ast_summary_header_t, version),
+                      &version, sizeof(version)));
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    ASSERT_EQ(write_sample(file), TM_OK);
+    uint32_t byte_order = 0x04030201;
+    ASSERT_TRUE(patch(file, offsetof(tm_ast_summary_header_t, byte_order),
+                      &byte_order, sizeof(byte_order)));
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    free(file);
+}
+
+TEST(truncated_file_rejected)
+{
+    char *file = summary_file("truncated");
+
+    ASSERT_EQ(write_sample(file), TM_OK);
+    ASSERT_EQ(truncate(file, (off_t)sizeof(tm_ast_summary_header_t) - 4), 0);
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    /* Whole records, short string table */
+    ASSERT_EQ(write_sample(file), TM_OK);
+    off_t records = (off_t)(sizeof(tm_ast_summary_header_t) +
+                            2 * sizeof(tm_ast_summary_func_t) +
+                            3 * sizeof(tm_ast_summary_call_t));
+    ASSERT_EQ(truncate(file, records + 4), 0);
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    free(file);
+}
+
+TEST(section_sizes_rejected)
+{
+    char *file = summary_file("sections");
+
+    /* Extra functions paid for by a string table size that wraps the sum */
+    ASSERT_EQ(write_sample(file), TM_OK);
+    tm_ast_summary_header_t header;
+    FILE *f = fopen(file, "rb");
+    ASSERT_NOT_NULL(f);
+    ASSERT_EQ(fread(&header, sizeof(header), 1, f), 1);
+    fclose(f);
+    uint64_t extra = 4 * sizeof(tm_ast_summary_func_t);
+    ASSERT_TRUE(header.strings_size < extra);
+    header.function_count += 4;
+    header.strings_size -= extra;
+    ASSERT_TRUE(patch(file, 0, &header, sizeof(header)));
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    /* More calls than the file holds */
+    ASSERT_EQ(write_sample(file), TM_OK);
+    uint32_t call_count = UINT32_MAX;
+    ASSERT_TRUE(patch(file, offsetof(tm_ast_summary_header_t, call_count),
+                      &call_count, sizeof(call_count)));
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    free(file);
+}
+
+TEST(string_offsets_rejected)
+{
+    char *file = summary_file("strings");
+
+    /* A callee name past the end of the string table */
+    ASSERT_EQ(write_sample(file), TM_OK);
+    uint32_t offset = 0x10000;
+    long call = (long)(sizeof(tm_ast_summary_header_t) + 2 * sizeof(tm_ast_summary_func_t));
+    ASSERT_TRUE(patch(file, call + (long)offsetof(tm_ast_summary_call_t, callee_offset),
+                      &offset, sizeof(offset)));
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    /* A string table that does not end in NUL */
+    ASSERT_EQ(write_sample(file), TM_OK);
+    struct stat st;
+    ASSERT_EQ(stat(file, &st), 0);
+    ASSERT_TRUE(patch(file, (long)st.st_size - 1, "x", 1));
+    ASSERT_EQ(read_sample(file), TM_ERR_PARSE);
+
+    free(file);
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+int main(void)
+{
+    printf("AST Summary Cache Tests\n");
+    printf("=======================\n\n");
+
+    if (!mkdtemp(g_dir)) {
+        printf("Cannot create %s\n", g_dir);
+        return 1;
+    }
+
+    printf("Round Trip:\n");
+    RUN_TEST(round_trip);
+    RUN_TEST(missing_file);
+    RUN_TEST(file_named_by_content);
+
+    printf("\nMatching:\n");
+    RUN_TEST(other_source_rejected);
+    RUN_TEST(first_hash_collision_rejected);
+    RUN_TEST(other_language_rejected);
+
+    printf("\nValidation:\n");
+    RUN_TEST(bad_header_rejected);
+    RUN_TEST(truncated_file_rejected);
+    RUN_TEST(section_sizes_rejected);
+    RUN_TEST(string_offsets_rejected);
+
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_dir);
+    if (system(cmd) != 0) printf("Could not remove %s\n", g_dir);
+
+    printf("\n=======================\n");
+    printf("All tests passed!\n");
+
+    return 0;
+}
@@ -0,0 +1,416 @@
+/**
+ * TraceMind - Call Graph Tests
+ *
+ * Frees hand-built graphs of both layouts, and, with tree-sitter, expands
+ * graphs from a small Python module: the depth limit, the per-depth node
+ * budget, deduplication of nodes and edges, the CSR edge layout, and a
+ * builder reused across an edit of a traced file.
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/ast.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ========================================================================== */
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running %s... ", #name); \
+    test_##name(); \
+    printf("PASS\n"); \
+} while (0)
+
+#define ASSERT_TRUE(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+               #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_STREQ(a, b) ASSERT_TRUE(strcmp((a), (b)) == 0)
+#define ASSERT_NOT_NULL(p) ASSERT_TRUE((p) != NULL)
+
+/* ============================================================================
+ * Hand-Built Graphs
+ * ========================================================================== */
+
+static tm_call_node_t *hand_node(const char *name, int line)
+{
+    tm_call_node_t *node = tm_calloc(1, sizeof(*node));
+    node->name = tm_strdup(name);
+    node->file = tm_strdup("app/handlers.py");
+    node->signature = tm_strdup(name);
+    node->start_line = line;
+    node->end_line = line + 2;
+    return node;
+}
+
+/* Three nodes, a -> b -> c, without edges */
+static tm_call_graph_t *hand_graph(void)
+{
+    tm_call_graph_t *graph = tm_calloc(1, sizeof(*graph));
+    graph->node_count = 3;
+    graph->node_capacity = 3;
+    graph->nodes = tm_calloc(3, sizeof(tm_call_node_t *));
+    graph->nodes[0] = hand_node("a", 1);
+    graph->nodes[1] = hand_node("b", 5);
+    graph->nodes[2] = hand_node("c", 9);
+    graph->entry_point = graph->nodes[0];
+    return graph;
+}
+
+/* Give node a one-entry edge list of its own */
+static tm_call_node_t **own_list(tm_call_node_t *node)
+{
+    tm_call_node_t **list = tm_malloc(sizeof(tm_call_node_t *));
+    list[0] = node;
+    return list;
+}
+
+TEST(free_hand_built_edge_lists)
+{
+    tm_call_graph_t *graph = hand_graph();
+    tm_call_node_t **n = graph->nodes;
+
+    /* Every node owns its lists, as graphs built node by node do */
+    n[0]->callees = own_list(n[1]);
+    n[0]->callee_count = 1;
+    n[1]->callers = own_list(n[0]);
+    n[1]->caller_count = 1;
+    n[1]->callees = own_list(n[2]);
+    n[1]->callee_count = 1;
+    n[2]->callers = own_list(n[1]);
+    n[2]->caller_count = 1;
+    graph->edge_count = 2;
+
+    ASSERT_TRUE(graph->adjacency == NULL);
+    ASSERT_TRUE(graph->node_block == NULL);
+    tm_call_graph_free(graph);
+}
+
+TEST(free_hand_built_adjacency)
+{
+    tm_call_graph_t *graph = hand_graph();
+    tm_call_node_t **n = graph->nodes;
+
+    /* Separate nodes, edge lists in one shared array */
+    graph->edge_count = 2;
+    graph->adjacency = tm_malloc(4 * sizeof(tm_call_node_t *));
+    graph->adjacency[0] = n[1];
+    graph->adjacency[1] = n[2];
+    graph->adjacency[2] = n[0];
+    graph->adjacency[3] = n[1];
+    n[0]->callees = &graph->adjacency[0];
+    n[0]->callee_count = 1;
+    n[1]->callees = &graph->adjacency[1];
+    n[1]->callee_count = 1;
+    n[1]->callers = &graph->adjacency[2];
+    n[1]->caller_count = 1;
+    n[2]->callers = &graph->adjacency[3];
+    n[2]->caller_count = 1;
+
+    tm_call_graph_free(graph);
+}
+
+TEST(free_empty_graph)
+{
+    tm_call_graph_free(NULL);
+    tm_call_graph_free(tm_calloc(1, sizeof(tm_call_graph_t)));
+}
+
+#ifdef HAVE_TREE_SITTER
+
+/* ============================================================================
+ * Expansion
+ * ========================================================================== */
+
+static char g_dir[] = "/tmp/tm_call_graph_XXXXXX";
+static char g_module[PATH_MAX];
+
+/*
+ * Depths from entry:
+ *
+ *   0  entry
+ *   1  first, second         entry calls first twice
+ *   2  shared, leaf          shared is called by first and second
+ *   3  deep
+ *   4  deeper
+ */
+static const char MODULE[] =
+    "def entry():\n"
+    "    first()\n"
+    "    second()\n"
+    "    first()\n"
+    "\n"
+    "def first():\n"
+    "    shared()\n"
+    "\n"
+    "def second():\n"
+    "    shared()\n"
+    "    leaf()\n"
+    "\n"
+    "def shared():\n"
+    "    deep()\n"
+    "\n"
+    "def deep():\n"
+    "    deeper()\n"
+    "\n"
+    "def deeper():\n"
+    "    return None\n"
+    "\n"
+    "def leaf():\n"
+    "    return None\n";
+
+static bool write_module(void)
+{
+    if (!mkdtemp(g_dir)) return false;
+    snprintf(g_module, sizeof(g_module), "%s/handlers.py", g_dir);
+    return tm_write_file_atomic(g_module, MODULE, sizeof(MODULE) - 1) == TM_OK;
+}
+
+/* Graph from entry, with at most per_depth nodes at each depth (0: default) */
+static tm_call_graph_t *expand(int max_depth, size_t per_depth)
+{
+    tm_ast_builder_t *builder = tm_ast_builder_new();
+    if (per_depth > 0) builder->max_nodes_per_depth = per_depth;
+    builder->time_budget_ms = 0;
+
+    tm_call_graph_t *graph = NULL;
+    if (tm_ast_add_file(builder, g_module) == TM_OK) {
+        graph = tm_ast_build_call_graph(builder, "entry", max_depth);
+    }
+    tm_ast_builder_free(builder);
+    return graph;
+}
+
+static const tm_call_node_t *find_node(const tm_call_graph_t *graph, const char *name)
+{
+    for (size_t i = 0; i < graph->node_count; i++) {
+        if (strcmp(graph->nodes[i]->name, name) == 0) return graph->nodes[i];
+    }
+    return NULL;
+}
+
+/* Whether list[0..count) lies in the graph's adjacency array at [from, to) */
+static bool in_adjacency(const tm_call_graph_t *graph, tm_call_node_t *const *list,
+                         size_t count, size_t from, size_t to)
+{
+    if (count == 0) return list == NULL;
+    return list >= graph->adjacency + from && list + count <= graph->adjacency + to;
+}
+
+TEST(depth_limit)
+{
+    tm_call_graph_t *graph = expand(2, 0);
+    ASSERT_NOT_NULL(graph);
+    ASSERT_EQ(graph->node_count, 5);
+    ASSERT_NOT_NULL(find_node(graph, "leaf"));
+    ASSERT_TRUE(find_node(graph, "deep") == NULL);
+    tm_call_graph_free(graph);
+
+    graph = expand(4, 0);
+    ASSERT_NOT_NULL(graph);
+    ASSERT_EQ(graph->node_count, 7);
+    ASSERT_NOT_NULL(find_node(graph, "deeper"));
+    tm_call_graph_free(graph);
+}
+
+TEST(per_depth_budget)
+{
+    /* One node per depth: second is dropped, and with it leaf */
+    tm_call_graph_t *graph = expand(3, 1);
+    ASSERT_NOT_NULL(graph);
+    ASSERT_EQ(graph->node_count, 4);
+    ASSERT_NOT_NULL(find_node(graph, "first"));
+    ASSERT_TRUE(find_node(graph, "second") == NULL);
+    ASSERT_TRUE(find_node(graph, "leaf") == NULL);
+    ASSERT_NOT_NULL(find_node(graph, "deep"));
+    ASSERT_EQ(graph->edge_count, 3);
+    tm_call_graph_free(graph);
+}
+
+TEST(visited_dedup)
+{
+    tm_call_graph_t *graph = expand(2, 0);
+    ASSERT_NOT_NULL(graph);
+
+    /* first is called twice, shared reached twice: one node, one edge each */
+    const tm_call_node_t *entry = graph->entry_point;
+    ASSERT_NOT_NULL(entry);
+    ASSERT_STREQ(entry->name, "entry");
+    ASSERT_EQ(entry->callee_count, 2);
+
+    const tm_call_node_t *shared = find_node(graph, "shared");
+    ASSERT_NOT_NULL(shared);
+    ASSERT_EQ(shared->caller_count, 2);
+    ASSERT_EQ(graph->edge_count, 5);
+
+    tm_call_graph_free(graph);
+}
+
+TEST(csr_layout)
+{
+    tm_call_graph_t *graph = expand(4, 0);
+    ASSERT_NOT_NULL(graph);
+    ASSERT_NOT_NULL(graph->node_block);
+    ASSERT_NOT_NULL(graph->adjacency);
+    size_t e = graph->edge_count;
+
+    /* Nodes live in one block, callees in the first half of the edges */
+    size_t callees = 0, callers = 0;
+    for (size_t i = 0; i < graph->node_count; i++) {
+        const tm_call_node_t *node = graph->nodes[i];
+        ASSERT_TRUE(node == &graph->node_block[i]);
+        ASSERT_TRUE(in_adjacency(graph, node->callees, node->callee_count, 0, e));
+        ASSERT_TRUE(in_adjacency(graph, node->callers, node->caller_count, e, 2 * e));
+        callees += node->callee_count;
+        callers += node->caller_count;
+    }
+    ASSERT_EQ(callees, e);
+    ASSERT_EQ(callers, e);
+
+    /* Grouped by node, in call-site and discovery order */
+    const tm_call_node_t *entry = graph->entry_point;
+    ASSERT_TRUE(entry->callees == graph->adjacency);
+    ASSERT_STREQ(entry->callees[0]->name, "first");
+    ASSERT_STREQ(entry->callees[1]->name, "second");
+
+    const tm_call_node_t *shared = find_node(graph, "shared");
+    ASSERT_STREQ(shared->callers[0]->name, "first");
+    ASSERT_STREQ(shared->callers[1]->name, "second");
+    ASSERT_STREQ(shared->callees[0]->name, "deep");
+
+    /* Shared strings come from the one table */
+    ASSERT_TRUE(entry->file == shared->file);
+
+    tm_call_graph_free(graph);
+}
+
+TEST(unknown_entry)
+{
+    tm_ast_builder_t *builder = tm_ast_builder_new();
+    ASSERT_EQ(tm_ast_add_file(builder, g_module), TM_OK);
+
+    tm_call_graph_t *graph = tm_ast_build_call_graph(builder, "missing", 3);
+    tm_ast_builder_free(builder);
+    ASSERT_NOT_NULL(graph);
+    ASSERT_EQ(graph->node_count, 0);
+    ASSERT_EQ(graph->edge_count, 0);
+    ASSERT_TRUE(graph->entry_point == NULL);
+    tm_call_graph_free(graph);
+}
+
+/* Replace the file under g_dir, with a later mtime however coarse the clock */
+static bool rewrite(const char *name, const char *content, int seconds)
+{
+    char path[PATH_MAX + 32];
+    snprintf(path, sizeof(path), "%s/%s", g_dir, name);
+    if (tm_write_file_atomic(path, content, strlen(content)) != TM_OK) return false;
+
+    struct timespec times[2] = { { .tv_nsec = UTIME_OMIT }, { .tv_sec = time(NULL) + seconds } };
+    return utimensat(AT_FDCWD, path, times, 0) == 0;
+}
+
+TEST(builder_reused_after_edit)
+{
+    ASSERT_TRUE(rewrite("service.py",
+                        "def handler():\n"
+                        "    validate()\n"
+                        "\n"
+                        "def validate():\n"
+                        "    return None\n", 10));
+
+    tm_stack_frame_t frame = { .function = "handler", .file = "service.py", .line = 2 };
+    tm_stack_trace_t trace = { .language = TM_LANG_PYTHON, .frames = &frame, .frame_count = 1 };
+
+    tm_graph_builder_t *builder = tm_graph_builder_new(g_dir, 3);
+    builder->time_budget_ms = 0;
+
+    tm_call_graph_t *graph = NULL;
+    ASSERT_EQ(tm_graph_builder_build(builder, &trace, &graph), TM_OK);
+    ASSERT_EQ(graph->node_count, 2);
+    ASSERT_EQ(find_node(graph, "validate")->start_line, 4);
+    tm_call_graph_free(graph);
+
+    /* Definitions shift down three lines; validate now calls normalize */
+    ASSERT_TRUE(rewrite("service.py",
+                        "import os\n"
+                        "\n"
+                        "\n"
+                        "def handler():\n"
+                        "    validate()\n"
+                        "\n"
+                        "def validate():\n"
+                        "    return normalize(os.sep)\n"
+                        "\n"
+                        "def normalize(value):\n"
+                        "    return value\n", 20));
+    frame.line = 5;
+
+    ASSERT_EQ(tm_graph_builder_build(builder, &trace, &graph), TM_OK);
+    ASSERT_EQ(builder->file_count, 1);
+    ASSERT_EQ(graph->node_count, 3);
+    ASSERT_EQ(graph->entry_point->start_line, 4);
+
+    const tm_call_node_t *validate = find_node(graph, "validate");
+    ASSERT_NOT_NULL(validate);
+    ASSERT_EQ(validate->start_line, 7);
+    ASSERT_EQ(validate->end_line, 8);
+    ASSERT_EQ(validate->callee_count, 1);
+    ASSERT_STREQ(validate->callees[0]->name, "normalize");
+    ASSERT_EQ(validate->callees[0]->start_line, 10);
+
+    tm_call_graph_free(graph);
+    tm_graph_builder_free(builder);
+}
+
+#endif /* HAVE_TREE_SITTER */
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+int main(void)
+{
+    printf("Call Graph Tests\n");
+    printf("================\n\n");
+
+    printf("Freeing:\n");
+    RUN_TEST(free_hand_built_edge_lists);
+    RUN_TEST(free_hand_built_adjacency);
+    RUN_TEST(free_empty_graph);
+
+#ifdef HAVE_TREE_SITTER
+    if (!write_module()) {
+        printf("Cannot write %s\n", g_module);
+        return 1;
+    }
+
+    printf("\nExpansion:\n");
+    RUN_TEST(depth_limit);
+    RUN_TEST(per_depth_budget);
+    RUN_TEST(visited_dedup);
+    RUN_TEST(csr_layout);
+    RUN_TEST(unknown_entry);
+    RUN_TEST(builder_reused_after_edit);
+
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_dir);
+    if (system(cmd) != 0) printf("Could not remove %s\n", g_dir);
+#else
+    printf("\nExpansion: skipped (no tree-sitter)\n");
+#endif
+
+    printf("\n================\n");
+    printf("All tests passed!\n");
+
+    return 0;
+}
@@ -0,0 +1,363 @@
+/**
+ * TraceMind - Commit-Graph Reader Tests
+ *
+ * Checks the Bloom key hash against known answers for both filter versions,
+ * then reads a split commit-graph chain written by the git CLI and asks its
+ * changed-path filters about every path each commit touched. Fixture tests
+ * are skipped when git is missing or cannot write changed-path filters.
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/commit_graph.h"
+#include <assert.h>
+#include <string.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ========================================================================== */
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running %s... ", #name); \
+    test_##name(); \
+    printf("PASS\n"); \
+} while (0)
+
+#define ASSERT_TRUE(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+               #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_NOT_NULL(p) ASSERT_TRUE((p) != NULL)
+#define ASSERT_CASE(cond, i) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Case %zu: %s\n    at %s:%d\n", \
+               (size_t)(i), #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define SKIP_WITHOUT_FIXTURE() do { \
+    if (!g_fixture) { \
+        printf("skipped (%s) ", g_skip_reason); \
+        return; \
+    } \
+} while (0)
+
+/* ============================================================================
+ * Fixture
+ * ========================================================================== */
+
+static char g_dir[] = "/tmp/tm_commit_graph_XXXXXX";
+static bool g_created;
+static bool g_fixture;
+static const char *g_skip_reason = "no fixture";
+static int g_commit_seq;
+
+/* A path with bytes >= 0x80, hashed differently by the two filter versions */
+#define HIGHBIT_PATH "docs/caf\xc3\xa9.md"
+
+/* Run a shell command in the fixture repository, quietly */
+static bool run(const char *fmt, ...)
+{
+    char cmd[1024];
+    int n = snprintf(cmd, sizeof(cmd), "cd '%s' && ", g_dir);
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(cmd + n, sizeof(cmd) - (size_t)n, fmt, args);
+    va_end(args);
+
+    strncat(cmd, " >/dev/null 2>&1", sizeof(cmd) - strlen(cmd) - 1);
+    return system(cmd) == 0;
+}
+
+/* Output of a command run in the fixture repository (caller frees) */
+static char *capture(const char *fmt, ...)
+{
+    char cmd[1024];
+    int n = snprintf(cmd, sizeof(cmd), "cd '%s' && ", g_dir);
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(cmd + n, sizeof(cmd) - (size_t)n, fmt, args);
+    va_end(args);
+
+    FILE *p = popen(cmd, "r");
+    if (!p) return NULL;
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    char buf[4096];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), p)) > 0) {
+        tm_strbuf_append_len(&sb, buf, got);
+    }
+    if (pclose(p) != 0) {
+        tm_strbuf_free(&sb);
+        return NULL;
+    }
+    return tm_strbuf_finish(&sb);
+}
+
+/* Append a line to a file and commit everything, one hour after the last */
+static bool commit_edit(const char *rel, const char *message)
+{
+    char date[32];
+    snprintf(date, sizeof(date), "@%lld +0000", 1700000000LL + 3600LL * ++g_commit_seq);
+    setenv("GIT_AUTHOR_DATE", date, 1);
+    setenv("GIT_COMMITTER_DATE", date, 1);
+    return run("echo '%s' >> '%s' && git add -A && git commit -q -m '%s'",
+               message, rel, message);
+}
+
+/*
+ *   1    adds src/app.py and the high-bit path; commit-graph base layer
+ *   2-3  edit src/app.py, then the high-bit path
+ *   4    adds lib/util/strings.py; second layer split on top of the first
+ */
+static bool build_fixture(void)
+{
+    setenv("GIT_CONFIG_NOSYSTEM", "1", 1);
+    setenv("GIT_CONFIG_GLOBAL", "/dev/null", 1);
+    setenv("GIT_AUTHOR_NAME", "Test Author", 1);
+    setenv("GIT_AUTHOR_EMAIL", "author@example.com", 1);
+    setenv("GIT_COMMITTER_NAME", "Test Committer", 1);
+    setenv("GIT_COMMITTER_EMAIL", "committer@example.com", 1);
+
+    if (!run("git init -q && git config gc.auto 0 && mkdir -p src docs lib/util")) {
+        return false;
+    }
+
+    bool ok = run("echo app > src/app.py") && commit_edit(HIGHBIT_PATH, "Initial import");
+    ok = ok && run("git commit-graph write --reachable --changed-paths --split");
+    ok = ok && commit_edit("src/app.py", "Tune app");
+    ok = ok && commit_edit(HIGHBIT_PATH, "Document app");
+    ok = ok && commit_edit("lib/util/strings.py", "Add string helpers");
+    ok = ok && run("git commit-graph write --reachable --changed-paths --split=no-merge");
+    return ok;
+}
+
+static void setup_fixture(void)
+{
+    if (system("git --version >/dev/null 2>&1") != 0) {
+        g_skip_reason = "git not installed";
+        return;
+    }
+    if (!mkdtemp(g_dir)) {
+        g_skip_reason = "no temp dir";
+        return;
+    }
+    g_created = true;
+    if (!build_fixture()) {
+        g_skip_reason = "git cannot write split changed-path filters";
+        return;
+    }
+
+    g_fixture = true;
+}
+
+static void teardown_fixture(void)
+{
+    if (!g_created) return;
+
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_dir);
+    if (system(cmd) != 0) printf("Could not remove %s\n", g_dir);
+}
+
+static tm_commit_graph_t *open_fixture_graph(void)
+{
+    char objects[PATH_MAX];
+    snprintf(objects, sizeof(objects), "%s/.git/objects", g_dir);
+
+    tm_commit_graph_t *graph = NULL;
+    if (tm_commit_graph_open(objects, &graph) != TM_OK) return NULL;
+    return graph;
+}
+
+static bool oid_from_hex(const char *hex, uint8_t oid[TM_COMMIT_GRAPH_OID_SIZE])
+{
+    for (size_t i = 0; i < TM_COMMIT_GRAPH_OID_SIZE; i++) {
+        unsigned int byte;
+        if (sscanf(hex + 2 * i, "%2x", &byte) != 1) return false;
+        oid[i] = (uint8_t)byte;
+    }
+    return true;
+}
+
+/* ============================================================================
+ * Murmur3 Tests
+ * ========================================================================== */
+
+/*
+ * Unseeded vectors are git's t0095-bloom.sh; the seeded ones are the first
+ * two key hashes it prints for "Hello world!". The high-bit string is the
+ * one git added with version 2 filters: version 1 sign-extends its bytes.
+ */
+TEST(murmur3_known_answers)
+{
+    static const struct {
+        uint32_t seed;
+        const char *data;
+        uint32_t version;
+        uint32_t expected;
+    } cases[] = {
+        { 0, "", 2, 0x00000000u },
+        { 0, "Hello world!", 2, 0x627b0c2cu },
+        { 0, "The quick brown fox jumps over the lazy dog", 2, 0x2e4ff723u },
+        { 0, "\x99\xaa\xbb\xcc\xdd\xee\xff", 2, 0xa183ccfdu },
+        { 0, "\x99\xaa\xbb\xcc\xdd\xee\xff", 1, 0xdd92776eu },
+        { TM_BLOOM_SEED0, "Hello world!", 2, 0xb270de9bu },
+        { TM_BLOOM_SEED0, "Hello world!", 1, 0xb270de9bu },
+    };
+
+    for (size_t i = 0; i < TM_ARRAY_SIZE(cases); i++) {
+        uint32_t hash = tm_commit_graph_murmur3(cases[i].seed, cases[i].data,
+                                                strlen(cases[i].data), cases[i].version);
+        ASSERT_CASE(hash == cases[i].expected, i);
+    }
+
+    /* Second key hash: hash0 + hash1 */
+    uint32_t hash0 = tm_commit_graph_murmur3(TM_BLOOM_SEED0, "Hello world!", 12, 2);
+    uint32_t hash1 = tm_commit_graph_murmur3(TM_BLOOM_SEED1, "Hello world!", 12, 2);
+    ASSERT_EQ((uint32_t)(hash0 + hash1), 0x1bb6f26eu);
+}
+
+TEST(murmur3_versions_agree_on_ascii)
+{
+    const char *key = "src/app/handlers/request.py";
+    for (size_t len = 0; len <= strlen(key); len++) {
+        ASSERT_CASE(tm_commit_graph_murmur3(TM_BLOOM_SEED1, key, len, 1) ==
+                    tm_commit_graph_murmur3(TM_BLOOM_SEED1, key, len, 2), len);
+    }
+}
+
+/* ============================================================================
+ * Split Chain Tests
+ * ========================================================================== */
+
+TEST(chain_has_two_layers)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    tm_commit_graph_t *graph = open_fixture_graph();
+    ASSERT_NOT_NULL(graph);
+    ASSERT_EQ(graph->layer_count, 2);
+    ASSERT_EQ(graph->layers[0].commit_count, 1);
+    ASSERT_EQ(graph->layers[1].commit_count, 3);
+    ASSERT_TRUE(tm_commit_graph_has_bloom(graph));
+
+    tm_commit_graph_free(graph);
+}
+
+/*
+ * Every path a commit changed, and each of its leading directories, must
+ * test positive: a false negative would drop the commit from a walk.
+ */
+TEST(filters_match_git_diff_tree)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    tm_commit_graph_t *graph = open_fixture_graph();
+    ASSERT_NOT_NULL(graph);
+
+    char *log = capture("git log --format=%%H");
+    ASSERT_NOT_NULL(log);
+
+    size_t checked = 0;
+    char *save = NULL;
+    for (char *sha = strtok_r(log, "\n", &save); sha; sha = strtok_r(NULL, "\n", &save)) {
+        uint8_t oid[TM_COMMIT_GRAPH_OID_SIZE];
+        ASSERT_TRUE(oid_from_hex(sha, oid));
+
+        char *paths = capture("git -c core.quotepath=off diff-tree --root "
+                              "--no-commit-id --name-only -r %s", sha);
+        ASSERT_NOT_NULL(paths);
+
+        char *psave = NULL;
+        for (char *path = strtok_r(paths, "\n", &psave); path;
+             path = strtok_r(NULL, "\n", &psave)) {
+            const char *query = path;
+            ASSERT_EQ(tm_commit_graph_maybe_changed(graph, oid, &query, 1), 1);
+            checked++;
+        }
+        free(paths);
+    }
+    free(log);
+    tm_commit_graph_free(graph);
+
+    /* Five paths over four commits */
+    ASSERT_EQ(checked, 5);
+}
+
+/* Version 1 filters only match the high-bit path with sign extension */
+TEST(highbit_path_in_upper_layer)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    tm_commit_graph_t *graph = open_fixture_graph();
+    ASSERT_NOT_NULL(graph);
+
+    char *sha = capture("git rev-parse HEAD~1");
+    ASSERT_NOT_NULL(sha);
+    uint8_t oid[TM_COMMIT_GRAPH_OID_SIZE];
+    ASSERT_TRUE(oid_from_hex(sha, oid));
+    free(sha);
+
+    const char *changed = HIGHBIT_PATH;
+    const char *untouched = "lib/util/strings.py";
+    ASSERT_EQ(tm_commit_graph_maybe_changed(graph, oid, &changed, 1), 1);
+    ASSERT_EQ(tm_commit_graph_maybe_changed(graph, oid, &untouched, 1), 0);
+
+    tm_commit_graph_free(graph);
+}
+
+TEST(commit_outside_graph)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    tm_commit_graph_t *graph = open_fixture_graph();
+    ASSERT_NOT_NULL(graph);
+
+    uint8_t oid[TM_COMMIT_GRAPH_OID_SIZE];
+    memset(oid, 0xee, sizeof(oid));
+    const char *path = "src/app.py";
+    ASSERT_EQ(tm_commit_graph_maybe_changed(graph, oid, &path, 1), -1);
+
+    tm_commit_graph_free(graph);
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+int main(void)
+{
+    printf("Commit-Graph Reader Tests\n");
+    printf("=========================\n\n");
+
+    printf("Murmur3:\n");
+    RUN_TEST(murmur3_known_answers);
+    RUN_TEST(murmur3_versions_agree_on_ascii);
+
+    setup_fixture();
+
+    printf("\nSplit Chain:\n");
+    RUN_TEST(chain_has_two_layers);
+    RUN_TEST(filters_match_git_diff_tree);
+    RUN_TEST(highbit_path_in_upper_layer);
+    RUN_TEST(commit_outside_graph);
+
+    teardown_fixture();
+
+    printf("\n=========================\n");
+    printf("All tests passed!\n");
+
+    return 0;
+}
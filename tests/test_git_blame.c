@@ -0,0 +1,248 @@
+/**
+ * TraceMind - Blame Cache Tests
+ *
+ * Builds a fixture repository with the git CLI in which two paths hold the
+ * same blob but were added by different commits, and checks that cached
+ * blame keeps them apart. Skipped when git is missing or the build has no
+ * blame (no libgit2).
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/git.h"
+#include <assert.h>
+#include <dirent.h>
+#include <string.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ========================================================================== */
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running %s... ", #name); \
+    test_##name(); \
+    printf("PASS\n"); \
+} while (0)
+
+#define ASSERT_TRUE(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+               #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_STREQ(a, b) ASSERT_TRUE(strcmp((a), (b)) == 0)
+#define ASSERT_NOT_NULL(p) ASSERT_TRUE((p) != NULL)
+
+#define SKIP_WITHOUT_FIXTURE() do { \
+    if (!g_fixture) { \
+        printf("skipped (%s) ", g_skip_reason); \
+        return; \
+    } \
+} while (0)
+
+/* ============================================================================
+ * Fixture
+ * ========================================================================== */
+
+static char g_dir[] = "/tmp/tm_git_blame_XXXXXX";
+static char g_cache[PATH_MAX];
+static bool g_created;
+static bool g_fixture;
+static const char *g_skip_reason = "no fixture";
+static int g_commit_seq;
+static char g_first_sha[41];
+static char g_second_sha[41];
+
+/* Run a shell command in the fixture repository, quietly */
+static bool run(const char *fmt, ...)
+{
+    char cmd[1024];
+    int n = snprintf(cmd, sizeof(cmd), "cd '%s' && ", g_dir);
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(cmd + n, sizeof(cmd) - (size_t)n, fmt, args);
+    va_end(args);
+
+    strncat(cmd, " >/dev/null 2>&1", sizeof(cmd) - strlen(cmd) - 1);
+    return system(cmd) == 0;
+}
+
+/* Commit everything one hour after the last commit and record its SHA */
+static bool commit(const char *message, char sha[41])
+{
+    char date[32];
+    snprintf(date, sizeof(date), "@%lld +0000", 1700000000LL + 3600LL * ++g_commit_seq);
+    setenv("GIT_AUTHOR_DATE", date, 1);
+    setenv("GIT_COMMITTER_DATE", date, 1);
+    if (!run("git add -A && git commit -q -m '%s'", message)) return false;
+
+    char cmd[PATH_MAX + 32];
+    snprintf(cmd, sizeof(cmd), "cd '%s' && git rev-parse HEAD", g_dir);
+    FILE *p = popen(cmd, "r");
+    if (!p) return false;
+    bool ok = fgets(sha, 41, p) != NULL && strlen(sha) == 40;
+    return pclose(p) == 0 && ok;
+}
+
+/*
+ *   1    adds src/handlers.py
+ *   2    copies it to src/legacy/handlers.py (same blob, new history)
+ */
+static bool build_fixture(void)
+{
+    setenv("GIT_CONFIG_NOSYSTEM", "1", 1);
+    setenv("GIT_CONFIG_GLOBAL", "/dev/null", 1);
+    setenv("GIT_AUTHOR_NAME", "Test Author", 1);
+    setenv("GIT_AUTHOR_EMAIL", "author@example.com", 1);
+    setenv("GIT_COMMITTER_NAME", "Test Committer", 1);
+    setenv("GIT_COMMITTER_EMAIL", "committer@example.com", 1);
+
+    if (!run("git init -q && mkdir -p src/legacy")) return false;
+
+    bool ok = run("printf 'def handle(request):\\n    return respond(request)\\n' "
+                  "> src/handlers.py") && commit("Add handlers", g_first_sha);
+    ok = ok && run("cp src/handlers.py src/legacy/handlers.py") &&
+         commit("Keep legacy handlers", g_second_sha);
+    ok = ok && run("test \"$(git rev-parse HEAD:src/handlers.py)\" = "
+                   "\"$(git rev-parse HEAD:src/legacy/handlers.py)\"");
+    return ok;
+}
+
+static void setup_fixture(void)
+{
+    if (system("git --version >/dev/null 2>&1") != 0) {
+        g_skip_reason = "git not installed";
+        return;
+    }
+    if (!mkdtemp(g_dir)) {
+        g_skip_reason = "no temp dir";
+        return;
+    }
+    g_created = true;
+    snprintf(g_cache, sizeof(g_cache), "%s/.cache", g_dir);
+    if (!build_fixture()) {
+        g_skip_reason = "fixture setup failed";
+        return;
+    }
+
+    tm_git_repo_t *repo = NULL;
+    tm_error_t err = tm_git_repo_open(g_dir, &repo);
+    if (err == TM_OK) err = tm_git_repo_use_blame_cache(repo, g_cache);
+    tm_git_repo_free(repo);
+    if (err != TM_OK) {
+        g_skip_reason = "no blame support";
+        return;
+    }
+
+    g_fixture = true;
+}
+
+static void teardown_fixture(void)
+{
+    if (!g_created) return;
+
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_dir);
+    if (system(cmd) != 0) printf("Could not remove %s\n", g_dir);
+}
+
+/* Blame line 1 of path through the cache; caller frees */
+static tm_git_blame_t *blame_first_line(const char *path)
+{
+    tm_git_repo_t *repo = NULL;
+    if (tm_git_repo_open(g_dir, &repo) != TM_OK) return NULL;
+
+    tm_blame_request_t request = { .file_path = path, .line = 1 };
+    if (tm_git_repo_use_blame_cache(repo, g_cache) == TM_OK) {
+        tm_git_blame_lines(repo, &request, 1);
+    }
+    tm_git_repo_free(repo);
+    return request.blame;
+}
+
+static size_t cache_entries(void)
+{
+    char dir[PATH_MAX + 8];
+    snprintf(dir, sizeof(dir), "%s/blame", g_cache);
+
+    DIR *d = opendir(dir);
+    if (!d) return 0;
+
+    size_t count = 0;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        size_t len = strlen(de->d_name);
+        if (len > 5 && strcmp(de->d_name + len - 5, ".json") == 0) count++;
+    }
+    closedir(d);
+    return count;
+}
+
+/* ============================================================================
+ * Tests
+ * ========================================================================== */
+
+TEST(shared_blob_keeps_path_history)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    /* Fill the cache from the original path first */
+    tm_git_blame_t *original = blame_first_line("src/handlers.py");
+    ASSERT_NOT_NULL(original);
+    ASSERT_STREQ(original->sha, g_first_sha);
+    tm_git_blames_free(original, 1);
+
+    tm_git_blame_t *copy = blame_first_line("src/legacy/handlers.py");
+    ASSERT_NOT_NULL(copy);
+    ASSERT_STREQ(copy->sha, g_second_sha);
+    tm_git_blames_free(copy, 1);
+
+    ASSERT_EQ(cache_entries(), 2);
+}
+
+TEST(cached_blame_matches_fresh)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    /* Both paths are cached by now; answers must not change */
+    tm_git_blame_t *original = blame_first_line("src/handlers.py");
+    tm_git_blame_t *copy = blame_first_line("src/legacy/handlers.py");
+    ASSERT_NOT_NULL(original);
+    ASSERT_NOT_NULL(copy);
+    ASSERT_STREQ(original->sha, g_first_sha);
+    ASSERT_STREQ(copy->sha, g_second_sha);
+    tm_git_blames_free(original, 1);
+    tm_git_blames_free(copy, 1);
+
+    ASSERT_EQ(cache_entries(), 2);
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+int main(void)
+{
+    printf("Blame Cache Tests\n");
+    printf("=================\n\n");
+
+    tm_git_init();
+    setup_fixture();
+
+    printf("Shared Blobs:\n");
+    RUN_TEST(shared_blob_keeps_path_history);
+    RUN_TEST(cached_blame_matches_fresh);
+
+    teardown_fixture();
+    tm_git_cleanup();
+
+    printf("\n=================\n");
+    printf("All tests passed!\n");
+
+    return 0;
+}
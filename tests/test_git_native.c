@@ -0,0 +1,517 @@
+/**
+ * TraceMind - Native Git Reader Tests
+ *
+ * Builds a fixture repository with the git CLI and checks the object
+ * reader and commit walk against git itself. Skipped when git is missing
+ * or the build has no object reader (no zlib).
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/git.h"
+#include "internal/git_odb.h"
+#include <assert.h>
+#include <string.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ========================================================================== */
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running %s... ", #name); \
+    test_##name(); \
+    printf("PASS\n"); \
+} while (0)
+
+#define ASSERT_TRUE(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+               #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_STREQ(a, b) ASSERT_TRUE(strcmp((a), (b)) == 0)
+#define ASSERT_NOT_NULL(p) ASSERT_TRUE((p) != NULL)
+
+#define SKIP_WITHOUT_FIXTURE() do { \
+    if (!g_fixture) { \
+        printf("skipped (%s) ", g_skip_reason); \
+        return; \
+    } \
+} while (0)
+
+/* ============================================================================
+ * Fixture
+ * ========================================================================== */
+
+static char g_dir[] = "/tmp/tm_git_native_XXXXXX";
+static bool g_created;
+static bool g_fixture;
+static const char *g_skip_reason = "no fixture";
+static int g_commit_seq;
+
+/* Run a shell command in the fixture repository, quietly */
+static bool run(const char *fmt, ...)
+{
+    char cmd[1024];
+    int n = snprintf(cmd, sizeof(cmd), "cd '%s' && ", g_dir);
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(cmd + n, sizeof(cmd) - (size_t)n, fmt, args);
+    va_end(args);
+
+    strncat(cmd, " >/dev/null 2>&1", sizeof(cmd) - strlen(cmd) - 1);
+    return system(cmd) == 0;
+}
+
+/* Output of a command run in the fixture repository (caller frees) */
+static char *capture(const char *fmt, ...)
+{
+    char cmd[1024];
+    int n = snprintf(cmd, sizeof(cmd), "cd '%s' && ", g_dir);
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(cmd + n, sizeof(cmd) - (size_t)n, fmt, args);
+    va_end(args);
+
+    FILE *p = popen(cmd, "r");
+    if (!p) return NULL;
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    char buf[4096];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), p)) > 0) {
+        tm_strbuf_append_len(&sb, buf, got);
+    }
+    if (pclose(p) != 0) {
+        tm_strbuf_free(&sb);
+        return NULL;
+    }
+    return tm_strbuf_finish(&sb);
+}
+
+/*
+ * A file large enough that successive versions pack as deltas. Version v
+ * rewrites every 25th handler starting at v. Every line is unique, so the
+ * reader's line stats agree with git's numstat.
+ */
+static bool write_source(const char *rel, int version)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", g_dir, rel);
+
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    for (int i = 0; i < 300; i++) {
+        if (i % 25 == version % 25) {
+            fprintf(f, "def handler_%d(request):\n    return respond(request, %d, %d)\n", i, i, version);
+        } else {
+            fprintf(f, "def handler_%d(request):\n    return respond(request, %d)\n", i, i);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+/* Commit everything with a committer time one hour after the last one */
+static bool commit(const char *message)
+{
+    char date[32];
+    snprintf(date, sizeof(date), "@%lld +0000", 1700000000LL + 3600LL * ++g_commit_seq);
+    setenv("GIT_AUTHOR_DATE", date, 1);
+    setenv("GIT_COMMITTER_DATE", date, 1);
+    return run("git add -A && git commit -q -m '%s'", message);
+}
+
+/*
+ *   1-4  on main, then packed with REF_DELTA bases
+ *   5    on side (db.py); 6 on main (app.py); 7 merges side
+ *   8    on main, then packed incrementally with OFS_DELTA bases, and a
+ *        commit-graph with changed-path filters written over 1-8
+ *   9    deletes docs/NOTES.md; 10 edits app.py; both stay loose
+ */
+static bool build_fixture(void)
+{
+    setenv("GIT_CONFIG_NOSYSTEM", "1", 1);
+    setenv("GIT_CONFIG_GLOBAL", "/dev/null", 1);
+    setenv("GIT_AUTHOR_NAME", "Test Author", 1);
+    setenv("GIT_AUTHOR_EMAIL", "author@example.com", 1);
+    setenv("GIT_COMMITTER_NAME", "Test Committer", 1);
+    setenv("GIT_COMMITTER_EMAIL", "committer@example.com", 1);
+
+    if (!run("git init -q && git symbolic-ref HEAD refs/heads/main && "
+             "mkdir src docs && git config gc.auto 0")) {
+        return false;
+    }
+
+    bool ok = write_source("src/app.py", 1) && write_source("src/db.py", 1) &&
+              run("echo notes > docs/NOTES.md") && commit("Initial import");
+    ok = ok && write_source("src/app.py", 2) && commit("Tune app handlers");
+    ok = ok && write_source("src/app.py", 3) && write_source("src/db.py", 3) &&
+         commit("Change app and db together");
+    ok = ok && write_source("src/app.py", 4) && commit("Retry app requests");
+    ok = ok && run("git -c repack.useDeltaBaseOffset=false repack -a -d -q");
+
+    ok = ok && run("git checkout -q -b side") &&
+         write_source("src/db.py", 5) && commit("Pool db connections");
+    ok = ok && run("git checkout -q main") &&
+         write_source("src/app.py", 6) && commit("Log app errors");
+    ok = ok && run("GIT_AUTHOR_DATE='@%lld +0000' GIT_COMMITTER_DATE='@%lld +0000' "
+                   "git merge -q --no-ff --no-edit side",
+                   1700000000LL + 3600LL * (g_commit_seq + 1),
+                   1700000000LL + 3600LL * (g_commit_seq + 1));
+    g_commit_seq++;
+    ok = ok && write_source("src/app.py", 8) && commit("Validate app input");
+    ok = ok && run("git repack -d -q");
+
+    /* Older git has no changed-path filters; the reader copes without */
+    if (ok) run("git commit-graph write --reachable --changed-paths");
+
+    ok = ok && run("git rm -q docs/NOTES.md") && commit("Drop notes");
+    ok = ok && write_source("src/app.py", 10) && commit("Time out app requests");
+    return ok;
+}
+
+static void setup_fixture(void)
+{
+    if (system("git --version >/dev/null 2>&1") != 0) {
+        g_skip_reason = "git not installed";
+        return;
+    }
+    if (!mkdtemp(g_dir)) {
+        g_skip_reason = "no temp dir";
+        return;
+    }
+    g_created = true;
+    if (!build_fixture()) {
+        g_skip_reason = "fixture setup failed";
+        return;
+    }
+
+    tm_odb_t *odb = NULL;
+    char objects[PATH_MAX];
+    snprintf(objects, sizeof(objects), "%s/.git/objects", g_dir);
+    tm_error_t err = tm_odb_open(objects, &odb);
+    tm_odb_free(odb);
+    if (err != TM_OK) {
+        g_skip_reason = "no native object reader";
+        return;
+    }
+
+    g_fixture = true;
+}
+
+static void teardown_fixture(void)
+{
+    if (!g_created) return;
+
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_dir);
+    if (system(cmd) != 0) printf("Could not remove %s\n", g_dir);
+}
+
+/* ============================================================================
+ * Object Database Tests
+ * ========================================================================== */
+
+static tm_odb_type_t type_from_name(const char *name)
+{
+    if (strcmp(name, "commit") == 0) return TM_ODB_COMMIT;
+    if (strcmp(name, "tree") == 0) return TM_ODB_TREE;
+    if (strcmp(name, "blob") == 0) return TM_ODB_BLOB;
+    if (strcmp(name, "tag") == 0) return TM_ODB_TAG;
+    return 0;
+}
+
+TEST(fixture_has_packs_and_loose_objects)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    char *packs = capture("ls .git/objects/pack/*.pack | wc -l");
+    ASSERT_NOT_NULL(packs);
+    ASSERT_EQ(atoi(packs), 2);
+    free(packs);
+
+    char *loose = capture("git count-objects | cut -d' ' -f1");
+    ASSERT_NOT_NULL(loose);
+    ASSERT_TRUE(atoi(loose) > 0);
+    free(loose);
+}
+
+TEST(odb_reads_every_object)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    tm_odb_t *odb = NULL;
+    char objects[PATH_MAX];
+    snprintf(objects, sizeof(objects), "%s/.git/objects", g_dir);
+    ASSERT_EQ(tm_odb_open(objects, &odb), TM_OK);
+
+    /* Loose and packed, including every delta in both packs */
+    char *list = capture("git cat-file --batch-all-objects "
+                         "--batch-check='%%(objectname) %%(objecttype) %%(objectsize)'");
+    ASSERT_NOT_NULL(list);
+
+    size_t checked = 0;
+    bool ok = true;
+    char *save = NULL;
+    for (char *line = strtok_r(list, "\n", &save); line && ok; line = strtok_r(NULL, "\n", &save)) {
+        char hex[41], type_name[16];
+        size_t size;
+        if (sscanf(line, "%40s %15s %zu", hex, type_name, &size) != 3) continue;
+
+        uint8_t oid[TM_ODB_OID_SIZE];
+        tm_odb_type_t type;
+        uint8_t *data = NULL;
+        size_t data_size = 0;
+        ok = tm_odb_oid_parse(hex, oid) &&
+             tm_odb_read(odb, oid, &type, &data, &data_size) == TM_OK &&
+             type == type_from_name(type_name) && data_size == size;
+
+        /* Byte-for-byte, since a bad delta base still yields the right size */
+        if (ok) {
+            char *expected = capture("git cat-file %s %s", type_name, hex);
+            ok = expected && memcmp(expected, data, size) == 0;
+            free(expected);
+        }
+        if (!ok) printf("\n    Mismatch reading %s %s ", type_name, hex);
+
+        free(data);
+        checked++;
+    }
+
+    free(list);
+    tm_odb_free(odb);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(checked > 30);
+}
+
+TEST(odb_missing_object)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    tm_odb_t *odb = NULL;
+    char objects[PATH_MAX];
+    snprintf(objects, sizeof(objects), "%s/.git/objects", g_dir);
+    ASSERT_EQ(tm_odb_open(objects, &odb), TM_OK);
+
+    uint8_t oid[TM_ODB_OID_SIZE];
+    ASSERT_TRUE(tm_odb_oid_parse("0123456789abcdef0123456789abcdef01234567", oid));
+
+    tm_odb_type_t type;
+    uint8_t *data = NULL;
+    size_t size = 0;
+    ASSERT_EQ(tm_odb_read(odb, oid, &type, &data, &size), TM_ERR_NOT_FOUND);
+
+    tm_odb_free(odb);
+}
+
+/* ============================================================================
+ * Commit Walk Tests
+ * ========================================================================== */
+
+/* Compare tm_git_get_commits for one path (or none) with git's own log */
+static bool commits_match_log(const char *path, bool include_merges)
+{
+    tm_git_repo_t *repo = NULL;
+    if (tm_git_repo_open(g_dir, &repo) != TM_OK) return false;
+
+    tm_commit_opts_t opts = {
+        .max_commits = 100,
+        .file_paths = path ? &path : NULL,
+        .file_path_count = path ? 1 : 0,
+        .include_merges = include_merges
+    };
+    tm_git_commit_t *commits = NULL;
+    size_t count = 0;
+    tm_error_t err = tm_git_get_commits(repo, &opts, &commits, &count);
+
+    char *log = capture("git log --format=%%H %s %s%s",
+                        include_merges ? "" : "--no-merges",
+                        path ? "-- " : "", path ? path : "");
+
+    bool ok = err == TM_OK && log != NULL;
+    size_t expected = 0;
+    char *save = NULL;
+    for (char *sha = ok ? strtok_r(log, "\n", &save) : NULL; sha && ok;
+         sha = strtok_r(NULL, "\n", &save)) {
+        ok = expected < count && strcmp(commits[expected].sha, sha) == 0;
+        expected++;
+    }
+    ok = ok && expected == count && count > 0;
+    if (!ok) printf("\n    %s: %zu commits, git log has %zu ", path ? path : "(all)", count, expected);
+
+    free(log);
+    tm_git_commits_free(commits, count);
+    tm_git_repo_free(repo);
+    return ok;
+}
+
+TEST(commits_match_git_log)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    ASSERT_TRUE(commits_match_log(NULL, true));
+    ASSERT_TRUE(commits_match_log(NULL, false));
+    ASSERT_TRUE(commits_match_log("src/app.py", false));
+    ASSERT_TRUE(commits_match_log("src/db.py", false));
+}
+
+TEST(commits_for_deleted_path)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    /* Not in HEAD's tree, so the walk diffs whole trees for it */
+    ASSERT_TRUE(commits_match_log("docs/NOTES.md", false));
+}
+
+TEST(commit_fields)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    tm_git_repo_t *repo = NULL;
+    ASSERT_EQ(tm_git_repo_open(g_dir, &repo), TM_OK);
+
+    tm_commit_opts_t opts = { .max_commits = 1 };
+    tm_git_commit_t *commits = NULL;
+    size_t count = 0;
+    ASSERT_EQ(tm_git_get_commits(repo, &opts, &commits, &count), TM_OK);
+    ASSERT_EQ(count, 1);
+
+    ASSERT_STREQ(commits[0].author, "Test Author");
+    ASSERT_STREQ(commits[0].email, "author@example.com");
+    ASSERT_EQ(commits[0].timestamp, 1700000000LL + 3600LL * g_commit_seq);
+    ASSERT_TRUE(strncmp(commits[0].message, "Time out app requests", 21) == 0);
+    ASSERT_EQ(commits[0].file_count, 1);
+    ASSERT_STREQ(commits[0].files_changed[0], "src/app.py");
+    ASSERT_EQ(commits[0].additions, 24);
+    ASSERT_EQ(commits[0].deletions, 24);
+
+    tm_git_commits_free(commits, count);
+    tm_git_repo_free(repo);
+}
+
+/* ============================================================================
+ * Working Tree Tests
+ * ========================================================================== */
+
+/* Rewrite the given 1-based lines of a file, dropping those marked negative */
+static bool edit_lines(const char *rel, const int *lines, size_t count)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", g_dir, rel);
+
+    size_t size = 0;
+    char *data = tm_read_file(path, &size);
+    if (!data) return false;
+
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    int number = 1;
+    for (char *line = data; *line; number++) {
+        char *nl = strchr(line, '\n');
+        size_t len = nl ? (size_t)(nl - line) + 1 : strlen(line);
+
+        bool drop = false, rewrite = false;
+        for (size_t i = 0; i < count; i++) {
+            if (lines[i] == -number) drop = true;
+            if (lines[i] == number) rewrite = true;
+        }
+        if (rewrite) tm_strbuf_appendf(&sb, "    raise RuntimeError(%d)\n", number);
+        else if (!drop) tm_strbuf_append_len(&sb, line, len);
+        line += len;
+    }
+    free(data);
+
+    tm_error_t err = tm_write_file_atomic(path, sb.data, sb.len);
+    tm_strbuf_free(&sb);
+    return err == TM_OK;
+}
+
+TEST(worktree_hunks_match_git_diff)
+{
+    SKIP_WITHOUT_FIXTURE();
+
+    /* Three edits far apart, one of them a deletion, plus two close together */
+    static const int edits[] = { 6, 300, -450, 560, 564 };
+    ASSERT_TRUE(edit_lines("src/app.py", edits, TM_ARRAY_SIZE(edits)));
+
+    tm_stack_frame_t frame = { .function = "handler_149", .file = "src/app.py", .line = 300 };
+    tm_stack_trace_t trace = { .frames = &frame, .frame_count = 1 };
+
+    tm_git_repo_t *repo = NULL;
+    ASSERT_EQ(tm_git_repo_open(g_dir, &repo), TM_OK);
+    tm_git_dirty_hunk_t *hunks = NULL;
+    size_t count = 0;
+    tm_error_t err = tm_git_worktree_changes(repo, &trace, &hunks, &count);
+    tm_git_repo_free(repo);
+    ASSERT_EQ(err, TM_OK);
+
+    /* Same hunk headers as git, function context aside */
+    char *headers = capture("git diff -U3 HEAD -- src/app.py | grep '^@@' | sed 's/ @@.*/ @@/'");
+    ASSERT_NOT_NULL(headers);
+
+    size_t expected = 0;
+    bool ok = true;
+    char *save = NULL;
+    for (char *h = strtok_r(headers, "\n", &save); h && ok; h = strtok_r(NULL, "\n", &save)) {
+        bool found = false;
+        for (size_t i = 0; i < count && !found; i++) {
+            found = hunks[i].diff && strstr(hunks[i].diff, h) != NULL;
+        }
+        if (!found) printf("\n    No hunk for %s ", h);
+        ok = found;
+        expected++;
+    }
+    free(headers);
+
+    bool sized = ok && expected == 4 && count == expected;
+
+    /* The frame's hunk covers the rewritten line alone; its deletion half
+     * touches the line before, as in the libgit2 backend */
+    bool framed = sized && hunks[0].frame == 0 &&
+                  hunks[0].start_line == 299 && hunks[0].end_line == 300;
+
+    tm_git_dirty_hunks_free(hunks, count);
+    ASSERT_TRUE(ok);
+    ASSERT_TRUE(sized);
+    ASSERT_TRUE(framed);
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+int main(void)
+{
+    printf("Native Git Reader Tests\n");
+    printf("=======================\n\n");
+
+    setup_fixture();
+
+    printf("Object Database:\n");
+    RUN_TEST(fixture_has_packs_and_loose_objects);
+    RUN_TEST(odb_reads_every_object);
+    RUN_TEST(odb_missing_object);
+
+    printf("\nCommit Walk:\n");
+    RUN_TEST(commits_match_git_log);
+    RUN_TEST(commits_for_deleted_path);
+    RUN_TEST(commit_fields);
+
+    printf("\nWorking Tree:\n");
+    RUN_TEST(worktree_hunks_match_git_diff);
+
+    teardown_fixture();
+
+    printf("\n=======================\n");
+    printf("All tests passed!\n");
+
+    return 0;
+}
@@ -0,0 +1,247 @@
+/**
+ * TraceMind - Commit History Index Tests
+ *
+ * Writes index files with the builder and reads them back: newer commits
+ * stacked on an index, a capped build continued with older commits, and
+ * the partial-index boundary.
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/history_index.h"
+#include <assert.h>
+#include <string.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ========================================================================== */
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running %s... ", #name); \
+    test_##name(); \
+    printf("PASS\n"); \
+} while (0)
+
+#define ASSERT_TRUE(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+               #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_NOT_NULL(p) ASSERT_TRUE((p) != NULL)
+
+/* ============================================================================
+ * Fixture
+ * ========================================================================== */
+
+static char g_dir[] = "/tmp/tm_history_index_XXXXXX";
+static uint8_t g_head[TM_HISTORY_OID_SIZE];
+
+static char *index_file(const char *name)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "%s/%s.idx", g_dir, name);
+    return tm_strbuf_finish(&sb);
+}
+
+/* Entry for a commit whose OID is all tag bytes */
+static tm_history_entry_t entry(int64_t timestamp, uint8_t tag)
+{
+    tm_history_entry_t e = { .timestamp = timestamp, .additions = tag };
+    memset(e.oid, tag, sizeof(e.oid));
+    return e;
+}
+
+/* Write builder over base to file and load the result */
+static tm_history_index_t *write_and_load(const tm_history_builder_t *builder,
+                                          const tm_history_index_t *base,
+                                          const char *file)
+{
+    tm_history_index_t *index = NULL;
+    if (tm_history_builder_write(builder, base, g_head, file) != TM_OK) return NULL;
+    if (tm_history_index_load(file, &index) != TM_OK) return NULL;
+    return index;
+}
+
+/* ============================================================================
+ * Tests
+ * ========================================================================== */
+
+TEST(lookup_sorted_paths)
+{
+    char *file = index_file("lookup");
+    tm_history_builder_t builder;
+    tm_history_builder_init(&builder);
+
+    tm_history_entry_t e = entry(300, 3);
+    tm_history_builder_add(&builder, "src/b.c", &e);
+    tm_history_builder_add(&builder, "src/a.c", &e);
+    e = entry(200, 2);
+    tm_history_builder_add(&builder, "src/b.c", &e);
+
+    tm_history_index_t *index = write_and_load(&builder, NULL, file);
+    tm_history_builder_free(&builder);
+    ASSERT_NOT_NULL(index);
+    ASSERT_EQ(index->header->path_count, 2);
+    ASSERT_EQ(index->header->boundary, 0);
+
+    size_t count = 0;
+    const tm_history_entry_t *run = tm_history_index_lookup(index, "src/b.c", &count);
+    ASSERT_NOT_NULL(run);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(run[0].timestamp, 300);
+    ASSERT_EQ(run[1].timestamp, 200);
+
+    ASSERT_NOT_NULL(tm_history_index_lookup(index, "src/a.c", &count));
+    ASSERT_EQ(count, 1);
+    ASSERT_TRUE(tm_history_index_lookup(index, "src/c.c", &count) == NULL);
+    ASSERT_EQ(count, 0);
+
+    tm_history_index_free(index);
+    free(file);
+}
+
+TEST(newer_commits_go_first)
+{
+    char *file = index_file("newer");
+    tm_history_builder_t builder;
+    tm_history_builder_init(&builder);
+
+    tm_history_entry_t e = entry(100, 1);
+    tm_history_builder_add(&builder, "a.c", &e);
+    builder.boundary = 100;
+    tm_history_index_t *base = write_and_load(&builder, NULL, file);
+    tm_history_builder_free(&builder);
+    ASSERT_NOT_NULL(base);
+
+    /* Commits on top keep the base's boundary */
+    tm_history_builder_init(&builder);
+    e = entry(200, 2);
+    tm_history_builder_add(&builder, "a.c", &e);
+    tm_history_builder_add(&builder, "b.c", &e);
+    builder.boundary = base->header->boundary;
+    tm_history_index_t *index = write_and_load(&builder, base, file);
+    tm_history_builder_free(&builder);
+    tm_history_index_free(base);
+    ASSERT_NOT_NULL(index);
+    ASSERT_EQ(index->header->boundary, 100);
+
+    size_t count = 0;
+    const tm_history_entry_t *run = tm_history_index_lookup(index, "a.c", &count);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(run[0].timestamp, 200);
+    ASSERT_EQ(run[1].timestamp, 100);
+
+    tm_history_index_free(index);
+    free(file);
+}
+
+TEST(older_commits_continue_base)
+{
+    char *file = index_file("older");
+    tm_history_builder_t builder;
+    tm_history_builder_init(&builder);
+
+    /* A capped first build: only commits at or after time 150 */
+    tm_history_entry_t e = entry(200, 2);
+    tm_history_builder_add(&builder, "a.c", &e);
+    e = entry(150, 3);
+    tm_history_builder_add(&builder, "a.c", &e);
+    builder.boundary = 150;
+    tm_history_index_t *base = write_and_load(&builder, NULL, file);
+    tm_history_builder_free(&builder);
+    ASSERT_NOT_NULL(base);
+    ASSERT_EQ(base->header->boundary, 150);
+
+    /* The next run reaches the root commit */
+    tm_history_builder_init(&builder);
+    builder.older = true;
+    e = entry(100, 4);
+    tm_history_builder_add(&builder, "a.c", &e);
+    tm_history_builder_add(&builder, "old.c", &e);
+    e = entry(50, 5);
+    tm_history_builder_add(&builder, "a.c", &e);
+    tm_history_index_t *index = write_and_load(&builder, base, file);
+    tm_history_builder_free(&builder);
+    tm_history_index_free(base);
+    ASSERT_NOT_NULL(index);
+    ASSERT_EQ(index->header->boundary, 0);
+    ASSERT_EQ(index->header->path_count, 2);
+    ASSERT_EQ(index->header->entry_count, 5);
+
+    size_t count = 0;
+    const tm_history_entry_t *run = tm_history_index_lookup(index, "a.c", &count);
+    ASSERT_EQ(count, 4);
+    for (size_t i = 1; i < count; i++) {
+        ASSERT_TRUE(run[i - 1].timestamp > run[i].timestamp);
+    }
+
+    const char *patterns[] = { "a.c", "old.c" };
+    tm_history_entry_t *entries = NULL;
+    ASSERT_EQ(tm_history_index_query(index, patterns, 2, &entries, &count), TM_OK);
+    ASSERT_EQ(count, 4);
+    ASSERT_EQ(entries[0].timestamp, 200);
+    ASSERT_EQ(entries[3].timestamp, 50);
+    free(entries);
+
+    tm_history_index_free(index);
+    free(file);
+}
+
+TEST(truncated_file_rejected)
+{
+    char *file = index_file("truncated");
+    tm_history_builder_t builder;
+    tm_history_builder_init(&builder);
+
+    tm_history_entry_t e = entry(100, 1);
+    tm_history_builder_add(&builder, "a.c", &e);
+    ASSERT_EQ(tm_history_builder_write(&builder, NULL, g_head, file), TM_OK);
+    tm_history_builder_free(&builder);
+
+    ASSERT_EQ(truncate(file, (off_t)sizeof(tm_history_header_t) + 8), 0);
+
+    tm_history_index_t *index = NULL;
+    ASSERT_EQ(tm_history_index_load(file, &index), TM_ERR_PARSE);
+    ASSERT_TRUE(index == NULL);
+
+    free(file);
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+int main(void)
+{
+    printf("History Index Tests\n");
+    printf("===================\n\n");
+
+    if (!mkdtemp(g_dir)) {
+        printf("Cannot create %s\n", g_dir);
+        return 1;
+    }
+    memset(g_head, 0xab, sizeof(g_head));
+
+    printf("Building:\n");
+    RUN_TEST(lookup_sorted_paths);
+    RUN_TEST(newer_commits_go_first);
+    RUN_TEST(older_commits_continue_base);
+
+    printf("\nLoading:\n");
+    RUN_TEST(truncated_file_rejected);
+
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_dir);
+    if (system(cmd) != 0) printf("Could not remove %s\n", g_dir);
+
+    printf("\n===================\n");
+    printf("All tests passed!\n");
+
+    return 0;
+}
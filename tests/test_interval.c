@@ -0,0 +1,230 @@
+/**
+ * TraceMind - Interval Index Tests
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/interval.h"
+#include <assert.h>
+#include <string.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ========================================================================== */
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running %s... ", #name); \
+    test_##name(); \
+    printf("PASS\n"); \
+} while (0)
+
+#define ASSERT_TRUE(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+               #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_CASE(cond, i) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Case %zu: %s\n    at %s:%d\n", \
+               (size_t)(i), #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+/* ============================================================================
+ * Test Data
+ * ========================================================================== */
+
+/*
+ * Hunks of one file, given out of order. Tags are the bit each interval
+ * sets in an overlap mask:
+ *
+ *   10-20 (0x01)   containing 12-14 (0x02) and 15-15 (0x04)
+ *   30-40 (0x08)   sharing line 40 with 40-45 (0x10)
+ *   100-200 (0x20) containing 120-130 (0x40)
+ */
+static const tm_interval_t HUNKS[] = {
+    { 100, 200, 0x20 },
+    { 30, 40, 0x08 },
+    { 12, 14, 0x02 },
+    { 40, 45, 0x10 },
+    { 10, 20, 0x01 },
+    { 120, 130, 0x40 },
+    { 15, 15, 0x04 },
+};
+
+typedef struct {
+    int start;
+    int end;
+    size_t count;                 /* Overlapping intervals */
+    uint32_t mask;                /* OR of their tags */
+    int distance;
+} query_case_t;
+
+static const query_case_t QUERIES[] = {
+    /* Boundaries are inclusive on both sides */
+    { 10, 10, 1, 0x01, 0 },
+    { 20, 20, 1, 0x01, 0 },
+    { 9, 9, 0, 0, 1 },
+    { 21, 21, 0, 0, 1 },
+    { 40, 40, 2, 0x18, 0 },
+    { 45, 46, 1, 0x10, 0 },
+    { 46, 46, 0, 0, 1 },
+    { 1, 10, 1, 0x01, 0 },
+
+    /* Nested intervals are reported with their parent */
+    { 13, 13, 2, 0x03, 0 },
+    { 15, 15, 2, 0x05, 0 },
+    { 12, 15, 3, 0x07, 0 },
+    { 125, 125, 2, 0x60, 0 },
+    { 150, 160, 1, 0x20, 0 },
+
+    /* A query spanning several intervals */
+    { 18, 35, 2, 0x09, 0 },
+    { 0, 1000, 7, 0x7f, 0 },
+
+    /* Gaps: distance to the nearer of the left and right neighbours */
+    { 22, 24, 0, 0, 2 },          /* 20 is 2 left, 30 is 6 right */
+    { 26, 27, 0, 0, 3 },          /* 30 is 3 right */
+    { 60, 60, 0, 0, 15 },         /* 45 is 15 left, 100 is 40 right */
+    { 90, 95, 0, 0, 5 },          /* 100 is 5 right */
+    { 1, 5, 0, 0, 5 },            /* Only a right neighbour */
+    { 250, 260, 0, 0, 50 },       /* Only a left neighbour */
+};
+
+/* ============================================================================
+ * Interval Index Tests
+ * ========================================================================== */
+
+static void collect(const tm_interval_t *interval, void *ctx)
+{
+    uint32_t *mask = ctx;
+    *mask |= interval->tag;
+}
+
+static void collect_starts(const tm_interval_t *interval, void *ctx)
+{
+    int *starts = ctx;
+    size_t i = 0;
+    while (starts[i] != 0) i++;
+    starts[i] = interval->start;
+}
+
+TEST(overlap_table)
+{
+    tm_interval_index_t index;
+    tm_interval_index_init(&index, HUNKS, TM_ARRAY_SIZE(HUNKS));
+
+    for (size_t i = 0; i < TM_ARRAY_SIZE(QUERIES); i++) {
+        const query_case_t *q = &QUERIES[i];
+        uint32_t mask = 0;
+        size_t count = tm_interval_index_overlaps(&index, q->start, q->end, collect, &mask);
+        ASSERT_CASE(count == q->count, i);
+        ASSERT_CASE(mask == q->mask, i);
+        ASSERT_CASE(tm_interval_index_overlaps(&index, q->start, q->end, NULL, NULL) == q->count, i);
+    }
+
+    tm_interval_index_free(&index);
+}
+
+TEST(distance_table)
+{
+    tm_interval_index_t index;
+    tm_interval_index_init(&index, HUNKS, TM_ARRAY_SIZE(HUNKS));
+
+    for (size_t i = 0; i < TM_ARRAY_SIZE(QUERIES); i++) {
+        const query_case_t *q = &QUERIES[i];
+        ASSERT_CASE(tm_interval_index_distance(&index, q->start, q->end) == q->distance, i);
+    }
+
+    tm_interval_index_free(&index);
+}
+
+TEST(overlaps_in_start_order)
+{
+    tm_interval_index_t index;
+    tm_interval_index_init(&index, HUNKS, TM_ARRAY_SIZE(HUNKS));
+
+    int starts[TM_ARRAY_SIZE(HUNKS) + 1] = { 0 };
+    ASSERT_EQ(tm_interval_index_overlaps(&index, 0, 1000, collect_starts, starts),
+              TM_ARRAY_SIZE(HUNKS));
+    for (size_t i = 1; i < TM_ARRAY_SIZE(HUNKS); i++) {
+        ASSERT_CASE(starts[i - 1] <= starts[i], i);
+    }
+
+    tm_interval_index_free(&index);
+}
+
+TEST(long_interval_left_of_gap)
+{
+    /* A long early interval still covers queries past later short ones */
+    static const tm_interval_t spans[] = {
+        { 1, 100, 1 }, { 10, 11, 2 }, { 20, 21, 4 }, { 200, 210, 8 }
+    };
+    tm_interval_index_t index;
+    tm_interval_index_init(&index, spans, TM_ARRAY_SIZE(spans));
+
+    uint32_t mask = 0;
+    ASSERT_EQ(tm_interval_index_overlaps(&index, 50, 60, collect, &mask), 1);
+    ASSERT_EQ(mask, 1);
+    ASSERT_EQ(tm_interval_index_distance(&index, 50, 60), 0);
+    ASSERT_EQ(tm_interval_index_distance(&index, 150, 150), 50);
+
+    tm_interval_index_free(&index);
+}
+
+TEST(empty_index)
+{
+    tm_interval_index_t index;
+    tm_interval_index_init(&index, NULL, 0);
+
+    ASSERT_EQ(index.count, 0);
+    ASSERT_EQ(tm_interval_index_overlaps(&index, 1, 10, collect, NULL), 0);
+    ASSERT_EQ(tm_interval_index_distance(&index, 1, 10), -1);
+    ASSERT_EQ(tm_interval_index_overlaps(NULL, 1, 10, NULL, NULL), 0);
+    ASSERT_EQ(tm_interval_index_distance(NULL, 1, 10), -1);
+
+    tm_interval_index_free(&index);
+}
+
+TEST(inverted_query)
+{
+    tm_interval_index_t index;
+    tm_interval_index_init(&index, HUNKS, TM_ARRAY_SIZE(HUNKS));
+
+    ASSERT_EQ(tm_interval_index_overlaps(&index, 20, 10, NULL, NULL), 0);
+
+    tm_interval_index_free(&index);
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+int main(void)
+{
+    printf("Interval Index Tests\n");
+    printf("====================\n\n");
+
+    printf("Overlaps:\n");
+    RUN_TEST(overlap_table);
+    RUN_TEST(overlaps_in_start_order);
+    RUN_TEST(inverted_query);
+
+    printf("\nDistance:\n");
+    RUN_TEST(distance_table);
+    RUN_TEST(long_interval_left_of_gap);
+
+    printf("\nEdge Cases:\n");
+    RUN_TEST(empty_index);
+
+    printf("\n====================\n");
+    printf("All tests passed!\n");
+
+    return 0;
+}
@@ -4,7 +4,9 @@
 
 #include "tracemind.h"
 #include "internal/common.h"
+#include "internal/input_format.h"
 #include "internal/parser.h"
+#include "internal/llm.h"
 #include <assert.h>
 #include <string.h>
 
@@ -189,6 +191,202 @@ TEST(garbage_input)
     if (trace) tm_stack_trace_free(trace);
 }
 
+/* ============================================================================
+ * Timestamp Tests
+ * ========================================================================== */
+
+TEST(timestamp_formats)
+{
+    int64_t t = 0;
+    
+    ASSERT_TRUE(tm_parse_timestamp("2024-01-15T10:30:45.123Z", &t));
+    ASSERT_EQ(t, 1705314645);
+    ASSERT_TRUE(tm_parse_timestamp("[2024-01-15 12:30:45+02:00] ERROR db down", &t));
+    ASSERT_EQ(t, 1705314645);
+    ASSERT_TRUE(tm_parse_timestamp("10.0.0.1 - - [15/Jan/2024:10:30:45 +0000] \"GET /\"", &t));
+    ASSERT_EQ(t, 1705314645);
+    ASSERT_TRUE(tm_parse_timestamp("1705314645123", &t));
+    ASSERT_EQ(t, 1705314645);
+    ASSERT_TRUE(!tm_parse_timestamp("version 1.2.3 build 42", &t));
+}
+
+TEST(timestamp_local_zone)
+{
+    int64_t t = 0;
+    
+    /* Offset-less times are local: EST is UTC-5, EDT is UTC-4 */
+    setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+    tzset();
+    ASSERT_TRUE(tm_parse_timestamp("2024-01-15 05:30:45 ERROR db down", &t));
+    ASSERT_EQ(t, 1705314645);
+    ASSERT_TRUE(tm_parse_timestamp("2024-07-15T06:30:45", &t));
+    ASSERT_EQ(t, 1721039445);
+    
+    /* An explicit zone wins over TZ */
+    ASSERT_TRUE(tm_parse_timestamp("2024-01-15T10:30:45Z", &t));
+    ASSERT_EQ(t, 1705314645);
+    
+    setenv("TZ", "UTC0", 1);
+    tzset();
+}
+
+TEST(incident_time_prefers_errors)
+{
+    const char *log =
+        "2024-01-15 10:00:00 INFO starting\n"
+        "2024-01-15 10:30:45 ERROR request failed\n"
+        "2024-01-15 10:31:00 ERROR retry failed\n";
+    ASSERT_EQ(tm_find_incident_time(log, strlen(log), NULL), 1705314645);
+    ASSERT_EQ(tm_find_incident_time("no times here", 13, NULL), 0);
+}
+
+/* ============================================================================
+ * Hypothesis Response Tests
+ * ========================================================================== */
+
+static const char *HYPOTHESES_JSON =
+"{\"summary\": \"db outage\", \"hypotheses\": ["
+"{\"rank\": 1, \"confidence\": 80, \"title\": \"Pool exhausted\"},"
+"{\"rank\": 2, \"confidence\": 40, \"title\": \"Bad migration\"}"
+"]}";
+
+TEST(hypotheses_fenced)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "```json\n%s\n```\n", HYPOTHESES_JSON);
+    
+    tm_hypothesis_t **hyps = NULL;
+    size_t count = 0;
+    ASSERT_EQ(tm_parse_hypotheses(sb.data, &hyps, &count), TM_OK);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(hyps[0]->confidence, 80);
+    ASSERT_STREQ(hyps[1]->title, "Bad migration");
+    
+    tm_hypotheses_free(hyps, count);
+    tm_strbuf_free(&sb);
+}
+
+TEST(hypotheses_in_prose)
+{
+    /* A brace pair in the prose is not the root object */
+    const char *text =
+        "Looking at the {trace}, here is my analysis:\n"
+        "{\"hypotheses\": [{\"rank\": 1, \"title\": \"Null config\"}]}\n"
+        "Let me know if you need more detail.";
+    
+    tm_hypothesis_t **hyps = NULL;
+    size_t count = 0;
+    ASSERT_EQ(tm_parse_hypotheses(text, &hyps, &count), TM_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_STREQ(hyps[0]->title, "Null config");
+    tm_hypotheses_free(hyps, count);
+    
+    ASSERT_EQ(tm_parse_hypotheses("No JSON here, sorry.", &hyps, &count), TM_ERR_PARSE);
+    ASSERT_EQ(tm_parse_hypotheses("{\"answer\": [1, 2]}", &hyps, &count), TM_ERR_PARSE);
+}
+
+TEST(hypotheses_after_unbalanced_brace)
+{
+    /* An opening brace in the prose never closes */
+    const char *text =
+        "The handler builds a dict with { but never closes it. Findings:\n"
+        "{\"hypotheses\": [{\"rank\": 1, \"title\": \"Unclosed literal\"}]}";
+    
+    tm_hypothesis_t **hyps = NULL;
+    size_t count = 0;
+    ASSERT_EQ(tm_parse_hypotheses(text, &hyps, &count), TM_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_STREQ(hyps[0]->title, "Unclosed literal");
+    tm_hypotheses_free(hyps, count);
+}
+
+TEST(hypotheses_key_not_value)
+{
+    /* "hypotheses" as a string value does not name the next array */
+    const char *text =
+        "{\"kind\": \"hypotheses\", \"notes\": [{\"title\": \"Not one\"}], "
+        "\"hypotheses\" : [{\"title\": \"Real\"}]}";
+    
+    tm_hypothesis_t **hyps = NULL;
+    size_t count = 0;
+    ASSERT_EQ(tm_parse_hypotheses(text, &hyps, &count), TM_OK);
+    ASSERT_EQ(count, 1);
+    ASSERT_STREQ(hyps[0]->title, "Real");
+    tm_hypotheses_free(hyps, count);
+    
+    /* Neither a value directly before an array nor an array element */
+    ASSERT_EQ(tm_parse_hypotheses("{\"section\": \"hypotheses\" [{\"title\": \"x\"}]}",
+                                  &hyps, &count), TM_ERR_PARSE);
+    ASSERT_EQ(tm_parse_hypotheses("{\"notes\": [\"hypotheses\", [{\"title\": \"x\"}]]}",
+                                  &hyps, &count), TM_ERR_PARSE);
+}
+
+TEST(hypotheses_braces_in_strings)
+{
+    const char *text =
+        "{\"hypotheses\": [{\"title\": \"Template {name} ] not \\\"closed\\\" \\\\\", "
+        "\"explanation\": \"}]}\"}, {\"title\": \"Second\"}]}";
+    
+    tm_hypothesis_t **hyps = NULL;
+    size_t count = 0;
+    ASSERT_EQ(tm_parse_hypotheses(text, &hyps, &count), TM_OK);
+    ASSERT_EQ(count, 2);
+    ASSERT_STREQ(hyps[0]->title, "Template {name} ] not \"closed\" \\");
+    ASSERT_STREQ(hyps[0]->explanation, "}]}");
+    ASSERT_STREQ(hyps[1]->title, "Second");
+    tm_hypotheses_free(hyps, count);
+}
+
+TEST(hypotheses_truncated)
+{
+    /* Cut off mid-element, as with finish_reason=length */
+    const char *text =
+        "{\"hypotheses\": [{\"rank\": 1, \"title\": \"First\"}, "
+        "{\"rank\": 2, \"title\": \"Second\"}, {\"rank\": 3, \"title\": \"Thi";
+    
+    tm_hypothesis_t **hyps = NULL;
+    size_t count = 0;
+    ASSERT_EQ(tm_parse_hypotheses(text, &hyps, &count), TM_OK);
+    ASSERT_EQ(count, 2);
+    ASSERT_STREQ(hyps[0]->title, "First");
+    ASSERT_STREQ(hyps[1]->title, "Second");
+    tm_hypotheses_free(hyps, count);
+    
+    /* Nothing complete yet */
+    ASSERT_EQ(tm_parse_hypotheses("{\"hypotheses\": [{\"rank\": 1, \"ti", &hyps, &count),
+              TM_ERR_PARSE);
+}
+
+TEST(hypotheses_byte_chunks)
+{
+    tm_hypothesis_parser_t parser;
+    tm_hypothesis_parser_init(&parser);
+    
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "Sure!\n```json\n%s\n```", HYPOTHESES_JSON);
+    
+    /* Each element is parsed as soon as its closing brace arrives */
+    size_t first_close = strstr(sb.data, "\"Pool exhausted\"}") - sb.data + 16;
+    for (size_t i = 0; i < sb.len; i++) {
+        ASSERT_EQ(tm_hypothesis_parser_feed(&parser, sb.data + i, 1), TM_OK);
+        if (i + 1 == first_close) ASSERT_EQ(parser.count, 0);
+        if (i == first_close) ASSERT_EQ(parser.count, 1);
+    }
+    
+    tm_hypothesis_t **hyps = NULL;
+    size_t count = 0;
+    ASSERT_EQ(tm_hypothesis_parser_finish(&parser, &hyps, &count), TM_OK);
+    ASSERT_EQ(count, 2);
+    ASSERT_STREQ(hyps[0]->title, "Pool exhausted");
+    ASSERT_EQ(hyps[1]->rank, 2);
+    
+    tm_hypotheses_free(hyps, count);
+    tm_hypothesis_parser_free(&parser);
+    tm_strbuf_free(&sb);
+}
+
 /* ============================================================================
  * Main
  * ========================================================================== */
@@ -198,6 +396,10 @@ int main(void)
     printf("Parser Tests\n");
     printf("============\n\n");
     
+    /* Offset-less timestamps are local time; pin the zone */
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    
     printf("Python Parser:\n");
     RUN_TEST(python_trace_parsing);
     RUN_TEST(python_language_detection);
@@ -215,6 +417,20 @@ int main(void)
     RUN_TEST(null_input);
     RUN_TEST(garbage_input);
     
+    printf("\nTimestamps:\n");
+    RUN_TEST(timestamp_formats);
+    RUN_TEST(timestamp_local_zone);
+    RUN_TEST(incident_time_prefers_errors);
+    
+    printf("\nHypothesis Responses:\n");
+    RUN_TEST(hypotheses_fenced);
+    RUN_TEST(hypotheses_in_prose);
+    RUN_TEST(hypotheses_after_unbalanced_brace);
+    RUN_TEST(hypotheses_key_not_value);
+    RUN_TEST(hypotheses_braces_in_strings);
+    RUN_TEST(hypotheses_truncated);
+    RUN_TEST(hypotheses_byte_chunks);
+    
     printf("\n============\n");
     printf("All tests passed!\n");
     
@@ -0,0 +1,246 @@
+/**
+ * TraceMind - Symbol Index Tests
+ *
+ * Indexes a small source tree spread over several top-level directories,
+ * then refreshes the index with nothing changed and with one file edited.
+ * Symbol lookups are checked when tree-sitter is available.
+ */
+
+#include "tracemind.h"
+#include "internal/common.h"
+#include "internal/symbol_index.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+
+/* ============================================================================
+ * Test Utilities
+ * ========================================================================== */
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running %s... ", #name); \
+    test_##name(); \
+    printf("PASS\n"); \
+} while (0)
+
+#define ASSERT_TRUE(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL\n    Assertion failed: %s\n    at %s:%d\n", \
+               #cond, __FILE__, __LINE__); \
+        return; \
+    } \
+} while (0)
+
+#define ASSERT_EQ(a, b) ASSERT_TRUE((a) == (b))
+#define ASSERT_STREQ(a, b) ASSERT_TRUE(strcmp((a), (b)) == 0)
+#define ASSERT_NOT_NULL(p) ASSERT_TRUE((p) != NULL)
+
+/* ============================================================================
+ * Fixture
+ * ========================================================================== */
+
+static char g_dir[] = "/tmp/tm_symbol_index_XXXXXX";
+static char g_repo[PATH_MAX];
+static char g_index[PATH_MAX];
+
+/* Indexed files, in path order */
+static const char *const INDEXED[] = {
+    "api/handlers.py",
+    "api/v2/routes.py",
+    "main.py",
+    "pkg/store/store.go",
+    "web/app.js"
+};
+
+static bool write_source(const char *rel, const char *content)
+{
+    char path[PATH_MAX + 64];
+    snprintf(path, sizeof(path), "%s/%s", g_repo, rel);
+    return tm_write_file_atomic(path, content, strlen(content)) == TM_OK;
+}
+
+/*
+ *   main.py                  root files are walked before the fan-out
+ *   api/, pkg/, web/         one subtree walk each
+ *   node_modules/, .venv/    skipped
+ *   docs/                    nothing to index
+ */
+static bool build_fixture(void)
+{
+    if (!mkdtemp(g_dir)) return false;
+    snprintf(g_repo, sizeof(g_repo), "%s/repo", g_dir);
+    snprintf(g_index, sizeof(g_index), "%s/symbols.idx", g_dir);
+
+    static const char *const dirs[] = {
+        "api/v2", "pkg/store", "web", "node_modules/left-pad", ".venv/lib", "docs"
+    };
+    for (size_t i = 0; i < TM_ARRAY_SIZE(dirs); i++) {
+        char path[PATH_MAX + 64];
+        snprintf(path, sizeof(path), "%s/%s", g_repo, dirs[i]);
+        if (tm_mkdir_p(path) != TM_OK) return false;
+    }
+
+    return write_source("main.py", "def main():\n    handle(None)\n") &&
+           write_source("api/handlers.py", "def handle(request):\n    return route(request)\n") &&
+           write_source("api/v2/routes.py", "def route(request):\n    return None\n") &&
+           write_source("pkg/store/store.go",
+                        "package store\n\nfunc Save(key string) error {\n\treturn nil\n}\n") &&
+           write_source("web/app.js", "export function render(view) {\n  return view;\n}\n") &&
+           write_source("node_modules/left-pad/index.js", "function leftPad() {}\n") &&
+           write_source(".venv/lib/site.py", "def site():\n    pass\n") &&
+           write_source("docs/notes.txt", "def not_code():\n");
+}
+
+static void teardown_fixture(void)
+{
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_dir);
+    if (system(cmd) != 0) printf("Could not remove %s\n", g_dir);
+}
+
+/* Identity of the index file: rewrites replace it with a new inode */
+static bool index_identity(struct stat *st)
+{
+    return stat(g_index, st) == 0;
+}
+
+static const tm_symbol_file_t *find_file(const tm_symbol_index_t *index, const char *path)
+{
+    for (uint32_t i = 0; i < index->header->file_count; i++) {
+        const tm_symbol_file_t *f = &index->files[i];
+        if (strcmp(tm_symbol_index_string(index, f->path_offset), path) == 0) return f;
+    }
+    return NULL;
+}
+
+#ifdef HAVE_TREE_SITTER
+/* Path of the file defining name, or NULL */
+static const char *defined_in(const tm_symbol_index_t *index, const char *name)
+{
+    size_t count = 0;
+    const uint32_t *ids = tm_symbol_index_lookup(index, name, &count);
+    for (size_t i = 0; i < count; i++) {
+        const tm_symbol_t *sym = &index->symbols[ids[i]];
+        if (sym->kind & TM_SYMBOL_DEFINITION) {
+            return tm_symbol_index_string(index, index->files[sym->file].path_offset);
+        }
+    }
+    return NULL;
+}
+#endif
+
+/* ============================================================================
+ * Tests
+ * ========================================================================== */
+
+TEST(first_build_walks_tree)
+{
+    tm_symbol_index_t *index = NULL;
+    ASSERT_EQ(tm_symbol_index_update(g_repo, g_index, 4, &index), TM_OK);
+    ASSERT_NOT_NULL(index);
+
+    /* Every subtree's files, merged in path order */
+    ASSERT_EQ(index->header->file_count, TM_ARRAY_SIZE(INDEXED));
+    for (size_t i = 0; i < TM_ARRAY_SIZE(INDEXED); i++) {
+        ASSERT_STREQ(tm_symbol_index_string(index, index->files[i].path_offset), INDEXED[i]);
+    }
+    ASSERT_STREQ(tm_symbol_index_string(index, find_file(index, "api/v2/routes.py")->module_offset),
+                 "api.v2.routes");
+
+#ifdef HAVE_TREE_SITTER
+    ASSERT_STREQ(defined_in(index, "route"), "api/v2/routes.py");
+    ASSERT_STREQ(defined_in(index, "Save"), "pkg/store/store.go");
+    ASSERT_TRUE(defined_in(index, "leftPad") == NULL);
+#endif
+
+    tm_symbol_index_free(index);
+}
+
+TEST(unchanged_tree_keeps_index)
+{
+    struct stat before, after;
+    ASSERT_TRUE(index_identity(&before));
+
+    /* Serial and parallel walks agree, and nothing is rewritten */
+    for (size_t workers = 1; workers <= 4; workers += 3) {
+        tm_symbol_index_t *index = NULL;
+        ASSERT_EQ(tm_symbol_index_update(g_repo, g_index, workers, &index), TM_OK);
+        ASSERT_NOT_NULL(index);
+        ASSERT_EQ(index->header->file_count, TM_ARRAY_SIZE(INDEXED));
+        tm_symbol_index_free(index);
+    }
+
+    ASSERT_TRUE(index_identity(&after));
+    ASSERT_EQ(after.st_ino, before.st_ino);
+    ASSERT_EQ(after.st_mtim.tv_sec, before.st_mtim.tv_sec);
+    ASSERT_EQ(after.st_mtim.tv_nsec, before.st_mtim.tv_nsec);
+}
+
+TEST(edited_file_refreshed)
+{
+    tm_symbol_index_t *index = NULL;
+    ASSERT_EQ(tm_symbol_index_load(g_index, &index), TM_OK);
+    uint64_t old_hash = find_file(index, "api/v2/routes.py")->content_hash;
+    uint64_t other_hash = find_file(index, "api/handlers.py")->content_hash;
+    tm_symbol_index_free(index);
+
+    struct stat before, after;
+    ASSERT_TRUE(index_identity(&before));
+
+    /* Rename the function, with a later mtime however coarse the clock */
+    ASSERT_TRUE(write_source("api/v2/routes.py",
+                             "def dispatch(request, version):\n    return None\n"));
+    char path[PATH_MAX + 64];
+    snprintf(path, sizeof(path), "%s/api/v2/routes.py", g_repo);
+    struct timespec times[2] = { { .tv_nsec = UTIME_OMIT }, { .tv_sec = time(NULL) + 10 } };
+    ASSERT_EQ(utimensat(AT_FDCWD, path, times, 0), 0);
+
+    ASSERT_EQ(tm_symbol_index_update(g_repo, g_index, 4, &index), TM_OK);
+    ASSERT_NOT_NULL(index);
+    ASSERT_TRUE(index_identity(&after));
+    ASSERT_TRUE(after.st_ino != before.st_ino);
+
+    ASSERT_EQ(index->header->file_count, TM_ARRAY_SIZE(INDEXED));
+    const tm_symbol_file_t *edited = find_file(index, "api/v2/routes.py");
+    ASSERT_NOT_NULL(edited);
+    ASSERT_TRUE(edited->content_hash != old_hash);
+    ASSERT_EQ(edited->mtime_sec, (int64_t)times[1].tv_sec);
+    ASSERT_EQ(find_file(index, "api/handlers.py")->content_hash, other_hash);
+
+#ifdef HAVE_TREE_SITTER
+    ASSERT_STREQ(defined_in(index, "dispatch"), "api/v2/routes.py");
+    ASSERT_TRUE(defined_in(index, "route") == NULL);
+    ASSERT_STREQ(defined_in(index, "handle"), "api/handlers.py");
+#endif
+
+    tm_symbol_index_free(index);
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+int main(void)
+{
+    printf("Symbol Index Tests\n");
+    printf("==================\n\n");
+
+    if (!build_fixture()) {
+        printf("Cannot create fixture under %s\n", g_dir);
+        return 1;
+    }
+
+    printf("Refresh:\n");
+    RUN_TEST(first_build_walks_tree);
+    RUN_TEST(unchanged_tree_keeps_index);
+    RUN_TEST(edited_file_refreshed);
+
+    teardown_fixture();
+
+    printf("\n==================\n");
+    printf("All tests passed!\n");
+
+    return 0;
+}
@@ -0,0 +1,1149 @@
+/**
+ * TraceMind - Mock LLM Server
+ *
+ * Loopback HTTP server speaking the OpenAI chat-completions and Anthropic
+ * messages formats (plus their batch APIs), for benchmarks and offline
+ * regression runs:
+ *
+ *   tracemind-mock-llm --port 0 --latency 200 --fail-429 5
+ *
+ * Prints "listening on 127.0.0.1:<port>" on stdout once ready, then serves
+ * until SIGINT/SIGTERM or --max-requests is reached.
+ */
+
+#include "internal/common.h"
+#include <jansson.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/* ============================================================================
+ * Options
+ * ========================================================================== */
+
+typedef struct {
+    int port;
+    int latency_ms;          /* Base latency before the first byte */
+    int jitter_ms;           /* Uniform extra latency in [0, jitter_ms] */
+    int chunk_delay_ms;      /* Delay between streamed chunks */
+    int chunk_size;          /* Characters per streamed chunk */
+    int fail_429_pct;        /* Percentage of requests answered with 429 */
+    int fail_500_pct;        /* Percentage of requests answered with 500 */
+    int timeout_pct;         /* Percentage of requests that never answer */
+    int hang_ms;             /* How long a "timed out" request stalls */
+    long max_requests;       /* Exit after this many requests (0 = never) */
+    unsigned int seed;
+    char *payload;           /* Assistant content returned on success */
+    int batch_polls;         /* Status polls before a batch reports done */
+    bool quiet;
+} mock_opts_t;
+
+static const char *DEFAULT_PAYLOAD =
+    "{\"hypotheses\":["
+    "{\"rank\":1,\"confidence\":82,"
+    "\"title\":\"Query built from unvalidated input\","
+    "\"explanation\":\"The failing frame executes SQL assembled from request data.\","
+    "\"evidence\":\"Top frame is the query execution call.\","
+    "\"next_step\":\"Log the generated SQL before execution.\","
+    "\"fix_suggestion\":\"Use parameterized queries in the handler.\","
+    "\"debug_commands\":[\"git log --oneline -5\",\"grep -rn execute .\"],"
+    "\"similar_errors\":\"Often caused by string-formatted SQL.\","
+    "\"related_files\":[\"handlers.py\"],\"related_commits\":[]},"
+    "{\"rank\":2,\"confidence\":11,"
+    "\"title\":\"Schema drift after migration\","
+    "\"explanation\":\"A recent migration may have renamed a column.\","
+    "\"evidence\":\"Error mentions a syntax problem near a column list.\","
+    "\"next_step\":\"Compare the schema with the query.\","
+    "\"fix_suggestion\":\"Align the query with the migrated schema.\","
+    "\"debug_commands\":[\"git log --oneline -- migrations/\"],"
+    "\"similar_errors\":\"Seen after partial deploys.\","
+    "\"related_files\":[],\"related_commits\":[]},"
+    "{\"rank\":3,\"confidence\":7,"
+    "\"title\":\"Driver version mismatch\","
+    "\"explanation\":\"The database driver may quote identifiers differently.\","
+    "\"evidence\":\"Third-party frames precede the error.\","
+    "\"next_step\":\"Check the installed driver version.\","
+    "\"fix_suggestion\":\"Pin the driver to the last known good version.\","
+    "\"debug_commands\":[\"pip freeze | grep -i psycopg\"],"
+    "\"similar_errors\":\"Common after dependency upgrades.\","
+    "\"related_files\":[],\"related_commits\":[]}"
+    "]}";
+
+static mock_opts_t g_opts;
+static volatile sig_atomic_t g_stop = 0;
+
+/* ============================================================================
+ * Shared State
+ * ========================================================================== */
+
+/* Counters and a tiny prefix-cache model, shared across connection threads */
+typedef struct {
+    pthread_mutex_t lock;
+    long requests;
+    long ok;
+    long rate_limited;
+    long server_errors;
+    long timeouts;
+    unsigned int rng;
+    uint64_t prefixes[256];  /* FNV-1a hashes of seen cacheable prefixes */
+    size_t prefix_count;
+} mock_state_t;
+
+static mock_state_t g_state = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static int next_random(void)
+{
+    pthread_mutex_lock(&g_state.lock);
+    g_state.rng = g_state.rng * 1103515245u + 12345u;
+    int r = (int)((g_state.rng >> 16) & 0x7fff);
+    pthread_mutex_unlock(&g_state.lock);
+    return r;
+}
+
+static void sleep_ms(int ms)
+{
+    if (ms <= 0) return;
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+static uint64_t fnv1a(const char *s, size_t len)
+{
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * Record a cacheable prefix. Returns true if it was already cached.
+ */
+static bool prefix_cache_lookup(const char *prefix, size_t len)
+{
+    uint64_t h = fnv1a(prefix, len);
+    bool hit = false;
+
+    pthread_mutex_lock(&g_state.lock);
+    for (size_t i = 0; i < g_state.prefix_count; i++) {
+        if (g_state.prefixes[i] == h) {
+            hit = true;
+            break;
+        }
+    }
+    if (!hit) {
+        g_state.prefixes[g_state.prefix_count % TM_ARRAY_SIZE(g_state.prefixes)] = h;
+        g_state.prefix_count++;
+    }
+    pthread_mutex_unlock(&g_state.lock);
+
+    return hit;
+}
+
+/* ============================================================================
+ * HTTP I/O
+ * ========================================================================== */
+
+typedef struct {
+    char method[8];
+    char path[256];
+    char *body;
+    size_t body_len;
+} http_request_t;
+
+static bool write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static bool read_request(int fd, http_request_t *req)
+{
+    tm_strbuf_t buf;
+    tm_strbuf_init(&buf);
+    char chunk[4096];
+    char *header_end = NULL;
+
+    while (!header_end) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            tm_strbuf_free(&buf);
+            return false;
+        }
+        tm_strbuf_append_len(&buf, chunk, (size_t)n);
+        header_end = strstr(buf.data, "\r\n\r\n");
+        if (!header_end && buf.len > 65536) {
+            tm_strbuf_free(&buf);
+            return false;
+        }
+    }
+
+    if (sscanf(buf.data, "%7s %255s", req->method, req->path) != 2) {
+        tm_strbuf_free(&buf);
+        return false;
+    }
+
+    size_t content_length = 0;
+    const char *cl = tm_strcasestr(buf.data, "\r\ncontent-length:");
+    if (cl && cl < header_end) {
+        content_length = (size_t)strtoul(cl + 17, NULL, 10);
+    }
+
+    /* curl holds large bodies back until it sees 100 Continue */
+    const char *expect = tm_strcasestr(buf.data, "\r\nexpect: 100-continue");
+    if (expect && expect < header_end && buf.len == (size_t)(header_end - buf.data) + 4) {
+        const char *cont = "HTTP/1.1 100 Continue\r\n\r\n";
+        write_all(fd, cont, strlen(cont));
+    }
+
+    size_t header_len = (size_t)(header_end - buf.data) + 4;
+    while (buf.len - header_len < content_length) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            tm_strbuf_free(&buf);
+            return false;
+        }
+        tm_strbuf_append_len(&buf, chunk, (size_t)n);
+    }
+
+    req->body_len = content_length;
+    req->body = tm_strndup(buf.data + header_len, content_length);
+    tm_strbuf_free(&buf);
+    return true;
+}
+
+static void send_response(int fd, int status, const char *reason,
+                          const char *extra_headers, const char *body)
+{
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    tm_strbuf_appendf(&sb, "HTTP/1.1 %d %s\r\n"
+                           "Content-Type: application/json\r\n"
+                           "Content-Length: %zu\r\n"
+                           "Connection: close\r\n",
+                      status, reason, strlen(body));
+    if (extra_headers) tm_strbuf_append(&sb, extra_headers);
+    tm_strbuf_append(&sb, "\r\n");
+    tm_strbuf_append(&sb, body);
+    write_all(fd, sb.data, sb.len);
+    tm_strbuf_free(&sb);
+}
+
+/* Send a JSON value and release it */
+static void send_json(int fd, int status, const char *reason, json_t *value)
+{
+    char *body = json_dumps(value, JSON_COMPACT);
+    send_response(fd, status, reason, NULL, body ? body : "{}");
+    free(body);
+    json_decref(value);
+}
+
+static void send_sse_event(int fd, const char *event, json_t *data)
+{
+    char *payload = json_dumps(data, JSON_COMPACT);
+    tm_strbuf_t sb;
+    tm_strbuf_init(&sb);
+    if (event) tm_strbuf_appendf(&sb, "event: %s\n", event);
+    tm_strbuf_append(&sb, "data: ");
+    tm_strbuf_append(&sb, payload);
+    tm_strbuf_append(&sb, "\n\n");
+    write_all(fd, sb.data, sb.len);
+    tm_strbuf_free(&sb);
+    free(payload);
+    json_decref(data);
+}
+
+/* ============================================================================
+ * Provider Formats
+ * ========================================================================== */
+
+typedef enum {
+    FORMAT_OPENAI,
+    FORMAT_ANTHROPIC
+} wire_format_t;
+
+/* Token usage for one simulated completion */
+typedef struct {
+    int prompt;
+    int completion;
+    int cache_read;
+    int cache_write;
+} usage_t;
+
+static int estimate_tokens(size_t chars)
+{
+    return (int)((chars + 3) / 4);
+}
+
+static void append_text_content(tm_strbuf_t *sb, json_t *content)
+{
+    if (json_is_string(content)) {
+        tm_strbuf_append(sb, json_string_value(content));
+        return;
+    }
+    size_t i;
+    json_t *block;
+    json_array_foreach(content, i, block) {
+        json_t *text = json_object_get(block, "text");
+        if (json_is_string(text)) tm_strbuf_append(sb, json_string_value(text));
+    }
+}
+
+/**
+ * Model provider-side prompt caching. OpenAI caches any repeated prefix
+ * automatically (here: everything but the last message); Anthropic caches
+ * up to the last block carrying cache_control.
+ */
+static usage_t compute_usage(json_t *req, wire_format_t format, size_t completion_len)
+{
+    usage_t u = { 0 };
+    tm_strbuf_t all, prefix;
+    tm_strbuf_init(&all);
+    tm_strbuf_init(&prefix);
+
+    json_t *messages = json_object_get(req, "messages");
+    size_t n = json_array_size(messages);
+
+    if (format == FORMAT_ANTHROPIC) {
+        size_t i;
+        json_t *block;
+        json_t *system = json_object_get(req, "system");
+        if (json_is_string(system)) {
+            tm_strbuf_append(&all, json_string_value(system));
+        } else {
+            json_array_foreach(system, i, block) {
+                json_t *text = json_object_get(block, "text");
+                if (json_is_string(text)) tm_strbuf_append(&all, json_string_value(text));
+                if (json_object_get(block, "cache_control")) {
+                    tm_strbuf_append_len(&prefix, all.data + prefix.len, all.len - prefix.len);
+                }
+            }
+        }
+        for (size_t m = 0; m < n; m++) {
+            json_t *content = json_object_get(json_array_get(messages, m), "content");
+            if (json_is_string(content)) {
+                tm_strbuf_append(&all, json_string_value(content));
+                continue;
+            }
+            json_array_foreach(content, i, block) {
+                json_t *text = json_object_get(block, "text");
+                if (json_is_string(text)) tm_strbuf_append(&all, json_string_value(text));
+                if (json_object_get(block, "cache_control")) {
+                    tm_strbuf_append_len(&prefix, all.data + prefix.len, all.len - prefix.len);
+                }
+            }
+        }
+    } else {
+        for (size_t m = 0; m < n; m++) {
+            append_text_content(&all, json_object_get(json_array_get(messages, m), "content"));
+            if (m + 2 == n) tm_strbuf_append_len(&prefix, all.data, all.len);
+        }
+    }
+
+    u.prompt = estimate_tokens(all.len);
+    u.completion = estimate_tokens(completion_len);
+
+    /* Providers only cache prefixes of at least 1024 tokens */
+    int prefix_tokens = estimate_tokens(prefix.len);
+    if (prefix.len > 0 && prefix_tokens >= 1024) {
+        if (prefix_cache_lookup(prefix.data, prefix.len)) {
+            u.cache_read = prefix_tokens;
+        } else if (format == FORMAT_ANTHROPIC) {
+            u.cache_write = prefix_tokens;
+        }
+    }
+
+    tm_strbuf_free(&all);
+    tm_strbuf_free(&prefix);
+    return u;
+}
+
+static json_t *openai_usage_json(const usage_t *u)
+{
+    return json_pack("{s:i, s:i, s:i, s:{s:i}}",
+                     "prompt_tokens", u->prompt,
+                     "completion_tokens", u->completion,
+                     "total_tokens", u->prompt + u->completion,
+                     "prompt_tokens_details", "cached_tokens", u->cache_read);
+}
+
+static json_t *anthropic_usage_json(const usage_t *u)
+{
+    return json_pack("{s:i, s:i, s:i, s:i}",
+                     "input_tokens", u->prompt - u->cache_read - u->cache_write,
+                     "output_tokens", u->completion,
+                     "cache_read_input_tokens", u->cache_read,
+                     "cache_creation_input_tokens", u->cache_write);
+}
+
+static json_t *error_json(wire_format_t format, int status)
+{
+    const char *type = status == 429 ? "rate_limit_error" : "api_error";
+
+    json_t *err = json_pack("{s:s, s:s}", "type", type, "message", "mock injected failure");
+    return format == FORMAT_ANTHROPIC
+        ? json_pack("{s:s, s:o}", "type", "error", "error", err)
+        : json_pack("{s:o}", "error", err);
+}
+
+static void send_error(int fd, wire_format_t format, int status)
+{
+    const char *reason = status == 429 ? "Too Many Requests" : "Internal Server Error";
+    json_t *body = error_json(format, status);
+
+    char *text = json_dumps(body, JSON_COMPACT);
+    send_response(fd, status, reason, status == 429 ? "Retry-After: 1\r\n" : NULL, text);
+    free(text);
+    json_decref(body);
+}
+
+static json_t *completion_json(wire_format_t format, const char *model,
+                               long id, const usage_t *u)
+{
+    json_t *body;
+
+    if (format == FORMAT_ANTHROPIC) {
+        body = json_pack("{s:s, s:s, s:s, s:s, s:[{s:s, s:s}], s:s, s:o}",
+                         "id", "msg_mock",
+                         "type", "message",
+                         "role", "assistant",
+                         "model", model,
+                         "content", "type", "text", "text", g_opts.payload,
+                         "stop_reason", "end_turn",
+                         "usage", anthropic_usage_json(u));
+    } else {
+        body = json_pack("{s:s, s:s, s:s, s:[{s:i, s:{s:s, s:s}, s:s}], s:o}",
+                         "id", "chatcmpl-mock",
+                         "object", "chat.completion",
+                         "model", model,
+                         "choices", "index", 0,
+                                    "message", "role", "assistant", "content", g_opts.payload,
+                                    "finish_reason", "stop",
+                         "usage", openai_usage_json(u));
+    }
+
+    json_object_set_new(body, "created", json_integer(id));
+    return body;
+}
+
+static void send_completion(int fd, wire_format_t format, const char *model,
+                            long id, const usage_t *u)
+{
+    send_json(fd, 200, "OK", completion_json(format, model, id, u));
+}
+
+static void send_stream(int fd, wire_format_t format, const char *model, const usage_t *u)
+{
+    const char *headers =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: close\r\n\r\n";
+    if (!write_all(fd, headers, strlen(headers))) return;
+
+    size_t len = strlen(g_opts.payload);
+    size_t step = g_opts.chunk_size > 0 ? (size_t)g_opts.chunk_size : 64;
+
+    if (format == FORMAT_ANTHROPIC) {
+        json_t *usage = anthropic_usage_json(u);
+        json_object_set_new(usage, "output_tokens", json_integer(0));
+        send_sse_event(fd, "message_start",
+            json_pack("{s:s, s:{s:s, s:s, s:s, s:s, s:[], s:o}}",
+                      "type", "message_start",
+                      "message", "id", "msg_mock", "type", "message",
+                      "role", "assistant", "model", model, "content",
+                      "usage", usage));
+        send_sse_event(fd, "content_block_start",
+            json_pack("{s:s, s:i, s:{s:s, s:s}}",
+                      "type", "content_block_start", "index", 0,
+                      "content_block", "type", "text", "text", ""));
+    }
+
+    for (size_t off = 0; off < len; off += step) {
+        sleep_ms(g_opts.chunk_delay_ms);
+        json_t *piece = json_stringn(g_opts.payload + off, TM_MIN(step, len - off));
+
+        if (format == FORMAT_ANTHROPIC) {
+            send_sse_event(fd, "content_block_delta",
+                json_pack("{s:s, s:i, s:{s:s, s:o}}",
+                          "type", "content_block_delta", "index", 0,
+                          "delta", "type", "text_delta", "text", piece));
+        } else {
+            send_sse_event(fd, NULL,
+                json_pack("{s:s, s:s, s:s, s:[{s:i, s:{s:o}, s:n}]}",
+                          "id", "chatcmpl-mock", "object", "chat.completion.chunk",
+                          "model", model,
+                          "choices", "index", 0, "delta", "content", piece,
+                          "finish_reason"));
+        }
+    }
+
+    if (format == FORMAT_ANTHROPIC) {
+        send_sse_event(fd, "content_block_stop",
+            json_pack("{s:s, s:i}", "type", "content_block_stop", "index", 0));
+        send_sse_event(fd, "message_delta",
+            json_pack("{s:s, s:{s:s}, s:{s:i}}",
+                      "type", "message_delta",
+                      "delta", "stop_reason", "end_turn",
+                      "usage", "output_tokens", u->completion));
+        send_sse_event(fd, "message_stop", json_pack("{s:s}", "type", "message_stop"));
+    } else {
+        send_sse_event(fd, NULL,
+            json_pack("{s:s, s:s, s:s, s:[{s:i, s:{}, s:s}], s:o}",
+                      "id", "chatcmpl-mock", "object", "chat.completion.chunk",
+                      "model", model,
+                      "choices", "index", 0, "delta", "finish_reason", "stop",
+                      "usage", openai_usage_json(u)));
+        const char *done = "data: [DONE]\n\n";
+        write_all(fd, done, strlen(done));
+    }
+}
+
+/* ============================================================================
+ * Batch API
+ * ========================================================================== */
+
+/* Uploaded or generated JSONL files (OpenAI Files API) */
+typedef struct {
+    char id[32];
+    char *content;
+} mock_file_t;
+
+typedef struct {
+    char id[32];
+    wire_format_t format;
+    char input_file_id[32];
+    char output_file_id[32];          /* OpenAI */
+    char error_file_id[32];           /* OpenAI */
+    char *results;                    /* Anthropic JSONL */
+    int polls_left;                   /* Status polls before reporting done */
+    size_t succeeded;
+    size_t failed;
+} mock_batch_t;
+
+/* Guarded by g_state.lock */
+static mock_file_t *g_files;
+static size_t g_file_count, g_file_cap;
+static mock_batch_t *g_batches;
+static size_t g_batch_count, g_batch_cap;
+static int g_port;
+
+/* Store a file and copy its id to out; takes ownership of content */
+static void file_store(char *content, char *out, size_t out_size)
+{
+    mock_file_t file = { .content = content };
+    pthread_mutex_lock(&g_state.lock);
+    snprintf(file.id, sizeof(file.id), "file-mock%zu", g_file_count + 1);
+    TM_VEC_PUSH(g_files, g_file_count, g_file_cap, file);
+    pthread_mutex_unlock(&g_state.lock);
+    snprintf(out, out_size, "%s", file.id);
+}
+
+/* Copy of a stored file's content, or NULL */
+static char *file_content(const char *id)
+{
+    char *content = NULL;
+    pthread_mutex_lock(&g_state.lock);
+    for (size_t i = 0; i < g_file_count; i++) {
+        if (strcmp(g_files[i].id, id) == 0) {
+            content = tm_strdup(g_files[i].content);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_state.lock);
+    return content;
+}
+
+/* Path segment following marker (e.g. the id in /v1/batches/<id>/...) */
+static void path_segment(const char *path, const char *marker, char *out, size_t out_size)
+{
+    const char *p = strstr(path, marker);
+    p = p ? p + strlen(marker) : "";
+    size_t len = strcspn(p, "/?");
+    snprintf(out, out_size, "%.*s", (int)TM_MIN(len, out_size - 1), p);
+}
+
+/* Extract the part named "file" from a multipart/form-data body */
+static char *multipart_file(const char *body, size_t len)
+{
+    const char *eol = strstr(body, "\r\n");
+    if (!eol || body[0] != '-') return NULL;
+    size_t boundary_len = (size_t)(eol - body);
+
+    const char *name = strstr(body, "name=\"file\"");
+    const char *start = name ? strstr(name, "\r\n\r\n") : NULL;
+    if (!start) return NULL;
+    start += 4;
+
+    const char *end = body + len;
+    for (const char *p = start; p + 2 + boundary_len <= end; p++) {
+        if (p[0] == '\r' && p[1] == '\n' && memcmp(p + 2, body, boundary_len) == 0) {
+            return tm_strndup(start, (size_t)(p - start));
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Run one batched request through the same fault injection and usage model
+ * as the synchronous path. Returns the response body; *status is the HTTP
+ * status it would have had.
+ */
+static json_t *batch_line_response(wire_format_t format, json_t *params, int *status)
+{
+    long id;
+    pthread_mutex_lock(&g_state.lock);
+    id = ++g_state.requests;
+    pthread_mutex_unlock(&g_state.lock);
+
+    int roll = next_random() % 100;
+    long *counter = &g_state.ok;
+    json_t *body;
+
+    if (roll < g_opts.fail_429_pct) {
+        counter = &g_state.rate_limited;
+        *status = 429;
+        body = error_json(format, 429);
+    } else if (roll < g_opts.fail_429_pct + g_opts.fail_500_pct) {
+        counter = &g_state.server_errors;
+        *status = 500;
+        body = error_json(format, 500);
+    } else {
+        json_t *model_val = json_object_get(params, "model");
+        const char *model = json_is_string(model_val) ? json_string_value(model_val) : "mock";
+        usage_t usage = compute_usage(params, format, strlen(g_opts.payload));
+        *status = 200;
+        body = completion_json(format, model, id, &usage);
+    }
+
+    pthread_mutex_lock(&g_state.lock);
+    (*counter)++;
+    pthread_mutex_unlock(&g_state.lock);
+    return body;
+}
+
+static json_t *openai_batch_json(const mock_batch_t *b)
+{
+    const char *status = b->polls_left > 0 ? "in_progress" : "completed";
+    json_t *obj = json_pack("{s:s, s:s, s:s, s:s, s:s, s:s, s:{s:i, s:i, s:i}}",
+                            "id", b->id,
+                            "object", "batch",
+                            "endpoint", "/v1/chat/completions",
+                            "input_file_id", b->input_file_id,
+                            "completion_window", "24h",
+                            "status", status,
+                            "request_counts",
+                                "total", (int)(b->succeeded + b->failed),
+                                "completed", b->polls_left > 0 ? 0 : (int)b->succeeded,
+                                "failed", b->polls_left > 0 ? 0 : (int)b->failed);
+
+    bool done = b->polls_left <= 0;
+    json_object_set_new(obj, "output_file_id",
+                        done && b->output_file_id[0] ? json_string(b->output_file_id) : json_null());
+    json_object_set_new(obj, "error_file_id",
+                        done && b->error_file_id[0] ? json_string(b->error_file_id) : json_null());
+    return obj;
+}
+
+static json_t *anthropic_batch_json(const mock_batch_t *b)
+{
+    bool done = b->polls_left <= 0;
+    json_t *obj = json_pack("{s:s, s:s, s:s, s:{s:i, s:i, s:i, s:i, s:i}}",
+                            "id", b->id,
+                            "type", "message_batch",
+                            "processing_status", done ? "ended" : "in_progress",
+                            "request_counts",
+                                "processing", done ? 0 : (int)(b->succeeded + b->failed),
+                                "succeeded", done ? (int)b->succeeded : 0,
+                                "errored", done ? (int)b->failed : 0,
+                                "canceled", 0,
+                                "expired", 0);
+
+    if (done) {
+        char url[160];
+        snprintf(url, sizeof(url), "http://127.0.0.1:%d/v1/messages/batches/%s/results",
+                 g_port, b->id);
+        json_object_set_new(obj, "results_url", json_string(url));
+    } else {
+        json_object_set_new(obj, "results_url", json_null());
+    }
+    return obj;
+}
+
+/* Register a processed batch and answer with its status object */
+static void batch_store(int fd, mock_batch_t *batch)
+{
+    batch->polls_left = g_opts.batch_polls;
+
+    pthread_mutex_lock(&g_state.lock);
+    snprintf(batch->id, sizeof(batch->id), "%s%zu",
+             batch->format == FORMAT_ANTHROPIC ? "msgbatch_mock" : "batch_mock",
+             g_batch_count + 1);
+    TM_VEC_PUSH(g_batches, g_batch_count, g_batch_cap, *batch);
+    json_t *obj = batch->format == FORMAT_ANTHROPIC
+        ? anthropic_batch_json(batch) : openai_batch_json(batch);
+    pthread_mutex_unlock(&g_state.lock);
+
+    send_json(fd, 200, "OK", obj);
+}
+
+static void handle_file_upload(int fd, const http_request_t *req)
+{
+    char *content = multipart_file(req->body, req->body_len);
+    if (!content) {
+        send_response(fd, 400, "Bad Request", NULL,
+                      "{\"error\":{\"type\":\"invalid_request_error\",\"message\":\"missing file part\"}}");
+        return;
+    }
+
+    size_t bytes = strlen(content);
+    char id[32];
+    file_store(content, id, sizeof(id));
+    send_json(fd, 200, "OK", json_pack("{s:s, s:s, s:i, s:s}", "id", id, "object", "file",
+                                       "bytes", (int)bytes, "purpose", "batch"));
+}
+
+static void handle_openai_batch_create(int fd, const http_request_t *req)
+{
+    json_error_t jerr;
+    json_t *body = json_loadb(req->body, req->body_len, 0, &jerr);
+    const char *input_id = json_string_value(json_object_get(body, "input_file_id"));
+    char *input = input_id ? file_content(input_id) : NULL;
+
+    if (!input) {
+        json_decref(body);
+        send_response(fd, 400, "Bad Request", NULL,
+                      "{\"error\":{\"type\":\"invalid_request_error\",\"message\":\"unknown input_file_id\"}}");
+        return;
+    }
+
+    mock_batch_t batch = { .format = FORMAT_OPENAI };
+    snprintf(batch.input_file_id, sizeof(batch.input_file_id), "%s", input_id);
+    json_decref(body);
+
+    tm_strbuf_t output, errors;
+    tm_strbuf_init(&output);
+    tm_strbuf_init(&errors);
+
+    char *save = NULL;
+    for (char *line = strtok_r(input, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        json_t *req_line = json_loads(line, 0, &jerr);
+        if (!req_line) continue;
+
+        int status = 0;
+        json_t *resp = batch_line_response(FORMAT_OPENAI, json_object_get(req_line, "body"), &status);
+        json_t *out = json_pack("{s:s, s:O, s:{s:i, s:s, s:o}, s:n}",
+                                "id", "batch_req_mock",
+                                "custom_id", json_object_get(req_line, "custom_id"),
+                                "response", "status_code", status,
+                                            "request_id", "req_mock",
+                                            "body", resp,
+                                "error");
+        char *text = json_dumps(out, JSON_COMPACT);
+        tm_strbuf_t *dst = status == 200 ? &output : &errors;
+        tm_strbuf_appendf(dst, "%s\n", text);
+        if (status == 200) batch.succeeded++; else batch.failed++;
+
+        free(text);
+        json_decref(out);
+        json_decref(req_line);
+    }
+    free(input);
+
+    if (output.len > 0) {
+        file_store(tm_strbuf_finish(&output), batch.output_file_id, sizeof(batch.output_file_id));
+    } else {
+        tm_strbuf_free(&output);
+    }
+    if (errors.len > 0) {
+        file_store(tm_strbuf_finish(&errors), batch.error_file_id, sizeof(batch.error_file_id));
+    } else {
+        tm_strbuf_free(&errors);
+    }
+
+    batch_store(fd, &batch);
+}
+
+static void handle_anthropic_batch_create(int fd, const http_request_t *req)
+{
+    json_error_t jerr;
+    json_t *body = json_loadb(req->body, req->body_len, 0, &jerr);
+    json_t *requests = json_object_get(body, "requests");
+
+    if (!json_is_array(requests)) {
+        json_decref(body);
+        send_response(fd, 400, "Bad Request", NULL,
+                      "{\"type\":\"error\",\"error\":{\"type\":\"invalid_request_error\",\"message\":\"requests must be an array\"}}");
+        return;
+    }
+
+    mock_batch_t batch = { .format = FORMAT_ANTHROPIC };
+    tm_strbuf_t results;
+    tm_strbuf_init(&results);
+
+    size_t i;
+    json_t *item;
+    json_array_foreach(requests, i, item) {
+        int status = 0;
+        json_t *resp = batch_line_response(FORMAT_ANTHROPIC, json_object_get(item, "params"), &status);
+        json_t *result = status == 200
+            ? json_pack("{s:s, s:o}", "type", "succeeded", "message", resp)
+            : json_pack("{s:s, s:o}", "type", "errored", "error", resp);
+        json_t *out = json_pack("{s:O, s:o}", "custom_id", json_object_get(item, "custom_id"),
+                                "result", result);
+
+        char *text = json_dumps(out, JSON_COMPACT);
+        tm_strbuf_appendf(&results, "%s\n", text);
+        if (status == 200) batch.succeeded++; else batch.failed++;
+
+        free(text);
+        json_decref(out);
+    }
+    json_decref(body);
+
+    batch.results = tm_strbuf_finish(&results);
+    batch_store(fd, &batch);
+}
+
+/* GET a batch status, or (results = true) an Anthropic results file */
+static void handle_batch_get(int fd, const http_request_t *req, wire_format_t format, bool results)
+{
+    char id[32];
+    path_segment(req->path, "/batches/", id, sizeof(id));
+
+    json_t *obj = NULL;
+    char *content = NULL;
+
+    pthread_mutex_lock(&g_state.lock);
+    for (size_t i = 0; i < g_batch_count; i++) {
+        mock_batch_t *b = &g_batches[i];
+        if (strcmp(b->id, id) != 0 || b->format != format) continue;
+
+        if (results) {
+            if (b->polls_left <= 0 && b->results) content = tm_strdup(b->results);
+        } else {
+            if (b->polls_left > 0) b->polls_left--;
+            obj = format == FORMAT_ANTHROPIC ? anthropic_batch_json(b) : openai_batch_json(b);
+        }
+        break;
+    }
+    pthread_mutex_unlock(&g_state.lock);
+
+    if (obj) {
+        send_json(fd, 200, "OK", obj);
+    } else if (content) {
+        send_response(fd, 200, "OK", NULL, content);
+        free(content);
+    } else {
+        send_response(fd, 404, "Not Found", NULL,
+                      "{\"error\":{\"type\":\"not_found_error\",\"message\":\"unknown batch\"}}");
+    }
+}
+
+static void handle_file_get(int fd, const http_request_t *req)
+{
+    char id[32];
+    path_segment(req->path, "/files/", id, sizeof(id));
+
+    char *content = file_content(id);
+    if (content) {
+        send_response(fd, 200, "OK", NULL, content);
+        free(content);
+    } else {
+        send_response(fd, 404, "Not Found", NULL,
+                      "{\"error\":{\"type\":\"not_found_error\",\"message\":\"unknown file\"}}");
+    }
+}
+
+/* ============================================================================
+ * Request Dispatch
+ * ========================================================================== */
+
+/* Stall like an unresponsive upstream, returning early if the client hangs up */
+static void stall(int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    poll(&pfd, 1, g_opts.hang_ms);
+}
+
+static void handle_chat(int fd, const http_request_t *req, wire_format_t format)
+{
+    json_error_t jerr;
+    json_t *body = json_loadb(req->body, req->body_len, 0, &jerr);
+    if (!body) {
+        send_response(fd, 400, "Bad Request", NULL,
+                      "{\"error\":{\"type\":\"invalid_request_error\",\"message\":\"invalid JSON\"}}");
+        return;
+    }
+
+    long id;
+    pthread_mutex_lock(&g_state.lock);
+    id = ++g_state.requests;
+    pthread_mutex_unlock(&g_state.lock);
+
+    int latency = g_opts.latency_ms;
+    if (g_opts.jitter_ms > 0) latency += next_random() % (g_opts.jitter_ms + 1);
+    sleep_ms(latency);
+
+    /* Fault injection: one roll, split across the configured percentages */
+    int roll = next_random() % 100;
+    long *counter = &g_state.ok;
+
+    if (roll < g_opts.fail_429_pct) {
+        counter = &g_state.rate_limited;
+        send_error(fd, format, 429);
+    } else if (roll < g_opts.fail_429_pct + g_opts.fail_500_pct) {
+        counter = &g_state.server_errors;
+        send_error(fd, format, 500);
+    } else if (roll < g_opts.fail_429_pct + g_opts.fail_500_pct + g_opts.timeout_pct) {
+        counter = &g_state.timeouts;
+        stall(fd);
+    } else {
+        json_t *model_val = json_object_get(body, "model");
+        const char *model = json_is_string(model_val) ? json_string_value(model_val) : "mock";
+        usage_t usage = compute_usage(body, format, strlen(g_opts.payload));
+
+        if (json_is_true(json_object_get(body, "stream"))) {
+            send_stream(fd, format, model, &usage);
+        } else {
+            send_completion(fd, format, model, id, &usage);
+        }
+    }
+
+    pthread_mutex_lock(&g_state.lock);
+    (*counter)++;
+    pthread_mutex_unlock(&g_state.lock);
+
+    if (g_opts.max_requests > 0 && id >= g_opts.max_requests) {
+        g_stop = 1;
+    }
+
+    json_decref(body);
+}
+
+static void dispatch(int fd, const http_request_t *req)
+{
+    if (!g_opts.quiet) {
+        fprintf(stderr, "mock: %s %s (%zu bytes)\n", req->method, req->path, req->body_len);
+    }
+
+    if (strcmp(req->method, "GET") == 0 && strcmp(req->path, "/health") == 0) {
+        send_response(fd, 200, "OK", NULL, "{\"status\":\"ok\"}");
+    } else if (strcmp(req->method, "POST") == 0 && tm_str_ends_with(req->path, "/chat/completions")) {
+        handle_chat(fd, req, FORMAT_OPENAI);
+    } else if (strcmp(req->method, "POST") == 0 && tm_str_ends_with(req->path, "/messages")) {
+        handle_chat(fd, req, FORMAT_ANTHROPIC);
+    } else if (strcmp(req->method, "POST") == 0 && tm_str_ends_with(req->path, "/messages/batches")) {
+        handle_anthropic_batch_create(fd, req);
+    } else if (strcmp(req->method, "GET") == 0 && strstr(req->path, "/messages/batches/")) {
+        handle_batch_get(fd, req, FORMAT_ANTHROPIC, tm_str_ends_with(req->path, "/results"));
+    } else if (strcmp(req->method, "POST") == 0 && tm_str_ends_with(req->path, "/files")) {
+        handle_file_upload(fd, req);
+    } else if (strcmp(req->method, "GET") == 0 && strstr(req->path, "/files/")) {
+        handle_file_get(fd, req);
+    } else if (strcmp(req->method, "POST") == 0 && tm_str_ends_with(req->path, "/batches")) {
+        handle_openai_batch_create(fd, req);
+    } else if (strcmp(req->method, "GET") == 0 && strstr(req->path, "/batches/")) {
+        handle_batch_get(fd, req, FORMAT_OPENAI, false);
+    } else {
+        send_response(fd, 404, "Not Found", NULL,
+                      "{\"error\":{\"type\":\"not_found_error\",\"message\":\"unknown route\"}}");
+    }
+}
+
+static void *connection_thread(void *arg)
+{
+    int fd = (int)(intptr_t)arg;
+    http_request_t req = { 0 };
+
+    if (read_request(fd, &req)) {
+        dispatch(fd, &req);
+    }
+
+    TM_FREE(req.body);
+    close(fd);
+    return NULL;
+}
+
+/* ============================================================================
+ * Main
+ * ========================================================================== */
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "Usage: tracemind-mock-llm [options]\n"
+        "\n"
+        "  -p, --port <n>          Listen port on 127.0.0.1 (0 = ephemeral)\n"
+        "  -l, --latency <ms>      Latency before responding (default: 0)\n"
+        "  -j, --jitter <ms>       Random extra latency (default: 0)\n"
+        "      --chunk-delay <ms>  Delay between streamed chunks (default: 5)\n"
+        "      --chunk-size <n>    Characters per streamed chunk (default: 64)\n"
+        "      --fail-429 <pct>    Answer this share of requests with 429\n"
+        "      --fail-500 <pct>    Answer this share of requests with 500\n"
+        "      --timeout <pct>     Never answer this share of requests\n"
+        "      --hang <ms>         Stall time for --timeout (default: 120000)\n"
+        "      --payload <file>    Canned assistant content (default: 3 hypotheses)\n"
+        "      --max-requests <n>  Exit after n chat requests\n"
+        "      --seed <n>          RNG seed for latency and fault injection\n"
+        "      --batch-polls <n>   Status polls before a batch completes (default: 2)\n"
+        "  -q, --quiet             Do not log requests\n");
+}
+
+int main(int argc, char **argv)
+{
+    static struct option long_options[] = {
+        {"port",         required_argument, 0, 'p'},
+        {"latency",      required_argument, 0, 'l'},
+        {"jitter",       required_argument, 0, 'j'},
+        {"chunk-delay",  required_argument, 0, 1},
+        {"chunk-size",   required_argument, 0, 2},
+        {"fail-429",     required_argument, 0, 3},
+        {"fail-500",     required_argument, 0, 4},
+        {"timeout",      required_argument, 0, 5},
+        {"hang",         required_argument, 0, 6},
+        {"payload",      required_argument, 0, 7},
+        {"max-requests", required_argument, 0, 8},
+        {"seed",         required_argument, 0, 9},
+        {"batch-polls",  required_argument, 0, 10},
+        {"quiet",        no_argument,       0, 'q'},
+        {"help",         no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    g_opts.chunk_delay_ms = 5;
+    g_opts.chunk_size = 64;
+    g_opts.hang_ms = 120000;
+    g_opts.seed = 42;
+    g_opts.batch_polls = 2;
+
+    const char *payload_path = NULL;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:l:j:qh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p': g_opts.port = atoi(optarg); break;
+            case 'l': g_opts.latency_ms = atoi(optarg); break;
+            case 'j': g_opts.jitter_ms = atoi(optarg); break;
+            case 1: g_opts.chunk_delay_ms = atoi(optarg); break;
+            case 2: g_opts.chunk_size = atoi(optarg); break;
+            case 3: g_opts.fail_429_pct = atoi(optarg); break;
+            case 4: g_opts.fail_500_pct = atoi(optarg); break;
+            case 5: g_opts.timeout_pct = atoi(optarg); break;
+            case 6: g_opts.hang_ms = atoi(optarg); break;
+            case 7: payload_path = optarg; break;
+            case 8: g_opts.max_requests = atol(optarg); break;
+            case 9: g_opts.seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 10: g_opts.batch_polls = atoi(optarg); break;
+            case 'q': g_opts.quiet = true; break;
+            case 'h': usage(); return 0;
+            default: usage(); return 1;
+        }
+    }
+
+    if (payload_path) {
+        FILE *f = fopen(payload_path, "rb");
+        if (!f) {
+            fprintf(stderr, "mock: cannot open payload %s: %s\n", payload_path, strerror(errno));
+            return 1;
+        }
+        tm_strbuf_t sb;
+        tm_strbuf_init(&sb);
+        char chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+            tm_strbuf_append_len(&sb, chunk, n);
+        }
+        fclose(f);
+        g_opts.payload = tm_strbuf_finish(&sb);
+    } else {
+        g_opts.payload = tm_strdup(DEFAULT_PAYLOAD);
+    }
+    g_state.rng = g_opts.seed;
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("mock: socket");
+        return 1;
+    }
+
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)g_opts.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, 64) != 0) {
+        perror("mock: bind");
+        close(listen_fd);
+        return 1;
+    }
+
+    socklen_t addr_len = sizeof(addr);
+    getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len);
+    g_port = ntohs(addr.sin_port);
+    printf("listening on 127.0.0.1:%d\n", g_port);
+    fflush(stdout);
+
+    struct sigaction sa = { 0 };
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    while (!g_stop) {
+        struct pollfd pfd = { .fd = listen_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 100) <= 0) continue;
+
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+
+        pthread_t tid;
+        if (pthread_create(&tid, &attr, connection_thread, (void *)(intptr_t)fd) != 0) {
+            close(fd);
+        }
+    }
+
+    pthread_attr_destroy(&attr);
+    close(listen_fd);
+
+    pthread_mutex_lock(&g_state.lock);
+    fprintf(stderr, "mock: %ld requests (%ld ok, %ld 429, %ld 500, %ld timeout)\n",
+            g_state.requests, g_state.ok, g_state.rate_limited,
+            g_state.server_errors, g_state.timeouts);
+    pthread_mutex_unlock(&g_state.lock);
+
+    for (size_t i = 0; i < g_file_count; i++) free(g_files[i].content);
+    for (size_t i = 0; i < g_batch_count; i++) free(g_batches[i].results);
+    free(g_files);
+    free(g_batches);
+    TM_FREE(g_opts.payload);
+    return 0;
+}